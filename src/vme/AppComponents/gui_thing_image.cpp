@@ -10,6 +10,7 @@
 #include "core/graphics/texture_atlas.h"
 #include "core/item.h"
 #include "core/items.h"
+#include "thumbnail_cache.h"
 
 vme_unordered_map<uint32_t, QPixmap> GUIImageCache::serverIdToPixmap;
 vme_unordered_map<uint32_t, std::unique_ptr<QImage>> GUIImageCache::textureIdToQImage;
@@ -24,6 +25,15 @@ QtTextureArea::QtTextureArea(QRect rect, QImage *image)
 namespace
 {
     constexpr int InitialImageCacheCapacity = 4096;
+
+    // QPixmap can only be used on the GUI thread, so background threads use this instead of GUIImageCache::blackSquarePixmap.
+    QImage blackSquareImage()
+    {
+        QImage image(32, 32, QImage::Format::Format_ARGB32);
+        image.fill(QColor(0, 0, 0, 255));
+
+        return image;
+    }
 } // namespace
 
 void GUIImageCache::initialize()
@@ -41,7 +51,8 @@ const QPixmap &GUIImageCache::get(uint32_t serverId)
     auto found = serverIdToPixmap.find(serverId);
     if (found == serverIdToPixmap.end())
     {
-        serverIdToPixmap.try_emplace(serverId, GUIThingImage::itemPixmap(serverId));
+        QImage thumbnail = ThumbnailCache::global().get(serverId);
+        serverIdToPixmap.try_emplace(serverId, thumbnail.isNull() ? blackSquarePixmap() : QPixmap::fromImage(std::move(thumbnail)));
     }
 
     return serverIdToPixmap.at(serverId);
@@ -115,20 +126,7 @@ QImage GUIThingImage::getCreatureTypeImage(const CreatureType &creatureType, Dir
 
 QImage GUIThingImage::getItemTypeImage(const ItemType &itemType, uint8_t subtype)
 {
-    TextureInfo info = subtype > 1 ? itemType.getTextureInfoForSubtype(subtype, TextureInfo::CoordinateType::Unnormalized)
-                                   : itemType.getTextureInfo(TextureInfo::CoordinateType::Unnormalized);
-
-    QRect rect(info.window.x0, info.window.y0, info.window.x1, info.window.y1);
-    QImage *textureImage = GUIImageCache::getOrCreateQImageForTexture(info.getTexture());
-
-    QImage image = textureImage->copy(rect).flipped(Qt::Vertical);
-
-    if (rect.width() > 32 || rect.height() > 32)
-    {
-        image = image.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    }
-
-    return image;
+    return ThumbnailCache::global().get(itemType.id, subtype);
 }
 
 QImage GUIThingImage::getItemTypeImage(uint32_t serverId, uint8_t subtype)
@@ -310,12 +308,12 @@ QPixmap CreatureImageProvider::requestPixmap(const QString &id, QSize *size, con
     return QPixmap::fromImage(GUIThingImage::getCreatureTypeImage(*creatureType, static_cast<Direction>(direction)));
 }
 
-QPixmap ItemTypeImageProvider::requestPixmap(const QString &id, QSize *size, const QSize &requestedSize)
+QQuickImageResponse *ItemTypeImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
     // id is either 'serverId' or 'serverId:subtype'.
     auto parts = id.split(':');
 
-    uint32_t serverId;
+    uint32_t serverId = 0;
     uint8_t subtype = 1;
 
     bool success = false;
@@ -341,10 +339,40 @@ QPixmap ItemTypeImageProvider::requestPixmap(const QString &id, QSize *size, con
         }
     }
 
-    if (!(success && Items::items.validItemType(serverId)))
+    if (!success)
     {
-        return GUIImageCache::blackSquarePixmap();
+        // An invalid server ID gives a black square
+        serverId = 0;
     }
 
-    return QPixmap::fromImage(GUIThingImage::getItemTypeImage(serverId, subtype));
-}
\ No newline at end of file
+    return new ItemThumbnailResponse(serverId, subtype);
+}
+
+ItemThumbnailResponse::ItemThumbnailResponse(uint32_t serverId, uint8_t subtype)
+    : result(std::make_shared<Result>())
+{
+    result->response = this;
+
+    ThumbnailCache::global().request(serverId, subtype, [result = this->result](const QImage &image) {
+        std::lock_guard<std::mutex> lock(result->mutex);
+        result->image = image.isNull() ? blackSquareImage() : image;
+
+        // Queued, because the callback can be called before the response has been returned to the QML engine.
+        if (result->response)
+        {
+            QMetaObject::invokeMethod(result->response, &QQuickImageResponse::finished, Qt::QueuedConnection);
+        }
+    });
+}
+
+ItemThumbnailResponse::~ItemThumbnailResponse()
+{
+    std::lock_guard<std::mutex> lock(result->mutex);
+    result->response = nullptr;
+}
+
+QQuickTextureFactory *ItemThumbnailResponse::textureFactory() const
+{
+    std::lock_guard<std::mutex> lock(result->mutex);
+    return QQuickTextureFactory::textureFactoryForImage(result->image);
+}
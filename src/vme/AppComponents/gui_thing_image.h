@@ -2,6 +2,9 @@
 
 #include <memory>
 
+#include <mutex>
+
+#include <QImage>
 #include <QQuickImageProvider>
 #include <QRect>
 
@@ -63,13 +66,37 @@ class GUIThingImage
     static QtTextureArea getTextureArea();
 };
 
-class ItemTypeImageProvider : public QQuickImageProvider
+/*
+    Item images are served from the ThumbnailCache. They are generated on its background thread, so that scrolling
+    through large tilesets does not block the UI.
+*/
+class ItemTypeImageProvider : public QQuickAsyncImageProvider
 {
   public:
-    ItemTypeImageProvider()
-        : QQuickImageProvider(QQuickImageProvider::Pixmap) {}
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+};
 
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize) override;
+class ItemThumbnailResponse : public QQuickImageResponse
+{
+  public:
+    ItemThumbnailResponse(uint32_t serverId, uint8_t subtype);
+    ~ItemThumbnailResponse();
+
+    QQuickTextureFactory *textureFactory() const override;
+
+  private:
+    /*
+        The thumbnail can be finished on the ThumbnailCache thread after the response has been deleted (e.g. when
+        the image is no longer visible), so the result is shared with the ThumbnailCache callback.
+    */
+    struct Result
+    {
+        std::mutex mutex;
+        ItemThumbnailResponse *response;
+        QImage image;
+    };
+
+    std::shared_ptr<Result> result;
 };
 
 class CreatureImageProvider : public QQuickImageProvider
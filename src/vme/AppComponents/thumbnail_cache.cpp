@@ -0,0 +1,345 @@
+#include "thumbnail_cache.h"
+
+#include <algorithm>
+
+#include <QRect>
+#include <QString>
+
+#include "core/debug.h"
+#include "core/item_type.h"
+#include "core/items.h"
+#include "core/logger.h"
+
+ThumbnailCache::ThumbnailCache(size_t memoryBudgetBytes)
+    : memoryBudget(memoryBudgetBytes), worker(&ThumbnailCache::run, this) {}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAdded.notify_all();
+
+    worker.join();
+}
+
+ThumbnailCache &ThumbnailCache::global()
+{
+    static ThumbnailCache cache;
+    return cache;
+}
+
+uint64_t ThumbnailCache::cacheKey(uint32_t serverId, uint8_t subtype)
+{
+    // Subtypes 0 and 1 both use the default texture, so they share a thumbnail
+    uint8_t textureSubtype = subtype > 1 ? subtype : 0;
+    return (static_cast<uint64_t>(serverId) << 8) | textureSubtype;
+}
+
+std::optional<ThumbnailCache::Job> ThumbnailCache::createJob(uint32_t serverId, uint8_t subtype)
+{
+    if (!Items::items.validItemType(serverId))
+    {
+        return std::nullopt;
+    }
+
+    const ItemType *itemType = Items::items.getItemTypeByServerId(serverId);
+    TextureInfo info = subtype > 1 ? itemType->getTextureInfoForSubtype(subtype, TextureInfo::CoordinateType::Unnormalized)
+                                   : itemType->getTextureInfo(TextureInfo::CoordinateType::Unnormalized);
+
+    return Job{cacheKey(serverId, subtype), info.atlas, info.window};
+}
+
+void ThumbnailCache::setMemoryBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    memoryBudget = bytes;
+    evict();
+}
+
+void ThumbnailCache::setDiskCacheDirectory(const std::filesystem::path &directory)
+{
+    if (!directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error)
+        {
+            VME_LOG_ERROR("Could not create the thumbnail cache directory " << directory << ": " << error.message());
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    diskDirectory = directory;
+}
+
+size_t ThumbnailCache::memoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+QImage ThumbnailCache::get(uint32_t serverId, uint8_t subtype)
+{
+    uint64_t key = cacheKey(serverId, subtype);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (const QImage *image = findInMemory(key))
+        {
+            return *image;
+        }
+    }
+
+    QImage image = loadFromDisk(key);
+    if (image.isNull())
+    {
+        auto job = createJob(serverId, subtype);
+        if (!job)
+        {
+            return QImage();
+        }
+
+        job->atlas->readPixels([&image, &job](const std::vector<uint8_t> &pixels) {
+            image = createThumbnail(pixels, *job->atlas, job->window);
+        });
+
+        saveToDisk(key, image);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    insert(key, image);
+
+    return image;
+}
+
+void ThumbnailCache::request(uint32_t serverId, uint8_t subtype, Callback callback)
+{
+    uint64_t key = cacheKey(serverId, subtype);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (const QImage *image = findInMemory(key))
+    {
+        QImage result = *image;
+        lock.unlock();
+
+        callback(result);
+        return;
+    }
+
+    auto &callbacks = pendingCallbacks[key];
+    callbacks.emplace_back(std::move(callback));
+
+    // Already being generated
+    if (callbacks.size() > 1)
+    {
+        return;
+    }
+
+    auto job = createJob(serverId, subtype);
+    if (!job)
+    {
+        auto invalid = std::move(callbacks);
+        pendingCallbacks.erase(key);
+        lock.unlock();
+
+        for (auto &f : invalid)
+        {
+            f(QImage());
+        }
+        return;
+    }
+
+    jobs.emplace_back(*job);
+    lock.unlock();
+
+    jobAdded.notify_one();
+}
+
+void ThumbnailCache::run()
+{
+    std::vector<Job> batch;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAdded.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+            if (stopping)
+            {
+                return;
+            }
+
+            batch.swap(jobs);
+        }
+
+        process(batch);
+        batch.clear();
+    }
+}
+
+void ThumbnailCache::process(std::vector<Job> &batch)
+{
+    std::vector<std::pair<uint64_t, QImage>> results;
+    results.reserve(batch.size());
+
+    std::vector<Job> missing;
+    for (const auto &job : batch)
+    {
+        QImage image = loadFromDisk(job.key);
+        if (image.isNull())
+        {
+            missing.emplace_back(job);
+        }
+        else
+        {
+            results.emplace_back(job.key, std::move(image));
+        }
+    }
+
+    size_t firstGenerated = results.size();
+
+    // Thumbnails from the same atlas are created together so that each atlas is read (and possibly decompressed) only once.
+    std::sort(missing.begin(), missing.end(), [](const Job &a, const Job &b) { return a.atlas < b.atlas; });
+
+    auto it = missing.begin();
+    while (it != missing.end())
+    {
+        auto end = std::find_if(it, missing.end(), [atlas = it->atlas](const Job &job) { return job.atlas != atlas; });
+
+        it->atlas->readPixels([&results, it, end](const std::vector<uint8_t> &pixels) {
+            for (auto job = it; job != end; ++job)
+            {
+                results.emplace_back(job->key, createThumbnail(pixels, *job->atlas, job->window));
+            }
+        });
+
+        it = end;
+    }
+
+    for (size_t i = firstGenerated; i < results.size(); ++i)
+    {
+        saveToDisk(results[i].first, results[i].second);
+    }
+
+    std::vector<std::pair<std::vector<Callback>, QImage>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &[key, image] : results)
+        {
+            insert(key, image);
+
+            auto callbacks = pendingCallbacks.find(key);
+            if (callbacks != pendingCallbacks.end())
+            {
+                finished.emplace_back(std::move(callbacks.value()), image);
+                pendingCallbacks.erase(callbacks);
+            }
+        }
+    }
+
+    for (auto &[callbacks, image] : finished)
+    {
+        for (auto &callback : callbacks)
+        {
+            callback(image);
+        }
+    }
+}
+
+QImage ThumbnailCache::createThumbnail(const std::vector<uint8_t> &atlasPixels, const TextureAtlas &atlas, const TextureWindow &window)
+{
+    QImage atlasImage(atlasPixels.data(), atlas.width, atlas.height, atlas.width * 4, QImage::Format::Format_ARGB32);
+
+    // copy() detaches the sprite from 'atlasPixels', which might be a temporary buffer.
+    QImage sprite = atlasImage.copy(QRect(window.x0, window.y0, window.x1, window.y1)).flipped(Qt::Vertical);
+
+    if (sprite.width() > ThumbnailSize || sprite.height() > ThumbnailSize)
+    {
+        sprite = sprite.scaled(ThumbnailSize, ThumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    return sprite;
+}
+
+const QImage *ThumbnailCache::findInMemory(uint64_t key)
+{
+    auto found = thumbnails.find(key);
+    if (found == thumbnails.end())
+    {
+        return nullptr;
+    }
+
+    Entry &entry = found.value();
+    lru.splice(lru.begin(), lru, entry.lruPosition);
+
+    return &entry.image;
+}
+
+void ThumbnailCache::insert(uint64_t key, const QImage &image)
+{
+    if (thumbnails.find(key) != thumbnails.end())
+    {
+        return;
+    }
+
+    lru.emplace_front(key);
+    thumbnails.try_emplace(key, Entry{image, lru.begin()});
+    usedBytes += image.sizeInBytes();
+
+    evict();
+}
+
+void ThumbnailCache::evict()
+{
+    while (usedBytes > memoryBudget && !lru.empty())
+    {
+        auto found = thumbnails.find(lru.back());
+        DEBUG_ASSERT(found != thumbnails.end(), "Thumbnail in LRU list but not in the cache.");
+
+        usedBytes -= found->second.image.sizeInBytes();
+        thumbnails.erase(found);
+        lru.pop_back();
+    }
+}
+
+std::filesystem::path ThumbnailCache::diskPath(uint64_t key) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (diskDirectory.empty())
+    {
+        return {};
+    }
+
+    return diskDirectory / std::format("{}_{}.png", key >> 8, key & 0xFF);
+}
+
+QImage ThumbnailCache::loadFromDisk(uint64_t key) const
+{
+    auto path = diskPath(key);
+    if (path.empty() || !std::filesystem::exists(path))
+    {
+        return QImage();
+    }
+
+    QImage image;
+    image.load(QString::fromStdString(path.string()), "PNG");
+
+    return image.convertToFormat(QImage::Format::Format_ARGB32);
+}
+
+void ThumbnailCache::saveToDisk(uint64_t key, const QImage &image) const
+{
+    auto path = diskPath(key);
+    if (path.empty() || image.isNull())
+    {
+        return;
+    }
+
+    if (!image.save(QString::fromStdString(path.string()), "PNG"))
+    {
+        VME_LOG_ERROR("Could not write thumbnail " << path);
+    }
+}
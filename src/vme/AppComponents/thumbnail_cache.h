@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <QImage>
+
+#include "core/graphics/texture_atlas.h"
+#include "core/util.h"
+
+/*
+    Cache of item thumbnails (at most 32x32 pixels) for the item palette and other UI.
+
+    A thumbnail only needs a single sprite tile, so the tiles are read with TextureAtlas::readPixels, which does
+    not keep the atlases decompressed. Thumbnails are generated on a background thread and kept in memory up to a
+    byte budget (least recently used thumbnails are evicted first). They can optionally be stored on disk as well,
+    so that later sessions do not need to decompress any atlas to show the palettes.
+*/
+class ThumbnailCache
+{
+  public:
+    using Callback = std::function<void(const QImage &image)>;
+
+    static constexpr size_t DefaultMemoryBudgetBytes = 16 * 1024 * 1024;
+    static constexpr int ThumbnailSize = 32;
+
+    ThumbnailCache(size_t memoryBudgetBytes = DefaultMemoryBudgetBytes);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache &other) = delete;
+    ThumbnailCache &operator=(const ThumbnailCache &other) = delete;
+
+    static ThumbnailCache &global();
+
+    void setMemoryBudget(size_t bytes);
+
+    /*
+        Also store thumbnails as PNG files in 'directory'. An empty path disables the disk cache.
+        NOTE: Thumbnails on disk are never invalidated, so the directory must be specific to the client version.
+    */
+    void setDiskCacheDirectory(const std::filesystem::path &directory);
+
+    /*
+        Returns the thumbnail, generating it on the calling thread if it is not cached.
+        Returns a null QImage if the server ID is not a valid item type.
+    */
+    QImage get(uint32_t serverId, uint8_t subtype = 0);
+
+    /*
+        Calls 'callback' with the thumbnail. If the thumbnail is in memory, the callback is called immediately.
+        Otherwise it is called from the background thread once the thumbnail has been generated.
+    */
+    void request(uint32_t serverId, uint8_t subtype, Callback callback);
+
+    size_t memoryUsage() const;
+
+    /*
+        Extracts the sprite at 'window' (unnormalized) from the pixels of 'atlas' and scales it down to fit in
+        ThumbnailSize x ThumbnailSize.
+    */
+    static QImage createThumbnail(const std::vector<uint8_t> &atlasPixels, const TextureAtlas &atlas, const TextureWindow &window);
+
+  private:
+    struct Job
+    {
+        uint64_t key;
+        const TextureAtlas *atlas;
+        TextureWindow window;
+    };
+
+    struct Entry
+    {
+        QImage image;
+        std::list<uint64_t>::iterator lruPosition;
+    };
+
+    static uint64_t cacheKey(uint32_t serverId, uint8_t subtype);
+    static std::optional<Job> createJob(uint32_t serverId, uint8_t subtype);
+
+    // These require 'mutex' to be held.
+    const QImage *findInMemory(uint64_t key);
+    void insert(uint64_t key, const QImage &image);
+    void evict();
+
+    std::filesystem::path diskPath(uint64_t key) const;
+    QImage loadFromDisk(uint64_t key) const;
+    void saveToDisk(uint64_t key, const QImage &image) const;
+
+    void run();
+    void process(std::vector<Job> &batch);
+
+    mutable std::mutex mutex;
+    std::condition_variable jobAdded;
+
+    std::vector<Job> jobs;
+    vme_unordered_map<uint64_t, std::vector<Callback>> pendingCallbacks;
+
+    vme_unordered_map<uint64_t, Entry> thumbnails;
+    // Most recently used first
+    std::list<uint64_t> lru;
+
+    size_t memoryBudget;
+    size_t usedBytes = 0;
+
+    std::filesystem::path diskDirectory;
+
+    bool stopping = false;
+    std::thread worker;
+};
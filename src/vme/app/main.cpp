@@ -10,6 +10,7 @@
 #include <QQmlApplicationEngine>
 #include <QQuickStyle>
 #include <QQuickWindow>
+#include <QStandardPaths>
 #include <QString>
 #include <QVariant>
 
@@ -25,8 +26,10 @@
 #include "core/item_palette.h"
 #include "core/items.h"
 #include "core/random.h"
+#include "core/settings.h"
 #include "core/time_util.h"
 #include "gui_thing_image.h"
+#include "thumbnail_cache.h"
 
 #include <QtQml/qqmlextensionplugin.h>
 Q_IMPORT_QML_PLUGIN(AppComponentsPlugin)
@@ -170,6 +173,12 @@ int main(int argc, char **argv)
 
     MainApp app(argc, argv);
 
+    if (Settings::CACHE_THUMBNAILS_ON_DISK)
+    {
+        std::filesystem::path cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString();
+        ThumbnailCache::global().setDiskCacheDirectory(cacheLocation / "thumbnails" / version);
+    }
+
     return app.start();
 }
 
@@ -0,0 +1,82 @@
+#include "alias_table.h"
+
+#include "debug.h"
+
+namespace
+{
+    // numerator / denominator * 2^32 for numerator < denominator, by long division so that nothing overflows.
+    uint64_t fraction32(uint64_t numerator, uint64_t denominator)
+    {
+        uint64_t result = 0;
+        for (int bit = 0; bit < 32; ++bit)
+        {
+            numerator <<= 1;
+            result <<= 1;
+            if (numerator >= denominator)
+            {
+                numerator -= denominator;
+                result |= 1;
+            }
+        }
+
+        return result;
+    }
+} // namespace
+
+AliasTable::AliasTable(const std::vector<uint32_t> &weights)
+{
+    const size_t count = weights.size();
+    columns.resize(count, Column{uint64_t(1) << 32, 0});
+
+    uint64_t totalWeight = 0;
+    for (uint32_t weight : weights)
+    {
+        totalWeight += weight;
+    }
+
+    if (count == 0 || totalWeight == 0)
+    {
+        DEBUG_ASSERT(count == 0, "An AliasTable needs a positive total weight.");
+        columns.clear();
+        return;
+    }
+
+    // Scaled so that the average column has exactly 'totalWeight'
+    std::vector<uint64_t> scaled(count);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        scaled[i] = static_cast<uint64_t>(weights[i]) * count;
+        (scaled[i] < totalWeight ? small : large).emplace_back(i);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        uint32_t less = small.back();
+        small.pop_back();
+        uint32_t more = large.back();
+
+        columns[less].threshold = fraction32(scaled[less], totalWeight);
+        columns[less].alias = more;
+
+        // The large index gives the rest of the column to the small one
+        scaled[more] -= totalWeight - scaled[less];
+        if (scaled[more] < totalWeight)
+        {
+            large.pop_back();
+            small.emplace_back(more);
+        }
+    }
+
+    // The remaining columns are full (up to rounding)
+    for (uint32_t i : small)
+    {
+        columns[i] = Column{uint64_t(1) << 32, i};
+    }
+    for (uint32_t i : large)
+    {
+        columns[i] = Column{uint64_t(1) << 32, i};
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/*
+    Samples an index with probability proportional to its weight in constant time (Walker's alias method, built
+    with Vose's algorithm). Every index has a column; a random number picks a column, and then either the column's
+    index or its alias.
+
+    The build uses integer arithmetic, so the table is exact up to 2^-32 per column and the same on every platform.
+*/
+class AliasTable
+{
+  public:
+    AliasTable() = default;
+    explicit AliasTable(const std::vector<uint32_t> &weights);
+
+    /*
+        An index for the 64 random bits in 'random' (see CounterRandom). The upper 32 bits pick the column and the
+        lower 32 bits decide between the column and its alias.
+    */
+    uint32_t sample(uint64_t random) const noexcept
+    {
+        auto column = static_cast<uint32_t>(((random >> 32) * columns.size()) >> 32);
+        auto fraction = static_cast<uint32_t>(random);
+
+        const Column &entry = columns[column];
+        return fraction < entry.threshold ? column : entry.alias;
+    }
+
+    size_t size() const noexcept
+    {
+        return columns.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return columns.empty();
+    }
+
+  private:
+    struct Column
+    {
+        // The probability of the column's own index, times 2^32
+        uint64_t threshold;
+        uint32_t alias;
+    };
+
+    std::vector<Column> columns;
+};
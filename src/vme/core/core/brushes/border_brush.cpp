@@ -171,8 +171,7 @@ void BorderBrush::apply(MapView &mapView, const Position &position)
         return;
     }
 
-    const Map &map = *mapView.map();
-    BorderNeighborMap neighbors(position, this, map);
+    BorderNeighborMap neighbors = neighborsAt(mapView, position);
 
     std::string dirName = "None";
 
@@ -235,6 +234,8 @@ void BorderBrush::apply(MapView &mapView, const Position &position)
     {
         quadrantChanged(mapView, position, neighbors, tileInfo.borderStartQuadrant, *mouseQuadrant);
     }
+
+    endNeighborChanges(position);
 }
 
 void BorderBrush::quadrantChangeInFirstTile(TileCover cover, TileCover &nextCover, TileQuadrant prevQuadrant, TileQuadrant currQuadrant)
@@ -314,10 +315,11 @@ void BorderBrush::quadrantChangeInFirstTile(TileCover cover, TileCover &nextCove
 
 void BorderBrush::quadrantChanged(MapView &mapView, const Position &position, TileQuadrant prevQuadrant, TileQuadrant currQuadrant)
 {
-    const Map &map = *mapView.map();
-    BorderNeighborMap neighbors(position, this, map);
+    BorderNeighborMap neighbors = neighborsAt(mapView, position);
 
     quadrantChanged(mapView, position, neighbors, prevQuadrant, currQuadrant);
+
+    endNeighborChanges(position);
 }
 
 void BorderBrush::quadrantChanged(MapView &mapView, const Position &position, BorderNeighborMap &neighbors, TileQuadrant prevQuadrant, TileQuadrant currQuadrant)
@@ -337,6 +339,27 @@ void BorderBrush::quadrantChanged(MapView &mapView, const Position &position, Bo
     tileInfo.quadrant = currQuadrant;
 }
 
+BorderNeighborMap BorderBrush::neighborsAt(MapView &mapView, const Position &position)
+{
+    const Map &map = *mapView.map();
+    neighborCache.validate(&map, MapHistory::History::revision());
+
+    // While dragging, only the tiles that are new to the 5x5 area or that the last apply changed are read.
+    neighborCache.moveTo(position, [this, &map](const Position &pos) {
+        const Tile *tile = map.getTile(pos);
+        return tile ? tile->getTileCover(this) : TILE_COVER_NONE;
+    });
+
+    return BorderNeighborMap(this, neighborCache);
+}
+
+void BorderBrush::endNeighborChanges(const Position &position)
+{
+    // Fixing borders only changes the 3x3 area around the position
+    neighborCache.invalidate(position, 1);
+    neighborCache.setRevision(MapHistory::History::revision());
+}
+
 void BorderBrush::updateCenter(BorderNeighborMap &neighbors)
 {
     using namespace TileCoverShortHands;
@@ -943,6 +966,23 @@ BorderNeighborMap::BorderNeighborMap(const Position &position, BorderBrush *brus
     }
 }
 
+BorderNeighborMap::BorderNeighborMap(BorderBrush *brush, const SlidingNeighborCache<TileCover> &cache)
+{
+    for (int dy = -2; dy <= 2; ++dy)
+    {
+        for (int dx = -2; dx <= 2; ++dx)
+        {
+            TileQuadrant quadrant = brush->getNeighborQuadrant(dx, dy);
+            TileCover tileCover = TileCovers::unifyTileCover(cache.at(dx, dy), quadrant);
+
+            auto diagonals = tileCover & TileCovers::Diagonals;
+            DEBUG_ASSERT((diagonals == TileCovers::None) || TileCovers::exactlyOneSet(diagonals & TileCovers::Diagonals), "Preferred diagonal must be None or have exactly one diagonal set.");
+
+            set(dx, dy, tileCover);
+        }
+    }
+}
+
 TileCover BorderNeighborMap::getTileCoverAt(BorderBrush *brush, const Map &map, const Position position) const
 {
     Tile *tile = map.getTile(position);
@@ -9,6 +9,7 @@
 #include "../tile_cover.h"
 #include "border_brush_variation.h"
 #include "brush.h"
+#include "sliding_neighbor_cache.h"
 
 struct Position;
 class MapView;
@@ -138,6 +139,8 @@ struct BorderRule
 struct BorderNeighborMap
 {
     BorderNeighborMap(const Position &position, BorderBrush *brush, const Map &map);
+    // From the covers of 'cache' (see Tile::getTileCover(const BorderBrush *)), like reading them from the map.
+    BorderNeighborMap(BorderBrush *brush, const SlidingNeighborCache<TileCover> &cache);
     [[nodiscard]] TileCover at(int x, int y) const;
     TileCover &at(int x, int y);
     TileCover &center();
@@ -147,7 +150,7 @@ struct BorderNeighborMap
     bool hasExpandedCover() const noexcept;
     void addExpandedCover(int x, int y);
 
-    std::vector<ExpandedTileBlock> expandedCovers;
+    ExpandedTileBlocks expandedCovers;
 
   private:
     int index(int x, int y) const;
@@ -244,6 +247,13 @@ class BorderBrush final : public Brush
 
     void quadrantChanged(MapView &mapView, const Position &position, BorderNeighborMap &neighbors, TileQuadrant prevQuadrant, TileQuadrant currQuadrant);
 
+    /*
+        The neighbors of 'position', read through neighborCache. endNeighborChanges must be called after changing
+        the map around the position.
+    */
+    BorderNeighborMap neighborsAt(MapView &mapView, const Position &position);
+    void endNeighborChanges(const Position &position);
+
     bool presentAt(const Map &map, Position position) const;
     uint32_t borderItemAt(const Map &map, Position position) const;
 
@@ -263,6 +273,9 @@ class BorderBrush final : public Brush
 
     std::vector<uint32_t> sortedServerIds;
 
+    // The covers of this brush around the last position that it was applied to
+    SlidingNeighborCache<TileCover> neighborCache;
+
     std::string id;
     uint32_t _iconServerId;
 
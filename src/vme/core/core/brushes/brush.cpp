@@ -1,5 +1,6 @@
 #include "brush.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "../items.h"
@@ -15,16 +16,6 @@
 #include "wall_brush.h"
 
 
-std::unordered_set<Position> CircularBrushShape::Size3x3 = {
-    Position(1, 0, 0),
-
-    Position(0, 1, 0),
-    Position(1, 1, 0),
-    Position(2, 1, 0),
-
-    Position(1, 2, 0),
-};
-
 Brush::Brush(std::string name)
     : _name(std::move(name)) {}
 
@@ -53,6 +44,11 @@ void Brush::applyWithoutBorderize(MapView &mapView, const Position &position)
     apply(mapView, position);
 }
 
+void Brush::applyArea(MapView &mapView, const BrushFootprint &area, int z)
+{
+    area.forEachPosition(z, [this, &mapView](const Position &position) { apply(mapView, position); });
+}
+
 int Brush::variationCount() const
 {
     return 1;
@@ -71,36 +67,53 @@ DrawItemType::DrawItemType(ItemType *itemType, Position relativePosition)
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>
 
-RectangularBrushShape::RectangularBrushShape(uint16_t width, uint16_t height)
-    : width(width), height(height) {}
+BrushShape::BrushShape(BrushFootprint &&footprint)
+    : _footprint(std::move(footprint)) {}
 
-std::unordered_set<Position> RectangularBrushShape::getRelativePositions() const noexcept
+std::unordered_set<Position> BrushShape::getRelativePositions() const noexcept
 {
-    int minX = -width / 2;
-    int maxX = width / 2;
-
-    int minY = -height / 2;
-    int maxY = height / 2;
-
     std::unordered_set<Position> positions;
-    for (int y = minY; y < maxY; ++y)
-    {
-        for (int x = minX; x < maxX; ++x)
-        {
-            positions.emplace(Position(x, y, 0));
-        }
-    }
+    positions.reserve(_footprint.size());
+    _footprint.forEachPosition(0, [&positions](const Position &position) { positions.emplace(position); });
 
     return positions;
 }
 
+RectangularBrushShape::RectangularBrushShape(uint16_t width, uint16_t height)
+    : BrushShape(createFootprint(width, height)), width(width), height(height) {}
+
+BrushFootprint RectangularBrushShape::createFootprint(uint16_t width, uint16_t height)
+{
+    int w = std::max<int>(width, 1);
+    int h = std::max<int>(height, 1);
+
+    // Centered on the brush position. Even sizes extend one more tile to the right and bottom.
+    int minX = -(w - 1) / 2;
+    int minY = -(h - 1) / 2;
+
+    return BrushFootprint::rectangle(minX, minY, minX + w - 1, minY + h - 1);
+}
+
 CircularBrushShape::CircularBrushShape(uint16_t radius)
-    : radius(radius) {}
+    : BrushShape(createFootprint(radius)), radius(radius) {}
 
-std::unordered_set<Position> CircularBrushShape::getRelativePositions() const noexcept
+BrushFootprint CircularBrushShape::createFootprint(uint16_t radius)
 {
-    // TODO implement other sizes
-    return Size3x3;
+    // The tiles whose center is within 'radius' of the center of the brush position
+    int r = radius;
+
+    std::vector<BrushFootprint::Span> spans;
+    for (int y = -r; y <= r; ++y)
+    {
+        int halfWidth = 0;
+        while ((halfWidth + 1) * (halfWidth + 1) + y * y <= r * r)
+        {
+            ++halfWidth;
+        }
+        spans.emplace_back(BrushFootprint::Span{y, -halfWidth, halfWidth});
+    }
+
+    return BrushFootprint(std::move(spans));
 }
 
 Brush::LazyGround::LazyGround(GroundBrush *brush)
@@ -8,6 +8,8 @@
 #include "../creature.h"
 #include "../lazy_object.h"
 #include "../position.h"
+#include "../small_vector.h"
+#include "brush_footprint.h"
 
 struct Position;
 class Tileset;
@@ -19,20 +21,36 @@ class GroundBrush;
 class ItemType;
 class Brush;
 
+/*
+    The footprint of a shape is computed once, when the shape is created for a size.
+*/
 class BrushShape
 {
   public:
     virtual ~BrushShape() = default;
-    [[nodiscard]] virtual std::unordered_set<Position> getRelativePositions() const noexcept = 0;
+    [[nodiscard]] std::unordered_set<Position> getRelativePositions() const noexcept;
+
+    // The positions relative to the brush position
+    const BrushFootprint &footprint() const noexcept
+    {
+        return _footprint;
+    }
+
+  protected:
+    BrushShape(BrushFootprint &&footprint);
+
+  private:
+    BrushFootprint _footprint;
 };
 
 class RectangularBrushShape : public BrushShape
 {
   public:
     RectangularBrushShape(uint16_t width, uint16_t height);
-    std::unordered_set<Position> getRelativePositions() const noexcept override;
 
   private:
+    static BrushFootprint createFootprint(uint16_t width, uint16_t height);
+
     uint16_t width;
     uint16_t height;
 };
@@ -41,10 +59,10 @@ class CircularBrushShape : public BrushShape
 {
   public:
     CircularBrushShape(uint16_t radius);
-    std::unordered_set<Position> getRelativePositions() const noexcept override;
 
   private:
-    static std::unordered_set<Position> Size3x3;
+    static BrushFootprint createFootprint(uint16_t radius);
+
     uint16_t radius;
 };
 
@@ -54,6 +72,9 @@ struct ExpandedTileBlock
     int y = 0;
 };
 
+// At most the 3x3 area around the brush position is expanded.
+using ExpandedTileBlocks = SmallVector<ExpandedTileBlock, 9>;
+
 enum class BrushType
 {
     Creature,
@@ -122,6 +143,12 @@ class Brush
     virtual void apply(MapView &mapView, const Position &position) = 0;
     virtual void erase(MapView &mapView, const Position &position) = 0;
 
+    /*
+        Applies the brush to every position of 'area' (absolute positions on floor 'z') as one batch. By default,
+        the brush is applied to one position at a time. 'area' must be within the map.
+    */
+    virtual void applyArea(MapView &mapView, const BrushFootprint &area, int z);
+
     [[nodiscard]] virtual std::string getDisplayId() const = 0;
 
     const std::string &name() const noexcept;
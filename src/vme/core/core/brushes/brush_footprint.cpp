@@ -0,0 +1,146 @@
+#include "brush_footprint.h"
+
+#include <algorithm>
+#include <utility>
+
+BrushFootprint::BrushFootprint(std::vector<Span> &&spans)
+    : _spans(std::move(spans))
+{
+    normalize();
+}
+
+BrushFootprint BrushFootprint::rectangle(int fromX, int fromY, int toX, int toY)
+{
+    std::vector<Span> spans;
+    if (fromX <= toX)
+    {
+        spans.reserve(std::max(toY - fromY + 1, 0));
+        for (int y = fromY; y <= toY; ++y)
+        {
+            spans.emplace_back(Span{y, fromX, toX});
+        }
+    }
+
+    return BrushFootprint(std::move(spans));
+}
+
+BrushFootprint BrushFootprint::sweep(const std::vector<Position> &path) const
+{
+    std::vector<Span> spans;
+    spans.reserve(_spans.size() * path.size());
+
+    for (const Position &position : path)
+    {
+        for (const Span &span : _spans)
+        {
+            spans.emplace_back(Span{span.y + position.y, span.fromX + position.x, span.toX + position.x});
+        }
+    }
+
+    return BrushFootprint(std::move(spans));
+}
+
+BrushFootprint BrushFootprint::expanded(int radius) const
+{
+    std::vector<Span> spans;
+    spans.reserve(_spans.size() * (2 * radius + 1));
+
+    for (const Span &span : _spans)
+    {
+        for (int dy = -radius; dy <= radius; ++dy)
+        {
+            spans.emplace_back(Span{span.y + dy, span.fromX - radius, span.toX + radius});
+        }
+    }
+
+    return BrushFootprint(std::move(spans));
+}
+
+BrushFootprint BrushFootprint::clipped(int fromX, int fromY, int toX, int toY) const
+{
+    std::vector<Span> spans;
+    spans.reserve(_spans.size());
+
+    for (const Span &span : _spans)
+    {
+        if (span.y < fromY || span.y > toY)
+            continue;
+
+        Span clippedSpan{span.y, std::max(span.fromX, fromX), std::min(span.toX, toX)};
+        if (clippedSpan.fromX <= clippedSpan.toX)
+        {
+            spans.emplace_back(clippedSpan);
+        }
+    }
+
+    return BrushFootprint(std::move(spans));
+}
+
+bool BrushFootprint::contains(int x, int y) const
+{
+    if (_spans.empty() || y < _minY || y > _maxY || x < _minX || x > _maxX)
+        return false;
+
+    auto row = static_cast<size_t>(y - _minY);
+    auto first = _spans.begin() + rowStarts[row];
+    auto last = _spans.begin() + rowStarts[row + 1];
+
+    // The first span that ends at or after x
+    auto found = std::lower_bound(first, last, x, [](const Span &span, int x) { return span.toX < x; });
+    return found != last && found->fromX <= x;
+}
+
+void BrushFootprint::normalize()
+{
+    std::sort(_spans.begin(), _spans.end(), [](const Span &lhs, const Span &rhs) {
+        return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.fromX < rhs.fromX);
+    });
+
+    // Merge the spans of a row that overlap or touch
+    size_t count = 0;
+    for (const Span &span : _spans)
+    {
+        if (count > 0)
+        {
+            Span &previous = _spans[count - 1];
+            if (previous.y == span.y && span.fromX <= previous.toX + 1)
+            {
+                previous.toX = std::max(previous.toX, span.toX);
+                continue;
+            }
+        }
+
+        _spans[count++] = span;
+    }
+    _spans.resize(count);
+
+    _size = 0;
+    rowStarts.clear();
+
+    if (_spans.empty())
+        return;
+
+    _minY = _spans.front().y;
+    _maxY = _spans.back().y;
+    _minX = _spans.front().fromX;
+    _maxX = _spans.front().toX;
+
+    rowStarts.resize(static_cast<size_t>(_maxY - _minY) + 2, 0);
+
+    uint32_t index = 0;
+    for (int y = _minY; y <= _maxY + 1; ++y)
+    {
+        while (index < _spans.size() && _spans[index].y < y)
+        {
+            ++index;
+        }
+        rowStarts[y - _minY] = index;
+    }
+
+    for (const Span &span : _spans)
+    {
+        _minX = std::min(_minX, span.fromX);
+        _maxX = std::max(_maxX, span.toX);
+        _size += static_cast<size_t>(span.toX - span.fromX + 1);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "../position.h"
+
+/*
+    A set of tiles on one floor, stored as inclusive x-spans per row. The spans are sorted by row and then by x,
+    and the spans of a row do not touch.
+
+    Brush shapes keep their footprint relative to the brush position (see BrushShape::footprint). Translating it
+    along the path of the mouse gives the area that a brush covers between two mouse samples (see sweep), which
+    can be applied as one batch (see Brush::applyArea).
+*/
+class BrushFootprint
+{
+  public:
+    struct Span
+    {
+        int y;
+        int fromX;
+        int toX;
+    };
+
+    BrushFootprint() = default;
+    // The spans may be in any order and may overlap.
+    explicit BrushFootprint(std::vector<Span> &&spans);
+
+    static BrushFootprint rectangle(int fromX, int fromY, int toX, int toY);
+
+    // The union of this footprint placed at every position of 'path', in absolute positions.
+    BrushFootprint sweep(const std::vector<Position> &path) const;
+
+    // Every tile within 'radius' (in both x and y) of a tile of the footprint.
+    BrushFootprint expanded(int radius) const;
+
+    // The part of the footprint inside the rectangle [fromX, toX] x [fromY, toY].
+    BrushFootprint clipped(int fromX, int fromY, int toX, int toY) const;
+
+    bool contains(int x, int y) const;
+
+    template <typename F>
+    void forEachPosition(int z, F &&f) const;
+
+    const std::vector<Span> &spans() const noexcept
+    {
+        return _spans;
+    }
+
+    bool empty() const noexcept
+    {
+        return _spans.empty();
+    }
+
+    // The number of tiles
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    // The bounding box. Only valid if the footprint is not empty.
+    int minX() const noexcept
+    {
+        return _minX;
+    }
+
+    int maxX() const noexcept
+    {
+        return _maxX;
+    }
+
+    int minY() const noexcept
+    {
+        return _minY;
+    }
+
+    int maxY() const noexcept
+    {
+        return _maxY;
+    }
+
+  private:
+    // Sorts and merges the spans, and builds the row index.
+    void normalize();
+
+    std::vector<Span> _spans;
+    // The index of the first span of every row from minY to maxY, followed by the number of spans.
+    std::vector<uint32_t> rowStarts;
+
+    size_t _size = 0;
+
+    int _minX = 0;
+    int _maxX = 0;
+    int _minY = 0;
+    int _maxY = 0;
+};
+
+template <typename F>
+void BrushFootprint::forEachPosition(int z, F &&f) const
+{
+    for (const Span &span : _spans)
+    {
+        for (int x = span.fromX; x <= span.toX; ++x)
+        {
+            f(Position(x, span.y, z));
+        }
+    }
+}
@@ -9,6 +9,7 @@
 #include "../item_palette.h"
 #include "../items.h"
 #include "../logger.h"
+#include "../tile_cover.h"
 #include "../time_util.h"
 #include "border_brush.h"
 #include "brush.h"
@@ -188,6 +189,9 @@ bool BrushLoader::load(std::filesystem::path path)
         if (!brushes.is_null())
         {
             parseBrushes(brushes);
+
+            // Build the border lookup tables up front instead of on the first brush stroke.
+            TileCovers::initializeLookupTables();
         }
 
         auto tilesets = asArray(rootJson, "tilesets");
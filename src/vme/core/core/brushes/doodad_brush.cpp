@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -13,6 +14,7 @@
 #include "../random.h"
 #include "../tile.h"
 #include "brushes.h"
+#include "occupancy_grid.h"
 
 using DoodadAlternative = DoodadBrush::DoodadAlternative;
 using DoodadSingle = DoodadBrush::DoodadSingle;
@@ -22,6 +24,18 @@ namespace
 {
     constexpr float DefaultThickness = 0.25;
     constexpr int MaxPreviewRetries = 5;
+
+    // The tiles of an entry. A single is stored in 'single'.
+    std::span<const DoodadBrush::CompositeTile> entryTiles(const DoodadBrush::DoodadEntry &entry, DoodadBrush::CompositeTile &single)
+    {
+        if (entry.type == DoodadBrush::EntryType::Composite)
+        {
+            return static_cast<const DoodadComposite &>(entry).tiles;
+        }
+
+        single.serverId = static_cast<const DoodadSingle &>(entry).serverId;
+        return std::span<const DoodadBrush::CompositeTile>(&single, 1);
+    }
 } // namespace
 
 DoodadBrush::DoodadBrush(std::string id, const std::string &name, DoodadAlternative &&alternative, uint32_t iconServerId)
@@ -160,6 +174,115 @@ void DoodadBrush::apply(MapView &mapView, const Position &position)
     updatePreview(alternateIndex);
 }
 
+void DoodadBrush::applyInRegion(MapView &mapView, const Position &from, const Position &to)
+{
+    applyInRegion(mapView, from, to, thickness);
+}
+
+void DoodadBrush::applyInRegion(MapView &mapView, const Position &from, const Position &to, float density)
+{
+    const Map &map = *mapView.map();
+
+    MapArea area(map, from, to);
+    if (area.empty || alternatives.empty())
+        return;
+
+    const DoodadAlternative &alternative = alternatives.at(util::modulo(mapView.getBrushVariation(), alternatives.size()));
+    if (alternative.choices.empty())
+        return;
+
+    // Every tile is read from the map at most once. A tile is taken if the map blocks it or if a doodad was placed on it.
+    OccupancyGrid checked;
+    OccupancyGrid taken;
+
+    auto isTaken = [&](const Position &position) {
+        if (!checked.test(position))
+        {
+            checked.set(position);
+
+            // Same checks as apply: MapView::addItem places on positions without a tile, but not on tiles with a
+            // blocking item or without a ground (see Tile::hasBlockingItem). prepareApply blocks tiles that already
+            // have this doodad, or removes this doodad before the check when replacing it.
+            const Tile *tile = map.getTile(position);
+            bool blocked = false;
+            if (tile)
+            {
+                auto ownItem = [this](const Item &item) { return item.itemType->brush() == this; };
+                if (replaceBehavior == ReplaceBehavior::Replace)
+                {
+                    const Item *ground = tile->ground();
+                    blocked = !ground || ground->itemType->isBlocking() || std::ranges::any_of(tile->items(), [&ownItem](const std::shared_ptr<Item> &item) {
+                                  return item->itemType->isBlocking() && !ownItem(*item);
+                              });
+                }
+                else
+                {
+                    blocked = tile->hasBlockingItem() || (replaceBehavior == ReplaceBehavior::Block && tile->containsItem(ownItem));
+                }
+            }
+
+            if (blocked)
+            {
+                taken.set(position);
+            }
+        }
+
+        return taken.test(position);
+    };
+
+    MapHistory::Action action(MapHistory::ActionType::SetTile);
+    CompositeTile single;
+
+    for (const Position &position : area)
+    {
+        // Skip positions based on density, like updatePreview
+        if (Random::global().nextDouble() > density)
+            continue;
+
+        for (int retry = 0; retry < MaxPreviewRetries; ++retry)
+        {
+            auto tiles = entryTiles(*alternative.sampleEntry(_name), single);
+
+            bool fits = std::ranges::all_of(tiles, [&](const CompositeTile &tile) {
+                Position pos = position + tile.relativePosition();
+                return mapView.isValidPos(pos) && !isTaken(pos);
+            });
+
+            if (!fits)
+                continue;
+
+            for (const CompositeTile &tile : tiles)
+            {
+                Position pos = position + tile.relativePosition();
+
+                // The first item of this call on the tile replaces the doodads that were there
+                const Tile *mapTile = map.getTile(pos);
+                if (replaceBehavior == ReplaceBehavior::Replace && !taken.test(pos) && mapTile)
+                {
+                    const auto &items = mapTile->items();
+                    for (size_t index = items.size(); index-- > 0;)
+                    {
+                        if (items[index]->itemType->brush() == this)
+                        {
+                            action.addChange(MapHistory::TileDelta::removeItem(pos, static_cast<uint16_t>(index)));
+                        }
+                    }
+                }
+
+                taken.set(pos);
+                action.addChange(MapHistory::TileDelta::addItem(pos, Item(tile.serverId)));
+            }
+
+            break;
+        }
+    }
+
+    if (!action.changes.empty())
+    {
+        mapView.history.commit(std::move(action));
+    }
+}
+
 uint32_t DoodadBrush::iconServerId() const
 {
     return _iconServerId;
@@ -235,48 +358,47 @@ DoodadAlternative::DoodadAlternative(std::vector<std::unique_ptr<DoodadEntry>> &
     }
 }
 
-std::vector<ItemPreviewInfo> DoodadAlternative::sample(const std::string &brushName) const
+const DoodadBrush::DoodadEntry *DoodadAlternative::sampleEntry(const std::string &brushName) const
 {
-    std::vector<ItemPreviewInfo> result{};
-    if (choices.empty())
-        return result;
-
     uint32_t weight = Random::global().nextInt<uint32_t>(static_cast<uint32_t>(0), totalWeight);
 
-    DoodadEntry *found;
-
     for (const auto &entry : choices)
     {
         if (weight < entry->weight)
         {
-            found = entry.get();
-            break;
+            return entry.get();
         }
     }
 
-    if (found == nullptr)
-    {
-        // If we get here, something is off with `weight` for some entry or with `totalWeight`.
-        VME_LOG_ERROR(
-            "[GroundBrush::nextServerId] Brush " << brushName
-                                                 << ": Could not find matching weight for randomly generated weight "
-                                                 << weight << " (totalWeight: " << totalWeight << ".");
-
-        // No match in for-loop. Use the first entry.
-        found = choices.at(0).get();
-    }
+    // If we get here, something is off with `weight` for some entry or with `totalWeight`.
+    VME_LOG_ERROR(
+        "[GroundBrush::nextServerId] Brush " << brushName
+                                             << ": Could not find matching weight for randomly generated weight "
+                                             << weight << " (totalWeight: " << totalWeight << ".");
+
+    // No match in for-loop. Use the first entry.
+    return choices.at(0).get();
+}
+
+std::vector<ItemPreviewInfo> DoodadAlternative::sample(const std::string &brushName) const
+{
+    std::vector<ItemPreviewInfo> result{};
+    if (choices.empty())
+        return result;
+
+    const DoodadEntry *found = sampleEntry(brushName);
 
     switch (found->type)
     {
         case EntryType::Single:
         {
-            auto *single = static_cast<DoodadSingle *>(found);
+            auto *single = static_cast<const DoodadSingle *>(found);
             result.emplace_back(single->serverId, PositionConstants::Zero);
             break;
         }
         case EntryType::Composite:
         {
-            auto *composite = static_cast<DoodadComposite *>(found);
+            auto *composite = static_cast<const DoodadComposite *>(found);
             for (const CompositeTile &tile : composite->tiles)
             {
                 const Position relativePos(
@@ -90,6 +90,8 @@ class DoodadBrush final : public Brush
 
       private:
         friend class DoodadBrush;
+
+        const DoodadEntry *sampleEntry(const std::string &brushName) const;
         std::vector<std::unique_ptr<DoodadEntry>> choices;
 
         uint32_t totalWeight = 0;
@@ -101,6 +103,15 @@ class DoodadBrush final : public Brush
     void apply(MapView &mapView, const Position &position) override;
     void erase(MapView &mapView, const Position &position) override;
 
+    /*
+        Scatters doodads of the current variation over [from, to] as one history action. A doodad is tried at
+        each tile with probability 'density'. A doodad is only placed if none of its tiles are blocking (like apply)
+        or taken by another doodad placed by this call, which is tracked in an occupancy grid (see OccupancyGrid).
+    */
+    void applyInRegion(MapView &mapView, const Position &from, const Position &to, float density);
+    // Uses the thickness of the brush as the density.
+    void applyInRegion(MapView &mapView, const Position &from, const Position &to);
+
     uint32_t iconServerId() const;
     bool erasesItem(uint32_t serverId) const override;
     BrushType type() const override;
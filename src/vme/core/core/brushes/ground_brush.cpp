@@ -3,9 +3,12 @@
 
 #include <algorithm>
 #include <format>
+#include <iterator>
+#include <ranges>
 
 #include "../items.h"
 #include "../map_view.h"
+#include "../parallel.h"
 #include "../position.h"
 #include "../random.h"
 #include "../settings.h"
@@ -16,6 +19,158 @@
 #include "mountain_brush.h"
 
 std::variant<std::monostate, uint32_t, const GroundBrush *> GroundBrush::replacementFilter = std::monostate{};
+SlidingNeighborCache<TileBorderBlock> GroundBrush::neighborCache;
+GroundBrush::RegionBands GroundBrush::regionBands;
+
+namespace
+{
+    /*
+        A border on a tile is only valid if the neighbor in that direction has a border of the same brush that
+        connects to it. Otherwise, 'removeCover' is removed from the tile (see GroundBrush::removeInvalidBorders).
+    */
+    struct InvalidBorderCheck
+    {
+        int dx;
+        int dy;
+        TileCover requiredCover;
+        TileCover removeCover;
+    };
+
+    constexpr std::array<InvalidBorderCheck, 8> InvalidBorderChecks = {{
+        {-1, -1, TILE_COVER_NORTH_EAST | TILE_COVER_SOUTH_WEST | TILE_COVER_EAST | TILE_COVER_SOUTH | TILE_COVER_SOUTH_EAST_CORNER, TILE_COVER_NORTH_WEST_CORNER},
+        {0, -1, TileCovers::FullSouth, TILE_COVER_NORTH},
+        {1, -1, TILE_COVER_NORTH_WEST | TILE_COVER_SOUTH_EAST | TILE_COVER_WEST | TILE_COVER_SOUTH | TILE_COVER_SOUTH_WEST_CORNER, TILE_COVER_NORTH_EAST_CORNER},
+        {1, 0, TileCovers::FullWest, TILE_COVER_EAST},
+        {1, 1, TILE_COVER_NORTH_WEST | TILE_COVER_SOUTH_WEST | TILE_COVER_WEST | TILE_COVER_NORTH | TILE_COVER_NORTH_WEST_CORNER, TILE_COVER_SOUTH_EAST_CORNER},
+        {0, 1, TileCovers::FullNorth, TILE_COVER_SOUTH},
+        {-1, 1, TILE_COVER_NORTH_WEST | TILE_COVER_SOUTH_EAST | TILE_COVER_WEST | TILE_COVER_NORTH | TILE_COVER_NORTH_EAST_CORNER, TILE_COVER_SOUTH_WEST_CORNER},
+        {-1, 0, TileCovers::FullEast, TILE_COVER_WEST},
+    }};
+
+    // The cover to remove for every signature of valid neighbors. Bit i of the signature is set if check i holds.
+    constexpr std::array<TileCover, 256> InvalidBorderRemovals = [] {
+        std::array<TileCover, 256> removals{};
+        for (size_t signature = 0; signature < removals.size(); ++signature)
+        {
+            TileCover remove = TILE_COVER_NONE;
+            for (size_t i = 0; i < InvalidBorderChecks.size(); ++i)
+            {
+                if (!(signature & (size_t(1) << i)))
+                {
+                    remove |= InvalidBorderChecks[i].removeCover;
+                }
+            }
+            removals[signature] = remove;
+        }
+        return removals;
+    }();
+
+    /*
+        Calls f(brush, borderType) for every border item that 'cover' places on a tile, in the order that they are
+        placed. Blocks that can not be placed as they are (see BorderStackBehavior) are changed to the cover
+        that is placed.
+    */
+    template <typename F>
+    void forEachBorderType(TileBorderBlock &cover, F &&f)
+    {
+        using namespace TileCoverShortHands;
+
+        for (auto &block : cover.covers)
+        {
+            auto cover = block.cover;
+            auto brush = block.brush;
+
+            if (brush->stackBehavior() == BorderStackBehavior::FullGround)
+            {
+                if (!TileCovers::exactlyOneSet(cover))
+                {
+                    block.cover = Full;
+                    f(brush, BorderType::Center);
+                    continue;
+                }
+            }
+            else if (brush->stackBehavior() == BorderStackBehavior::Clear)
+            {
+                if (!TileCovers::exactlyOneSet(cover))
+                {
+                    block.cover = None;
+                    continue;
+                }
+            }
+            else
+            {
+                if (cover & Full)
+                {
+                    f(brush, BorderType::North);
+                    f(brush, BorderType::East);
+                    f(brush, BorderType::South);
+                    f(brush, BorderType::West);
+                    continue;
+                }
+            }
+
+            // Sides
+            if (cover & North)
+            {
+                f(brush, BorderType::North);
+            }
+            if (cover & East)
+            {
+                f(brush, BorderType::East);
+            }
+            if (cover & South)
+            {
+                f(brush, BorderType::South);
+            }
+            if (cover & West)
+            {
+                f(brush, BorderType::West);
+            }
+
+            // Diagonals
+            if (cover & Diagonals)
+            {
+                if (cover & NorthWest)
+                {
+                    f(brush, BorderType::NorthWestDiagonal);
+                }
+                else if (cover & NorthEast)
+                {
+                    f(brush, BorderType::NorthEastDiagonal);
+                }
+                else if (cover & SouthEast)
+                {
+                    f(brush, BorderType::SouthEastDiagonal);
+                }
+                else if (cover & SouthWest)
+                {
+                    f(brush, BorderType::SouthWestDiagonal);
+                }
+            }
+
+            // Corners
+            if (cover & Corners)
+            {
+                if (cover & NorthEastCorner)
+                {
+                    f(brush, BorderType::NorthEastCorner);
+                }
+                if (cover & NorthWestCorner)
+                {
+                    f(brush, BorderType::NorthWestCorner);
+                }
+                if (cover & SouthEastCorner)
+                {
+                    f(brush, BorderType::SouthEastCorner);
+                }
+                if (cover & SouthWestCorner)
+                {
+                    f(brush, BorderType::SouthWestCorner);
+                }
+            }
+        }
+    }
+} // namespace
 
 GroundBrush::GroundBrush(std::string id, const std::string &name, std::vector<WeightedItemId> &&weightedIds)
     : Brush(name), _weightedIds(std::move(weightedIds)), id(id), _iconServerId(_weightedIds.at(0).id)
@@ -42,15 +197,18 @@ void GroundBrush::setIconServerId(uint32_t serverId)
 
 void GroundBrush::initialize()
 {
-    // Sort by weights descending to optimize iteration in sampleServerId() for the most common cases.
+    // Sort by weights descending so that the most common IDs come first.
     std::sort(_weightedIds.begin(), _weightedIds.end(), [](const WeightedItemId &a, const WeightedItemId &b) { return a.weight > b.weight; });
 
-    for (auto &entry : _weightedIds)
+    std::vector<uint32_t> weights;
+    weights.reserve(_weightedIds.size());
+    for (const auto &entry : _weightedIds)
     {
-        totalWeight += entry.weight;
-        entry.weight = totalWeight;
+        weights.emplace_back(entry.weight);
         _serverIds.emplace(entry.id);
     }
+
+    sampler = AliasTable(weights);
 }
 
 void GroundBrush::erase(MapView &mapView, const Position &position)
@@ -75,11 +233,21 @@ void GroundBrush::apply(MapView &mapView, const Position &position)
 
     if (mayPlaceOnTile(tile))
     {
+        const Map &map = *mapView.map();
+        // Before setGround, which is our own change
+        neighborCache.validate(&map, MapHistory::History::revision());
+
         mapView.setGround(tile, Item(nextServerId()), true);
 
         if (Settings::AUTO_BORDER)
         {
-            GroundNeighborMap neighbors(this, position, *mapView.map());
+            // While dragging, only the tiles that are new to the 5x5 area or that the last apply changed are read.
+            neighborCache.moveTo(position, [&map](const Position &pos) {
+                const Tile *neighbor = map.getTile(pos);
+                return neighbor ? neighbor->getBorderItemCovers() : TileBorderBlock{};
+            });
+
+            GroundNeighborMap neighbors(this, neighborCache);
             // neighbors.addCenterCorners();
 
             // Must manually set center because the new ground has not been committed to the map yet.
@@ -95,6 +263,10 @@ void GroundBrush::apply(MapView &mapView, const Position &position)
 
             MountainBrush::generalBorderize(mapView, position);
         }
+
+        // Borderizing only changes the 3x3 area around the position
+        neighborCache.invalidate(position, 1);
+        neighborCache.setRevision(MapHistory::History::revision());
     }
 }
 
@@ -114,6 +286,484 @@ void GroundBrush::apply(MapView &mapView, const Position &position, const Border
     }
 }
 
+void GroundBrush::applyInRegion(MapView &mapView, const Position &from, const Position &to)
+{
+    auto area = BrushFootprint::rectangle(std::min(from.x, to.x), std::min(from.y, to.y), std::max(from.x, to.x), std::max(from.y, to.y));
+    sweepRegion(mapView, area, std::min(from.z, to.z), std::max(from.z, to.z), this);
+}
+
+void GroundBrush::applyArea(MapView &mapView, const BrushFootprint &area, int z)
+{
+    if (area.empty())
+        return;
+
+    if (Settings::AUTO_BORDER)
+    {
+        sweepRegion(mapView, area, z, z, this);
+    }
+    else
+    {
+        area.forEachPosition(z, [this, &mapView](const Position &position) { applyWithoutBorderize(mapView, position); });
+    }
+}
+
+void GroundBrush::borderizeRegion(MapView &mapView, const Position &from, const Position &to)
+{
+    auto area = BrushFootprint::rectangle(std::min(from.x, to.x), std::min(from.y, to.y), std::max(from.x, to.x), std::max(from.y, to.y));
+    sweepRegion(mapView, area, std::min(from.z, to.z), std::max(from.z, to.z), nullptr);
+}
+
+void GroundBrush::sweepRegion(MapView &mapView, const BrushFootprint &area, int minZ, int maxZ, GroundBrush *placedGround)
+{
+    using namespace TileCoverShortHands;
+
+    if (area.empty())
+        return;
+
+    // The bounding box of the area
+    const int minX = area.minX();
+    const int maxX = area.maxX();
+    const int minY = area.minY();
+    const int maxY = area.maxY();
+
+    // The area and the one-tile rim around it. For a rectangle, this is the whole window of the sweep.
+    const BrushFootprint sweptArea = area.expanded(1);
+
+    const Map &map = *mapView.map();
+
+    // Grounds are sampled per position, so the placed IDs do not depend on how the region is split between threads.
+    const CounterRandom groundRandom(Random::global().nextUint64());
+
+    // Border items per tile; rarely more than a few, so they are stored inline.
+    using BorderIds = SmallVector<uint32_t, 8>;
+    using BorderIndices = SmallVector<uint16_t, 8>;
+
+    struct SweepTile
+    {
+        TileBorderBlock block;
+        Tile *tile = nullptr;
+        bool placed = false;
+        // The tile has a mountain ground or mountain items
+        bool mountain = false;
+    };
+
+    struct Borderized
+    {
+        TileBorderBlock block;
+        // The ground to place, if any
+        GroundBrush *ground = nullptr;
+        BorderIds borderIds;
+    };
+
+    struct TileChange
+    {
+        Position position;
+        // Descending
+        BorderIndices removedBorders;
+        // 0 if the ground is kept
+        uint32_t groundServerId;
+        BorderIds borderIds;
+    };
+
+    struct Band
+    {
+        std::vector<TileChange> changes;
+        std::vector<std::pair<Position, TileBorderBlock>> ruleTiles;
+        std::vector<Position> mountainTiles;
+    };
+
+    // The window spans the rim plus one more column on each side, because the rim is borderized as well.
+    const int windowMinX = minX - 2;
+    const int windowWidth = (maxX - minX + 1) + 4;
+
+    auto inRegion = [&area](int x, int y) {
+        return area.contains(x, y);
+    };
+
+    // The region and its rim
+    auto inSweep = [&sweptArea](int x, int y) {
+        return sweptArea.contains(x, y);
+    };
+
+    auto mapTile = [&map](int x, int y, int z) -> Tile * {
+        return (x < 0 || y < 0) ? nullptr : map.getTile(Position(x, y, z));
+    };
+
+    auto willPlace = [&](int x, int y, int z) {
+        if (!placedGround || !inRegion(x, y) || x < 0 || y < 0)
+            return false;
+
+        Tile *tile = mapTile(x, y, z);
+        return !tile || mayPlaceOnTile(*tile);
+    };
+
+    auto isMountain = [](const Item &item) {
+        return item.itemType->hasFlag(ItemTypeFlag::InMountainBrush);
+    };
+
+    // Same as the per-tile path: a placed ground removes the borders of its neighbors that face it (see
+    // GroundNeighborMap::getExcludeMask), along with the corners that no longer connect to anything (see preBorderize).
+    auto loadTile = [&](int x, int y, int z) {
+        SweepTile entry;
+        entry.tile = mapTile(x, y, z);
+        entry.placed = willPlace(x, y, z);
+
+        if (entry.tile)
+        {
+            Item *ground = entry.tile->ground();
+            entry.mountain = (ground && isMountain(*ground)) || std::ranges::any_of(entry.tile->items(), [&isMountain](const std::shared_ptr<Item> &item) {
+                                 return isMountain(*item);
+                             });
+        }
+
+        if (entry.placed)
+        {
+            entry.block.ground = placedGround;
+            return entry;
+        }
+
+        if (!entry.tile)
+        {
+            return entry;
+        }
+
+        TileCover excludeMask = None;
+        TileCover removeCorners = None;
+        if (placedGround)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    if ((dx != 0 || dy != 0) && willPlace(x + dx, y + dy, z))
+                    {
+                        // The offset of this tile as seen from the placed tile
+                        excludeMask |= GroundNeighborMap::getExcludeMask(-dx, -dy);
+
+                        if (dx == 0 && dy == 1)
+                            removeCorners |= SouthWestCorner | SouthEastCorner;
+                        else if (dx == 0 && dy == -1)
+                            removeCorners |= NorthWestCorner | NorthEastCorner;
+                        else if (dx == 1 && dy == 0)
+                            removeCorners |= NorthEastCorner | SouthEastCorner;
+                        else if (dx == -1 && dy == 0)
+                            removeCorners |= NorthWestCorner | SouthWestCorner;
+                    }
+                }
+            }
+        }
+
+        entry.block = entry.tile->getFullBorderTileCover(excludeMask);
+        for (auto &cover : entry.block.covers)
+        {
+            cover.cover = TileCovers::unifyTileCover(cover.cover, TileQuadrant::TopLeft);
+            if (cover.brush->centerBrush() != entry.block.ground)
+            {
+                cover.cover &= ~removeCorners;
+            }
+        }
+
+        return entry;
+    };
+
+    // The border items (and possibly a new ground) that 'cover' places on the tile.
+    auto resolve = [](TileBorderBlock &&cover, const SweepTile &entry, GroundBrush *ground) {
+        Borderized result;
+        result.ground = ground;
+
+        forEachBorderType(cover, [&result, &entry](const BorderBrush *brush, BorderType borderType) {
+            if (borderType == BorderType::Center && brush->centerBrush())
+            {
+                // Like applyWithoutBorderize: the new ground clears the borders below it.
+                if (!entry.tile || mayPlaceOnTile(*entry.tile))
+                {
+                    result.ground = brush->centerBrush();
+                    result.borderIds.clear();
+                }
+            }
+            else
+            {
+                auto borderItemId = brush->getServerId(borderType);
+                if (borderItemId && Items::items.validItemType(*borderItemId))
+                {
+                    result.borderIds.emplace_back(*borderItemId);
+                }
+            }
+        });
+
+        result.block = std::move(cover);
+        return result;
+    };
+
+    /*
+        Borderizes the rows of a band in two passes. The first pass borderizes the placed tiles from the map as it
+        was before the fill. The second pass borderizes the other tiles from the result of the first pass. A row
+        therefore only depends on the two rows above and below it, and the band reads that halo from the map.
+        Both passes keep rolling windows of rows: five rows of tiles and three rows of first-pass borders.
+    */
+    auto sweepBand = [&](Band &band, int firstRow, int lastRow, int z) {
+        // Scratch rows that are reused by the bands (and sweeps) on the same thread. Every row is overwritten
+        // before it is read.
+        thread_local std::array<std::vector<SweepTile>, 5> tileRows;
+        thread_local std::array<std::vector<Borderized>, 3> firstPassRows;
+
+        auto tileRow = [minY](int y) -> std::vector<SweepTile> & {
+            return tileRows[(y - (minY - 3)) % 5];
+        };
+
+        auto firstPassRow = [minY](int y) -> std::vector<Borderized> & {
+            return firstPassRows[(y - (minY - 2)) % 3];
+        };
+
+        auto neighborhoodAt = [](auto &rowAbove, auto &row, auto &rowBelow, int i, auto getBlock) {
+            BorderNeighborhood neighborhood;
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                neighborhood[dx + 1] = &getBlock(rowAbove[i + dx]);
+                neighborhood[3 + dx + 1] = &getBlock(row[i + dx]);
+                neighborhood[6 + dx + 1] = &getBlock(rowBelow[i + dx]);
+            }
+            return neighborhood;
+        };
+
+        auto loadRow = [&](int y) {
+            auto &row = tileRow(y);
+            row.resize(windowWidth);
+            for (int i = 0; i < windowWidth; ++i)
+            {
+                row[i] = loadTile(windowMinX + i, y, z);
+            }
+        };
+
+        auto firstPass = [&](int y) {
+            auto &row = firstPassRow(y);
+            row.resize(windowWidth);
+
+            auto &tiles = tileRow(y);
+            auto tileBlock = [](SweepTile &entry) -> const TileBorderBlock & { return entry.block; };
+
+            for (int i = 0; i < windowWidth; ++i)
+            {
+                int x = windowMinX + i;
+                SweepTile &entry = tiles[i];
+
+                if (entry.placed)
+                {
+                    auto neighborhood = neighborhoodAt(tileRow(y - 1), tiles, tileRow(y + 1), i, tileBlock);
+                    // There is no mouse quadrant to prefer a diagonal from in a region.
+                    row[i] = resolve(computeBorders(neighborhood, std::nullopt), entry, placedGround);
+                }
+                else
+                {
+                    row[i] = Borderized{entry.block};
+
+                    // Like GroundBrush::borderize, which cleans up the tiles around the position it borderizes.
+                    if (!placedGround && entry.tile && inSweep(x, y))
+                    {
+                        auto neighborhood = neighborhoodAt(tileRow(y - 1), tiles, tileRow(y + 1), i, tileBlock);
+                        removeInvalidBorders(row[i].block, neighborhood);
+                    }
+                }
+            }
+        };
+
+        loadRow(firstRow - 2);
+        loadRow(firstRow - 1);
+        loadRow(firstRow);
+        loadRow(firstRow + 1);
+        firstPass(firstRow - 1);
+        firstPass(firstRow);
+
+        auto firstPassBlock = [](Borderized &entry) -> const TileBorderBlock & { return entry.block; };
+
+        for (int y = firstRow; y <= lastRow; ++y)
+        {
+            loadRow(y + 2);
+            firstPass(y + 1);
+
+            auto &tiles = tileRow(y);
+            for (int x = minX - 1; x <= maxX + 1; ++x)
+            {
+                if (!inSweep(x, y))
+                    continue;
+
+                const int i = x - windowMinX;
+                SweepTile &entry = tiles[i];
+                Position pos(x, y, z);
+
+                Borderized result;
+                if (entry.placed)
+                {
+                    result = firstPassRow(y)[i];
+
+                    bool nearMountain = false;
+                    for (int dy = -1; dy <= 1; ++dy)
+                    {
+                        for (int dx = -1; dx <= 1; ++dx)
+                        {
+                            nearMountain |= tileRow(y + dy)[i + dx].mountain;
+                        }
+                    }
+
+                    if (nearMountain)
+                    {
+                        band.mountainTiles.emplace_back(pos);
+                    }
+                }
+                else
+                {
+                    // Same early exits as fixBordersAtOffset
+                    Item *ground = entry.tile ? entry.tile->ground() : nullptr;
+                    if (!ground || isMountain(*ground))
+                    {
+                        continue;
+                    }
+
+                    auto neighborhood = neighborhoodAt(firstPassRow(y - 1), firstPassRow(y), firstPassRow(y + 1), i, firstPassBlock);
+                    result = resolve(computeBorders(neighborhood, std::nullopt), entry, nullptr);
+                }
+
+                BorderIndices currentBorders;
+                if (entry.tile)
+                {
+                    const auto &items = entry.tile->items();
+                    for (size_t index = items.size(); index-- > 0;)
+                    {
+                        if (items[index]->isBorder())
+                        {
+                            currentBorders.emplace_back(static_cast<uint16_t>(index));
+                        }
+                    }
+                }
+
+                bool unchanged = !result.ground && std::ranges::equal(currentBorders | std::views::reverse, result.borderIds, [&entry](uint16_t index, uint32_t serverId) {
+                                     return entry.tile->items()[index]->serverId() == serverId;
+                                 });
+
+                if (!unchanged && x >= 0 && y >= 0)
+                {
+                    uint32_t groundServerId = result.ground ? result.ground->serverIdAt(groundRandom, pos) : 0;
+                    band.changes.emplace_back(TileChange{pos, std::move(currentBorders), groundServerId, std::move(result.borderIds)});
+                }
+
+                bool hasRules = std::ranges::any_of(result.block.covers, [](const BorderCover &block) { return !block.brush->rules.empty(); });
+                if (hasRules)
+                {
+                    band.ruleTiles.emplace_back(pos, std::move(result.block));
+                }
+            }
+        }
+    };
+
+    MapHistory::Action action(MapHistory::ActionType::SetTile);
+
+    std::vector<std::pair<Position, TileBorderBlock>> ruleTiles;
+    std::vector<Position> mountainTiles;
+
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        const int firstRow = minY - 1;
+        const int lastRow = maxY + 1;
+
+        std::vector<Band> bands;
+        size_t tileCount = static_cast<size_t>(windowWidth) * static_cast<size_t>(lastRow - firstRow + 1);
+        if (tileCount < regionBands.minParallelTiles)
+        {
+            bands.resize(1);
+            sweepBand(bands.front(), firstRow, lastRow, z);
+        }
+        else
+        {
+            const int bandRows = regionBands.bandRows;
+            bands.resize(parallel::bandCount(firstRow, lastRow, bandRows));
+
+            resolveLazyBorderState();
+            parallel::forEachBand(firstRow, lastRow, bandRows, [&bands, &sweepBand, z](size_t band, int bandFirstRow, int bandLastRow) {
+                sweepBand(bands[band], bandFirstRow, bandLastRow, z);
+            });
+        }
+
+        for (auto &band : bands)
+        {
+            for (auto &change : band.changes)
+            {
+                for (uint16_t index : change.removedBorders)
+                {
+                    action.addChange(MapHistory::TileDelta::removeItem(change.position, index));
+                }
+
+                if (change.groundServerId != 0)
+                {
+                    action.addChange(MapHistory::TileDelta::addItem(change.position, Item(change.groundServerId)));
+                }
+
+                for (uint32_t serverId : change.borderIds)
+                {
+                    action.addChange(MapHistory::TileDelta::addItem(change.position, Item(serverId)));
+                }
+            }
+
+            std::ranges::move(band.ruleTiles, std::back_inserter(ruleTiles));
+            std::ranges::move(band.mountainTiles, std::back_inserter(mountainTiles));
+        }
+    }
+
+    if (!action.changes.empty())
+    {
+        mapView.history.commit(std::move(action));
+    }
+
+    for (const auto &[pos, cover] : ruleTiles)
+    {
+        applyBorderRules(mapView, pos, cover);
+    }
+
+    // The tiles near mountains were found by the sweep, so the mountain pass only reads the area around them.
+    for (auto first = mountainTiles.begin(); first != mountainTiles.end();)
+    {
+        int z = first->z;
+        auto last = std::find_if(first, mountainTiles.end(), [z](const Position &pos) { return pos.z != z; });
+
+        std::vector<BrushFootprint::Span> spans;
+        spans.reserve(static_cast<size_t>(last - first));
+        for (auto it = first; it != last; ++it)
+        {
+            spans.emplace_back(BrushFootprint::Span{it->y, it->x, it->x});
+        }
+
+        MountainBrush::borderizeRegion(mapView, BrushFootprint(std::move(spans)), z);
+        first = last;
+    }
+}
+
+void GroundBrush::resolveLazyBorderState()
+{
+    for (auto &[id, brush] : Brushes::getGroundBrushes())
+    {
+        for (auto &border : brush->borders)
+        {
+            if (border.to)
+            {
+                border.to->value();
+            }
+
+            border.brush->centerBrush();
+            border.brush->preferredZOrder();
+        }
+    }
+
+    for (auto &[id, brush] : Brushes::getBorderBrushes())
+    {
+        brush->centerBrush();
+        brush->preferredZOrder();
+    }
+
+    for (auto &[id, brush] : Brushes::getMountainBrushes())
+    {
+        brush->ground();
+    }
+}
+
 void GroundBrush::fixBorders(MapView &mapView, const Position &position, GroundNeighborMap &neighbors)
 {
     // Do (0, 0) first
@@ -134,8 +784,6 @@ void GroundBrush::fixBorders(MapView &mapView, const Position &position, GroundN
 
 void GroundBrush::fixBordersAtOffset(MapView &mapView, const Position &position, GroundNeighborMap &neighbors, int x, int y)
 {
-    using namespace TileCoverShortHands;
-
     auto pos = position + Position(x, y, 0);
 
     // Early exits
@@ -157,64 +805,23 @@ void GroundBrush::fixBordersAtOffset(MapView &mapView, const Position &position,
         }
     }
 
-    auto currentCover = neighbors.at(x, y);
-
-    TileBorderBlock cover;
-    cover.ground = currentCover.ground;
-
-    neighbors.mirrorNorth(cover, x, y);
-    neighbors.mirrorEast(cover, neighbors.at(x - 1, y));
-    neighbors.mirrorSouth(cover, neighbors.at(x, y - 1));
-    neighbors.mirrorWest(cover, neighbors.at(x + 1, y));
-
-    neighbors.mirrorNorthWest(cover, neighbors.at(x - 1, y - 1));
-    neighbors.mirrorNorthEast(cover, neighbors.at(x + 1, y - 1));
-    neighbors.mirrorSouthEast(cover, neighbors.at(x + 1, y + 1));
-    neighbors.mirrorSouthWest(cover, neighbors.at(x - 1, y + 1));
-
-    // Do not use a mirrored diagonal if we already have a diagonal.
-    for (auto &block : cover.covers)
+    BorderNeighborhood neighborhood;
+    for (int dy = -1; dy <= 1; ++dy)
     {
-        auto current = currentCover.border(block.brush);
-        if (current && current->cover & Diagonals)
+        for (int dx = -1; dx <= 1; ++dx)
         {
-            block.cover &= ~(Diagonals);
+            neighborhood[(dy + 1) * 3 + (dx + 1)] = &neighbors.at(x + dx, y + dy);
         }
     }
 
-    cover.merge(currentCover);
-
-    auto quadrant = mapView.getMouseDownTileQuadrant();
-
-    // TileQuadrant quadrant = getNeighborQuadrant(x, y);
-    for (auto &block : cover.covers)
+    std::optional<TileQuadrant> quadrant;
+    if (x == 0 && y == 0)
     {
-        // Compute preferred diagonal
-        TileCover preferredDiagonal = block.cover & Diagonals;
-        if (x == 0 && y == 0)
-        {
-            if (quadrant)
-            {
-                switch (*quadrant)
-                {
-                    case TileQuadrant::TopLeft:
-                        preferredDiagonal = NorthWest;
-                        break;
-                    case TileQuadrant::TopRight:
-                        preferredDiagonal = NorthEast;
-                        break;
-                    case TileQuadrant::BottomRight:
-                        preferredDiagonal = SouthEast;
-                        break;
-                    case TileQuadrant::BottomLeft:
-                        preferredDiagonal = SouthWest;
-                        break;
-                }
-            }
-        }
-        block.cover = TileCovers::unifyTileCover(block.cover, TileQuadrant::TopLeft, preferredDiagonal);
+        quadrant = mapView.getMouseDownTileQuadrant();
     }
 
+    TileBorderBlock cover = computeBorders(neighborhood, quadrant);
+
     // fixBorderEdgeCases(x, y, cover, neighbors);
 
     Tile &tile = mapView.getOrCreateTile(pos);
@@ -222,112 +829,82 @@ void GroundBrush::fixBordersAtOffset(MapView &mapView, const Position &position,
         return item.isBorder();
     });
 
-    cover.sort();
-
     if (cover.covers.empty() && cover.ground && !mapView.getTile(pos)->hasGround())
     {
         cover.ground->applyWithoutBorderize(mapView, pos);
         return;
     }
 
-    for (auto &block : cover.covers)
-    {
-        auto cover = block.cover;
-        auto brush = block.brush;
+    forEachBorderType(cover, [&mapView, &pos](const BorderBrush *brush, BorderType borderType) {
+        apply(mapView, pos, brush, borderType);
+    });
 
-        const auto &borderData = brush->getBorderData();
+    neighbors.set(x, y, cover);
+}
 
-        if (brush->stackBehavior() == BorderStackBehavior::FullGround)
-        {
-            if (!TileCovers::exactlyOneSet(cover))
-            {
-                block.cover = Full;
-                apply(mapView, pos, brush, BorderType::Center);
-                continue;
-            }
-        }
-        else if (brush->stackBehavior() == BorderStackBehavior::Clear)
-        {
-            if (!TileCovers::exactlyOneSet(cover))
-            {
-                block.cover = None;
-                continue;
-            }
-        }
-        else
-        {
-            if (cover & Full)
-            {
-                apply(mapView, pos, brush, BorderType::North);
-                apply(mapView, pos, brush, BorderType::East);
-                apply(mapView, pos, brush, BorderType::South);
-                apply(mapView, pos, brush, BorderType::West);
-                continue;
-            }
-        }
+TileBorderBlock GroundBrush::computeBorders(const BorderNeighborhood &neighborhood, std::optional<TileQuadrant> quadrant)
+{
+    using namespace TileCoverShortHands;
 
-        // Sides
-        if (cover & North)
-        {
-            apply(mapView, pos, brush, BorderType::North);
-        }
-        if (cover & East)
-        {
-            apply(mapView, pos, brush, BorderType::East);
-        }
-        if (cover & South)
-        {
-            apply(mapView, pos, brush, BorderType::South);
-        }
-        if (cover & West)
-        {
-            apply(mapView, pos, brush, BorderType::West);
-        }
+    auto at = [&neighborhood](int dx, int dy) -> const TileBorderBlock & {
+        return *neighborhood[(dy + 1) * 3 + (dx + 1)];
+    };
+
+    const TileBorderBlock &currentCover = at(0, 0);
 
-        // Diagonals
-        if (cover & Diagonals)
+    TileBorderBlock cover;
+    cover.ground = currentCover.ground;
+
+    GroundNeighborMap::mirrorNorth(cover, at(0, 1));
+    GroundNeighborMap::mirrorEast(cover, at(-1, 0));
+    GroundNeighborMap::mirrorSouth(cover, at(0, -1));
+    GroundNeighborMap::mirrorWest(cover, at(1, 0));
+
+    GroundNeighborMap::mirrorNorthWest(cover, at(-1, -1));
+    GroundNeighborMap::mirrorNorthEast(cover, at(1, -1));
+    GroundNeighborMap::mirrorSouthEast(cover, at(1, 1));
+    GroundNeighborMap::mirrorSouthWest(cover, at(-1, 1));
+
+    // Do not use a mirrored diagonal if we already have a diagonal.
+    for (auto &block : cover.covers)
+    {
+        auto current = currentCover.border(block.brush);
+        if (current && current->cover & Diagonals)
         {
-            if (cover & NorthWest)
-            {
-                apply(mapView, pos, brush, BorderType::NorthWestDiagonal);
-            }
-            else if (cover & NorthEast)
-            {
-                apply(mapView, pos, brush, BorderType::NorthEastDiagonal);
-            }
-            else if (cover & SouthEast)
-            {
-                apply(mapView, pos, brush, BorderType::SouthEastDiagonal);
-            }
-            else if (cover & SouthWest)
-            {
-                apply(mapView, pos, brush, BorderType::SouthWestDiagonal);
-            }
+            block.cover &= ~(Diagonals);
         }
+    }
 
-        // Corners
-        if (cover & Corners)
+    cover.merge(currentCover);
+
+    for (auto &block : cover.covers)
+    {
+        // Compute preferred diagonal
+        TileCover preferredDiagonal = block.cover & Diagonals;
+        if (quadrant)
         {
-            if (cover & NorthEastCorner)
-            {
-                apply(mapView, pos, brush, BorderType::NorthEastCorner);
-            }
-            if (cover & NorthWestCorner)
-            {
-                apply(mapView, pos, brush, BorderType::NorthWestCorner);
-            }
-            if (cover & SouthEastCorner)
+            switch (*quadrant)
             {
-                apply(mapView, pos, brush, BorderType::SouthEastCorner);
-            }
-            if (cover & SouthWestCorner)
-            {
-                apply(mapView, pos, brush, BorderType::SouthWestCorner);
+                case TileQuadrant::TopLeft:
+                    preferredDiagonal = NorthWest;
+                    break;
+                case TileQuadrant::TopRight:
+                    preferredDiagonal = NorthEast;
+                    break;
+                case TileQuadrant::BottomRight:
+                    preferredDiagonal = SouthEast;
+                    break;
+                case TileQuadrant::BottomLeft:
+                    preferredDiagonal = SouthWest;
+                    break;
             }
         }
+        block.cover = TileCovers::unifyTileCover(block.cover, TileQuadrant::TopLeft, preferredDiagonal);
     }
 
-    neighbors.set(x, y, cover);
+    cover.sort();
+
+    return cover;
 }
 
 bool GroundBrush::mayPlaceOnTile(Tile &tile)
@@ -409,24 +986,25 @@ uint32_t GroundBrush::nextServerId() const
 
 uint32_t GroundBrush::sampleServerId() const
 {
-    uint32_t weight = Random::global().nextInt<uint32_t>(static_cast<uint32_t>(0), totalWeight);
-
-    for (const auto &entry : _weightedIds)
+    if (sampler.empty())
     {
-        if (weight < entry.weight)
-        {
-            return entry.id;
-        }
+        VME_LOG_ERROR("[GroundBrush::nextServerId] Brush " << _name << " has no weighted IDs with a positive weight.");
+        return _weightedIds.at(0).id;
     }
 
-    // If we get here, something is off with `weight` for some weighted ID or with `totalWeight`.
-    VME_LOG_ERROR(
-        "[GroundBrush::nextServerId] Brush " << _name
-                                             << ": Could not find matching weight for randomly generated weight "
-                                             << weight << " (totalWeight: " << totalWeight << ".");
+    return _weightedIds[sampler.sample(Random::global().nextUint64())].id;
+}
 
-    // No match in for-loop. Use the first ID.
-    return _weightedIds.at(0).id;
+uint32_t GroundBrush::serverIdAt(const CounterRandom &random, const Position &position) const
+{
+    if (sampler.empty())
+        return _weightedIds.at(0).id;
+
+    // Consecutive tiles of a row have consecutive counters
+    uint64_t counter = (static_cast<uint64_t>(static_cast<uint32_t>(position.y)) << 32) | static_cast<uint32_t>(position.x);
+    counter ^= static_cast<uint64_t>(static_cast<uint8_t>(position.z)) << 56;
+
+    return _weightedIds[sampler.sample(random.at(counter))].id;
 }
 
 std::string GroundBrush::brushId() const noexcept
@@ -683,74 +1261,71 @@ void GroundBrush::postBorderize(MapView &mapView, const Position &position, Grou
     {
         for (int dy = -1; dy <= 1; ++dy)
         {
-            auto &center = neighbors.at(dx, dy);
-            for (auto &cover : center.covers)
+            applyBorderRules(mapView, position + Position(dx, dy, 0), neighbors.at(dx, dy));
+        }
+    }
+}
+
+void GroundBrush::applyBorderRules(MapView &mapView, const Position &pos, const TileBorderBlock &center)
+{
+    for (auto &cover : center.covers)
+    {
+        for (auto &rule : cover.brush->rules)
+        {
+            const auto &otherCover = rule.check(center);
+            if (otherCover)
             {
-                for (auto &rule : cover.brush->rules)
+                // Perform the rule cases
+                for (const auto &ruleCase : rule.cases)
                 {
-                    const auto &otherCover = rule.check(center);
-                    if (otherCover)
+                    if ((cover.cover & TileCovers::fromBorderType(ruleCase.selfEdge)) && ((*otherCover) & TileCovers::fromBorderType(ruleCase.borderEdge)))
                     {
-                        // Perform the rule cases
-                        for (const auto &ruleCase : rule.cases)
+                        switch (ruleCase.action->type)
                         {
-                            if ((cover.cover & TileCovers::fromBorderType(ruleCase.selfEdge)) && ((*otherCover) & TileCovers::fromBorderType(ruleCase.borderEdge)))
+                            case BorderRuleAction::Type::Replace:
                             {
-                                Position pos = position + Position(dx, dy, 0);
-
-                                switch (ruleCase.action->type)
+                                auto *action = static_cast<ReplaceAction *>(ruleCase.action.get());
+                                if (action->replaceSelf)
+                                {
+                                    uint32_t oldServerId = *cover.brush->getServerId(ruleCase.selfEdge);
+                                    action->apply(mapView, pos, oldServerId);
+                                }
+                                else
                                 {
-                                    case BorderRuleAction::Type::Replace:
-                                    {
-                                        auto *action = static_cast<ReplaceAction *>(ruleCase.action.get());
-                                        if (action->replaceSelf)
-                                        {
-                                            uint32_t oldServerId = *cover.brush->getServerId(ruleCase.selfEdge);
-                                            action->apply(mapView, pos, oldServerId);
-                                        }
-                                        else
-                                        {
-                                            BorderBrush *otherBrush = Brushes::getBorderBrush(rule.borderId);
-
-                                            uint32_t oldServerId = *otherBrush->getServerId(ruleCase.borderEdge);
-                                            action->apply(mapView, pos, oldServerId);
-                                        }
-                                        break;
-                                    }
-                                    case BorderRuleAction::Type::SetFull:
-                                    {
-                                        auto *action = static_cast<SetFullAction *>(ruleCase.action.get());
-                                        BorderBrush *borderBrush = action->setSelf ? cover.brush : Brushes::getBorderBrush(rule.borderId);
-                                        action->apply(mapView, pos, borderBrush->centerBrush());
-                                    }
+                                    BorderBrush *otherBrush = Brushes::getBorderBrush(rule.borderId);
+
+                                    uint32_t oldServerId = *otherBrush->getServerId(ruleCase.borderEdge);
+                                    action->apply(mapView, pos, oldServerId);
                                 }
+                                break;
+                            }
+                            case BorderRuleAction::Type::SetFull:
+                            {
+                                auto *action = static_cast<SetFullAction *>(ruleCase.action.get());
+                                BorderBrush *borderBrush = action->setSelf ? cover.brush : Brushes::getBorderBrush(rule.borderId);
+                                action->apply(mapView, pos, borderBrush->centerBrush());
                             }
                         }
+                    }
+                }
 
-                        // Perform the rule actions
-                        if (!rule.actions.empty())
+                // Perform the rule actions
+                for (auto &action : rule.actions)
+                {
+                    switch (action->type)
+                    {
+                        case BorderRuleAction::Type::SetFull:
                         {
-                            Position pos = position + Position(dx, dy, 0);
-
-                            for (auto &action : rule.actions)
-                            {
-                                switch (action->type)
-                                {
-                                    case BorderRuleAction::Type::SetFull:
-                                    {
-                                        auto *setAction = static_cast<SetFullAction *>(action.get());
-                                        BorderBrush *borderBrush = setAction->setSelf ? cover.brush : Brushes::getBorderBrush(rule.borderId);
-                                        setAction->apply(mapView, pos, borderBrush->centerBrush());
-                                        break;
-                                    }
-                                    case BorderRuleAction::Type::Replace:
-                                    {
-                                        VME_LOG_ERROR(
-                                            std::format("Border rule action 'replace' is not implemented for brush '{}'.", cover.brush->getDisplayId()));
-                                        break;
-                                    }
-                                }
-                            }
+                            auto *setAction = static_cast<SetFullAction *>(action.get());
+                            BorderBrush *borderBrush = setAction->setSelf ? cover.brush : Brushes::getBorderBrush(rule.borderId);
+                            setAction->apply(mapView, pos, borderBrush->centerBrush());
+                            break;
+                        }
+                        case BorderRuleAction::Type::Replace:
+                        {
+                            VME_LOG_ERROR(
+                                std::format("Border rule action 'replace' is not implemented for brush '{}'.", cover.brush->getDisplayId()));
+                            break;
                         }
                     }
                 }
@@ -761,50 +1336,47 @@ void GroundBrush::postBorderize(MapView &mapView, const Position &position, Grou
 
 void GroundBrush::borderize(MapView &mapView, const Position &position)
 {
-    using namespace TileCoverShortHands;
-
     GroundNeighborMap neighbors(nullptr, position, *mapView.map());
 
     for (int dx = -1; dx <= 1; ++dx)
     {
         for (int dy = -1; dy <= 1; ++dy)
         {
-            auto &center = neighbors.at(dx, dy);
-            for (auto &block : center.covers)
+            BorderNeighborhood neighborhood;
+            for (int y = -1; y <= 1; ++y)
             {
-                TileCover remove = None;
-
-#define remove_invalid_border(x, y, requiredCover, removeCover)           \
-    do                                                                    \
-    {                                                                     \
-        auto neighbor = neighbors.at(dx + x, dy + y).border(block.brush); \
-        if (!(neighbor && (neighbor->cover & (requiredCover))))           \
-        {                                                                 \
-            remove |= (removeCover);                                      \
-        }                                                                 \
-    }                                                                     \
-    while (false)
-
-                remove_invalid_border(-1, -1, NorthEast | SouthWest | East | South | SouthEastCorner, NorthWestCorner);
-                remove_invalid_border(0, -1, FullSouth, North);
-                remove_invalid_border(1, -1, NorthWest | SouthEast | West | South | SouthWestCorner, NorthEastCorner);
-                remove_invalid_border(1, 0, FullWest, East);
-                remove_invalid_border(1, 1, NorthWest | SouthWest | West | North | NorthWestCorner, SouthEastCorner);
-                remove_invalid_border(0, 1, FullNorth, South);
-                remove_invalid_border(-1, 1, NorthWest | SouthEast | West | North | NorthEastCorner, SouthWestCorner);
-                remove_invalid_border(-1, 0, FullEast, West);
-
-                if (remove != None)
+                for (int x = -1; x <= 1; ++x)
                 {
-                    block.cover &= ~remove;
+                    neighborhood[(y + 1) * 3 + (x + 1)] = &neighbors.at(dx + x, dy + y);
                 }
             }
+
+            removeInvalidBorders(neighbors.at(dx, dy), neighborhood);
         }
     }
 
     fixBorders(mapView, position, neighbors);
 }
 
+void GroundBrush::removeInvalidBorders(TileBorderBlock &center, const BorderNeighborhood &neighborhood)
+{
+    for (auto &block : center.covers)
+    {
+        uint8_t signature = 0;
+        for (size_t i = 0; i < InvalidBorderChecks.size(); ++i)
+        {
+            const auto &check = InvalidBorderChecks[i];
+            auto neighbor = neighborhood[(check.dy + 1) * 3 + (check.dx + 1)]->border(block.brush);
+            if (neighbor && (neighbor->cover & check.requiredCover))
+            {
+                signature |= static_cast<uint8_t>(1 << i);
+            }
+        }
+
+        block.cover &= ~InvalidBorderRemovals[signature];
+    }
+}
+
 //>>>>>>>>>>>>>>>>>>>>>>>>>
 //>>>>>>>>>>>>>>>>>>>>>>>>>
 //>>>GroundNeighborMap>>>
@@ -832,6 +1404,35 @@ GroundNeighborMap::GroundNeighborMap(GroundBrush *centerGround, const Position &
     }
 }
 
+GroundNeighborMap::GroundNeighborMap(GroundBrush *centerGround, const SlidingNeighborCache<TileBorderBlock> &cache)
+    : centerGround(centerGround)
+{
+    for (int dy = -2; dy <= 2; ++dy)
+    {
+        for (int dx = -2; dx <= 2; ++dx)
+        {
+            const TileBorderBlock &itemCovers = cache.at(dx, dy);
+            TileCover mask = getExcludeMask(dx, dy);
+
+            TileBorderBlock &block = at(dx, dy);
+            block.ground = itemCovers.ground;
+            for (const auto &itemCover : itemCovers.covers)
+            {
+                TileCover cover = itemCover.cover & ~mask;
+                if (cover != TILE_COVER_NONE)
+                {
+                    block.add(cover, itemCover.brush);
+                }
+            }
+
+            for (auto &cover : block.covers)
+            {
+                cover.cover = TileCovers::unifyTileCover(cover.cover, TileQuadrant::TopLeft);
+            }
+        }
+    }
+}
+
 std::optional<TileBorderBlock> GroundNeighborMap::getTileCoverAt(const Map &map, const Position position, TileCover mask) const
 {
     Tile *tile = map.getTile(position);
@@ -886,7 +1487,7 @@ void GroundNeighborMap::set(int x, int y, TileBorderBlock tileCover)
     data[index(x, y)] = tileCover;
 }
 
-int GroundNeighborMap::index(int x, int y) const
+int GroundNeighborMap::index(int x, int y)
 {
     return (y + 2) * 5 + (x + 2);
 }
@@ -932,10 +1533,8 @@ void GroundNeighborMap::addBorderFromGround(value_type &self, const value_type &
     }
 }
 
-void GroundNeighborMap::mirrorNorth(TileBorderBlock &source, int dx, int dy)
+void GroundNeighborMap::mirrorNorth(TileBorderBlock &source, const TileBorderBlock &borders)
 {
-    TileBorderBlock &borders = at(dx, dy + 1);
-
     uint32_t sourceZ = source.zOrder();
     for (const auto &border : borders.covers)
     {
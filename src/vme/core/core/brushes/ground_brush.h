@@ -1,13 +1,18 @@
 #pragma once
 
+#include <array>
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <variant>
 
+#include "../alias_table.h"
 #include "../random.h"
+#include "../small_vector.h"
 #include "../tile.h"
 #include "../tile_cover.h"
 #include "brush.h"
+#include "sliding_neighbor_cache.h"
 
 struct Position;
 class MapView;
@@ -23,9 +28,12 @@ enum class BorderAlign
     Outer
 };
 
+// Tiles rarely have more than a few border layers, so they are stored inline.
+using BorderCovers = SmallVector<BorderCover, 4>;
+
 struct TileBorderBlock
 {
-    std::vector<BorderCover> covers = {};
+    BorderCovers covers = {};
     GroundBrush *ground = nullptr;
 
     uint32_t zOrder() const noexcept;
@@ -53,12 +61,8 @@ struct GroundBorder
 /**
  * Ground Brush
  *
- * Possible optimization:
- * nextServerId() performs linear search. It is the fastest approach for small lists (< 30 items at least).
- * However, if in the future it is common to use larger ground brushes (40-60+ items) then a possible optimization to try
- * is Walker's Alias Method:
- * https://gamedev.stackexchange.com/a/162996
- * C++ Implementation: https://gist.github.com/Liam0205/0b5786e9bfc73e75eb8180b5400cd1f8
+ * The server IDs are sampled from an alias table (see AliasTable), so a sample takes constant time regardless of
+ * the number of items in the brush.
  */
 
 class GroundBrush final : public Brush
@@ -76,6 +80,39 @@ class GroundBrush final : public Brush
     void apply(MapView &mapView, const Position &position) override;
     void applyWithoutBorderize(MapView &mapView, const Position &position) override;
 
+    /*
+        Fills the rectangle [from, to] with this ground and borderizes it as one history action. The grounds are
+        placed first. The borders of the region and of the one-tile rim around it are then computed in a single
+        row-major sweep that keeps rolling windows of neighbor borders, so that every tile is read from the map once
+        (see borderizeRegion). Tiles whose borders do not change are left untouched.
+    */
+    void applyInRegion(MapView &mapView, const Position &from, const Position &to);
+
+    /*
+        Like applyInRegion, for an area of any shape: the ground is placed on the area, and the area and its rim
+        are borderized in one sweep and one history action.
+    */
+    void applyArea(MapView &mapView, const BrushFootprint &area, int z) override;
+
+    /*
+        Borderizes every tile in [from, to] and in the one-tile rim around it, like borderize does for the area
+        around a single position. Large regions are split into bands of rows that are borderized in parallel; the
+        result is the same as when the region is borderized on one thread.
+    */
+    static void borderizeRegion(MapView &mapView, const Position &from, const Position &to);
+
+    // How borderizeRegion splits a region into bands of rows
+    struct RegionBands
+    {
+        // Below this many tiles, a region is borderized on the calling thread.
+        size_t minParallelTiles = 4096;
+        // Rows per band when a region is borderized in parallel
+        int bandRows = 32;
+    };
+
+    // Only changed by tests, to compare a region borderized in many bands with one borderized in a single band.
+    static RegionBands regionBands;
+
     void erase(MapView &mapView, const Position &position) override;
 
     uint32_t iconServerId() const;
@@ -88,6 +125,12 @@ class GroundBrush final : public Brush
 
     uint32_t nextServerId() const;
 
+    /*
+        The server ID for 'position' in the stream of 'random'. The same stream and position always give the same
+        ID, so a region can be filled in any order and on any number of threads with the same result.
+    */
+    uint32_t serverIdAt(const CounterRandom &random, const Position &position) const;
+
     std::string brushId() const noexcept;
 
     std::vector<ThingDrawInfo> getPreviewTextureInfo(int variation) const override;
@@ -117,6 +160,9 @@ class GroundBrush final : public Brush
     const std::vector<GroundBorder> &getBorders() const noexcept;
 
   private:
+    // The borders of a 3x3 area in row-major order. The tile that is borderized is at index 4.
+    using BorderNeighborhood = std::array<const TileBorderBlock *, 9>;
+
     void preBorderize(MapView &mapView, const Position &position, GroundNeighborMap &neighbors);
     void postBorderize(MapView &mapView, const Position &position, GroundNeighborMap &neighbors);
     static void apply(MapView &mapView, const Position &position, const BorderBrush *brush, BorderType borderType);
@@ -124,19 +170,36 @@ class GroundBrush final : public Brush
     static void fixBorders(MapView &mapView, const Position &position, GroundNeighborMap &neighbors);
     static void fixBordersAtOffset(MapView &mapView, const Position &position, GroundNeighborMap &neighbors, int x, int y);
 
+    /*
+        The borders of the center tile of 'neighborhood', given the borders and grounds around it. 'quadrant' is
+        the preferred diagonal when several are possible.
+    */
+    static TileBorderBlock computeBorders(const BorderNeighborhood &neighborhood, std::optional<TileQuadrant> quadrant);
+    static void applyBorderRules(MapView &mapView, const Position &pos, const TileBorderBlock &center);
+    static void removeInvalidBorders(TileBorderBlock &center, const BorderNeighborhood &neighborhood);
+
+    // Borderizes an area and its rim, and places 'placedGround' in the area first if it is not nullptr.
+    static void sweepRegion(MapView &mapView, const BrushFootprint &area, int minZ, int maxZ, GroundBrush *placedGround);
+
+    /*
+        Brushes resolve some of their state on first use (border targets, center brushes and z-orders). Borders
+        are only computed from several threads after this has resolved that state for every brush.
+    */
+    static void resolveLazyBorderState();
+
     void initialize();
     uint32_t sampleServerId() const;
 
     std::unordered_set<uint32_t> _serverIds;
     std::vector<WeightedItemId> _weightedIds;
+    // Indices into _weightedIds
+    AliasTable sampler;
 
     std::vector<GroundBorder> borders;
 
     std::string id;
     uint32_t _iconServerId;
 
-    uint32_t totalWeight = 0;
-
     uint32_t _zOrder = DefaultZOrder;
 
     /*
@@ -145,12 +208,20 @@ class GroundBrush final : public Brush
       GroundBrush*     -> May replace any ground tile that is part of the brush
     */
     static std::variant<std::monostate, uint32_t, const GroundBrush *> replacementFilter;
+
+    /*
+        The unmerged border covers (see Tile::getBorderItemCovers) around the last position that apply was called
+        on. Shared by all ground brushes, since the covers do not depend on the brush.
+    */
+    static SlidingNeighborCache<TileBorderBlock> neighborCache;
 };
 
 struct GroundNeighborMap
 {
     using value_type = TileBorderBlock;
     GroundNeighborMap(GroundBrush *centerGround, const Position &position, const Map &map);
+    // From the tiles of 'cache' (see Tile::getBorderItemCovers), like reading them from the map.
+    GroundNeighborMap(GroundBrush *centerGround, const SlidingNeighborCache<TileBorderBlock> &cache);
     value_type at(int x, int y) const;
     value_type &at(int x, int y);
     value_type &center();
@@ -160,27 +231,27 @@ struct GroundNeighborMap
     bool hasExpandedCover() const noexcept;
     void addExpandedCover(int x, int y);
 
-    TileCover getExcludeMask(int dx, int dy);
+    static TileCover getExcludeMask(int dx, int dy);
 
-    std::vector<ExpandedTileBlock> expandedCovers;
+    ExpandedTileBlocks expandedCovers;
     GroundBrush *centerGround;
 
     static void addBorderFromGround(value_type &self, const value_type &other, TileCover border);
 
-    void mirrorNorth(value_type &source, int dx, int dy);
-    void mirrorEast(value_type &source, const value_type &borders);
-    void mirrorSouth(value_type &source, const value_type &borders);
-    void mirrorWest(value_type &source, const value_type &borders);
+    static void mirrorNorth(value_type &source, const value_type &borders);
+    static void mirrorEast(value_type &source, const value_type &borders);
+    static void mirrorSouth(value_type &source, const value_type &borders);
+    static void mirrorWest(value_type &source, const value_type &borders);
 
-    void mirrorNorthWest(value_type &source, const value_type &borders);
-    void mirrorNorthEast(value_type &source, const value_type &borders);
-    void mirrorSouthEast(value_type &source, const value_type &borders);
-    void mirrorSouthWest(value_type &source, const value_type &borders);
+    static void mirrorNorthWest(value_type &source, const value_type &borders);
+    static void mirrorNorthEast(value_type &source, const value_type &borders);
+    static void mirrorSouthEast(value_type &source, const value_type &borders);
+    static void mirrorSouthWest(value_type &source, const value_type &borders);
 
     void addCenterCorners();
 
   private:
-    int index(int x, int y) const;
+    static int index(int x, int y);
     std::optional<value_type> getTileCoverAt(const Map &map, Position position, TileCover mask) const;
 
     std::array<value_type, TILES_IN_5_BY_5_GRID> data;
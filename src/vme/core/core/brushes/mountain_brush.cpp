@@ -1,6 +1,9 @@
 #include "mountain_brush.h"
 
+#include <algorithm>
+#include <array>
 #include <utility>
+#include <vector>
 
 #include "../items.h"
 #include "../map.h"
@@ -8,9 +11,216 @@
 #include "../settings.h"
 #include "../tile_cover.h"
 #include "border_brush.h"
+#include "brush_footprint.h"
 #include "ground_brush.h"
 #include "raw_brush.h"
 
+namespace
+{
+    /*
+        Removes the sides and corners of 'center' that do not connect to a cover of the same brush on the neighbor
+        in that direction. 'at(dx, dy)' is the block of the neighbor at that offset.
+    */
+    template <typename NeighborAt>
+    void removeInvalidCovers(MountainPart::BorderBlock &center, NeighborAt &&at)
+    {
+        using namespace TileCoverShortHands;
+
+        for (auto &block : center.covers)
+        {
+            auto connects = [&at, &block](int x, int y, TileCover requiredCover) {
+                const MountainPart::MountainCover *neighbor = at(x, y).getCover(block.brush);
+                return neighbor && (neighbor->cover & requiredCover);
+            };
+
+            if (!connects(0, -1, FullSouth))
+                TileCovers::eraseSide(block.cover, North);
+            if (!connects(1, 0, FullWest))
+                TileCovers::eraseSide(block.cover, East);
+            if (!connects(0, 1, FullNorth))
+                TileCovers::eraseSide(block.cover, South);
+            if (!connects(-1, 0, FullEast))
+                TileCovers::eraseSide(block.cover, West);
+
+            TileCover featureRemove = None;
+            if (!connects(-1, -1, Full | NorthEast | SouthWest | East | South | SouthEastCorner))
+                featureRemove |= NorthWestCorner;
+            if (!connects(1, -1, Full | NorthWest | SouthEast | West | South | SouthWestCorner))
+                featureRemove |= NorthEastCorner;
+            if (!connects(1, 1, Full | NorthWest | SouthWest | West | North | NorthWestCorner))
+                featureRemove |= SouthEastCorner;
+            if (!connects(-1, 1, Full | NorthWest | SouthEast | West | North | NorthEastCorner))
+                featureRemove |= SouthWestCorner;
+
+            if (featureRemove != None)
+            {
+                block.cover &= ~featureRemove;
+            }
+        }
+    }
+
+    // Removes the invalid covers of the 3x3 area around the center of a 5x5 neighborhood, like generalBorderize.
+    template <typename NeighborAt>
+    void removeInvalidCoversAround(NeighborAt &&at)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                removeInvalidCovers(at(dx, dy), [&at, dx, dy](int x, int y) -> const MountainPart::BorderBlock & {
+                    return at(dx + x, dy + y);
+                });
+            }
+        }
+    }
+
+    // The order in which fixBorders fixes the 3x3 area around a position. North and west are placed first so that
+    // mirroring works.
+    constexpr std::array<std::pair<int, int>, 9> FixBordersOrder = {{
+        {0, -1},
+        {-1, 0},
+        // Top
+        {-1, -1},
+        {1, -1},
+        // Middle
+        {0, 0},
+        {1, 0},
+        // Bottom
+        {-1, 1},
+        {0, 1},
+        {1, 1},
+    }};
+
+    // The covers of a tile as MountainNeighborMap::load reads them from the map.
+    void normalizeLoadedCovers(MountainPart::BorderBlock &block)
+    {
+        for (auto &cover : block.covers)
+        {
+            cover.cover = TileCovers::unifyTileCover(cover.cover, TileQuadrant::TopLeft);
+
+            if (!Settings::PLACE_MOUNTAIN_FEATURES)
+            {
+                cover.cover &= ~MountainBrush::Features;
+            }
+        }
+    }
+
+    /*
+        The mountain borders of a tile without a mountain ground, given its current covers and its neighbors.
+        The north and west neighbors are expected to have their final borders.
+    */
+    template <typename NeighborAt>
+    MountainPart::BorderBlock computeBorders(const MountainPart::BorderBlock &current, NeighborAt &&at)
+    {
+        using namespace TileCoverShortHands;
+
+        MountainPart::BorderBlock borderBlock;
+        borderBlock.ground = current.ground;
+
+        MountainNeighborMap::mirrorNorth(borderBlock, at(0, 1));
+        MountainNeighborMap::mirrorEast(borderBlock, at(-1, 0));
+        MountainNeighborMap::mirrorSouth(borderBlock, at(0, -1));
+        MountainNeighborMap::mirrorWest(borderBlock, at(1, 0));
+
+        // Do not use a mirrored diagonal if we already have a diagonal.
+        for (auto &block : borderBlock.covers)
+        {
+            auto cover = current.getCover(block.brush);
+            if (cover && cover->cover & Diagonals)
+            {
+                block.cover &= ~(Diagonals);
+            }
+        }
+
+        borderBlock.merge(current);
+
+        for (auto &cover : borderBlock.covers)
+        {
+            cover.cover = TileCovers::unifyTileCover(cover.cover, TileQuadrant::BottomRight);
+
+            // Special cases
+            if (!Settings::PLACE_MOUNTAIN_FEATURES)
+            {
+                TileCover &featureCover = cover.cover;
+
+                if ((featureCover & SouthWest) && !(at(1, 1).ground || at(1, 0).ground))
+                {
+                    featureCover &= ~SouthWest;
+                    if (!(featureCover & FullSouth))
+                    {
+                        featureCover |= South;
+                    }
+                }
+
+                if ((featureCover & NorthEast) && !(at(1, 1).ground || at(0, 1).ground))
+                {
+                    featureCover &= ~NorthEast;
+                    if (!(featureCover & FullEast))
+                    {
+                        featureCover |= East;
+                    }
+                }
+            }
+        }
+
+        return borderBlock;
+    }
+
+    // Calls f(brush, borderType) for every border that 'borderBlock' places, in the order that they are placed.
+    template <typename F>
+    void forEachBorderType(const MountainPart::BorderBlock &borderBlock, F &&f)
+    {
+        using namespace TileCoverShortHands;
+
+        for (const auto &block : borderBlock.covers)
+        {
+            auto cover = block.cover;
+            auto brush = block.brush;
+
+            if (cover & Full)
+            {
+                f(brush, BorderType::NorthWestDiagonal);
+                f(brush, BorderType::SouthEastDiagonal);
+                return;
+            }
+
+            auto applyIf = [&cover, &brush, &f](TileCover req, BorderType borderType) {
+                if (cover & req)
+                {
+                    f(brush, borderType);
+                }
+            };
+
+            // Sides
+            applyIf(North, BorderType::North);
+            applyIf(West, BorderType::West);
+
+            applyIf(NorthWest, BorderType::NorthWestDiagonal);
+
+            // Corners
+            if (cover & Corners)
+            {
+                applyIf(NorthEastCorner, BorderType::NorthEastCorner);
+                applyIf(NorthWestCorner, BorderType::NorthWestCorner);
+                applyIf(SouthWestCorner, BorderType::SouthWestCorner);
+            }
+
+            // Diagonals
+            if (cover & Diagonals)
+            {
+                applyIf(NorthEast, BorderType::NorthEastDiagonal);
+                applyIf(SouthWest, BorderType::SouthWestDiagonal);
+                applyIf(SouthEast, BorderType::SouthEastDiagonal);
+            }
+
+            applyIf(East, BorderType::East);
+            applyIf(South, BorderType::South);
+
+            applyIf(SouthEastCorner, BorderType::SouthEastCorner);
+        }
+    }
+} // namespace
+
 MountainBrush::MountainBrush(std::string id, std::string name, Brush::LazyGround ground, MountainPart::InnerWall innerWall, BorderData&& mountainBorders, uint32_t iconServerId)
     : Brush(std::move(name)), _id(std::move(id)), _ground(std::move(ground)), innerWall(innerWall), mountainBorder(std::move(mountainBorders)), _iconServerId(iconServerId)
 {
@@ -271,84 +481,193 @@ const MountainPart::MountainCover *MountainPart::BorderBlock::getCover(MountainB
 
 void MountainBrush::generalBorderize(MapView &mapView, const Position &position)
 {
-    using namespace TileCoverShortHands;
-
     MountainNeighborMap neighbors(position, *mapView.map());
 
-    for (int dx = -1; dx <= 1; ++dx)
-    {
-        for (int dy = -1; dy <= 1; ++dy)
+    removeInvalidCoversAround([&neighbors](int x, int y) -> MountainPart::BorderBlock & { return neighbors.at(x, y); });
+
+    fixBorders(mapView, position, neighbors);
+}
+
+void MountainBrush::borderizeRegion(MapView &mapView, const BrushFootprint &area, int z)
+{
+    if (area.empty())
+        return;
+
+    const Map &map = *mapView.map();
+
+    // generalBorderize changes the 3x3 area around a position, and reads the 5x5 area around it.
+    const BrushFootprint changedArea = area.expanded(1);
+    const BrushFootprint readArea = area.expanded(2);
+
+    const int minX = readArea.minX();
+    const int minY = readArea.minY();
+    const int width = readArea.maxX() - minX + 1;
+    const int height = readArea.maxY() - minY + 1;
+
+    auto index = [minX, minY, width](int x, int y) {
+        return static_cast<size_t>(y - minY) * static_cast<size_t>(width) + static_cast<size_t>(x - minX);
+    };
+
+    // The covers that MountainNeighborMap::load would read from the map after the generalBorderize calls so far
+    std::vector<MountainPart::BorderBlock> blocks(static_cast<size_t>(width) * static_cast<size_t>(height));
+    readArea.forEachPosition(z, [&](const Position &pos) {
+        if (pos.x >= 0 && pos.y >= 0)
         {
-            auto &center = neighbors.at(dx, dy);
-            for (auto &block : center.covers)
+            blocks[index(pos.x, pos.y)] = MountainNeighborMap::load(map, pos);
+        }
+    });
+
+    // The mountain items that the last generalBorderize call touching a tile placed on it
+    std::vector<std::vector<uint32_t>> placedIds(blocks.size());
+
+    auto hasMountainGround = [&map](const Position &pos) {
+        const Tile *tile = map.getTile(pos);
+        const Item *ground = tile ? tile->ground() : nullptr;
+        return ground && ground->itemType->hasFlag(ItemTypeFlag::InMountainBrush);
+    };
+
+    // Replays generalBorderize for every position on 'blocks', in row-major order like a fill of the area.
+    std::array<MountainPart::BorderBlock, 25> neighbors;
+    area.forEachPosition(z, [&](const Position &position) {
+        auto at = [&neighbors](int x, int y) -> MountainPart::BorderBlock & {
+            return neighbors[(y + 2) * 5 + (x + 2)];
+        };
+
+        for (int dy = -2; dy <= 2; ++dy)
+        {
+            for (int dx = -2; dx <= 2; ++dx)
+            {
+                at(dx, dy) = blocks[index(position.x + dx, position.y + dy)];
+            }
+        }
+
+        removeInvalidCoversAround(at);
+
+        for (const auto &[x, y] : FixBordersOrder)
+        {
+            Position pos = position + Position(x, y, 0);
+            if (pos.x < 0 || pos.y < 0)
+                continue;
+
+            auto &placed = placedIds[index(pos.x, pos.y)];
+            placed.clear();
+
+            const MountainPart::BorderBlock &current = at(x, y);
+            if (current.ground)
             {
-                TileCover featureRemove = None;
-
-#define fast_removeInvalidBorder(_x, _y, _requiredCover, _removeCover)            \
-    do                                                                            \
-    {                                                                             \
-        auto neighbor = neighbors.at(dx + (_x), dy + (_y)).getCover(block.brush); \
-        if (!(neighbor && (neighbor->cover & (_requiredCover))))                  \
-        {                                                                         \
-            featureRemove |= (_removeCover);                                      \
-        }                                                                         \
-    } while (false)
-
-#define fast_eraseInvalidSide(_x, _y, _requiredCover, _side)                      \
-    do                                                                            \
-    {                                                                             \
-        auto neighbor = neighbors.at(dx + (_x), dy + (_y)).getCover(block.brush); \
-        if (!(neighbor && (neighbor->cover & (_requiredCover))))                  \
-        {                                                                         \
-            TileCovers::eraseSide(block.cover, (_side));                          \
-        }                                                                         \
-    } while (false)
-
-                fast_eraseInvalidSide(0, -1, FullSouth, North);
-                fast_eraseInvalidSide(1, 0, FullWest, East);
-                fast_eraseInvalidSide(0, 1, FullNorth, South);
-                fast_eraseInvalidSide(-1, 0, FullEast, West);
-
-                fast_removeInvalidBorder(-1, -1, Full | NorthEast | SouthWest | East | South | SouthEastCorner, NorthWestCorner);
-                fast_removeInvalidBorder(1, -1, Full | NorthWest | SouthEast | West | South | SouthWestCorner, NorthEastCorner);
-                fast_removeInvalidBorder(1, 1, Full | NorthWest | SouthWest | West | North | NorthWestCorner, SouthEastCorner);
-                fast_removeInvalidBorder(-1, 1, Full | NorthWest | SouthEast | West | North | NorthEastCorner, SouthWestCorner);
-
-                if (featureRemove != None)
+                uint32_t innerWallId = current.ground->innerWallServerId(!at(x + 1, y).ground, !at(x, y + 1).ground);
+                if (innerWallId != 0 && Items::items.validItemType(innerWallId))
                 {
-                    block.cover &= ~featureRemove;
+                    placed.emplace_back(innerWallId);
                 }
+
+                continue;
+            }
+
+            // Same early exit as fixBordersAtOffset: the mountain items are removed, and nothing is placed.
+            MountainPart::BorderBlock placedCovers;
+            if (!hasMountainGround(pos))
+            {
+                MountainPart::BorderBlock borderBlock = computeBorders(current, [&at, x, y](int dx, int dy) -> const MountainPart::BorderBlock & {
+                    return at(x + dx, y + dy);
+                });
+
+                forEachBorderType(borderBlock, [&placed, &placedCovers](MountainBrush *brush, BorderType borderType) {
+                    auto borderItemId = featureServerId(brush, borderType);
+                    if (borderItemId && Items::items.validItemType(*borderItemId))
+                    {
+                        placed.emplace_back(*borderItemId);
+
+                        TileCover cover = brush->getTileCover(*borderItemId);
+                        if (cover != TILE_COVER_NONE)
+                        {
+                            placedCovers.add(cover, brush);
+                        }
+                    }
+                });
+
+                at(x, y) = std::move(borderBlock);
             }
+
+            // The next positions read the tile as it would be on the map.
+            normalizeLoadedCovers(placedCovers);
+            blocks[index(pos.x, pos.y)] = std::move(placedCovers);
         }
-    }
+    });
 
-    fixBorders(mapView, position, neighbors);
-}
+    MapHistory::Action action(MapHistory::ActionType::SetTile);
+    std::vector<uint16_t> removedIndices;
 
-void MountainBrush::fixBorders(MapView &mapView, const Position &position, MountainNeighborMap &neighbors)
-{
-    // Place north and west first so that mirroring works
-    fixBordersAtOffset(mapView, position, neighbors, 0, -1);
-    fixBordersAtOffset(mapView, position, neighbors, -1, 0);
+    changedArea.forEachPosition(z, [&](const Position &pos) {
+        if (pos.x < 0 || pos.y < 0)
+            return;
+
+        const Tile *tile = map.getTile(pos);
+        const auto &placed = placedIds[index(pos.x, pos.y)];
+
+        // The mountain ground is kept. Placing it again (like fixBordersAtOffset) would only resample it, but a
+        // ground brush also clears the borders below it.
+        const MountainPart::BorderBlock &block = blocks[index(pos.x, pos.y)];
+        bool clearBorders = block.ground && block.ground->ground()->type() == BrushType::Ground;
+
+        // The mountain items on the tile, and the borders at the bottom of the stack if the ground clears them
+        removedIndices.clear();
+        if (tile)
+        {
+            const auto &items = tile->items();
+
+            size_t borderCount = 0;
+            if (clearBorders)
+            {
+                while (borderCount < items.size() && items[borderCount]->itemType->isBorder())
+                {
+                    ++borderCount;
+                }
+            }
+
+            for (size_t i = 0; i < items.size(); ++i)
+            {
+                if (i < borderCount || items[i]->itemType->hasFlag(ItemTypeFlag::InMountainBrush))
+                {
+                    removedIndices.emplace_back(static_cast<uint16_t>(i));
+                }
+            }
+        }
+
+        bool unchanged = std::ranges::equal(removedIndices, placed, [tile](uint16_t index, uint32_t serverId) {
+            return tile->items()[index]->serverId() == serverId;
+        });
 
-    // Top
-    fixBordersAtOffset(mapView, position, neighbors, -1, -1);
-    fixBordersAtOffset(mapView, position, neighbors, 1, -1);
+        if (unchanged)
+            return;
 
-    // Middle
-    fixBordersAtOffset(mapView, position, neighbors, 0, 0);
-    fixBordersAtOffset(mapView, position, neighbors, 1, 0);
+        for (auto it = removedIndices.rbegin(); it != removedIndices.rend(); ++it)
+        {
+            action.addChange(MapHistory::TileDelta::removeItem(pos, *it));
+        }
 
-    // Bottom
-    fixBordersAtOffset(mapView, position, neighbors, -1, 1);
-    fixBordersAtOffset(mapView, position, neighbors, 0, 1);
-    fixBordersAtOffset(mapView, position, neighbors, 1, 1);
+        for (uint32_t serverId : placed)
+        {
+            action.addChange(MapHistory::TileDelta::addItem(pos, Item(serverId)));
+        }
+    });
+
+    if (!action.changes.empty())
+    {
+        mapView.history.commit(std::move(action));
+    }
 }
 
-void MountainBrush::fixBordersAtOffset(MapView &mapView, const Position &position, MountainNeighborMap &neighbors, int x, int y)
+void MountainBrush::fixBorders(MapView &mapView, const Position &position, MountainNeighborMap &neighbors)
 {
-    using namespace TileCoverShortHands;
+    for (const auto &[x, y] : FixBordersOrder)
+    {
+        fixBordersAtOffset(mapView, position, neighbors, x, y);
+    }
+}
 
+void MountainBrush::fixBordersAtOffset(MapView &mapView, const Position &position, MountainNeighborMap &neighbors, int x, int y)
+{
     auto pos = position + Position(x, y, 0);
 
     if (mapView.hasTile(pos))
@@ -371,20 +690,10 @@ void MountainBrush::fixBordersAtOffset(MapView &mapView, const Position &positio
 
         currentCover.ground->ground()->applyWithoutBorderize(mapView, pos);
 
-        bool innerEast = !neighbors.at(x + 1, y).ground;
-        bool innerSouth = !neighbors.at(x, y + 1).ground;
-
-        if (innerEast && innerSouth)
+        uint32_t innerWallId = currentCover.ground->innerWallServerId(!neighbors.at(x + 1, y).ground, !neighbors.at(x, y + 1).ground);
+        if (innerWallId != 0)
         {
-            mapView.addItem(pos, currentCover.ground->innerWall.southEast);
-        }
-        else if (innerEast)
-        {
-            mapView.addItem(pos, currentCover.ground->innerWall.east);
-        }
-        else if (innerSouth)
-        {
-            mapView.addItem(pos, currentCover.ground->innerWall.south);
+            mapView.addItem(pos, innerWallId);
         }
 
         return;
@@ -400,135 +709,15 @@ void MountainBrush::fixBordersAtOffset(MapView &mapView, const Position &positio
         }
     }
 
-    MountainPart::BorderBlock borderBlock;
-    borderBlock.ground = currentCover.ground;
-
-    MountainNeighborMap::mirrorNorth(borderBlock, neighbors.at(x, y + 1));
-    MountainNeighborMap::mirrorEast(borderBlock, neighbors.at(x - 1, y));
-    MountainNeighborMap::mirrorSouth(borderBlock, neighbors.at(x, y - 1));
-    MountainNeighborMap::mirrorWest(borderBlock, neighbors.at(x + 1, y));
-
-    // MountainNeighborMap::mirrorNorthWest(borderBlock, neighbors.at(x - 1, y - 1));
-    // MountainNeighborMap::mirrorNorthEast(borderBlock, neighbors.at(x + 1, y - 1));
-    // MountainNeighborMap::mirrorSouthEast(borderBlock, neighbors.at(x + 1, y + 1));
-    // MountainNeighborMap::mirrorSouthWest(borderBlock, neighbors.at(x - 1, y + 1));
-
-    // Do not use a mirrored diagonal if we already have a diagonal.
-    for (auto &block : borderBlock.covers)
-    {
-        auto current = currentCover.getCover(block.brush);
-        if (current && current->cover & Diagonals)
-        {
-            block.cover &= ~(Diagonals);
-        }
-    }
-
-    borderBlock.merge(currentCover);
-
-    // auto quadrant = mapView.getMouseDownTileQuadrant();
-
-    // // TileQuadrant quadrant = getNeighborQuadrant(x, y);
-    for (auto &cover : borderBlock.covers)
-    {
-        //     // Compute preferred diagonal
-        //     TileCover preferredDiagonal = block.cover & Diagonals;
-        //     if (x == 0 && y == 0)
-        //     {
-        //         if (quadrant)
-        //         {
-        //             switch (*quadrant)
-        //             {
-        //                 case TileQuadrant::TopLeft:
-        //                     preferredDiagonal = NorthWest;
-        //                     break;
-        //                 case TileQuadrant::TopRight:
-        //                     preferredDiagonal = NorthEast;
-        //                     break;
-        //                 case TileQuadrant::BottomRight:
-        //                     preferredDiagonal = SouthEast;
-        //                     break;
-        //                 case TileQuadrant::BottomLeft:
-        //                     preferredDiagonal = SouthWest;
-        //                     break;
-        //             }
-        //         }
-        //     }
-        cover.cover = TileCovers::unifyTileCover(cover.cover, TileQuadrant::BottomRight);
-
-        // Special cases
-        if (!Settings::PLACE_MOUNTAIN_FEATURES)
-        {
-            TileCover &featureCover = cover.cover;
-            // cover &= ~MountainBrush::features;
-
-            if ((featureCover & SouthWest) && !(neighbors.at(x + 1, y + 1).ground || neighbors.at(x + 1, y).ground))
-            {
-                featureCover &= ~SouthWest;
-                if (!(featureCover & FullSouth))
-                {
-                    featureCover |= South;
-                }
-            }
-
-            if ((featureCover & NorthEast) && !(neighbors.at(x + 1, y + 1).ground || neighbors.at(x, y + 1).ground))
-            {
-                featureCover &= ~NorthEast;
-                if (!(featureCover & FullEast))
-                {
-                    featureCover |= East;
-                }
-            }
-        }
-    }
+    MountainPart::BorderBlock borderBlock = computeBorders(currentCover, [&neighbors, x, y](int dx, int dy) -> const MountainPart::BorderBlock & {
+        return neighbors.at(x + dx, y + dy);
+    });
 
     neighbors.set(x, y, borderBlock);
 
-    for (const auto &block : borderBlock.covers)
-    {
-        auto cover = block.cover;
-        auto brush = block.brush;
-
-        if (cover & Full)
-        {
-            applyFeature(mapView, pos, brush, BorderType::NorthWestDiagonal);
-            applyFeature(mapView, pos, brush, BorderType::SouthEastDiagonal);
-            return;
-        }
-
-        auto applyIf = [&cover, &mapView, &pos, &brush](TileCover req, BorderType borderType) {
-            if (cover & req)
-            {
-                applyFeature(mapView, pos, brush, borderType);
-            }
-        };
-
-        // Sides
-        applyIf(North, BorderType::North);
-        applyIf(West, BorderType::West);
-
-        applyIf(NorthWest, BorderType::NorthWestDiagonal);
-
-        // Corners
-        if (cover & Corners)
-        {
-            applyIf(NorthEastCorner, BorderType::NorthEastCorner);
-            applyIf(NorthWestCorner, BorderType::NorthWestCorner);
-            applyIf(SouthWestCorner, BorderType::SouthWestCorner);
-        }
-
-        // Diagonals
-        if (cover & Diagonals)
-        {
-            applyIf(NorthEast, BorderType::NorthEastDiagonal);
-            applyIf(SouthWest, BorderType::SouthWestDiagonal);
-            applyIf(SouthEast, BorderType::SouthEastDiagonal);
-        }
-
-        applyIf(East, BorderType::East);
-        applyIf(South, BorderType::South);
-
-        applyIf(SouthEastCorner, BorderType::SouthEastCorner);
-    }
+    forEachBorderType(borderBlock, [&mapView, &pos](MountainBrush *brush, BorderType borderType) {
+        applyFeature(mapView, pos, brush, borderType);
+    });
 }
 
 uint32_t MountainPart::BorderBlock::zOrder() const noexcept
@@ -538,13 +727,42 @@ uint32_t MountainPart::BorderBlock::zOrder() const noexcept
 }
 
 void MountainBrush::applyFeature(MapView &mapView, const Position &position, MountainBrush *brush, BorderType borderType)
+{
+    auto borderItemId = featureServerId(brush, borderType);
+    if (borderItemId)
+    {
+        mapView.addItem(position, *borderItemId);
+    }
+}
+
+std::optional<uint32_t> MountainBrush::featureServerId(MountainBrush *brush, BorderType borderType)
 {
     auto borderItemId = brush->mountainBorder.getServerId(borderType);
 
     if (borderItemId && (!isFeature(TileCovers::fromBorderType(borderType)) || Settings::PLACE_MOUNTAIN_FEATURES))
     {
-        mapView.addItem(position, *borderItemId);
+        return borderItemId;
     }
+
+    return std::nullopt;
+}
+
+uint32_t MountainBrush::innerWallServerId(bool innerEast, bool innerSouth) const noexcept
+{
+    if (innerEast && innerSouth)
+    {
+        return innerWall.southEast;
+    }
+    else if (innerEast)
+    {
+        return innerWall.east;
+    }
+    else if (innerSouth)
+    {
+        return innerWall.south;
+    }
+
+    return 0;
 }
 
 MountainPart::MountainCover::MountainCover(TileCover cover, MountainBrush *brush)
@@ -558,30 +776,29 @@ MountainPart::MountainCover::MountainCover(TileCover cover, MountainBrush *brush
 
 MountainNeighborMap::MountainNeighborMap(const Position &position, const Map &map)
 {
-    TileCover noFeatureMask = ~MountainBrush::Features;
     for (int dy = -2; dy <= 2; ++dy)
     {
         for (int dx = -2; dx <= 2; ++dx)
         {
-            auto borderBlock = getTileCoverAt(map, position + Position(dx, dy, 0));
-            if (borderBlock)
-            {
-                for (auto &cover : borderBlock->covers)
-                {
-                    cover.cover = TileCovers::unifyTileCover(cover.cover, TileQuadrant::TopLeft);
-
-                    if (!Settings::PLACE_MOUNTAIN_FEATURES)
-                    {
-                        cover.cover &= noFeatureMask;
-                    }
-                }
-                set(dx, dy, *borderBlock);
-            }
+            set(dx, dy, load(map, position + Position(dx, dy, 0)));
         }
     }
 }
 
-bool MountainNeighborMap::isMountainFeaturePart(const ItemType &itemType) const
+MountainPart::BorderBlock MountainNeighborMap::load(const Map &map, const Position &position)
+{
+    auto borderBlock = getTileCoverAt(map, position);
+    if (!borderBlock)
+    {
+        return MountainPart::BorderBlock{};
+    }
+
+    normalizeLoadedCovers(*borderBlock);
+
+    return *borderBlock;
+}
+
+bool MountainNeighborMap::isMountainFeaturePart(const ItemType &itemType)
 {
     Brush *brush = itemType.getBrush(BrushType::Mountain);
     if (!brush)
@@ -617,7 +834,7 @@ int MountainNeighborMap::index(int x, int y) const
     return (y + 2) * 5 + (x + 2);
 }
 
-std::optional<MountainPart::BorderBlock> MountainNeighborMap::getTileCoverAt(const Map &map, const Position position) const
+std::optional<MountainPart::BorderBlock> MountainNeighborMap::getTileCoverAt(const Map &map, const Position position)
 {
     Tile *tile = map.getTile(position);
 
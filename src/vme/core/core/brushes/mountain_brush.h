@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <variant>
@@ -10,6 +11,7 @@
 #include "brush.h"
 
 struct Position;
+class BrushFootprint;
 class MapView;
 class Tile;
 class GroundBrush;
@@ -66,6 +68,14 @@ class MountainBrush final : public Brush
 
     static void generalBorderize(MapView &mapView, const Position &position);
 
+    /*
+        Like generalBorderize for every position in 'area' in row-major order, as one history action. The mountain
+        covers of the area and the two-tile rim around it are read from the map once, and the generalBorderize calls
+        are replayed on them in memory. The result is the same, except that mountain grounds are kept instead of
+        being placed again. Tiles whose mountain items do not change are left untouched.
+    */
+    static void borderizeRegion(MapView &mapView, const BrushFootprint &area, int z);
+
     void apply(MapView &mapView, const Position &position) override;
     void applyWithoutBorderize(MapView &mapView, const Position &position) override;
     void erase(MapView &mapView, const Position &position) override;
@@ -110,6 +120,12 @@ class MountainBrush final : public Brush
     static void applyFeature(MapView &mapView, const Position &position, MountainBrush *brush, BorderType borderType);
     static void applyBorder(MapView &mapView, const Position &position, MountainBrush *brush, BorderType borderType);
 
+    // The item of a border, if it is placed with the current settings (see Settings::PLACE_MOUNTAIN_FEATURES)
+    static std::optional<uint32_t> featureServerId(MountainBrush *brush, BorderType borderType);
+
+    // The inner wall for a mountain tile whose east and/or south neighbors are not mountain, or 0 for none
+    uint32_t innerWallServerId(bool innerEast, bool innerSouth) const noexcept;
+
     void postBorderizePass(MapView &mapView, const Position &position);
 
     BorderType getBorderType(uint32_t serverId) const;
@@ -138,6 +154,10 @@ struct MountainNeighborMap
 {
     using value_type = MountainPart::BorderBlock;
     MountainNeighborMap(const Position &position, const Map &map);
+
+    // The covers of the tile at 'position', as they are read into the neighbor map
+    static value_type load(const Map &map, const Position &position);
+
     value_type at(int x, int y) const;
     value_type &at(int x, int y);
     value_type &center();
@@ -149,7 +169,7 @@ struct MountainNeighborMap
 
     TileCover getExcludeMask(int dx, int dy);
 
-    std::vector<ExpandedTileBlock> expandedCovers;
+    ExpandedTileBlocks expandedCovers;
 
     static void addBorderFromGround(value_type &self, const value_type &other, TileCover border);
 
@@ -167,8 +187,8 @@ struct MountainNeighborMap
 
   private:
     int index(int x, int y) const;
-    std::optional<MountainPart::BorderBlock> getTileCoverAt(const Map &map, const Position position) const;
-    bool isMountainFeaturePart(const ItemType &itemType) const;
+    static std::optional<MountainPart::BorderBlock> getTileCoverAt(const Map &map, const Position position);
+    static bool isMountainFeaturePart(const ItemType &itemType);
 
     std::array<value_type, 25> data;
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "../position.h"
+#include "../util.h"
+
+/*
+    One bit per tile, stored in 32x32 chunks that are created on first use. Used to track the tiles that are
+    taken while placing many things over an area, so that a conflict check is a bit test instead of a tile lookup.
+*/
+class OccupancyGrid
+{
+  public:
+    static constexpr int ChunkShift = 5;
+    static constexpr int ChunkSize = 1 << ChunkShift;
+
+    bool test(const Position &position) const
+    {
+        const Chunk *chunk = findChunk(position);
+        return chunk && (chunk->rows[localY(position)] & bit(position));
+    }
+
+    void set(const Position &position)
+    {
+        getOrCreateChunk(position).rows[localY(position)] |= bit(position);
+    }
+
+    void clear()
+    {
+        chunkIndices.clear();
+        chunks.clear();
+        lastKey = NoChunk;
+    }
+
+    // The number of chunks that have been created
+    size_t chunkCount() const noexcept
+    {
+        return chunks.size();
+    }
+
+  private:
+    struct Chunk
+    {
+        std::array<uint32_t, ChunkSize> rows{};
+    };
+
+    static constexpr uint64_t NoChunk = ~uint64_t(0);
+
+    static uint64_t chunkKey(const Position &position) noexcept
+    {
+        auto chunkX = static_cast<uint32_t>(position.x >> ChunkShift);
+        auto chunkY = static_cast<uint32_t>(position.y >> ChunkShift);
+
+        // Chunk coordinates use at most 27 bits
+        return (static_cast<uint64_t>(chunkY & 0x7FFFFFF) << 27 | (chunkX & 0x7FFFFFF)) | (static_cast<uint64_t>(static_cast<uint8_t>(position.z)) << 54);
+    }
+
+    static int localY(const Position &position) noexcept
+    {
+        return position.y & (ChunkSize - 1);
+    }
+
+    static uint32_t bit(const Position &position) noexcept
+    {
+        return uint32_t(1) << (position.x & (ChunkSize - 1));
+    }
+
+    const Chunk *findChunk(const Position &position) const
+    {
+        uint64_t key = chunkKey(position);
+        if (key == lastKey)
+            return &chunks[lastIndex];
+
+        auto found = chunkIndices.find(key);
+        if (found == chunkIndices.end())
+            return nullptr;
+
+        lastKey = key;
+        lastIndex = found->second;
+        return &chunks[lastIndex];
+    }
+
+    Chunk &getOrCreateChunk(const Position &position)
+    {
+        uint64_t key = chunkKey(position);
+        if (key != lastKey)
+        {
+            auto found = chunkIndices.find(key);
+            if (found == chunkIndices.end())
+            {
+                found = chunkIndices.emplace(key, static_cast<uint32_t>(chunks.size())).first;
+                chunks.emplace_back();
+            }
+
+            lastKey = key;
+            lastIndex = found->second;
+        }
+
+        return chunks[lastIndex];
+    }
+
+    vme_unordered_map<uint64_t, uint32_t> chunkIndices;
+    std::vector<Chunk> chunks;
+
+    // Consecutive lookups are usually in the same chunk
+    mutable uint64_t lastKey = NoChunk;
+    mutable uint32_t lastIndex = 0;
+};
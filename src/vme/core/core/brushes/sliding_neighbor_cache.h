@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+#include "../position.h"
+
+/*
+    Caches a value for every tile in the 5x5 area around the position that a brush was last applied to. While
+    dragging a brush, consecutive positions are adjacent, so moving the cache to the next position keeps most of
+    the area and only loads the new edge.
+
+    The cache does not see the changes to the map. The user must invalidate the tiles that it changes, and pass
+    the map state to validate and setRevision (see MapHistory::History::revision) so that other changes drop the
+    whole cache.
+*/
+template <typename T>
+class SlidingNeighborCache
+{
+  public:
+    static constexpr int Radius = 2;
+    static constexpr int Size = 2 * Radius + 1;
+
+    /*
+        Drops the cache unless it was last used with 'owner' and nothing has changed since setRevision.
+    */
+    void validate(const void *owner, uint64_t revision)
+    {
+        if (owner != this->owner || revision != this->revision)
+        {
+            clear();
+            this->owner = owner;
+            this->revision = revision;
+        }
+    }
+
+    /*
+        Moves the cache to the area around 'center'. 'load(position)' is called for the tiles that are not cached.
+    */
+    template <typename Load>
+    void moveTo(const Position &center, Load &&load)
+    {
+        bool overlaps = hasCenter && center.z == this->center.z;
+        int shiftX = center.x - this->center.x;
+        int shiftY = center.y - this->center.y;
+
+        for (int dy = -Radius; dy <= Radius; ++dy)
+        {
+            for (int dx = -Radius; dx <= Radius; ++dx)
+            {
+                Entry &entry = scratch[index(dx, dy)];
+
+                int oldX = dx + shiftX;
+                int oldY = dy + shiftY;
+                if (overlaps && contains(oldX, oldY) && entries[index(oldX, oldY)].valid)
+                {
+                    std::swap(entry, entries[index(oldX, oldY)]);
+                }
+                else
+                {
+                    entry.value = load(center + Position(dx, dy, 0));
+                    entry.valid = true;
+                    ++_loads;
+                }
+            }
+        }
+
+        std::swap(entries, scratch);
+        for (Entry &entry : scratch)
+        {
+            entry.valid = false;
+        }
+
+        this->center = center;
+        hasCenter = true;
+    }
+
+    // Offsets are relative to the center given to moveTo.
+    const T &at(int dx, int dy) const
+    {
+        return entries[index(dx, dy)].value;
+    }
+
+    /*
+        Marks the tiles within 'radius' of 'position' as changed, so that they are loaded again by the next moveTo.
+    */
+    void invalidate(const Position &position, int radius)
+    {
+        if (!hasCenter || position.z != center.z)
+            return;
+
+        for (int dy = -radius; dy <= radius; ++dy)
+        {
+            for (int dx = -radius; dx <= radius; ++dx)
+            {
+                int x = position.x + dx - center.x;
+                int y = position.y + dy - center.y;
+                if (contains(x, y))
+                {
+                    entries[index(x, y)].valid = false;
+                }
+            }
+        }
+    }
+
+    // The map state after the owner's own changes.
+    void setRevision(uint64_t revision)
+    {
+        this->revision = revision;
+    }
+
+    void clear()
+    {
+        for (Entry &entry : entries)
+        {
+            entry.valid = false;
+        }
+        hasCenter = false;
+    }
+
+    // The number of tiles that have been loaded
+    size_t loads() const noexcept
+    {
+        return _loads;
+    }
+
+  private:
+    struct Entry
+    {
+        T value{};
+        bool valid = false;
+    };
+
+    static constexpr bool contains(int dx, int dy)
+    {
+        return -Radius <= dx && dx <= Radius && -Radius <= dy && dy <= Radius;
+    }
+
+    static constexpr int index(int dx, int dy)
+    {
+        return (dy + Radius) * Size + (dx + Radius);
+    }
+
+    std::array<Entry, Size * Size> entries;
+    // Reused by moveTo to keep the allocations of the values
+    std::array<Entry, Size * Size> scratch;
+
+    const void *owner = nullptr;
+    uint64_t revision = 0;
+
+    Position center;
+    bool hasCenter = false;
+
+    size_t _loads = 0;
+};
@@ -1,9 +1,12 @@
 #include "wall_brush.h"
 
+#include <algorithm>
+
 #include "../items.h"
 #include "../map_view.h"
 #include "../random.h"
 #include "../settings.h"
+#include "wall_stroke.h"
 
 WallBrush::WallBrush(std::string id, const std::string &name, StraightPart &&horizontal, StraightPart &&vertical, Part &&corner, Part &&pole)
     : Brush(name), id(id), horizontal(std::move(horizontal)), vertical(std::move(vertical)), corner(std::move(corner)), pole(std::move(pole))
@@ -78,50 +81,84 @@ void WallBrush::apply(MapView &mapView, const Position &position)
 
 void WallBrush::connectWalls(MapView &mapView, WallNeighborMap &neighbors, const Position &center)
 {
-    for (int y = -1; y <= 1; ++y)
+    WallStroke::connect(
+        [&neighbors](int x, int y) { return neighbors.at(x, y); },
+        [this, &mapView, &center](int x, int y, WallType wallType) {
+            placeWall(mapView, center + Position(x, y, 0), wallType);
+        });
+}
+
+void WallBrush::applyStroke(MapView &mapView, const std::vector<Position> &positions)
+{
+    if (!Settings::AUTO_BORDER)
     {
-        for (int x = -1; x <= 1; ++x)
+        for (const auto &position : positions)
         {
-            if (!neighbors.at(x, y))
-            {
-                continue;
-            }
+            apply(mapView, position);
+        }
+        return;
+    }
 
-            auto pos = center + Position(x, y, 0);
+    WallStroke stroke;
+    for (const auto &position : positions)
+    {
+        stroke.place(position);
+    }
 
-            WallType wallType = WallType::Pole;
-            bool hasLeft = neighbors.at(x - 1, y);
-            if (hasLeft)
-            {
-                bool hasTop = neighbors.at(x, y - 1);
-                wallType = hasTop ? WallType::Corner : WallType::Horizontal;
-            }
-            else
-            {
-                bool hasTop = neighbors.at(x, y - 1);
-                if (hasTop)
-                {
-                    wallType = WallType::Vertical;
-                }
-            }
+    const Map &map = *mapView.map();
 
-            uint32_t serverId = sampleServerId(wallType);
-            if (Items::items.getItemTypeByServerId(serverId)->isBottom())
-            {
-                mapView.setBottomItem(pos, serverId);
-            }
-            else
-            {
-                mapView.removeItems(pos, [this](const Item &item) {
-                    return this->includes(item.serverId());
-                });
+    // Compute every type before placing anything, since the types are computed from the map before the stroke.
+    std::vector<std::pair<Position, WallType>> walls;
+    stroke.resolve(
+        [this, &map](const Position &position) {
+            const Tile *tile = map.getTile(position);
+            return tile && tile->hasWall(this);
+        },
+        [&walls](const Position &position, WallType wallType) {
+            walls.emplace_back(position, wallType);
+        });
 
-                mapView.addItem(pos, serverId);
-            }
+    for (const auto &[position, wallType] : walls)
+    {
+        const Tile *tile = map.getTile(position);
+        if (!tile || !hasWallOfType(*tile, wallType))
+        {
+            placeWall(mapView, position, wallType);
         }
     }
 }
 
+void WallBrush::placeWall(MapView &mapView, const Position &position, WallType wallType)
+{
+    uint32_t serverId = sampleServerId(wallType);
+    if (Items::items.getItemTypeByServerId(serverId)->isBottom())
+    {
+        mapView.setBottomItem(position, serverId);
+    }
+    else
+    {
+        mapView.removeItems(position, [this](const Item &item) {
+            return this->includes(item.serverId());
+        });
+
+        mapView.addItem(position, serverId);
+    }
+}
+
+bool WallBrush::hasWallOfType(const Tile &tile, WallType wallType) const
+{
+    const auto &items = tile.items();
+    auto wall = std::find_if(items.rbegin(), items.rend(), [this](const std::shared_ptr<Item> &item) {
+        return this->includes(item->serverId());
+    });
+
+    if (wall == items.rend())
+        return false;
+
+    uint32_t serverId = (*wall)->serverId();
+    return std::ranges::any_of(getPart(wallType).items, [serverId](const WeightedItemId &entry) { return entry.id == serverId; });
+}
+
 const WallBrush::Part &WallBrush::getPart(WallType type) const
 {
     switch (type)
@@ -241,29 +278,33 @@ void WallBrush::applyInRectangleArea(MapView &mapView, const Position &from, con
 
     int z = from.z;
 
+    std::vector<Position> positions;
+
     // Top
     for (int x = minX; x <= maxX; ++x)
     {
-        apply(mapView, Position(x, minY, z));
+        positions.emplace_back(x, minY, z);
     }
 
     // Right
     for (int y = minY + 1; y < maxY; ++y)
     {
-        apply(mapView, Position(maxX, y, z));
+        positions.emplace_back(maxX, y, z);
     }
 
     // Bottom
     for (int x = minX; x <= maxX; ++x)
     {
-        apply(mapView, Position(x, maxY, z));
+        positions.emplace_back(x, maxY, z);
     }
 
     // Left
     for (int y = minY + 1; y < maxY; ++y)
     {
-        apply(mapView, Position(minX, y, z));
+        positions.emplace_back(minX, y, z);
     }
+
+    applyStroke(mapView, positions);
 }
 
 std::string WallBrush::getDisplayId() const
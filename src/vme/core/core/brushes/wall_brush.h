@@ -52,6 +52,13 @@ class WallBrush final : public Brush
     std::vector<ThingDrawInfo> getPreviewTextureInfo(int variation) const override;
     std::vector<ThingDrawInfo> getPreviewTextureInfo(Position from, Position to) const;
 
+    /*
+        Places a wall at every position and connects the walls like apply does for each position, but the wall
+        types of the whole stroke are computed in one pass at the end (see WallStroke). Walls that already have
+        the right type are left as they are.
+    */
+    void applyStroke(MapView &mapView, const std::vector<Position> &positions);
+
     void applyInRectangleArea(MapView &mapView, const Position &from, const Position &to);
 
     std::string getDisplayId() const override;
@@ -76,6 +83,10 @@ class WallBrush final : public Brush
     uint32_t sampleServerId(WallType type) const;
 
     void connectWalls(MapView &mapView, WallNeighborMap &neighbors, const Position &center);
+    void placeWall(MapView &mapView, const Position &position, WallType wallType);
+
+    // True if the top wall of this brush on the tile is a plain wall (not a door or window) of 'wallType'
+    bool hasWallOfType(const Tile &tile, WallType wallType) const;
 
     std::unordered_set<uint32_t> _serverIds;
 
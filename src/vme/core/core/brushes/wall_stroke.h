@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vector>
+
+#include "../const.h"
+#include "../position.h"
+#include "occupancy_grid.h"
+
+/*
+    Resolves the wall types of a stroke of wall placements at once (see WallBrush::applyStroke).
+
+    Placing a wall one tile at a time reads the 5x5 area around the tile and sets the type of every wall in the
+    3x3 area around it, so a line of walls reads and writes most tiles several times. A stroke collects the
+    placed walls and the 3x3 areas around them, and then computes every wall type once from the final walls. The
+    types are the same as when the walls are placed one at a time: the type of a wall only depends on the walls
+    to its left and top, and a wall is recomputed whenever a wall is placed next to it.
+*/
+class WallStroke
+{
+  public:
+    // The type of a wall, given whether the tiles to its left and top have walls
+    static constexpr WallType wallType(bool hasLeft, bool hasTop) noexcept
+    {
+        if (hasLeft)
+        {
+            return hasTop ? WallType::Corner : WallType::Horizontal;
+        }
+
+        return hasTop ? WallType::Vertical : WallType::Pole;
+    }
+
+    /*
+        The per-tile rule of WallBrush::apply: calls f(x, y, wallType) for every wall in the 3x3 area around a
+        tile. 'hasWall(x, y)' tells whether the tile at offset (x, y) from that tile has a wall, for offsets in the
+        5x5 area around it.
+    */
+    template <typename HasWall, typename F>
+    static void connect(HasWall &&hasWall, F &&f)
+    {
+        for (int y = -1; y <= 1; ++y)
+        {
+            for (int x = -1; x <= 1; ++x)
+            {
+                if (hasWall(x, y))
+                {
+                    f(x, y, wallType(hasWall(x - 1, y), hasWall(x, y - 1)));
+                }
+            }
+        }
+    }
+
+    void place(const Position &position)
+    {
+        if (placedWalls.test(position))
+            return;
+
+        placedWalls.set(position);
+
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                Position pos = position + Position(dx, dy, 0);
+                if (!dirty.test(pos))
+                {
+                    dirty.set(pos);
+                    dirtyPositions.emplace_back(pos);
+                }
+            }
+        }
+    }
+
+    /*
+        Calls f(position, wallType) for every wall in the 3x3 areas around the placed walls. 'hasWall(position)'
+        tells whether the map has a wall before the stroke, and is called at most once per tile.
+    */
+    template <typename HasWall, typename F>
+    void resolve(HasWall &&hasWall, F &&f)
+    {
+        auto isWall = [this, &hasWall](const Position &position) {
+            if (placedWalls.test(position))
+                return true;
+
+            if (!checked.test(position))
+            {
+                checked.set(position);
+                if (hasWall(position))
+                {
+                    mapWalls.set(position);
+                }
+            }
+
+            return mapWalls.test(position);
+        };
+
+        for (const Position &position : dirtyPositions)
+        {
+            if (isWall(position))
+            {
+                f(position, wallType(isWall(position + Position(-1, 0, 0)), isWall(position + Position(0, -1, 0))));
+            }
+        }
+    }
+
+    bool empty() const noexcept
+    {
+        return dirtyPositions.empty();
+    }
+
+  private:
+    OccupancyGrid placedWalls;
+    OccupancyGrid dirty;
+    std::vector<Position> dirtyPositions;
+
+    // Map reads of resolve
+    OccupancyGrid checked;
+    OccupancyGrid mapWalls;
+};
@@ -22,116 +22,11 @@
 #include "../util.h"
 #include "texture_atlas.h"
 
-//////////////////////////////////
-//////////////////////////////////
-//////////////////////////////////
-//////////////////////////////////
-//////////////////////////////////
-//////////////////////////////////
-//////////////////////////////////
-
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-// >>>>>>>Fast upper bound>>>>>>>
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-// Fast upper bound from https://academy.realm.io/posts/how-we-beat-cpp-stl-binary-search/
-using namespace std;
-
-#ifndef _MSC_VER
-#define UNLIKELY(expr) __builtin_expect(!!(expr), 0)
-#define LIKELY(expr) __builtin_expect(!!(expr), 1)
-#else
-#define UNLIKELY(expr) (expr)
-#define LIKELY(expr) (expr)
-#endif
-
-#if defined(__GNUC__) || defined(__HP_aCC) || defined(__clang__)
-#define INLINE inline __attribute__((always_inline))
-#else
-#define INLINE __forceinline
-#endif
-
-// Force clang to use conditional move instead of branches. For other types of T than 64-bit integers, please
-// rewrite the assembly or use the ternary operator below instead.
-template <class T>
-INLINE size_t choose(T a, T b, size_t src1, size_t src2)
-{
-// #if defined(__clang__) && defined(__x86_64)
-//     size_t res = src1;
-//     asm("cmpq %1, %2; cmovaeq %4, %0"
-//         : "=q"(res)
-//         : "q"(a),
-//           "q"(b),
-//           "q"(src1),
-//           "q"(src2),
-//           "0"(res)
-//         : "cc");
-//     return res;
-// #else
-    return b >= a ? src2 : src1;
-// #endif
-}
-
-template <class T>
-INLINE size_t fast_upper_bound4(const vector<T> &vec, T value)
-{
-    size_t size = vec.size();
-    size_t low = 0;
-
-    while (size >= 8)
-    {
-        size_t half = size / 2;
-        size_t other_half = size - half;
-        size_t probe = low + half;
-        size_t other_low = low + other_half;
-        T v = vec[probe];
-        size = half;
-        low = choose(v, value, low, other_low);
-
-        half = size / 2;
-        other_half = size - half;
-        probe = low + half;
-        other_low = low + other_half;
-        v = vec[probe];
-        size = half;
-        low = choose(v, value, low, other_low);
-
-        half = size / 2;
-        other_half = size - half;
-        probe = low + half;
-        other_low = low + other_half;
-        v = vec[probe];
-        size = half;
-        low = choose(v, value, low, other_low);
-    }
-
-    while (size > 0)
-    {
-        size_t half = size / 2;
-        size_t other_half = size - half;
-        size_t probe = low + half;
-        size_t other_low = low + other_half;
-        T v = vec[probe];
-        size = half;
-        low = choose(v, value, low, other_low);
-    };
-
-    return low;
-}
-
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-// >>>>>>>Fast upper bound>>>>>>>
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-
 vme_unordered_map<uint32_t, ObjectAppearance> Appearances::_objects;
 vme_unordered_map<uint32_t, CreatureAppearance> Appearances::_creatures;
 
-std::vector<SpriteRange> Appearances::textureAtlasSpriteRanges;
-std::vector<int> Appearances::textureAtlasSpriteRangeIndex;
 vme_unordered_map<uint32_t, std::unique_ptr<TextureAtlas>> Appearances::textureAtlases;
+TextureAtlasIndex Appearances::textureAtlasIndex;
 
 bool Appearances::isLoaded;
 
@@ -156,24 +51,24 @@ void Appearances::loadAppearanceData(const std::filesystem::path path)
         }
     }
 
-    TimePoint startObjects;
-    for (int i = 0; i < parsed.object_size(); ++i)
+    loadAppearanceData(parsed);
+
+    VME_LOG("Loaded appearances.dat in " << start.elapsedMillis() << " ms.");
+}
+
+void Appearances::loadAppearanceData(const proto::Appearances &appearances)
+{
+    for (int i = 0; i < appearances.object_size(); ++i)
     {
-        const proto::Appearance &object = parsed.object(i);
+        const proto::Appearance &object = appearances.object(i);
         Appearances::_objects.emplace(object.id(), object);
     }
-    auto objectsMs = startObjects.elapsedMillis();
 
-    TimePoint startOutfits;
-    for (int i = 0; i < parsed.outfit_size(); ++i)
+    for (int i = 0; i < appearances.outfit_size(); ++i)
     {
-        auto &creatureAppearance = parsed.outfit(i);
+        auto &creatureAppearance = appearances.outfit(i);
         Appearances::_creatures.emplace(creatureAppearance.id(), creatureAppearance);
     }
-    auto outfitsMs = startOutfits.elapsedMillis();
-
-    VME_LOG("Loaded appearances.dat in " << start.elapsedMillis() << " ms (objects: " << objectsMs << " ms, "
-                                         << "outfits: " << outfitsMs << " ms).");
 
     Appearances::isLoaded = true;
 }
@@ -194,7 +89,8 @@ void Appearances::loadTextureAtlases(const std::filesystem::path catalogContents
     fileStream >> catalogJson;
     fileStream.close();
 
-    textureAtlasSpriteRanges.reserve(5000);
+    std::vector<TextureAtlas *> atlases;
+    atlases.reserve(5000);
 
     for (const auto &entry : catalogJson)
     {
@@ -221,30 +117,13 @@ void Appearances::loadTextureAtlases(const std::filesystem::path catalogContents
                 spriteType,
                 filename);
 
-            Appearances::textureAtlasSpriteRanges.emplace_back<SpriteRange>({firstSpriteId, lastSpriteId});
+            atlases.emplace_back(Appearances::textureAtlases[lastSpriteId].get());
         }
     }
 
-    textureAtlasSpriteRanges.shrink_to_fit();
-
-    /*
-        This sort is necessary! It enables lower_bound in getTextureAtlas()
-        to have complexity O(lg n).
-    */
-    std::sort(
-        Appearances::textureAtlasSpriteRanges.begin(),
-        Appearances::textureAtlasSpriteRanges.end(),
-        [](SpriteRange a, SpriteRange b) { return a.start < b.start; });
+    textureAtlasIndex.build(atlases);
 
-    auto textureAtlasCount = Appearances::textureAtlasSpriteRanges.size();
-    textureAtlasSpriteRangeIndex.resize(Appearances::textureAtlasSpriteRanges.size());
-    for (int i = 0; i < textureAtlasCount; ++i)
-    {
-        // end + 1 because our binary search uses upper bound. Without the + 1 we get the wrong index.
-        textureAtlasSpriteRangeIndex[i] = textureAtlasSpriteRanges[i].end + 1;
-    }
-
-    VME_LOG("Loaded compressed texture atlases in " << start.elapsedMillis() << " ms.");
+    VME_LOG("Loaded compressed texture atlases in " << start.elapsedMillis() << " ms (sprite index: " << textureAtlasIndex.sizeInBytes() / 1024 << " KB).");
 }
 
 std::pair<bool, std::optional<std::string>> Appearances::dumpSpriteFiles(const std::filesystem::path &assetFolder, const std::filesystem::path &destinationFolder)
@@ -290,22 +169,21 @@ std::pair<bool, std::optional<std::string>> Appearances::dumpSpriteFiles(const s
     return {true, std::nullopt};
 }
 
-TextureAtlas *Appearances::getTextureAtlas(const uint32_t spriteId)
+size_t Appearances::textureAtlasCount()
 {
-    auto result = fast_upper_bound4(textureAtlasSpriteRangeIndex, static_cast<int>(spriteId));
-    auto range = textureAtlasSpriteRanges[result];
+    return textureAtlases.size();
+}
 
-    if (range.start > spriteId || range.end < spriteId)
+std::vector<SpriteDrawInfo *> Appearances::spriteDrawInfos()
+{
+    std::vector<SpriteDrawInfo *> result;
+    for (auto it = _objects.begin(); it != _objects.end(); ++it)
     {
-        ABORT_PROGRAM("There is no sprite with ID " + std::to_string(spriteId));
+        // Mutable access to values of a robin_map goes through value()
+        it.value().collectSpriteDrawInfo(result);
     }
 
-    return textureAtlases.at(range.end).get();
-}
-
-size_t Appearances::textureAtlasCount()
-{
-    return textureAtlases.size();
+    return result;
 }
 
 size_t Appearances::objectCount()
@@ -587,6 +465,7 @@ ObjectAppearance::ObjectAppearance(ObjectAppearance &&other) noexcept
       _name(std::move(other._name)),
       flagData(std::move(other.flagData)),
       _frameGroups(std::move(other._frameGroups)),
+      _spriteDrawInfo(std::move(other._spriteDrawInfo)),
       flags(std::move(other.flags)) {}
 
 void ObjectAppearance::cacheTextureAtlases()
@@ -605,6 +484,42 @@ void ObjectAppearance::cacheTextureAtlases()
     }
 }
 
+void ObjectAppearance::cacheSpriteDrawInfo()
+{
+    // Several item types can share the same appearance
+    if (!_spriteDrawInfo.empty())
+    {
+        return;
+    }
+
+    _spriteDrawInfo.reserve(_frameGroups.size());
+
+    for (const auto &frameGroup : _frameGroups)
+    {
+        auto &infos = _spriteDrawInfo.emplace_back();
+        infos.reserve(frameGroup.spriteInfo.spriteIds.size());
+
+        for (const auto spriteId : frameGroup.spriteInfo.spriteIds)
+        {
+            TextureAtlas *atlas = Appearances::getTextureAtlas(spriteId);
+            TextureWindow window = atlas->getTextureWindow(spriteId);
+
+            infos.emplace_back(SpriteDrawInfo{atlas, window, atlas->getFragmentBounds(window), spriteId});
+        }
+    }
+}
+
+void ObjectAppearance::collectSpriteDrawInfo(std::vector<SpriteDrawInfo *> &result)
+{
+    for (auto &infos : _spriteDrawInfo)
+    {
+        for (auto &info : infos)
+        {
+            result.emplace_back(&info);
+        }
+    }
+}
+
 void ObjectAppearance::cacheTextureAtlas(uint32_t spriteId)
 {
     // If nothing is cached, cache the TextureAtlas for the first sprite ID in the appearance.
@@ -785,19 +700,6 @@ const TextureInfo CreatureAppearance::getTextureInfo(uint32_t frameGroupId, Dire
 
 TextureAtlas *CreatureAppearance::getTextureAtlas(uint32_t spriteId) const
 {
-    for (const auto atlas : _atlases)
-    {
-        if (atlas == nullptr)
-        {
-            return nullptr;
-        }
-
-        if (atlas->firstSpriteId <= spriteId && spriteId <= atlas->lastSpriteId)
-        {
-            return atlas;
-        }
-    }
-
     return Appearances::getTextureAtlas(spriteId);
 }
 
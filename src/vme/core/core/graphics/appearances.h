@@ -26,6 +26,7 @@
 #include "../util.h"
 #include "appearance_types.h"
 #include "texture_atlas.h"
+#include "texture_atlas_index.h"
 
 namespace proto
 {
@@ -91,6 +92,13 @@ class ObjectAppearance
     void cacheTextureAtlases();
     void cacheTextureAtlas(uint32_t spriteId);
 
+    /*
+        Precomputes the SpriteDrawInfo for every sprite in every frame group. Requires the texture atlases to be loaded.
+    */
+    void cacheSpriteDrawInfo();
+    inline const SpriteDrawInfo &spriteDrawInfo(uint32_t frameGroup, uint32_t spriteIndex) const;
+    void collectSpriteDrawInfo(std::vector<SpriteDrawInfo *> &result);
+
     bool hasFlag(AppearanceFlag flag)
     {
         return (flags & flag) > 0ULL;
@@ -146,6 +154,10 @@ class ObjectAppearance
     std::array<TextureAtlas *, CachedTextureAtlasAmount> _atlases = {};
 
     std::vector<FrameGroup> _frameGroups;
+
+    // Indexed by [frameGroup][spriteIndex], same indexing as the sprite IDs of the frame group.
+    std::vector<std::vector<SpriteDrawInfo>> _spriteDrawInfo;
+
     AppearanceFlag flags;
 
     std::string _name;
@@ -208,6 +220,11 @@ class Appearances
     static void loadTextureAtlases(const std::filesystem::path catalogContentsPath, const std::filesystem::path assetFolder);
 
     static void loadAppearanceData(const std::filesystem::path path);
+    /*
+        Adds the objects and outfits of already parsed appearance data, for example appearances that are built in
+        memory by tests.
+    */
+    static void loadAppearanceData(const proto::Appearances &appearances);
     static std::pair<bool, std::optional<std::string>> dumpSpriteFiles(const std::filesystem::path &assetFolder, const std::filesystem::path &destinationFolder);
 
     static SpriteAnimation parseSpriteAnimation(const proto::SpriteAnimation &animation);
@@ -235,7 +252,12 @@ class Appearances
         return &_creatures.at(looktype);
     }
 
-    static TextureAtlas *getTextureAtlas(const uint32_t spriteId);
+    static inline TextureAtlas *getTextureAtlas(const uint32_t spriteId);
+
+    /*
+        The cached SpriteDrawInfo of every object appearance. Used to redirect sprites to other atlases at runtime.
+    */
+    static std::vector<SpriteDrawInfo *> spriteDrawInfos();
 
     static bool isLoaded;
 
@@ -246,20 +268,12 @@ class Appearances
     static vme_unordered_map<AppearanceId, ObjectAppearance> _objects;
     static vme_unordered_map<AppearanceId, CreatureAppearance> _creatures;
 
-    /* 
-		Used for quick retrieval of the correct spritesheet given a sprite ID.
-		It stores the upper bound of the sprite ids in the sprite sheet.
-	*/
-    static std::set<uint32_t> catalogIndex;
-
     static vme_unordered_map<uint32_t, std::unique_ptr<TextureAtlas>> textureAtlases;
 
-    /* 
+    /*
 		Used for quick retrieval of a texture atlas given a sprite ID.
-		It stores the start and end sprite id in the sprite sheet.
 	*/
-    static std::vector<SpriteRange> textureAtlasSpriteRanges;
-    static std::vector<int> textureAtlasSpriteRangeIndex;
+    static TextureAtlasIndex textureAtlasIndex;
 };
 
 inline const vme_unordered_map<uint32_t, ObjectAppearance> &Appearances::objects()
@@ -267,6 +281,22 @@ inline const vme_unordered_map<uint32_t, ObjectAppearance> &Appearances::objects
     return _objects;
 }
 
+inline const SpriteDrawInfo &ObjectAppearance::spriteDrawInfo(uint32_t frameGroup, uint32_t spriteIndex) const
+{
+    return _spriteDrawInfo[frameGroup][spriteIndex];
+}
+
+inline TextureAtlas *Appearances::getTextureAtlas(const uint32_t spriteId)
+{
+    TextureAtlas *atlas = textureAtlasIndex.find(spriteId);
+    if (!atlas)
+    {
+        ABORT_PROGRAM("There is no sprite with ID " + std::to_string(spriteId));
+    }
+
+    return atlas;
+}
+
 //>>>>>>>>>>>>>>>>>>>>>>
 //>>>>>>>>>>>>>>>>>>>>>>
 //>>>>>>>Printing>>>>>>>
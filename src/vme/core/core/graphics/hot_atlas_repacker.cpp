@@ -0,0 +1,274 @@
+#include "hot_atlas_repacker.h"
+
+#include <algorithm>
+#include <array>
+
+#include "../logger.h"
+#include "../time_util.h"
+#include "../util.h"
+#include "appearances.h"
+
+namespace
+{
+    HotAtlasRepacker globalRepacker;
+
+    constexpr size_t SpriteLayoutCount = 4;
+
+    struct HotSprite
+    {
+        uint32_t spriteId;
+        uint32_t drawCount;
+        TextureAtlas *source;
+    };
+} // namespace
+
+HotAtlasRepacker::HotAtlasRepacker(uint32_t atlasSize, uint32_t repackIntervalFrames, uint32_t minimumDrawCount)
+    : atlasSize(atlasSize), repackIntervalFrames(repackIntervalFrames), minimumDrawCount(minimumDrawCount) {}
+
+HotAtlasRepacker &HotAtlasRepacker::global()
+{
+    return globalRepacker;
+}
+
+HotAtlasRepacker::RendererId HotAtlasRepacker::addRenderer()
+{
+    RendererId id = nextRendererId++;
+
+    // A new renderer has no GPU resources of atlases that are already retired.
+    renderers.emplace_back(RendererState{id, _generation, false});
+    return id;
+}
+
+void HotAtlasRepacker::removeRenderer(RendererId renderer)
+{
+    auto found = std::find_if(renderers.begin(), renderers.end(), [renderer](const RendererState &state) { return state.id == renderer; });
+    if (found == renderers.end())
+        return;
+
+    if (found->renderedThisFrame)
+    {
+        --renderersInFrame;
+    }
+
+    renderers.erase(found);
+    trimRetirements();
+}
+
+void HotAtlasRepacker::nextFrame(RendererId renderer)
+{
+    auto found = std::find_if(renderers.begin(), renderers.end(), [renderer](const RendererState &state) { return state.id == renderer; });
+    if (found == renderers.end())
+        return;
+
+    if (renderersInFrame == 0 || found->renderedThisFrame)
+    {
+        for (auto &state : renderers)
+        {
+            state.renderedThisFrame = false;
+        }
+        renderersInFrame = 0;
+        ++framesSinceRepack;
+    }
+
+    found->renderedThisFrame = true;
+    ++renderersInFrame;
+}
+
+void HotAtlasRepacker::releasedGeneration(RendererId renderer, uint32_t generation)
+{
+    auto found = std::find_if(renderers.begin(), renderers.end(), [renderer](const RendererState &state) { return state.id == renderer; });
+    if (found == renderers.end())
+        return;
+
+    found->releasedGeneration = generation;
+    trimRetirements();
+}
+
+void HotAtlasRepacker::trimRetirements()
+{
+    uint32_t released = _generation;
+    for (const auto &state : renderers)
+    {
+        released = std::min(released, state.releasedGeneration);
+    }
+
+    auto end = std::find_if(retirements.begin(), retirements.end(), [released](const Retirement &retirement) { return retirement.generation > released; });
+    retirements.erase(retirements.begin(), end);
+}
+
+bool HotAtlasRepacker::repackDue() const noexcept
+{
+    return framesSinceRepack >= repackIntervalFrames;
+}
+
+void HotAtlasRepacker::setSprites(const std::vector<SpriteDrawInfo *> &sprites)
+{
+    // The source atlases are read from the entries, so they must point to their client atlas.
+    restoreSprites();
+
+    spriteEntries.clear();
+    for (SpriteDrawInfo *sprite : sprites)
+    {
+        auto &entries = spriteEntries[sprite->spriteId];
+        entries.source = sprite->atlas;
+        entries.entries.emplace_back(sprite);
+    }
+
+    // The hot atlases were built for the previous entries.
+    retireAtlases();
+    spritesSet = true;
+}
+
+bool HotAtlasRepacker::repack()
+{
+    if (!spritesSet)
+    {
+        setSprites(Appearances::spriteDrawInfos());
+    }
+
+    TimePoint start;
+    framesSinceRepack = 0;
+
+    std::array<std::vector<HotSprite>, SpriteLayoutCount> groups;
+    vme_unordered_set<const TextureAtlas *> sourceAtlases;
+    for (uint32_t spriteId = 0; spriteId < drawCounts.size(); ++spriteId)
+    {
+        if (drawCounts[spriteId] < minimumDrawCount)
+            continue;
+
+        auto found = spriteEntries.find(spriteId);
+        if (found == spriteEntries.end())
+            continue;
+
+        TextureAtlas *atlas = found->second.source;
+        groups[to_underlying(atlas->spriteLayout())].emplace_back(HotSprite{spriteId, drawCounts[spriteId], atlas});
+        sourceAtlases.emplace(atlas);
+    }
+
+    // Halve the counts so that the next repack favors what is drawn from now on (e.g. after moving to another part of the map).
+    for (auto &count : drawCounts)
+    {
+        count /= 2;
+    }
+
+    size_t groupCount = std::count_if(groups.begin(), groups.end(), [](const auto &group) { return !group.empty(); });
+
+    // Nothing to gain if the hot sprites already live in as few atlases as we would create.
+    if (sourceAtlases.size() <= groupCount)
+    {
+        restoreSprites();
+        retireAtlases();
+        return false;
+    }
+
+    std::vector<uint32_t> spriteIds;
+    for (auto &group : groups)
+    {
+        if (group.empty())
+            continue;
+
+        const TextureAtlas *source = group.front().source;
+        size_t capacity = static_cast<size_t>(atlasSize / source->spriteWidth) * (atlasSize / source->spriteHeight);
+        if (group.size() > capacity)
+        {
+            std::nth_element(group.begin(), group.begin() + capacity, group.end(), [](const HotSprite &a, const HotSprite &b) {
+                return a.drawCount > b.drawCount;
+            });
+            group.resize(capacity);
+        }
+
+        // Sprites that are close in ID are often drawn together (e.g. the variations of a ground), keep them close.
+        std::sort(group.begin(), group.end(), [](const HotSprite &a, const HotSprite &b) { return a.spriteId < b.spriteId; });
+        for (const auto &hotSprite : group)
+        {
+            spriteIds.emplace_back(hotSprite.spriteId);
+        }
+    }
+
+    // Rebuilding the atlases also means uploading them to the GPU again, so only do it if the hot set changed.
+    // Otherwise the entries of the hot sprites are still redirected from the last repack.
+    if (spriteIds == hotSpriteIds)
+        return true;
+
+    restoreSprites();
+    retireAtlases();
+    hotSpriteIds = std::move(spriteIds);
+
+    for (size_t layout = 0; layout < SpriteLayoutCount; ++layout)
+    {
+        const auto &group = groups[layout];
+        if (group.empty())
+            continue;
+
+        Texture texture(atlasSize, atlasSize, std::vector<uint8_t>(static_cast<size_t>(atlasSize) * atlasSize * 4, 0));
+        auto &atlas = _atlases.emplace_back(std::make_unique<TextureAtlas>(std::move(texture), 0, static_cast<uint32_t>(group.size() - 1), static_cast<SpriteLayout>(layout)));
+
+        for (uint32_t index = 0; index < group.size(); ++index)
+        {
+            atlas->copySprite(*group[index].source, group[index].spriteId, index);
+            slots.emplace(group[index].spriteId, Slot{atlas.get(), index});
+        }
+    }
+
+    redirectSprites();
+
+    VME_LOG_D("Repacked " << slots.size() << " sprites from " << sourceAtlases.size() << " atlases into " << _atlases.size() << " hot atlases in " << start.elapsedMillis() << " ms.");
+
+    return true;
+}
+
+void HotAtlasRepacker::redirectSprites()
+{
+    for (const auto &[spriteId, slot] : slots)
+    {
+        for (SpriteDrawInfo *sprite : spriteEntries.at(spriteId).entries)
+        {
+            remappedSprites.emplace_back(RemappedSprite{sprite, *sprite});
+
+            sprite->atlas = slot.atlas;
+            sprite->window = slot.atlas->getTextureWindow(slot.index);
+            sprite->fragmentBounds = slot.atlas->getFragmentBounds(sprite->window);
+        }
+    }
+}
+
+void HotAtlasRepacker::reset()
+{
+    restoreSprites();
+    retireAtlases();
+
+    drawCounts.clear();
+    framesSinceRepack = 0;
+}
+
+void HotAtlasRepacker::restoreSprites()
+{
+    for (auto &remapped : remappedSprites)
+    {
+        *remapped.sprite = remapped.original;
+    }
+
+    remappedSprites.clear();
+}
+
+void HotAtlasRepacker::retireAtlases()
+{
+    if (_atlases.empty())
+        return;
+
+    ++_generation;
+
+    // Without renderers, no GPU resources were created for the atlases.
+    if (!renderers.empty())
+    {
+        auto &retirement = retirements.emplace_back(Retirement{_generation, {}});
+        for (auto &atlas : _atlases)
+        {
+            retirement.textureIds.emplace_back(atlas->getTexture()->id());
+        }
+    }
+
+    _atlases.clear();
+    slots.clear();
+    hotSpriteIds.clear();
+}
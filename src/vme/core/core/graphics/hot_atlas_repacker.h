@@ -0,0 +1,201 @@
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#include "../util.h"
+#include "texture_atlas.h"
+
+/*
+    Optional runtime repacking of frequently drawn sprites into larger "hot" texture atlases.
+
+    The client atlases group sprites by sprite ID, not by what is drawn together, so a single view of a town can
+    touch dozens of atlases. While enabled, the renderer records how often each sprite is drawn. The most drawn
+    sprites are then copied into a few large atlases (one per sprite size) and the SpriteDrawInfo entries of those
+    sprites are redirected to the hot atlases, so every draw that goes through SpriteDrawInfo is remapped
+    transparently.
+
+    Lookups by sprite ID (Appearances::getTextureAtlas) keep returning the client atlas. Quadrant draws and
+    creature draws are therefore unaffected. For the same reason the client atlases stay decompressed: the
+    repacker reduces the number of atlases that are bound per frame, not the decompressed memory.
+*/
+class HotAtlasRepacker
+{
+  public:
+    static constexpr uint32_t DefaultAtlasSize = 1024;
+    // Number of frames between two repacks. The first repack also happens after this many frames.
+    static constexpr uint32_t DefaultRepackIntervalFrames = 300;
+    // Sprites that were drawn fewer times than this since the last repack are left in their client atlas.
+    static constexpr uint32_t DefaultMinimumDrawCount = 16;
+
+    HotAtlasRepacker(uint32_t atlasSize = DefaultAtlasSize,
+                     uint32_t repackIntervalFrames = DefaultRepackIntervalFrames,
+                     uint32_t minimumDrawCount = DefaultMinimumDrawCount);
+
+    HotAtlasRepacker(const HotAtlasRepacker &other) = delete;
+    HotAtlasRepacker &operator=(const HotAtlasRepacker &other) = delete;
+
+    inline void recordUsage(uint32_t spriteId);
+
+    /*
+        Renderers register themselves so that the repacker can tell when a frame ends and when every renderer has
+        released the GPU resources of retired atlases.
+    */
+    using RendererId = uint32_t;
+    RendererId addRenderer();
+    void removeRenderer(RendererId renderer);
+
+    /*
+        Called by a renderer once per rendered frame. Several renderers share the repacker, so a new frame only
+        starts when a renderer renders again after already rendering in the current frame.
+    */
+    void nextFrame(RendererId renderer);
+
+    bool repackDue() const noexcept;
+
+    /*
+        Sets the entries that repack() can redirect and indexes them by sprite ID. Previously redirected entries
+        are restored. If this is not called, the first repack() uses Appearances::spriteDrawInfos().
+    */
+    void setSprites(const std::vector<SpriteDrawInfo *> &sprites);
+
+    /*
+        Rebuilds the hot atlases from the recorded draw counts and redirects the entries of the hot sprites. If the
+        hot set did not change, the entries are left as they are.
+
+        Returns true if any sprite is in a hot atlas.
+    */
+    bool repack();
+
+    /*
+        Restores every redirected SpriteDrawInfo, releases the hot atlases and forgets all draw counts.
+    */
+    void reset();
+
+    /*
+        Incremented every time hot atlases are released. Renderers compare this against the generation they last
+        saw to know when to release the GPU resources of the retired atlases (see forEachRetiredTextureId).
+    */
+    uint32_t generation() const noexcept
+    {
+        return _generation;
+    }
+
+    /*
+        Calls f(textureId) for every atlas that was retired after 'generation'.
+    */
+    template <typename F>
+    void forEachRetiredTextureId(uint32_t generation, F &&f) const;
+
+    /*
+        Tells that 'renderer' has released the GPU resources of every atlas retired up to 'generation'. Retired
+        texture IDs are forgotten once every renderer has released them.
+    */
+    void releasedGeneration(RendererId renderer, uint32_t generation);
+
+    const std::vector<std::unique_ptr<TextureAtlas>> &atlases() const noexcept
+    {
+        return _atlases;
+    }
+
+    bool empty() const noexcept
+    {
+        return _atlases.empty();
+    }
+
+    static HotAtlasRepacker &global();
+
+  private:
+    struct Slot
+    {
+        TextureAtlas *atlas;
+        // Index of the sprite within the hot atlas
+        uint32_t index;
+    };
+
+    struct SpriteEntries
+    {
+        // The client atlas of the sprite
+        TextureAtlas *source;
+        std::vector<SpriteDrawInfo *> entries;
+    };
+
+    struct RemappedSprite
+    {
+        SpriteDrawInfo *sprite;
+        SpriteDrawInfo original;
+    };
+
+    struct Retirement
+    {
+        // The generation that the atlases were retired in
+        uint32_t generation;
+        std::vector<uint32_t> textureIds;
+    };
+
+    struct RendererState
+    {
+        RendererId id;
+        uint32_t releasedGeneration;
+        bool renderedThisFrame;
+    };
+
+    void restoreSprites();
+    void redirectSprites();
+    void retireAtlases();
+    void trimRetirements();
+
+    uint32_t atlasSize;
+    uint32_t repackIntervalFrames;
+    uint32_t minimumDrawCount;
+
+    uint32_t framesSinceRepack = 0;
+    uint32_t _generation = 0;
+
+    // Indexed by sprite ID
+    std::vector<uint32_t> drawCounts;
+
+    std::vector<std::unique_ptr<TextureAtlas>> _atlases;
+    // Hot sprite ID -> location in the hot atlases
+    vme_unordered_map<uint32_t, Slot> slots;
+    // The sprite IDs in the hot atlases, used to detect whether a repack would change anything.
+    std::vector<uint32_t> hotSpriteIds;
+
+    // Sprite ID -> the entries that draw it. Built once, since the appearances do not change after loading.
+    vme_unordered_map<uint32_t, SpriteEntries> spriteEntries;
+    bool spritesSet = false;
+
+    std::vector<RemappedSprite> remappedSprites;
+    // Oldest first. Kept until every renderer has released them.
+    std::vector<Retirement> retirements;
+
+    std::vector<RendererState> renderers;
+    RendererId nextRendererId = 0;
+    uint32_t renderersInFrame = 0;
+};
+
+inline void HotAtlasRepacker::recordUsage(uint32_t spriteId)
+{
+    if (spriteId >= drawCounts.size())
+    {
+        drawCounts.resize(static_cast<size_t>(spriteId) + 1, 0);
+    }
+
+    ++drawCounts[spriteId];
+}
+
+template <typename F>
+void HotAtlasRepacker::forEachRetiredTextureId(uint32_t generation, F &&f) const
+{
+    for (const auto &retirement : retirements)
+    {
+        if (retirement.generation <= generation)
+            continue;
+
+        for (uint32_t textureId : retirement.textureIds)
+        {
+            f(textureId);
+        }
+    }
+}
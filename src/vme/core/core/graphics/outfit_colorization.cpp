@@ -0,0 +1,199 @@
+#include "outfit_colorization.h"
+
+#if defined(__AVX2__)
+#define VME_COLORIZE_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VME_COLORIZE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // The texture pixels are stored as BGRA. This is the 32-bit (little-endian) word of a pixel in that format.
+    inline uint32_t bgraWord(const Pixel &pixel)
+    {
+        return static_cast<uint32_t>(pixel.b()) |
+               static_cast<uint32_t>(pixel.g()) << 8 |
+               static_cast<uint32_t>(pixel.r()) << 16 |
+               static_cast<uint32_t>(pixel.a()) << 24;
+    }
+
+    inline const Pixel *templateColor(const Pixel &templatePixel, const OutfitColorization::Colors &colors)
+    {
+        if (templatePixel == Pixels::Yellow)
+            return &colors.head;
+        else if (templatePixel == Pixels::Red)
+            return &colors.body;
+        else if (templatePixel == Pixels::Green)
+            return &colors.legs;
+        else if (templatePixel == Pixels::Blue)
+            return &colors.feet;
+
+        return nullptr;
+    }
+
+#if defined(VME_COLORIZE_AVX2) || defined(VME_COLORIZE_SSE2)
+    /*
+        Multiplying a channel by 0xFF is the identity for the (a * b + 0xFF) >> 8 formula. Pixels that do not match
+        any template color therefore get the multiplier 0xFFFFFFFF, which lets us skip branching on the mask.
+    */
+    constexpr uint32_t IdentityMultiplier = 0xFFFFFFFF;
+#endif
+
+#if defined(VME_COLORIZE_AVX2)
+    inline __m256i select(__m256i mask, __m256i ifSet, __m256i otherwise)
+    {
+        return _mm256_blendv_epi8(otherwise, ifSet, mask);
+    }
+
+    inline __m256i multiplyChannels(__m256i lhs, __m256i rhs, __m256i zero, __m256i round)
+    {
+        __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(lhs, zero), _mm256_unpacklo_epi8(rhs, zero));
+        __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(lhs, zero), _mm256_unpackhi_epi8(rhs, zero));
+
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+
+        return _mm256_packus_epi16(lo, hi);
+    }
+
+    uint32_t colorizeAvx2(const uint8_t *templateRow, uint8_t *targetRow, uint32_t pixelCount, const OutfitColorization::Colors &colors)
+    {
+        const __m256i yellow = _mm256_set1_epi32(static_cast<int>(bgraWord(Pixels::Yellow)));
+        const __m256i red = _mm256_set1_epi32(static_cast<int>(bgraWord(Pixels::Red)));
+        const __m256i green = _mm256_set1_epi32(static_cast<int>(bgraWord(Pixels::Green)));
+        const __m256i blue = _mm256_set1_epi32(static_cast<int>(bgraWord(Pixels::Blue)));
+
+        const __m256i head = _mm256_set1_epi32(static_cast<int>(bgraWord(colors.head)));
+        const __m256i body = _mm256_set1_epi32(static_cast<int>(bgraWord(colors.body)));
+        const __m256i legs = _mm256_set1_epi32(static_cast<int>(bgraWord(colors.legs)));
+        const __m256i feet = _mm256_set1_epi32(static_cast<int>(bgraWord(colors.feet)));
+
+        const __m256i identity = _mm256_set1_epi32(static_cast<int>(IdentityMultiplier));
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i round = _mm256_set1_epi16(0xFF);
+
+        uint32_t i = 0;
+        for (; i + 8 <= pixelCount; i += 8)
+        {
+            const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(templateRow + i * 4));
+            __m256i *target = reinterpret_cast<__m256i *>(targetRow + i * 4);
+
+            __m256i multiplier = identity;
+            multiplier = select(_mm256_cmpeq_epi32(mask, yellow), head, multiplier);
+            multiplier = select(_mm256_cmpeq_epi32(mask, red), body, multiplier);
+            multiplier = select(_mm256_cmpeq_epi32(mask, green), legs, multiplier);
+            multiplier = select(_mm256_cmpeq_epi32(mask, blue), feet, multiplier);
+
+            _mm256_storeu_si256(target, multiplyChannels(_mm256_loadu_si256(target), multiplier, zero, round));
+        }
+
+        return i;
+    }
+#elif defined(VME_COLORIZE_SSE2)
+    inline __m128i select(__m128i mask, __m128i ifSet, __m128i otherwise)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, otherwise));
+    }
+
+    inline __m128i multiplyChannels(__m128i lhs, __m128i rhs, __m128i zero, __m128i round)
+    {
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(lhs, zero), _mm_unpacklo_epi8(rhs, zero));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(lhs, zero), _mm_unpackhi_epi8(rhs, zero));
+
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    uint32_t colorizeSse2(const uint8_t *templateRow, uint8_t *targetRow, uint32_t pixelCount, const OutfitColorization::Colors &colors)
+    {
+        const __m128i yellow = _mm_set1_epi32(static_cast<int>(bgraWord(Pixels::Yellow)));
+        const __m128i red = _mm_set1_epi32(static_cast<int>(bgraWord(Pixels::Red)));
+        const __m128i green = _mm_set1_epi32(static_cast<int>(bgraWord(Pixels::Green)));
+        const __m128i blue = _mm_set1_epi32(static_cast<int>(bgraWord(Pixels::Blue)));
+
+        const __m128i head = _mm_set1_epi32(static_cast<int>(bgraWord(colors.head)));
+        const __m128i body = _mm_set1_epi32(static_cast<int>(bgraWord(colors.body)));
+        const __m128i legs = _mm_set1_epi32(static_cast<int>(bgraWord(colors.legs)));
+        const __m128i feet = _mm_set1_epi32(static_cast<int>(bgraWord(colors.feet)));
+
+        const __m128i identity = _mm_set1_epi32(static_cast<int>(IdentityMultiplier));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(0xFF);
+
+        uint32_t i = 0;
+        for (; i + 4 <= pixelCount; i += 4)
+        {
+            const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(templateRow + i * 4));
+            __m128i *target = reinterpret_cast<__m128i *>(targetRow + i * 4);
+
+            __m128i multiplier = identity;
+            multiplier = select(_mm_cmpeq_epi32(mask, yellow), head, multiplier);
+            multiplier = select(_mm_cmpeq_epi32(mask, red), body, multiplier);
+            multiplier = select(_mm_cmpeq_epi32(mask, green), legs, multiplier);
+            multiplier = select(_mm_cmpeq_epi32(mask, blue), feet, multiplier);
+
+            _mm_storeu_si128(target, multiplyChannels(_mm_loadu_si128(target), multiplier, zero, round));
+        }
+
+        return i;
+    }
+#endif
+} // namespace
+
+// See https://stackoverflow.com/questions/45041273/how-to-correctly-multiply-two-colors-with-byte-components#comment77056973_45041273
+void OutfitColorization::colorizeRowScalar(const uint8_t *templateRow, uint8_t *targetRow, uint32_t pixelCount, const Colors &colors)
+{
+    for (uint32_t i = 0; i < pixelCount; ++i)
+    {
+        const uint8_t *src = templateRow + i * 4;
+
+        Pixel pixel{};
+        pixel.parts._b = src[0];
+        pixel.parts._g = src[1];
+        pixel.parts._r = src[2];
+        pixel.parts._a = src[3];
+
+        const Pixel *color = templateColor(pixel, colors);
+        if (!color)
+        {
+            continue;
+        }
+
+        uint8_t *dst = targetRow + i * 4;
+        dst[0] = (uint8_t)((dst[0] * color->b() + 0xFF) >> 8);
+        dst[1] = (uint8_t)((dst[1] * color->g() + 0xFF) >> 8);
+        dst[2] = (uint8_t)((dst[2] * color->r() + 0xFF) >> 8);
+        dst[3] = (uint8_t)((dst[3] * color->a() + 0xFF) >> 8);
+    }
+}
+
+void OutfitColorization::colorizeRow(const uint8_t *templateRow, uint8_t *targetRow, uint32_t pixelCount, const Colors &colors)
+{
+#if defined(VME_COLORIZE_AVX2)
+    uint32_t done = colorizeAvx2(templateRow, targetRow, pixelCount, colors);
+#elif defined(VME_COLORIZE_SSE2)
+    uint32_t done = colorizeSse2(templateRow, targetRow, pixelCount, colors);
+#else
+    uint32_t done = 0;
+#endif
+
+    if (done < pixelCount)
+    {
+        colorizeRowScalar(templateRow + done * 4, targetRow + done * 4, pixelCount - done, colors);
+    }
+}
+
+const char *OutfitColorization::kernelName()
+{
+#if defined(VME_COLORIZE_AVX2)
+    return "avx2";
+#elif defined(VME_COLORIZE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "texture.h"
+
+/*
+    Kernels used to create colored outfit variations from outfit template sprites.
+
+    Both the template and the target rows are stored in the BMP pixel format (BGRA). Every template pixel that
+    is Yellow/Red/Green/Blue multiplies the corresponding target pixel by the head/body/legs/feet color. All other
+    target pixels are left untouched.
+*/
+namespace OutfitColorization
+{
+    struct Colors
+    {
+        Pixel head;
+        Pixel body;
+        Pixel legs;
+        Pixel feet;
+    };
+
+    /*
+        Colorizes 'pixelCount' pixels of 'targetRow' using 'templateRow' as the mask. Uses AVX2 or SSE2 when
+        available at compile time, otherwise falls back to colorizeRowScalar.
+    */
+    void colorizeRow(const uint8_t *templateRow, uint8_t *targetRow, uint32_t pixelCount, const Colors &colors);
+
+    /*
+        Reference implementation. The vectorized kernels must produce exactly the same pixels as this one.
+    */
+    void colorizeRowScalar(const uint8_t *templateRow, uint8_t *targetRow, uint32_t pixelCount, const Colors &colors);
+
+    /*
+        The name of the kernel selected by colorizeRow ("avx2", "sse2" or "scalar").
+    */
+    const char *kernelName();
+} // namespace OutfitColorization
@@ -15,7 +15,7 @@
 #pragma warning(disable : 26812)
 #pragma warning(pop)
 
-uint32_t Texture::_nextTextureId = 0;
+std::atomic<uint32_t> Texture::_nextTextureId = 0;
 
 std::unordered_map<SolidColor, std::unique_ptr<Texture>> solidColorTextures;
 
@@ -135,6 +135,17 @@ void Texture::multiplyPixel(int x, int y, Pixel pixel)
     _pixels[i + 3] = (uint8_t)((_pixels[i + 3] * pixel.a() + 0xFF) >> 8);
 }
 
+const uint8_t *Texture::pixelAddress(int x, int y) const
+{
+    return _pixels.data() + 4 * ((_width - y - 1) * (_width) + x);
+}
+
+uint8_t *Texture::pixelAddress(int x, int y)
+{
+    DEBUG_ASSERT(!_finalized, "Texture is finalized.");
+    return _pixels.data() + 4 * ((_width - y - 1) * (_width) + x);
+}
+
 void Texture::finalize()
 {
     DEBUG_ASSERT(!_finalized, "Texture is already finalized.");
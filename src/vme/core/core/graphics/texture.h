@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -72,8 +73,16 @@ class Texture
 
     Pixel getPixel(int x, int y) const;
     void multiplyPixel(int x, int y, Pixel pixel);
+
+    /*
+        Address of the pixel at (x, y). Pixels with increasing x (within one row) are contiguous in memory.
+    */
+    const uint8_t *pixelAddress(int x, int y) const;
+    uint8_t *pixelAddress(int x, int y);
+
     static uint32_t nextTextureId();
-    static uint32_t _nextTextureId;
+    // Textures can be created from background threads (e.g. when decompressing texture atlases).
+    static std::atomic<uint32_t> _nextTextureId;
 
     uint32_t _id;
     std::vector<uint8_t> _pixels;
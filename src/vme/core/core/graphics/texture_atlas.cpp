@@ -14,6 +14,7 @@
 #include "../logger.h"
 #include "../position.h"
 #include "compression.h"
+#include "outfit_colorization.h"
 
 namespace
 {
@@ -28,44 +29,48 @@ namespace
 
 TextureAtlas::TextureAtlas(LZMACompressedBuffer &&buffer, uint32_t width, uint32_t height, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout, std::filesystem::path sourceFile)
     : sourceFile(sourceFile), width(width), height(height), firstSpriteId(firstSpriteId), lastSpriteId(lastSpriteId), texture(std::move(buffer))
+{
+    setSpriteLayout(spriteLayout);
+
+    // if (spriteLayout == SpriteLayout::TWO_BY_TWO)
+    // {
+    //     std::filesystem::path sourcePath = "D:/Programs/Tibia/packages/Tibia/assets";
+    //     std::filesystem::path path = "C:/Users/giuin/Desktop/texture_atlases";
+    //     dumpToFile(sourcePath, path);
+    // }
+}
+
+TextureAtlas::TextureAtlas(Texture &&texture, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout)
+    : width(texture.width()), height(texture.height()), firstSpriteId(firstSpriteId), lastSpriteId(lastSpriteId), texture(std::move(texture)), decompressed(true)
+{
+    setSpriteLayout(spriteLayout);
+    DEBUG_ASSERT(lastSpriteId - firstSpriteId < rows * columns, "The sprite range does not fit in the texture.");
+}
+
+void TextureAtlas::setSpriteLayout(SpriteLayout spriteLayout)
 {
     switch (spriteLayout)
     {
-        case SpriteLayout::ONE_BY_ONE:
-            this->rows = 12;
-            this->columns = 12;
-            this->spriteWidth = SPRITE_SIZE;
-            this->spriteHeight = SPRITE_SIZE;
-            drawOffset.x = 0;
-            drawOffset.y = 0;
-            break;
         case SpriteLayout::ONE_BY_TWO:
-            this->rows = 6;
-            this->columns = 12;
             this->spriteWidth = SPRITE_SIZE;
             this->spriteHeight = SPRITE_SIZE * 2;
             drawOffset.x = 0;
             drawOffset.y = -1;
             break;
         case SpriteLayout::TWO_BY_ONE:
-            this->rows = 12;
-            this->columns = 6;
             this->spriteWidth = SPRITE_SIZE * 2;
             this->spriteHeight = SPRITE_SIZE;
             drawOffset.x = -1;
             drawOffset.y = 0;
             break;
         case SpriteLayout::TWO_BY_TWO:
-            this->rows = 6;
-            this->columns = 6;
             this->spriteWidth = SPRITE_SIZE * 2;
             this->spriteHeight = SPRITE_SIZE * 2;
             drawOffset.x = -1;
             drawOffset.y = -1;
             break;
+        case SpriteLayout::ONE_BY_ONE:
         default:
-            this->rows = 12;
-            this->columns = 12;
             this->spriteWidth = SPRITE_SIZE;
             this->spriteHeight = SPRITE_SIZE;
             drawOffset.x = 0;
@@ -73,12 +78,23 @@ TextureAtlas::TextureAtlas(LZMACompressedBuffer &&buffer, uint32_t width, uint32
             break;
     }
 
-    // if (spriteLayout == SpriteLayout::TWO_BY_TWO)
-    // {
-    //     std::filesystem::path sourcePath = "D:/Programs/Tibia/packages/Tibia/assets";
-    //     std::filesystem::path path = "C:/Users/giuin/Desktop/texture_atlases";
-    //     dumpToFile(sourcePath, path);
-    // }
+    this->rows = height / spriteHeight;
+    this->columns = width / spriteWidth;
+}
+
+SpriteLayout TextureAtlas::spriteLayout() const noexcept
+{
+    bool wide = spriteWidth > SPRITE_SIZE;
+    bool tall = spriteHeight > SPRITE_SIZE;
+
+    if (wide && tall)
+        return SpriteLayout::TWO_BY_TWO;
+    else if (wide)
+        return SpriteLayout::TWO_BY_ONE;
+    else if (tall)
+        return SpriteLayout::ONE_BY_TWO;
+
+    return SpriteLayout::ONE_BY_ONE;
 }
 
 TextureAtlas::InternalTextureInfo TextureAtlas::internalTextureInfoNormalized(uint32_t spriteId) const
@@ -146,44 +162,32 @@ void TextureAtlas::overlay(TextureAtlas *templateAtlas, uint32_t variationId, ui
 
     DEBUG_ASSERT(!targetTexture.finalized(), "Target texture is finalized.");
 
-    auto head = Creatures::getColorFromLookupTable(look.head());
-    auto body = Creatures::getColorFromLookupTable(look.body());
-    auto legs = Creatures::getColorFromLookupTable(look.legs());
-    auto feet = Creatures::getColorFromLookupTable(look.feet());
+    OutfitColorization::Colors colors{
+        Creatures::getColorFromLookupTable(look.head()),
+        Creatures::getColorFromLookupTable(look.body()),
+        Creatures::getColorFromLookupTable(look.legs()),
+        Creatures::getColorFromLookupTable(look.feet())};
 
+    // Pixels within a row are contiguous, so each row of the sprite is colorized in one go.
     for (int y = targetY; y < targetY + spriteHeight; ++y)
     {
         int ty = templateY + y - targetY;
-        for (int x = targetX; x < targetX + spriteWidth; ++x)
-        {
-            int tx = templateX + x - targetX;
+        OutfitColorization::colorizeRow(templateTexture.pixelAddress(templateX, ty), targetTexture.pixelAddress(targetX, y), spriteWidth, colors);
+    }
+}
 
-            auto pixel = templateTexture.getPixel(tx, ty);
-            if (pixel == Pixels::Yellow)
-            {
-                targetTexture.multiplyPixel(x, y, head);
-            }
-            else if (pixel == Pixels::Red)
-            {
-                targetTexture.multiplyPixel(x, y, body);
-            }
-            else if (pixel == Pixels::Green)
-            {
-                targetTexture.multiplyPixel(x, y, legs);
-            }
-            else if (pixel == Pixels::Blue)
-            {
-                targetTexture.multiplyPixel(x, y, feet);
-            }
-            else if (pixel == Pixels::Magenta)
-            {
-                // Magenta
-            }
-            else
-            {
-                VME_LOG_D(std::format("{},{}: {},{},{},{}", tx, ty, pixel.r(), pixel.g(), pixel.b(), pixel.a()));
-            }
-        }
+void TextureAtlas::copySprite(TextureAtlas &source, uint32_t sourceSpriteId, uint32_t targetSpriteId)
+{
+    DEBUG_ASSERT(source.spriteWidth == spriteWidth && source.spriteHeight == spriteHeight, "Inconsistent sprite sizes.");
+    auto const [sourceX, sourceY] = source.textureOffset(sourceSpriteId);
+    auto const [targetX, targetY] = textureOffset(targetSpriteId);
+
+    const auto &sourceTexture = source.getOrCreateTexture();
+    auto &targetTexture = getOrCreateTexture();
+
+    for (uint32_t y = 0; y < spriteHeight; ++y)
+    {
+        std::memcpy(targetTexture.pixelAddress(targetX, targetY + y), sourceTexture.pixelAddress(sourceX, sourceY + y), spriteWidth * 4);
     }
 }
 
@@ -212,7 +216,7 @@ std::pair<int, int> TextureAtlas::textureOffset(uint32_t spriteId)
     int spriteIndex = spriteId - firstSpriteId;
 
     auto topLeftX = spriteWidth * (spriteIndex % columns);
-    auto topLeftY = spriteHeight * (spriteIndex / rows);
+    auto topLeftY = spriteHeight * (spriteIndex / columns);
 
     return {topLeftX, topLeftY};
 }
@@ -313,13 +317,45 @@ void TextureAtlas::decompressTexture() const
 {
     DEBUG_ASSERT(std::holds_alternative<LZMACompressedBuffer>(texture), "Tried to decompress a TextureAtlas that does not contain CompressedBytes.");
 
-    std::vector<uint8_t> decompressed = LZMA::decompress(std::move(std::get<LZMACompressedBuffer>(this->texture).buffer));
-    validateBmp(decompressed);
+    std::vector<uint8_t> pixels = decompressPixels(std::move(std::get<LZMACompressedBuffer>(this->texture).buffer));
+    texture = Texture(this->width, this->height, std::move(pixels));
+
+    decompressed.store(true, std::memory_order_release);
+}
+
+std::vector<uint8_t> TextureAtlas::decompressPixels(std::vector<uint8_t> &&compressed) const
+{
+    std::vector<uint8_t> bmp = LZMA::decompress(std::move(compressed));
+    validateBmp(bmp);
 
     uint32_t offset;
-    std::memcpy(&offset, decompressed.data() + OFFSET_OF_BMP_START_OFFSET, sizeof(uint32_t));
+    std::memcpy(&offset, bmp.data() + OFFSET_OF_BMP_START_OFFSET, sizeof(uint32_t));
+
+    return std::vector<uint8_t>(bmp.begin() + offset, bmp.end());
+}
+
+void TextureAtlas::readPixels(const std::function<void(const std::vector<uint8_t> &pixels)> &read) const
+{
+    if (!decompressed.load(std::memory_order_acquire))
+    {
+        std::vector<uint8_t> compressed;
+        {
+            std::lock_guard<std::mutex> lock(textureMutex);
+            if (auto buffer = std::get_if<LZMACompressedBuffer>(&texture))
+            {
+                compressed = buffer->buffer;
+            }
+        }
 
-    texture = Texture(this->width, this->height, std::vector<uint8_t>(decompressed.begin() + offset, decompressed.end()));
+        if (!compressed.empty())
+        {
+            read(decompressPixels(std::move(compressed)));
+            return;
+        }
+    }
+
+    // Once decompressed, the pixels of the atlas texture are never modified.
+    read(std::get<Texture>(texture).pixels());
 }
 
 Texture &TextureAtlas::getTexture(uint32_t variationId)
@@ -344,9 +380,13 @@ Texture &TextureAtlas::getTexture(uint32_t variationId)
 
 Texture &TextureAtlas::getOrCreateTexture() const
 {
-    if (std::holds_alternative<LZMACompressedBuffer>(texture))
+    if (!decompressed.load(std::memory_order_acquire))
     {
-        decompressTexture();
+        std::lock_guard<std::mutex> lock(textureMutex);
+        if (std::holds_alternative<LZMACompressedBuffer>(texture))
+        {
+            decompressTexture();
+        }
     }
 
     return std::get<Texture>(this->texture);
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <tuple>
 #include <utility>
 #include <variant>
@@ -38,6 +41,23 @@ struct TextureInfo
     const Texture &getTexture(uint32_t textureVariationId) const;
 };
 
+/*
+    Precomputed draw data for a single sprite. ObjectAppearance stores one per sprite index so that drawing an
+    item does not have to look up the atlas or recompute the texture window and fragment bounds.
+*/
+struct SpriteDrawInfo
+{
+    TextureAtlas *atlas;
+    TextureWindow window;
+    glm::vec4 fragmentBounds;
+    uint32_t spriteId;
+
+    TextureInfo textureInfo() const noexcept
+    {
+        return TextureInfo{atlas, window};
+    }
+};
+
 struct DrawOffset
 {
     int x;
@@ -62,6 +82,12 @@ struct TextureAtlas
   public:
     TextureAtlas(LZMACompressedBuffer &&buffer, uint32_t width, uint32_t height, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout, std::filesystem::path sourceFile);
 
+    /*
+        An atlas that is created at runtime (i.e. not read from the client assets). Its size is the size of the
+        texture, so it can be larger than TextureAtlasSize.
+    */
+    TextureAtlas(Texture &&texture, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout);
+
     std::filesystem::path sourceFile;
 
     uint32_t width;
@@ -81,12 +107,19 @@ struct TextureAtlas
     TextureAtlasVariation *getVariation(uint32_t id);
 
     std::pair<int, int> textureOffset(uint32_t spriteId);
+    SpriteLayout spriteLayout() const noexcept;
 
     bool hasColorVariation(uint32_t variationId) const;
     void dumpToFile(const std::filesystem::path &sourceFolder, const std::filesystem::path &destinationFolder);
 
     void overlay(TextureAtlas *templateAtlas, uint32_t variationId, uint32_t templateSpriteId, uint32_t targetSpriteId, Outfit::Look look);
 
+    /*
+        Copies the pixels of a sprite in 'source' into the slot of 'targetSpriteId' in this atlas. Both atlases
+        must have the same sprite size.
+    */
+    void copySprite(TextureAtlas &source, uint32_t sourceSpriteId, uint32_t targetSpriteId);
+
     glm::vec4 getFragmentBounds(const TextureWindow window) const;
     const TextureWindow getTextureWindow(uint32_t spriteId, uint32_t variationId, TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
     const TextureWindow getTextureWindow(uint32_t spriteId, TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
@@ -104,12 +137,21 @@ struct TextureAtlas
     WorldPosition worldPosOffset() const noexcept;
 
     void decompressTexture() const;
+
+    /*
+        Calls 'read' with the pixels of the whole atlas (same layout as Texture::pixels()). If the atlas is still
+        compressed, it is decompressed into a temporary buffer and stays compressed. This way, reading a few
+        sprites (e.g. for UI thumbnails) does not keep the whole atlas in memory. Thread-safe.
+    */
+    void readPixels(const std::function<void(const std::vector<uint8_t> &pixels)> &read) const;
+
     Texture *getTexture();
     Texture &getOrCreateTexture();
     Texture &getTexture(uint32_t variationId);
 
   private:
     Texture &getOrCreateTexture() const;
+    void setSpriteLayout(SpriteLayout spriteLayout);
 
     struct InternalTextureInfo
     {
@@ -121,8 +163,13 @@ struct TextureAtlas
 
     InternalTextureInfo internalTextureInfoNormalized(uint32_t spriteId) const;
     void validateBmp(std::vector<uint8_t> &decompressed) const;
+    std::vector<uint8_t> decompressPixels(std::vector<uint8_t> &&compressed) const;
 
     mutable std::variant<LZMACompressedBuffer, Texture> texture;
 
+    // Guards decompression of 'texture', which can be requested from several threads.
+    mutable std::mutex textureMutex;
+    mutable std::atomic<bool> decompressed = false;
+
     mutable std::unique_ptr<std::vector<TextureAtlasVariation>> variations;
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "texture_atlas.h"
+
+/*
+    Direct-indexed sprite ID -> TextureAtlas table.
+
+    Built once after the texture atlases are loaded. Every sprite ID maps to the atlas that contains it, so a
+    lookup is a single indexed load instead of a binary search over the atlas sprite ranges. Sprite IDs that are
+    not contained in any atlas map to nullptr.
+*/
+class TextureAtlasIndex
+{
+  public:
+    void build(const std::vector<TextureAtlas *> &atlases);
+    void clear();
+
+    inline TextureAtlas *find(uint32_t spriteId) const noexcept;
+
+    size_t sizeInBytes() const noexcept;
+
+  private:
+    std::vector<TextureAtlas *> atlasBySpriteId;
+};
+
+inline TextureAtlas *TextureAtlasIndex::find(uint32_t spriteId) const noexcept
+{
+    return spriteId < atlasBySpriteId.size() ? atlasBySpriteId[spriteId] : nullptr;
+}
+
+inline void TextureAtlasIndex::build(const std::vector<TextureAtlas *> &atlases)
+{
+    uint32_t maxSpriteId = 0;
+    for (const TextureAtlas *atlas : atlases)
+    {
+        maxSpriteId = std::max(maxSpriteId, atlas->lastSpriteId);
+    }
+
+    atlasBySpriteId.assign(atlases.empty() ? 0 : static_cast<size_t>(maxSpriteId) + 1, nullptr);
+
+    for (TextureAtlas *atlas : atlases)
+    {
+        std::fill(atlasBySpriteId.begin() + atlas->firstSpriteId, atlasBySpriteId.begin() + atlas->lastSpriteId + 1, atlas);
+    }
+}
+
+inline void TextureAtlasIndex::clear()
+{
+    atlasBySpriteId.clear();
+    atlasBySpriteId.shrink_to_fit();
+}
+
+inline size_t TextureAtlasIndex::sizeInBytes() const noexcept
+{
+    return atlasBySpriteId.size() * sizeof(TextureAtlas *);
+}
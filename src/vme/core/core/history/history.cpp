@@ -1,22 +1,72 @@
 #include "history.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+
 #include "../debug.h"
+#include "../items.h"
+#include "../logger.h"
 #include "../map_view.h"
+#include "../settings.h"
 #include "../util.h"
 
 namespace
 {
     constexpr size_t TransactionsReserveAmount = util::power(2, 5);
+
+    std::atomic<uint64_t> mapRevision = 0;
+
+    std::filesystem::path defaultSpillDirectory()
+    {
+        std::error_code error;
+        auto directory = std::filesystem::temp_directory_path(error);
+        return error ? std::filesystem::path() : directory;
+    }
+
+    // Several histories (one per map view) can spill to the same directory.
+    std::filesystem::path uniqueSpillFileName()
+    {
+        static std::atomic<uint32_t> nextId = 0;
+        auto time = std::chrono::system_clock::now().time_since_epoch().count();
+
+        return std::format("vme_history_{}_{}.bin", time, nextId++);
+    }
 };
 
 namespace MapHistory
 {
     History::History(MapView &mapView)
-        : mapView(&mapView), insertionIndex(0)
+        : mapView(&mapView),
+          insertionIndex(0),
+          _memoryBudget(static_cast<size_t>(std::max(Settings::HISTORY_MEMORY_BUDGET_MB, 0)) * 1024 * 1024),
+          spillDirectory(defaultSpillDirectory())
     {
         transactions.reserve(TransactionsReserveAmount);
     }
 
+    History::~History()
+    {
+        // The item notifications are global, so an unfinished transaction must not leave them batched.
+        if (currentTransaction.has_value())
+        {
+            Items::items.endNotificationBatch();
+        }
+    }
+
+    void History::beginNotificationBatch()
+    {
+        mapView->selection().beginBatch();
+        Items::items.beginNotificationBatch();
+    }
+
+    void History::endNotificationBatch()
+    {
+        Items::items.endNotificationBatch();
+        mapView->selection().endBatch();
+    }
+
     Action *History::getLatestAction()
     {
         if (!currentTransaction.has_value() || currentTransaction.value().actions.empty())
@@ -29,6 +79,11 @@ namespace MapHistory
         }
     }
 
+    uint64_t History::revision() noexcept
+    {
+        return mapRevision;
+    }
+
     void History::commit(MapHistory::ActionType actionType, MapHistory::Change::DataTypes &&change)
     {
         commit(MapHistory::Action(actionType, std::move(change)));
@@ -38,21 +93,91 @@ namespace MapHistory
     {
         DEBUG_ASSERT(currentTransaction.has_value(), "There is no current transaction.");
 
+        ++mapRevision;
+
         if (!action.committed)
         {
             action.commit(*mapView);
         }
 
-        Action *currentAction = getLatestAction();
-        if (currentAction && currentAction->getType() == action.getType())
+        if (currentTransaction.value().type != TransactionType::BrushAction)
         {
-            // Same action type, can merge actions
-            util::appendVector(std::move(action.changes), currentAction->changes);
+            Action *currentAction = getLatestAction();
+            if (currentAction && currentAction->getType() == action.getType())
+            {
+                // Same action type, can merge actions
+                util::appendVector(std::move(action.changes), currentAction->changes);
+            }
+            else
+            {
+                currentTransaction.value().addAction(std::move(action));
+            }
+            return;
         }
-        else
+
+        std::vector<Change> changes = std::move(action.changes);
+        action.changes.clear();
+
+        Action *currentAction = getLatestAction();
+        if (!currentAction || currentAction->getType() != action.getType())
         {
             currentTransaction.value().addAction(std::move(action));
         }
+
+        addChanges(std::move(changes));
+    }
+
+    void History::addChanges(std::vector<Change> &&changes)
+    {
+        auto &actions = currentTransaction.value().actions;
+        const auto actionIndex = static_cast<uint32_t>(actions.size() - 1);
+        auto &target = actions.back().changes;
+
+        for (auto &change : changes)
+        {
+            auto position = change.independentPosition();
+            if (!position)
+            {
+                // The change can depend on the earlier changes (a selection change, for example), so changes after
+                // it can not be merged into changes before it.
+                firstChanges.clear();
+                target.emplace_back(std::move(change));
+                continue;
+            }
+
+            auto [found, inserted] = firstChanges.try_emplace(*position, ChangeLocation{actionIndex, static_cast<uint32_t>(target.size())});
+            if (inserted)
+            {
+                target.emplace_back(std::move(change));
+                continue;
+            }
+
+            Change &first = actions[found->second.actionIndex].changes[found->second.changeIndex];
+            if (!std::holds_alternative<SetTile>(first.data))
+            {
+                mergeIntoTileSnapshot(first, change, *position);
+            }
+
+            // The first change restores the whole tile from before the transaction, and the map already holds the
+            // result of this change, so this change is not needed.
+            ++_coalescedChanges;
+        }
+    }
+
+    void History::mergeIntoTileSnapshot(Change &first, Change &later, const Position &position)
+    {
+        // Both changes only touch 'position', so they can be undone without undoing the changes in between.
+        later.undo(*mapView);
+        first.undo(*mapView);
+
+        // A deep copy, since a later change (an attribute change, for example) can change an item in place.
+        const Tile *tile = mapView->getTile(position);
+        std::unique_ptr<Tile> previous = tile ? std::make_unique<Tile>(tile->deepCopy()) : nullptr;
+
+        first.commit(*mapView);
+        later.commit(*mapView);
+
+        first = Change(SetTile::alreadyCommitted(position, std::move(previous)));
     }
 
     bool History::hasCurrentTransactionType(TransactionType type) const
@@ -71,6 +196,8 @@ namespace MapHistory
         }
 
         currentTransaction.emplace(type);
+        firstChanges.clear();
+        beginNotificationBatch();
     }
 
     void History::endTransaction(TransactionType type)
@@ -83,16 +210,22 @@ namespace MapHistory
         {
             if (insertionIndex < transactions.size())
             {
-                transactions.erase(transactions.begin() + insertionIndex, transactions.end());
+                eraseFrom(insertionIndex);
             }
 
-            transactions.emplace_back(std::move(currentTransaction.value()));
+            Transaction &transaction = transactions.emplace_back(std::move(currentTransaction.value()));
+            transaction.updateMemoryUsage();
+            usedBytes += transaction.memoryUsage();
+
             ++insertionIndex;
         }
 
         currentTransaction.reset();
+        firstChanges.clear();
+
+        endNotificationBatch();
 
-        mapView->selection().update();
+        enforceMemoryBudget();
     }
 
     bool History::undo()
@@ -108,9 +241,26 @@ namespace MapHistory
         }
         else
         {
-            transactions.at(insertionIndex - 1).undo(*mapView);
+            Transaction &transaction = transactions.at(insertionIndex - 1);
+            if (transaction.spilled())
+            {
+                reload(transaction);
+            }
+
+            // Undo and redo swap state between the map and the changes, so the memory usage of the transaction changes.
+            ++mapRevision;
+
+            usedBytes -= transaction.memoryUsage();
+            beginNotificationBatch();
+            transaction.undo(*mapView);
+            endNotificationBatch();
+            transaction.updateMemoryUsage();
+            usedBytes += transaction.memoryUsage();
+
             --insertionIndex;
 
+            enforceMemoryBudget();
+
             return true;
         }
     }
@@ -120,12 +270,147 @@ namespace MapHistory
         if (insertionIndex == transactions.size())
             return false;
 
-        transactions.at(insertionIndex).redo(*mapView);
+        Transaction &transaction = transactions.at(insertionIndex);
+        DEBUG_ASSERT(!transaction.spilled(), "Transactions that can be redone are never spilled.");
+
+        ++mapRevision;
+
+        usedBytes -= transaction.memoryUsage();
+        beginNotificationBatch();
+        transaction.redo(*mapView);
+        endNotificationBatch();
+        transaction.updateMemoryUsage();
+        usedBytes += transaction.memoryUsage();
+
         ++insertionIndex;
 
+        enforceMemoryBudget();
+
+        return true;
+    }
+
+    void History::setMemoryBudget(size_t bytes)
+    {
+        _memoryBudget = bytes;
+        enforceMemoryBudget();
+    }
+
+    void History::setSpillDirectory(const std::filesystem::path &directory, size_t diskBudgetBytes)
+    {
+        spillDirectory = directory;
+        diskBudget = diskBudgetBytes;
+
+        // Transactions that are already spilled stay in the current file.
+        if (spillFile && spillFile->size() == 0)
+        {
+            spillFile.reset();
+        }
+
+        enforceMemoryBudget();
+    }
+
+    size_t History::spilledBytes() const noexcept
+    {
+        return spillFile ? spillFile->size() : 0;
+    }
+
+    void History::enforceMemoryBudget()
+    {
+        // Spill the oldest transactions first. The latest transaction is kept in memory since it is the most likely to be undone.
+        for (size_t i = 0; usedBytes > _memoryBudget && i + 1 < insertionIndex; ++i)
+        {
+            if (!transactions[i].spilled())
+            {
+                spill(transactions[i]);
+            }
+        }
+
+        while ((usedBytes > _memoryBudget || spilledBytes() > diskBudget) && insertionIndex > 1)
+        {
+            dropOldest();
+        }
+    }
+
+    bool History::spill(Transaction &transaction)
+    {
+        if (!spillFile)
+        {
+            if (spillDirectory.empty())
+            {
+                return false;
+            }
+
+            spillFile = std::make_unique<SpillFile>(spillDirectory / uniqueSpillFileName());
+        }
+
+        SpillWriter writer;
+        if (!transaction.spill(writer))
+        {
+            return false;
+        }
+
+        auto entry = spillFile->write(writer.bytes());
+        if (!entry)
+        {
+            // Put the changes back from the bytes that could not be written.
+            SpillReader reader(std::vector<uint8_t>(writer.bytes()));
+            transaction.reload(reader);
+            return false;
+        }
+
+        transaction.spillEntry = entry;
+
+        usedBytes -= transaction.memoryUsage();
+        transaction.updateMemoryUsage();
+        usedBytes += transaction.memoryUsage();
+
         return true;
     }
 
+    void History::reload(Transaction &transaction)
+    {
+        SpillFile::Entry entry = transaction.spillEntry.value();
+
+        SpillReader reader(spillFile->read(entry));
+        transaction.reload(reader);
+
+        spillFile->release(entry);
+        transaction.spillEntry.reset();
+
+        usedBytes -= transaction.memoryUsage();
+        transaction.updateMemoryUsage();
+        usedBytes += transaction.memoryUsage();
+    }
+
+    void History::dropOldest()
+    {
+        Transaction &transaction = transactions.front();
+        if (transaction.spilled())
+        {
+            spillFile->release(transaction.spillEntry.value());
+        }
+
+        usedBytes -= transaction.memoryUsage();
+        transactions.erase(transactions.begin());
+        --insertionIndex;
+    }
+
+    void History::eraseFrom(size_t index)
+    {
+        for (size_t i = index; i < transactions.size(); ++i)
+        {
+            Transaction &transaction = transactions[i];
+            if (transaction.spilled())
+            {
+                spillFile->release(transaction.spillEntry.value());
+            }
+
+            usedBytes -= transaction.memoryUsage();
+        }
+
+        transactions.erase(transactions.begin() + index, transactions.end());
+    }
+
     bool History::hasCurrentTransaction() const
     {
         return currentTransaction.has_value();
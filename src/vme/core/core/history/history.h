@@ -1,16 +1,33 @@
 #pragma once
 
+#include <filesystem>
+#include <memory>
 #include <optional>
 #include <vector>
 
+#include "../position.h"
+#include "../util.h"
 #include "history_action.h"
+#include "history_spill.h"
 
 namespace MapHistory
 {
     class History
     {
       public:
+        static constexpr size_t DefaultDiskBudgetBytes = size_t(4) * 1024 * 1024 * 1024;
+
         History(MapView &mapView);
+        ~History();
+
+        History(const History &other) = delete;
+        History &operator=(const History &other) = delete;
+
+        /*
+            Within a brush transaction, a change to a position that the transaction already changed is merged into
+            the first change there: the first change keeps the state from before the transaction, and the map
+            holds the latest state. Dragging a brush over the same tiles again therefore does not grow the history.
+        */
         void commit(Action &&action);
         void commit(ActionType actionType, Change::DataTypes &&change);
 
@@ -32,12 +49,100 @@ namespace MapHistory
 
         Action *getLatestAction();
 
+        /*
+            Increased by every commit, undo and redo of any history, so a state of the map that was read at one
+            revision is still current if the revision has not changed (see SlidingNeighborCache).
+        */
+        static uint64_t revision() noexcept;
+
+        /*
+            When the finished transactions use more than 'bytes' of memory, the oldest transactions that can be
+            undone are spilled to the spill file (see setSpillDirectory), and read back when they are undone. If
+            that is not enough, the oldest transactions are dropped. The latest transaction and the transactions
+            that can be redone always stay in memory.
+        */
+        void setMemoryBudget(size_t bytes);
+
+        /*
+            Directory of the spill file. By default, the temporary directory is used. An empty path disables
+            spilling, so that transactions over the memory budget are dropped instead. At most 'diskBudgetBytes'
+            are spilled; past that, the oldest transactions are dropped.
+        */
+        void setSpillDirectory(const std::filesystem::path &directory, size_t diskBudgetBytes = DefaultDiskBudgetBytes);
+
+        size_t memoryBudget() const noexcept
+        {
+            return _memoryBudget;
+        }
+
+        /*
+            Estimated bytes used by the finished transactions that are in memory. Items that the transactions share
+            with the map are not counted, since spilling or dropping a transaction does not release them.
+        */
+        size_t memoryUsage() const noexcept
+        {
+            return usedBytes;
+        }
+
+        // Bytes of the transactions that are in the spill file
+        size_t spilledBytes() const noexcept;
+
+        // The number of finished transactions, including the ones that can be redone.
+        size_t size() const noexcept
+        {
+            return transactions.size();
+        }
+
+        const Transaction &transaction(size_t index) const
+        {
+            return transactions.at(index);
+        }
+
+        // The number of changes that were merged into an earlier change at the same position (see commit).
+        size_t coalescedChanges() const noexcept
+        {
+            return _coalescedChanges;
+        }
+
       private:
+        /*
+            Selection and item notifications are batched during a transaction (and during undo/redo) and
+            dispatched once at the end. See Selection::beginBatch and Items::beginNotificationBatch.
+        */
+        void beginNotificationBatch();
+        void endNotificationBatch();
+
+        struct ChangeLocation
+        {
+            uint32_t actionIndex;
+            uint32_t changeIndex;
+        };
+
+        void addChanges(std::vector<Change> &&changes);
+        void mergeIntoTileSnapshot(Change &first, Change &later, const Position &position);
+
+        void enforceMemoryBudget();
+        bool spill(Transaction &transaction);
+        void reload(Transaction &transaction);
+        void dropOldest();
+        void eraseFrom(size_t index);
+
         std::optional<Transaction> currentTransaction;
+        // The first change of the current transaction at every position it changed, for merging (see commit).
+        vme_unordered_map<Position, ChangeLocation> firstChanges;
+        size_t _coalescedChanges = 0;
         std::vector<Transaction> transactions;
 
         MapView *mapView;
 
         size_t insertionIndex;
+
+        size_t _memoryBudget;
+        size_t usedBytes = 0;
+
+        std::filesystem::path spillDirectory;
+        size_t diskBudget = DefaultDiskBudgetBytes;
+        // Created on the first spill
+        std::unique_ptr<SpillFile> spillFile;
     };
 } // namespace MapHistory
@@ -4,9 +4,16 @@
 
 #include "../debug.h"
 #include "../map_view.h"
+#include "../parallel.h"
 #include "../position.h"
 #include "../util.h"
 
+namespace
+{
+    // Below this many changes, starting threads costs more than it saves.
+    constexpr size_t MinParallelChanges = 4096;
+} // namespace
+
 namespace MapHistory
 {
     Transaction::Transaction(TransactionType groupType)
@@ -14,7 +21,9 @@ namespace MapHistory
 
     Transaction::Transaction(Transaction &&other) noexcept
         : type(other.type),
-          actions(std::move(other.actions))
+          actions(std::move(other.actions)),
+          _memoryUsage(other._memoryUsage),
+          spillEntry(other.spillEntry)
     {
     }
 
@@ -22,6 +31,8 @@ namespace MapHistory
     {
         type = other.type;
         actions = std::move(other.actions);
+        _memoryUsage = other._memoryUsage;
+        spillEntry = other.spillEntry;
 
         return *this;
     }
@@ -55,7 +66,52 @@ namespace MapHistory
 
     void Transaction::redo(MapView &mapView)
     {
-        commit(mapView);
+        for (auto &action : actions)
+        {
+            action.redo(mapView);
+        }
+
+        mapView.selection().update();
+    }
+
+    void Transaction::updateMemoryUsage()
+    {
+        _memoryUsage = sizeof(Transaction) + actions.capacity() * sizeof(Action);
+        for (const auto &action : actions)
+        {
+            _memoryUsage += action.memoryUsage() - sizeof(Action);
+        }
+    }
+
+    bool Transaction::spill(SpillWriter &writer)
+    {
+        for (uint32_t actionIndex = 0; actionIndex < actions.size(); ++actionIndex)
+        {
+            auto &changes = actions[actionIndex].changes;
+            for (uint32_t changeIndex = 0; changeIndex < changes.size(); ++changeIndex)
+            {
+                Change &change = changes[changeIndex];
+                if (change.canSpill())
+                {
+                    writer.writeU32(actionIndex);
+                    writer.writeU32(changeIndex);
+                    change.spill(writer);
+                }
+            }
+        }
+
+        return !writer.empty();
+    }
+
+    void Transaction::reload(SpillReader &reader)
+    {
+        while (!reader.finished())
+        {
+            uint32_t actionIndex = reader.nextU32();
+            uint32_t changeIndex = reader.nextU32();
+
+            actions.at(actionIndex).changes.at(changeIndex).reload(reader);
+        }
     }
 
     Action::Action(ActionType actionType, Change::DataTypes &&change)
@@ -69,6 +125,17 @@ namespace MapHistory
         changes.emplace_back(std::move(change));
     }
 
+    size_t Action::memoryUsage() const
+    {
+        size_t bytes = sizeof(Action) + (changes.capacity() - changes.size()) * sizeof(Change);
+        for (const auto &change : changes)
+        {
+            bytes += change.memoryUsage();
+        }
+
+        return bytes;
+    }
+
     bool Action::isCommitted() const
     {
         return committed;
@@ -91,7 +158,14 @@ namespace MapHistory
 
     void Action::redo(MapView &mapView)
     {
-        commit(mapView);
+        if (applyInParallel(mapView, true))
+        {
+            committed = true;
+        }
+        else
+        {
+            commit(mapView);
+        }
     }
 
     void Action::commit(MapView &mapView)
@@ -108,12 +182,64 @@ namespace MapHistory
     {
         DEBUG_ASSERT(committed, "Attempted to undo an action that is not committed.");
 
-        for (auto it = changes.rbegin(); it != changes.rend(); ++it)
+        if (!applyInParallel(mapView, false))
         {
-            auto &change = *it;
-            change.undo(mapView);
+            for (auto it = changes.rbegin(); it != changes.rend(); ++it)
+            {
+                auto &change = *it;
+                change.undo(mapView);
+            }
         }
 
         committed = false;
     }
+
+    bool Action::applyInParallel(MapView &mapView, bool redo)
+    {
+        if (changes.size() < MinParallelChanges)
+            return false;
+
+        DEBUG_ASSERT(committed != redo, "The action is already in the requested state.");
+
+        // An undo applies the changes in reverse order, so positions[i] belongs to the i:th change to apply.
+        const size_t count = changes.size();
+        auto changeIndex = [redo, count](size_t i) { return redo ? i : count - 1 - i; };
+
+        std::vector<Position> positions;
+        positions.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto position = changes[changeIndex(i)].independentPosition();
+            if (!position)
+                return false;
+
+            positions.emplace_back(*position);
+        }
+
+        // Creating tile locations can add quadtree nodes, which is not safe to do concurrently.
+        for (const auto &position : positions)
+        {
+            mapView._map->getOrCreateTileLocation(position);
+        }
+
+        parallel::forEachByLeaf(positions, 0, [this, &mapView, &changeIndex, redo](size_t i) {
+            ChangeItem::deferSelectionUpdates = true;
+
+            Change &change = changes[changeIndex(i)];
+            if (redo)
+                change.commit(mapView);
+            else
+                change.undo(mapView);
+
+            ChangeItem::deferSelectionUpdates = false;
+        });
+
+        Selection &selection = mapView.selection();
+        for (const auto &position : positions)
+        {
+            selection.updatePosition(position);
+        }
+
+        return true;
+    }
 } // namespace MapHistory
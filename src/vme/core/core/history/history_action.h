@@ -2,6 +2,7 @@
 
 #include <type_traits>
 
+#include <optional>
 #include <stack>
 #include <unordered_map>
 #include <vector>
@@ -53,6 +54,9 @@ namespace MapHistory
         void undo(MapView &mapView);
         void redo(MapView &mapView);
 
+        // Estimated bytes used by the action and its changes
+        size_t memoryUsage() const;
+
         bool isCommitted() const;
 
         MapHistory::ActionType getType() const;
@@ -65,6 +69,14 @@ namespace MapHistory
       private:
         friend class MapHistory::History;
 
+        /*
+            Redoes or undoes the changes in parallel, grouped by quadtree leaf. Only done for large actions where
+            every change touches a single position (see ChangeItem::independentPosition). The changes at a
+            position keep their order, and the selection is updated once for every position at the end.
+            Returns false if the action must be applied serially.
+        */
+        bool applyInParallel(MapView &mapView, bool redo);
+
         MapHistory::ActionType actionType;
         bool committed;
     };
@@ -92,11 +104,38 @@ namespace MapHistory
             return actions.empty();
         }
 
+        /*
+            Estimated bytes used by the transaction, as of the last call to updateMemoryUsage.
+        */
+        inline size_t memoryUsage() const noexcept
+        {
+            return _memoryUsage;
+        }
+
+        void updateMemoryUsage();
+
+        inline bool spilled() const noexcept
+        {
+            return spillEntry.has_value();
+        }
+
         TransactionType type;
 
       private:
         friend class MapHistory::History;
+
+        /*
+            Writes every change that can be spilled to 'writer' and releases its state.
+            Returns false if nothing could be spilled.
+        */
+        bool spill(SpillWriter &writer);
+        void reload(SpillReader &reader);
+
         std::vector<MapHistory::Action> actions;
+
+        size_t _memoryUsage = 0;
+        // Location of the spilled changes in the spill file of the history
+        std::optional<SpillFile::Entry> spillEntry;
     };
 } // namespace MapHistory
 
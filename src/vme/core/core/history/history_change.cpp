@@ -1,12 +1,95 @@
 #include "history_change.h"
 
 #include "../map_view.h"
+#include "../parallel.h"
 #include "../util.h"
 
 #include <algorithm>
+#include <tuple>
+
+namespace
+{
+    // Rough allocation overhead of a std::make_shared or container node allocation
+    constexpr size_t AllocationOverhead = 16;
+    // Rough size of the item data of an item (container, teleport, ...)
+    constexpr size_t ItemDataBytes = 64;
+
+    size_t itemMemoryUsage(const Item &item)
+    {
+        size_t bytes = sizeof(Item) + AllocationOverhead;
+
+        if (auto attributes = item.attributes())
+        {
+            bytes += attributes->size() * (sizeof(std::pair<const ItemAttribute_t, ItemAttribute>) + AllocationOverhead);
+        }
+
+        if (item.data())
+        {
+            bytes += ItemDataBytes;
+        }
+
+        return bytes;
+    }
+
+    /*
+        Items that are shared with another tile (for example the tile in the map, see Tile::copyForHistory) are
+        not counted, since dropping or spilling the history would not release them.
+    */
+    size_t itemMemoryUsage(const std::shared_ptr<Item> &item)
+    {
+        return item && item.use_count() == 1 ? itemMemoryUsage(*item) : 0;
+    }
+
+    size_t tileMemoryUsage(const Tile &tile)
+    {
+        size_t bytes = tile.items().capacity() * sizeof(std::shared_ptr<Item>);
+        for (const auto &item : tile.items())
+        {
+            bytes += itemMemoryUsage(item);
+        }
+
+        bytes += itemMemoryUsage(tile.sharedGround());
+
+        if (tile.creature())
+        {
+            bytes += sizeof(Creature) + AllocationOverhead;
+        }
+
+        return bytes;
+    }
+
+    using TileData = std::variant<std::unique_ptr<Tile>, Position>;
+
+    size_t tileMemoryUsage(const TileData &data)
+    {
+        auto tile = std::get_if<std::unique_ptr<Tile>>(&data);
+        return tile && *tile ? sizeof(Tile) + tileMemoryUsage(**tile) : 0;
+    }
+
+    bool canSpillTile(const TileData &data)
+    {
+        auto tile = std::get_if<std::unique_ptr<Tile>>(&data);
+        return tile && *tile && MapHistory::SpillWriter::canWrite(**tile);
+    }
+
+    void spillTile(TileData &data, MapHistory::SpillWriter &writer)
+    {
+        auto &tile = std::get<std::unique_ptr<Tile>>(data);
+        writer.writeTile(*tile);
+
+        data = tile->position();
+    }
+
+    void reloadTile(TileData &data, MapHistory::SpillReader &reader)
+    {
+        data = std::make_unique<Tile>(reader.readTile());
+    }
+} // namespace
 
 namespace MapHistory
 {
+    thread_local bool ChangeItem::deferSelectionUpdates = false;
+
     Map *ChangeItem::getMap(MapView &mapView) const noexcept
     {
         return mapView._map.get();
@@ -14,13 +97,16 @@ namespace MapHistory
 
     void ChangeItem::updateSelection(MapView &mapView, const Position &position)
     {
+        if (deferSelectionUpdates)
+            return;
+
         mapView.selection().updatePosition(position);
     }
 
     void ChangeItem::swapMapTile(MapView &mapView, std::unique_ptr<Tile> &&tile)
     {
         const Position position = tile->position();
-        bool selected = tile->hasSelection();
+        tile->recountSelection();
 
         TileLocation &location = getMap(mapView)->getOrCreateTileLocation(position);
         auto locationTile = location.tile();
@@ -36,29 +122,29 @@ namespace MapHistory
         // Not necessary when items are stored as pointers
         // location.tile()->movedInMap();
 
-        mapView.selection().setSelected(position, selected);
+        updateSelection(mapView, position);
     }
 
     void ChangeItem::swapMapTile(MapView &mapView, Tile &tile)
     {
         const Position position = tile.position();
-        bool selected = tile.hasSelection();
+        tile.recountSelection();
 
         auto &mapTile = mapView.getOrCreateTile(position);
         std::ranges::swap(mapTile, tile);
 
-        mapView.selection().setSelected(position, selected);
+        updateSelection(mapView, position);
     }
 
     std::unique_ptr<Tile> ChangeItem::setMapTile(MapView &mapView, Tile &&tile)
     {
         const Position position = tile.position();
-        bool selected = tile.hasSelection();
+        tile.recountSelection();
 
         TileLocation &location = getMap(mapView)->getOrCreateTileLocation(position);
         std::unique_ptr<Tile> oldTilePointer = location.replaceTile(std::move(tile));
 
-        mapView.selection().setSelected(position, selected);
+        updateSelection(mapView, position);
 
         return oldTilePointer;
     }
@@ -67,13 +153,15 @@ namespace MapHistory
     {
         Map *map = getMap(mapView);
         Tile *oldTile = map->getTile(position);
+        bool selected = oldTile && oldTile->hasSelection();
 
-        if (oldTile && oldTile->hasSelection())
+        std::unique_ptr<Tile> removed = map->dropTile(position);
+        if (selected)
         {
-            mapView.selection().deselect(oldTile->position());
+            updateSelection(mapView, position);
         }
 
-        return map->dropTile(position);
+        return removed;
     }
 
     void Change::commit(MapView &mapView)
@@ -120,15 +208,111 @@ namespace MapHistory
             data);
     }
 
+    ChangeItem *Change::changeItem()
+    {
+        return const_cast<ChangeItem *>(std::as_const(*this).changeItem());
+    }
+
+    const ChangeItem *Change::changeItem() const
+    {
+        return std::visit(
+            util::overloaded{
+                [](const std::unique_ptr<ChangeItem> &change) -> const ChangeItem * {
+                    return change.get();
+                },
+                [](const std::monostate &) -> const ChangeItem * {
+                    return nullptr;
+                },
+                [](const auto &change) -> const ChangeItem * {
+                    return &change;
+                }},
+            data);
+    }
+
+    size_t Change::memoryUsage() const
+    {
+        const ChangeItem *change = changeItem();
+        if (!change)
+        {
+            return sizeof(Change);
+        }
+
+        size_t bytes = sizeof(Change) + change->memoryUsage();
+        // Changes that are too large for the variant are allocated separately. Their exact size is not known here.
+        if (std::holds_alternative<std::unique_ptr<ChangeItem>>(data))
+        {
+            bytes += sizeof(DataTypes) + AllocationOverhead;
+        }
+
+        return bytes;
+    }
+
+    bool Change::canSpill() const
+    {
+        const ChangeItem *change = changeItem();
+        return change && change->canSpill();
+    }
+
+    void Change::spill(SpillWriter &writer)
+    {
+        changeItem()->spill(writer);
+    }
+
+    void Change::reload(SpillReader &reader)
+    {
+        changeItem()->reload(reader);
+    }
+
+    std::optional<Position> Change::independentPosition() const
+    {
+        const ChangeItem *change = changeItem();
+        return change ? change->independentPosition() : std::nullopt;
+    }
+
     SetTile::SetTile(Tile &&tile)
         : data(std::make_unique<Tile>(std::move(tile))) {}
 
     SetTile::SetTile(std::unique_ptr<Tile> &&tile)
         : data(std::move(tile)) {}
 
+    SetTile SetTile::alreadyCommitted(Position position, std::unique_ptr<Tile> &&previous)
+    {
+        SetTile change(std::move(previous));
+        if (!std::get<std::unique_ptr<Tile>>(change.data))
+        {
+            change.data = position;
+        }
+        change.committed = true;
+
+        return change;
+    }
+
     void SetTile::commit(MapView &mapView)
     {
+        swapWithMap(mapView);
+    }
+
+    void SetTile::undo(MapView &mapView)
+    {
+        swapWithMap(mapView);
+    }
+
+    void SetTile::swapWithMap(MapView &mapView)
+    {
+        if (auto position = std::get_if<Position>(&data))
+        {
+            // There is no tile to put back. If the map has no tile there either, nothing changes.
+            std::unique_ptr<Tile> removed = removeMapTile(mapView, *position);
+            if (removed)
+            {
+                data = std::move(removed);
+            }
+            return;
+        }
+
         auto &tile = std::get<std::unique_ptr<Tile>>(data);
+        DEBUG_ASSERT(tile != nullptr, "A SetTile without a tile must hold its position.");
+
         const Position position = tile->position();
         swapMapTile(mapView, std::move(tile));
         if (!tile)
@@ -137,20 +321,198 @@ namespace MapHistory
         }
     }
 
-    void SetTile::undo(MapView &mapView)
+    size_t SetTile::memoryUsage() const
     {
-        if (std::holds_alternative<Position>(data))
+        return tileMemoryUsage(data);
+    }
+
+    std::optional<Position> SetTile::independentPosition() const
+    {
+        if (auto position = std::get_if<Position>(&data))
+            return *position;
+
+        return std::get<std::unique_ptr<Tile>>(data)->position();
+    }
+
+    bool SetTile::canSpill() const
+    {
+        return canSpillTile(data);
+    }
+
+    void SetTile::spill(SpillWriter &writer)
+    {
+        spillTile(data, writer);
+    }
+
+    void SetTile::reload(SpillReader &reader)
+    {
+        reloadTile(data, reader);
+    }
+
+    TileDelta::TileDelta(Position position, Operation operation, uint16_t index)
+        : _position(position), _operation(operation), index(index) {}
+
+    TileDelta TileDelta::addItem(Position position, Item &&item, int insertionOffset)
+    {
+        bool ground = item.isGround();
+
+        TileDelta delta(position, ground ? Operation::ReplaceGround : Operation::AddItem, ground ? GroundIndex : 0);
+        delta.insertionOffset = insertionOffset;
+        delta.thing = std::make_shared<Item>(std::move(item));
+
+        return delta;
+    }
+
+    TileDelta TileDelta::removeItem(Position position, uint16_t index)
+    {
+        return TileDelta(position, Operation::RemoveItem, index);
+    }
+
+    TileDelta TileDelta::removeGround(Position position)
+    {
+        return TileDelta(position, Operation::ReplaceGround, GroundIndex);
+    }
+
+    TileDelta TileDelta::setAttribute(Position position, uint16_t index, ItemAttribute_t type, std::optional<ItemAttribute> &&attribute)
+    {
+        TileDelta delta(position, Operation::SetAttribute, index);
+        delta.attributeType = type;
+        if (attribute)
         {
-            data = removeMapTile(mapView, std::get<Position>(data));
+            delta.thing = std::make_unique<ItemAttribute>(std::move(*attribute));
         }
         else
         {
-            auto &tile = std::get<std::unique_ptr<Tile>>(data);
+            delta.thing = std::unique_ptr<ItemAttribute>();
+        }
 
-            swapMapTile(mapView, std::move(tile));
+        return delta;
+    }
+
+    void TileDelta::commit(MapView &mapView)
+    {
+        if (firstCommit)
+        {
+            createdTile = mapView.getTile(_position) == nullptr;
+        }
+
+        swap(mapView, true);
+        firstCommit = false;
+    }
+
+    void TileDelta::undo(MapView &mapView)
+    {
+        swap(mapView, false);
+
+        if (createdTile)
+        {
+            removeMapTile(mapView, _position);
         }
     }
 
+    void TileDelta::swap(MapView &mapView, bool apply)
+    {
+        Tile &tile = mapView.getOrCreateTile(_position);
+
+        switch (_operation)
+        {
+            case Operation::AddItem:
+            case Operation::RemoveItem:
+            {
+                auto &item = std::get<std::shared_ptr<Item>>(thing);
+
+                // An AddItem inserts the item when it is applied, a RemoveItem when it is undone.
+                if (apply == (_operation == Operation::AddItem))
+                {
+                    if (firstCommit)
+                    {
+                        Item *added = tile.addItem(std::move(*item), insertionOffset);
+                        index = static_cast<uint16_t>(tile.indexOf(added).value());
+                    }
+                    else
+                    {
+                        tile.insertItem(std::move(item), index);
+                    }
+                    item.reset();
+                }
+                else
+                {
+                    item = tile.dropItem(index);
+                }
+                break;
+            }
+            case Operation::ReplaceGround:
+            {
+                auto &ground = std::get<std::shared_ptr<Item>>(thing);
+
+                std::shared_ptr<Item> previous = tile.dropGround();
+                if (ground)
+                {
+                    tile.setGround(std::move(ground));
+                }
+                ground = std::move(previous);
+                break;
+            }
+            case Operation::SetAttribute:
+            {
+                Item *item = index == GroundIndex ? tile.ground() : tile.itemAt(index);
+                DEBUG_ASSERT(item != nullptr, "There is no item at the index of the delta.");
+
+                auto &attribute = std::get<std::unique_ptr<ItemAttribute>>(thing);
+
+                std::optional<ItemAttribute> next;
+                if (attribute)
+                {
+                    next.emplace(std::move(*attribute));
+                }
+
+                auto previous = item->swapAttribute(attributeType, std::move(next));
+                attribute = previous ? std::make_unique<ItemAttribute>(std::move(*previous)) : nullptr;
+                break;
+            }
+        }
+
+        updateSelection(mapView, _position);
+    }
+
+    size_t TileDelta::memoryUsage() const
+    {
+        if (auto item = std::get_if<std::shared_ptr<Item>>(&thing))
+        {
+            return itemMemoryUsage(*item);
+        }
+
+        auto &attribute = std::get<std::unique_ptr<ItemAttribute>>(thing);
+        return attribute ? sizeof(ItemAttribute) + AllocationOverhead : 0;
+    }
+
+    std::optional<Position> TileDelta::independentPosition() const
+    {
+        // The first commit of an AddItem creates the item, which is not safe to do concurrently.
+        if (firstCommit)
+            return std::nullopt;
+
+        return _position;
+    }
+
+    bool TileDelta::canSpill() const
+    {
+        auto item = std::get_if<std::shared_ptr<Item>>(&thing);
+        return item && *item && SpillWriter::canWrite(*item);
+    }
+
+    void TileDelta::spill(SpillWriter &writer)
+    {
+        auto &item = std::get<std::shared_ptr<Item>>(thing);
+        writer.writeItem(*item);
+        item.reset();
+    }
+
+    void TileDelta::reload(SpillReader &reader)
+    {
+        thing = reader.readItem();
+    }
+
     MergeTile::MergeTile(Tile &&tile)
         : data(std::make_unique<Tile>(std::move(tile))), firstCommit(true)
     {
@@ -172,7 +534,7 @@ namespace MapHistory
             auto currentTile = mapView.getTile(position);
             if (currentTile)
             {
-                Tile t = currentTile->deepCopy();
+                Tile t = currentTile->copyForHistory();
                 t.merge(*tile);
 
                 tile = std::make_unique<Tile>(std::move(t));
@@ -201,6 +563,11 @@ namespace MapHistory
         }
     }
 
+    size_t MergeTile::memoryUsage() const
+    {
+        return tileMemoryUsage(data);
+    }
+
     MoveFromMapToContainer::MoveFromMapToContainer(Tile &tile, Item *item, ContainerLocation &to)
         : fromPosition(tile.position()), to(to), data(PreFirstCommitData{item}) {}
 
@@ -382,6 +749,12 @@ namespace MapHistory
         data = pos;
     }
 
+    size_t RemoveTile::memoryUsage() const
+    {
+        auto tile = std::get_if<Tile>(&data);
+        return tile ? tileMemoryUsage(*tile) : 0;
+    }
+
     RemoveTile_v2::RemoveTile_v2(Position pos)
         : data(pos) {}
 
@@ -402,6 +775,26 @@ namespace MapHistory
         data = pos;
     }
 
+    size_t RemoveTile_v2::memoryUsage() const
+    {
+        return tileMemoryUsage(data);
+    }
+
+    bool RemoveTile_v2::canSpill() const
+    {
+        return canSpillTile(data);
+    }
+
+    void RemoveTile_v2::spill(SpillWriter &writer)
+    {
+        spillTile(data, writer);
+    }
+
+    void RemoveTile_v2::reload(SpillReader &reader)
+    {
+        reloadTile(data, reader);
+    }
+
     Move_v2::Move_v2(Position from, Position to)
         : fromTile(from), toTile(to) {}
 
@@ -515,110 +908,147 @@ namespace MapHistory
         updateSelection(mapView, toTile.position());
     }
 
-    std::function<bool(const Position &, const Position &)> MoveSelection::getPositionComparator()
+    size_t Move_v2::memoryUsage() const
     {
-        int dx = util::sgn(deltaPos.x);
-        int dy = util::sgn(deltaPos.y);
-
-        if (dx == 1 && dy == 1)
-        {
-            return [](const Position &a, const Position &b) { return a.x + a.y >= b.x + b.y; };
-        }
-        else if (dx == 1 && dy == -1)
-        {
-            return [](const Position &a, const Position &b) { return a.x + b.y >= b.x + a.y; };
-        }
-        else if (dx == -1 && dy == 1)
-        {
-            return [](const Position &a, const Position &b) { return b.x + a.y >= a.x + b.y; };
-        }
-        else if (dx == -1 && dy == -1)
-        {
-            return [](const Position &a, const Position &b) { return a.x + a.y <= b.x + b.y; };
-        }
-        else if (dx == 1 && dy == 0)
-        {
-            return [](const Position &a, const Position &b) { return a.x >= b.x; };
-        }
-        else if (dx == -1 && dy == 0)
-        {
-            return [](const Position &a, const Position &b) { return a.x <= b.x; };
-        }
-        else if (dx == 0 && dy == 1)
-        {
-            return [](const Position &a, const Position &b) { return a.y >= b.y; };
-        }
-        else if (dx == 0 && dy == -1)
-        {
-            return [](const Position &a, const Position &b) { return a.y <= b.y; };
-        }
-        else
+        size_t bytes = tileMemoryUsage(fromTile) + tileMemoryUsage(toTile);
+        if (partialMoveData)
         {
-            ABORT_PROGRAM("[MoveSelection::MoveSelection] dx or dy is 0. This should never happen.");
+            bytes += partialMoveData->indices.capacity() * sizeof(uint16_t);
         }
+
+        return bytes;
     }
 
-    MoveSelection::MoveSelection(std::vector<Position> positions, Position deltaPos)
-        : deltaPos(deltaPos),
-          moveData(std::make_unique<std::vector<MoveData>>()),
-          firstCommit(true)
+    namespace
     {
+        // Below this many tiles, starting threads costs more than it saves.
+        constexpr size_t MinParallelMoveTiles = 4096;
+    } // namespace
 
-        moveData = std::make_unique<std::vector<Position>>(std::move(positions));
-    }
+    MoveSelection::MoveSelection(std::vector<SelectionSpan> spans, Position deltaPos)
+        : deltaPos(deltaPos),
+          moveData(std::make_unique<std::vector<SelectionSpan>>(std::move(spans))),
+          firstCommit(true) {}
 
     void MoveSelection::commit(MapView &mapView)
     {
         if (firstCommit)
         {
-            auto comparator = getPositionComparator();
-            std::vector<Position> positions = *dataAsPositions();
+            if (deltaPos.x == 0 && deltaPos.y == 0)
+            {
+                ABORT_PROGRAM("[MoveSelection::commit] dx or dy is 0. This should never happen.");
+            }
 
-            // Necessary sort to avoid moves overlapping src/target positions of other moves
-            std::ranges::sort(positions, comparator);
+            std::vector<SelectionSpan> spans = std::move(*dataAsSpans());
+            moveTiles(mapView, spans);
 
-            moveData = std::make_unique<std::vector<MoveData>>();
-            auto &tiles = dataAsTiles();
-            tiles->reserve(positions.size());
+            // Every source is deselected before the targets are selected, since a target can also be a source.
+            Selection &selection = mapView.selection();
+            for (const auto &span : spans)
+                selection.deselectRegion(span.start, span.end());
 
-            for (const auto &pos : positions)
+            for (const auto &span : spans)
+                selection.selectRegion(span.start + deltaPos, span.end() + deltaPos);
+        }
+        else
+        {
+            for (auto &tile : *dataAsTiles())
             {
-                Tile &from = *mapView.getTile(pos);
-                Tile &to = mapView.getOrCreateTile(pos + deltaPos);
+                swapMapTile(mapView, tile);
+            }
+        }
 
-                Tile currentFrom = from.copyForHistory();
-                Tile currentTo = to.copyForHistory();
+        firstCommit = false;
+    }
 
-                from.moveSelected(to);
+    void MoveSelection::moveTiles(MapView &mapView, const std::vector<SelectionSpan> &spans)
+    {
+        size_t count = 0;
+        for (const auto &span : spans)
+            count += span.length;
 
-                mapView.selection().setSelected(pos, false);
-                mapView.selection().setSelected(pos + deltaPos, true);
+        std::vector<Position> sources;
+        std::vector<Position> targets;
+        sources.reserve(count);
+        targets.reserve(count);
+        for (const auto &span : spans)
+        {
+            span.forEach([this, &sources, &targets](const Position pos) {
+                sources.emplace_back(pos);
+                targets.emplace_back(pos + deltaPos);
+            });
+        }
 
-                tiles->emplace_back(MoveData{std::move(currentFrom), std::move(currentTo)});
-            }
+        // Creating a tile can change the structure of the map, so all tiles are looked up (and created) here.
+        std::vector<Tile *> sourceTiles;
+        std::vector<Tile *> targetTiles;
+        sourceTiles.reserve(count);
+        targetTiles.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            sourceTiles.emplace_back(mapView.getTile(sources[i]));
+            targetTiles.emplace_back(&mapView.getOrCreateTile(targets[i]));
         }
-        else
+
+        // The affected positions are the sources and every target that is not also a source.
+        std::vector<Position> affected = sources;
+        std::vector<Tile *> affectedTiles = sourceTiles;
         {
-            for (auto &tileData : *dataAsTiles())
+            vme_unordered_set<Position> sourceSet(sources.begin(), sources.end());
+            for (size_t i = 0; i < count; ++i)
             {
-                swapMapTile(mapView, tileData.fromTile);
-                swapMapTile(mapView, tileData.toTile);
+                if (sourceSet.find(targets[i]) == sourceSet.end())
+                {
+                    affected.emplace_back(targets[i]);
+                    affectedTiles.emplace_back(targetTiles[i]);
+                }
             }
         }
 
-        firstCommit = false;
+        auto history = std::make_unique<std::vector<Tile>>();
+        history->reserve(affected.size());
+        for (const auto &pos : affected)
+            history->emplace_back(pos);
+
+        parallel::forEachByLeaf(affected, MinParallelMoveTiles, [&history, &affectedTiles](size_t i) {
+            (*history)[i] = affectedTiles[i]->copyForHistory();
+        });
+
+        std::vector<Tile::SelectedThings> moved(count);
+        parallel::forEachByLeaf(sources, MinParallelMoveTiles, [&moved, &sourceTiles](size_t i) {
+            moved[i] = sourceTiles[i]->dropSelected();
+        });
+
+        parallel::forEachByLeaf(targets, MinParallelMoveTiles, [&moved, &targetTiles](size_t i) {
+            targetTiles[i]->addSelected(std::move(moved[i]));
+        });
+
+        moveData = std::move(history);
     }
 
     void MoveSelection::undo(MapView &mapView)
     {
-        for (auto &tileData : *dataAsTiles() | std::views::reverse)
+        for (auto &tile : *dataAsTiles())
         {
-            Position fromPos = tileData.fromTile.position();
-            Position toPos = tileData.toTile.position();
+            swapMapTile(mapView, tile);
+        }
+    }
 
-            swapMapTile(mapView, tileData.fromTile);
-            swapMapTile(mapView, tileData.toTile);
+    size_t MoveSelection::memoryUsage() const
+    {
+        if (auto spans = std::get_if<std::unique_ptr<std::vector<SelectionSpan>>>(&moveData))
+        {
+            return (*spans)->capacity() * sizeof(SelectionSpan);
         }
+
+        const auto &tiles = std::get<std::unique_ptr<std::vector<Tile>>>(moveData);
+        size_t bytes = tiles->capacity() * sizeof(Tile);
+        for (const auto &tile : *tiles)
+        {
+            bytes += tileMemoryUsage(tile);
+        }
+
+        return bytes;
     }
 
     Move::Move(Position from, Position to)
@@ -692,8 +1122,8 @@ namespace MapHistory
         Tile &to = mapView.getOrCreateTile(toPos);
 
         // VME_LOG_D("Moving from " << fromPos << " to " << toPos);
-        undoData.fromTile = from.deepCopy();
-        undoData.toTile = to.deepCopy();
+        undoData.fromTile = from.copyForHistory();
+        undoData.toTile = to.copyForHistory();
 
         std::visit(
             util::overloaded{
@@ -734,13 +1164,24 @@ namespace MapHistory
     {
         Map *map = getMap(mapView);
 
-        map->insertTile(undoData.toTile.deepCopy());
-        map->insertTile(undoData.fromTile.deepCopy());
+        map->insertTile(undoData.toTile.copyForHistory());
+        map->insertTile(undoData.fromTile.copyForHistory());
 
         updateSelection(mapView, undoData.fromTile.position());
         updateSelection(mapView, undoData.toTile.position());
     }
 
+    size_t Move::memoryUsage() const
+    {
+        size_t bytes = tileMemoryUsage(undoData.fromTile) + tileMemoryUsage(undoData.toTile);
+        if (auto partial = std::get_if<Partial>(&moveData))
+        {
+            bytes += partial->indices.capacity() * sizeof(uint16_t);
+        }
+
+        return bytes;
+    }
+
     SelectMultiple::SelectMultiple(const MapView &mapView, std::vector<Position> &&positions, bool select)
         : select(select)
     {
@@ -759,25 +1200,136 @@ namespace MapHistory
         }
     }
 
-    void SelectMultiple::commit(MapView &mapView)
+    SelectMultiple::SelectMultiple(const MapView &mapView, const std::vector<SelectionSpan> &spans, bool select)
+        : spans(spans), select(select)
     {
-        Map *map = getMap(mapView);
-        if (select)
+        for (const auto &span : spans)
         {
-            for (auto &entry : entries)
+            span.forEach([this, &mapView, select](const Position position) {
+                const Tile &tile = *mapView.getTile(position);
+
+                // (All selected + select) or (none selected + deselect) --> Do nothing
+                bool include = !((tile.allSelected() && select) || (!tile.hasSelection() && !select));
+
+                if (include)
+                {
+                    entries.emplace_back<Entry>(getEntry(mapView, tile));
+                }
+            });
+        }
+    }
+
+    SelectMultiple::SelectMultiple(const MapView &mapView, const Position &from, const Position &to, bool select)
+        : select(select)
+    {
+        const Position low(std::min(from.x, to.x), std::min(from.y, to.y), std::min(from.z, to.z));
+        const Position high(std::max(from.x, to.x), std::max(from.y, to.y), std::max(from.z, to.z));
+
+        size_t tileCount = 0;
+        for (auto &location : mapView.map()->getRegion(low, high))
+        {
+            const Tile *tile = location.tile();
+            if (!tile || tile->isEmpty())
+                continue;
+
+            ++tileCount;
+
+            // (All selected + select) or (none selected + deselect) --> Do nothing
+            bool include = !((tile->allSelected() && select) || (!tile->hasSelection() && !select));
+            if (include)
             {
-                map->getTile(entry.position)->selectAll();
-                mapView.selection().select(entry.position);
+                entries.emplace_back<Entry>(getEntry(mapView, *tile));
             }
         }
-        else
+
+        if (entries.empty())
+            return;
+
+        const size_t width = static_cast<size_t>(high.x - low.x + 1);
+        const size_t volume = width * static_cast<size_t>(high.y - low.y + 1) * static_cast<size_t>(high.z - low.z + 1);
+
+        if (tileCount == volume)
+        {
+            // Every position in the box has a tile, so each row of the box is one run.
+            for (auto z = low.z; z <= high.z; ++z)
+            {
+                for (auto y = low.y; y <= high.y; ++y)
+                {
+                    spans.emplace_back(SelectionSpan{Position(low.x, y, z), static_cast<int>(width)});
+                }
+            }
+
+            return;
+        }
+
+        std::vector<Position> positions;
+        positions.reserve(entries.size());
+        for (const auto &entry : entries)
+        {
+            positions.emplace_back(entry.position);
+        }
+
+        std::sort(positions.begin(), positions.end(), [](const Position &a, const Position &b) {
+            return std::tie(a.z, a.y, a.x) < std::tie(b.z, b.y, b.x);
+        });
+
+        for (const auto &pos : positions)
+        {
+            if (!spans.empty())
+            {
+                SelectionSpan &last = spans.back();
+                if (last.start.z == pos.z && last.start.y == pos.y && last.start.x + last.length == pos.x)
+                {
+                    ++last.length;
+                    continue;
+                }
+            }
+
+            spans.emplace_back(SelectionSpan{pos, 1});
+        }
+    }
+
+    void SelectMultiple::commit(MapView &mapView)
+    {
+        Map *map = getMap(mapView);
+
+        if (!spans.empty())
         {
             for (auto &entry : entries)
             {
-                map->getTile(entry.position)->deselectAll();
-                mapView.selection().deselect(entry.position);
+                Tile *tile = map->getTile(entry.position);
+                if (select)
+                    tile->selectAll();
+                else
+                    tile->deselectAll();
             }
+
+            if (select)
+                mapView.selection().select(spans);
+            else
+                mapView.selection().deselect(spans);
+
+            return;
         }
+
+        std::vector<Position> positions;
+        positions.reserve(entries.size());
+
+        for (auto &entry : entries)
+        {
+            Tile *tile = map->getTile(entry.position);
+            if (select)
+                tile->selectAll();
+            else
+                tile->deselectAll();
+
+            positions.emplace_back(entry.position);
+        }
+
+        if (select)
+            mapView.selection().select(positions);
+        else
+            mapView.selection().deselect(positions);
     }
 
     void SelectMultiple::undo(MapView &mapView)
@@ -849,6 +1401,17 @@ namespace MapHistory
         }
     }
 
+    size_t SelectMultiple::memoryUsage() const
+    {
+        size_t bytes = entries.capacity() * sizeof(Entry) + spans.capacity() * sizeof(SelectionSpan);
+        for (const auto &entry : entries)
+        {
+            bytes += entry.indices.capacity() * sizeof(uint16_t);
+        }
+
+        return bytes;
+    }
+
     SelectMultiple::Entry SelectMultiple::getEntry(const MapView &mapView, const Tile &tile) const
     {
         Entry result;
@@ -6,7 +6,9 @@
 
 #include "../creature.h"
 #include "../item_location.h"
+#include "../selection.h"
 #include "../tile.h"
+#include "history_spill.h"
 #include "thing_mutation.h"
 
 class MapView;
@@ -59,6 +61,43 @@ namespace MapHistory
         }
         virtual void undo(MapView &mapView) = 0;
 
+        /*
+            Estimated number of bytes that the change owns outside of the change object itself.
+        */
+        virtual size_t memoryUsage() const
+        {
+            return 0;
+        }
+
+        /*
+            Spilling moves the state of a committed change out of memory (see History::setMemoryBudget).
+            canSpill is true if spill would release memory. spill writes the state and releases it, and reload
+            reads it back. Nothing else is called on a spilled change before it has been reloaded.
+        */
+        virtual bool canSpill() const
+        {
+            return false;
+        }
+        virtual void spill(SpillWriter &writer) {}
+        virtual void reload(SpillReader &reader) {}
+
+        /*
+            The position of the only tile that the change touches, if redoing and undoing the change is safe to do
+            concurrently with changes at positions in other quadtree leaves (see Action::undo). Such changes may
+            only swap things between the change and the map, and must update the selection through the helpers
+            above.
+        */
+        virtual std::optional<Position> independentPosition() const
+        {
+            return std::nullopt;
+        }
+
+        /*
+            Set while an action applies its changes in parallel. The helpers above then leave the selection
+            alone, and the action updates the selection of every affected position afterwards.
+        */
+        static thread_local bool deferSelectionUpdates;
+
       protected:
         friend class MapHistory::Change;
         bool committed;
@@ -70,13 +109,99 @@ namespace MapHistory
         SetTile(Tile &&tile);
         SetTile(std::unique_ptr<Tile> &&tile);
 
+        /*
+            A SetTile that is already committed: undoing it puts 'previous' back at 'position', or removes the tile
+            there if 'previous' is nullptr.
+        */
+        static SetTile alreadyCommitted(Position position, std::unique_ptr<Tile> &&previous);
+
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
+        bool canSpill() const override;
+        void spill(SpillWriter &writer) override;
+        void reload(SpillReader &reader) override;
+        std::optional<Position> independentPosition() const override;
 
       protected:
+        /*
+            Commit and undo both swap the stored tile with the tile in the map. A Position means that there is
+            no tile to swap in; the map tile at that position is then taken out.
+        */
+        void swapWithMap(MapView &mapView);
+
         std::variant<std::unique_ptr<Tile>, Position> data;
     };
 
+    /*
+        Changes a single thing on a tile. Unlike SetTile, which keeps a copy of the whole tile, a delta only keeps
+        the thing that changed, so adding an item to a high stack costs as much history memory as adding it to an
+        empty tile.
+
+        Every delta uses the same encoding: the position, the operation, the index of the item in the tile and the
+        item or attribute that is not currently in the map (the removed item after a RemoveItem, the added item
+        after an undone AddItem, and so on).
+    */
+    class TileDelta : public ChangeItem
+    {
+      public:
+        enum class Operation : uint8_t
+        {
+            AddItem,
+            RemoveItem,
+            ReplaceGround,
+            SetAttribute
+        };
+
+        // Index that refers to the ground of the tile
+        static constexpr uint16_t GroundIndex = UINT16_MAX;
+
+        /*
+            The item is placed according to its stack order, like Tile::addItem. Grounds replace the current ground.
+        */
+        static TileDelta addItem(Position position, Item &&item, int insertionOffset = 0);
+        static TileDelta removeItem(Position position, uint16_t index);
+        static TileDelta removeGround(Position position);
+        static TileDelta setAttribute(Position position, uint16_t index, ItemAttribute_t type, std::optional<ItemAttribute> &&attribute);
+
+        void commit(MapView &mapView) override;
+        void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
+        bool canSpill() const override;
+        void spill(SpillWriter &writer) override;
+        void reload(SpillReader &reader) override;
+        std::optional<Position> independentPosition() const override;
+
+        inline Operation operation() const noexcept
+        {
+            return _operation;
+        }
+
+        inline Position position() const noexcept
+        {
+            return _position;
+        }
+
+      private:
+        TileDelta(Position position, Operation operation, uint16_t index);
+
+        // Swaps the stored item or attribute with the one in the map.
+        void swap(MapView &mapView, bool apply);
+
+        Position _position;
+        Operation _operation;
+        ItemAttribute_t attributeType = ItemAttribute_t::ActionId;
+        uint16_t index;
+        // Only used by AddItem before its first commit, since the index depends on the stack order.
+        int insertionOffset = 0;
+
+        bool firstCommit = true;
+        // True if the tile did not exist before the change. The tile is then removed again on undo.
+        bool createdTile = false;
+
+        std::variant<std::shared_ptr<Item>, std::unique_ptr<ItemAttribute>> thing;
+    };
+
     class MergeTile : public ChangeItem
     {
       public:
@@ -85,6 +210,7 @@ namespace MapHistory
 
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
 
       protected:
         bool firstCommit;
@@ -202,6 +328,10 @@ namespace MapHistory
 
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
+        bool canSpill() const override;
+        void spill(SpillWriter &writer) override;
+        void reload(SpillReader &reader) override;
 
       private:
         std::variant<std::unique_ptr<Tile>, Position> data;
@@ -214,6 +344,7 @@ namespace MapHistory
 
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
 
       private:
         std::variant<Tile, Position> data;
@@ -222,32 +353,39 @@ namespace MapHistory
     class MoveSelection : public ChangeItem
     {
       public:
-        MoveSelection(std::vector<Position> positions, Position deltaPos);
+        MoveSelection(std::vector<SelectionSpan> spans, Position deltaPos);
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
 
       private:
-        struct MoveData
+        /*
+            Moves the selected things of every position in 'spans' by deltaPos. The work is split by quadtree leaf
+            and spread over several threads. The affected tiles are first saved for the history. Then the selected
+            things are taken out of every source tile, and only after that added to the destination tiles. Since all
+            sources are emptied before any destination is filled, overlapping source and destination regions do
+            not need to be moved in any particular order.
+        */
+        void moveTiles(MapView &mapView, const std::vector<SelectionSpan> &spans);
+
+        std::unique_ptr<std::vector<SelectionSpan>> &dataAsSpans()
         {
-            Tile fromTile;
-            Tile toTile;
-        };
-
-        std::unique_ptr<std::vector<Position>> &dataAsPositions()
-        {
-            return std::get<std::unique_ptr<std::vector<Position>>>(moveData);
+            return std::get<std::unique_ptr<std::vector<SelectionSpan>>>(moveData);
         }
 
-        std::unique_ptr<std::vector<MoveData>> &dataAsTiles()
+        std::unique_ptr<std::vector<Tile>> &dataAsTiles()
         {
-            return std::get<std::unique_ptr<std::vector<MoveData>>>(moveData);
+            return std::get<std::unique_ptr<std::vector<Tile>>>(moveData);
         }
 
-        std::function<bool(const Position &, const Position &)> getPositionComparator();
-
         Position deltaPos;
 
-        std::variant<std::unique_ptr<std::vector<MoveData>>, std::unique_ptr<std::vector<Position>>> moveData;
+        /*
+            Before the first commit: the selected spans.
+            After: one tile per affected position, holding the state of that position that is not in the map.
+            Swapping every tile with the map therefore both undoes and redoes the move.
+        */
+        std::variant<std::unique_ptr<std::vector<Tile>>, std::unique_ptr<std::vector<SelectionSpan>>> moveData;
 
         bool firstCommit = true;
     };
@@ -272,6 +410,7 @@ namespace MapHistory
 
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
 
         Position fromPos() const
         {
@@ -316,6 +455,7 @@ namespace MapHistory
 
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
 
         inline Position fromPosition() const noexcept
         {
@@ -370,9 +510,19 @@ namespace MapHistory
     {
       public:
         SelectMultiple(const MapView &mapView, std::vector<Position> &&positions, bool select = true);
+        SelectMultiple(const MapView &mapView, const std::vector<SelectionSpan> &spans, bool select = true);
+        // The non-empty tiles in the box [from, to] (inclusive)
+        SelectMultiple(const MapView &mapView, const Position &from, const Position &to, bool select = true);
 
         void commit(MapView &mapView) override;
         void undo(MapView &mapView) override;
+        size_t memoryUsage() const override;
+
+        // True if no tile would change
+        bool empty() const noexcept
+        {
+            return entries.empty();
+        }
 
       private:
         struct Entry
@@ -392,6 +542,11 @@ namespace MapHistory
         };
 
         std::vector<Entry> entries;
+        /*
+            Runs that cover the positions of the entries, if they are known. commit then changes the selection
+            storage by run (see Selection::select(spans)) instead of by position.
+        */
+        std::vector<SelectionSpan> spans;
         bool select;
 
         Entry getEntry(const MapView &mapView, const Tile &tile) const;
@@ -471,6 +626,7 @@ namespace MapHistory
         using DataTypes = std::variant<
             std::monostate,
             SetTile,
+            TileDelta,
             MergeTile,
             RemoveTile,
             Select,
@@ -503,11 +659,23 @@ namespace MapHistory
         void commit(MapView &mapView);
         void undo(MapView &mapView);
 
+        // Estimated bytes used by the change, including the change itself.
+        size_t memoryUsage() const;
+
+        bool canSpill() const;
+        void spill(SpillWriter &writer);
+        void reload(SpillReader &reader);
+        std::optional<Position> independentPosition() const;
+
         DataTypes data;
 
       private:
         Change()
             : data({}) {}
+
+        // nullptr for an empty change
+        ChangeItem *changeItem();
+        const ChangeItem *changeItem() const;
     };
 
 } // namespace MapHistory
@@ -0,0 +1,238 @@
+#include "history_spill.h"
+
+#include <algorithm>
+
+#include "../debug.h"
+#include "../logger.h"
+#include "../tile.h"
+
+namespace
+{
+    constexpr uint8_t NoGround = 0;
+    constexpr uint8_t HasGround = 1;
+} // namespace
+
+namespace MapHistory
+{
+    void SpillWriter::writeU8(uint8_t value)
+    {
+        buffer.emplace_back(value);
+    }
+
+    void SpillWriter::writeU16(uint16_t value)
+    {
+        writeU8(static_cast<uint8_t>(value));
+        writeU8(static_cast<uint8_t>(value >> 8));
+    }
+
+    void SpillWriter::writeU32(uint32_t value)
+    {
+        writeU16(static_cast<uint16_t>(value));
+        writeU16(static_cast<uint16_t>(value >> 16));
+    }
+
+    void SpillWriter::writePosition(const Position &position)
+    {
+        writeU32(static_cast<uint32_t>(position.x));
+        writeU32(static_cast<uint32_t>(position.y));
+        writeU8(static_cast<uint8_t>(position.z));
+    }
+
+    bool SpillWriter::canWrite(const std::shared_ptr<Item> &item)
+    {
+        return item.use_count() == 1 && !item->hasAttributes() && item->itemDataType() == ItemDataType::Normal;
+    }
+
+    bool SpillWriter::canWrite(const Tile &tile)
+    {
+        if (tile._creature)
+            return false;
+
+        if (tile._ground && !canWrite(tile._ground))
+            return false;
+
+        return std::ranges::all_of(tile._items, [](const std::shared_ptr<Item> &item) { return canWrite(item); });
+    }
+
+    void SpillWriter::writeItem(const Item &item)
+    {
+        writeU32(item.serverId());
+        writeU8(item.subtype());
+        writeU8(item.selected ? 1 : 0);
+    }
+
+    void SpillWriter::writeTile(const Tile &tile)
+    {
+        DEBUG_ASSERT(canWrite(tile), "The tile can not be spilled.");
+
+        writePosition(tile._position);
+        writeU32(tile._flags);
+
+        if (tile._ground)
+        {
+            writeU8(HasGround);
+            writeItem(*tile._ground);
+        }
+        else
+        {
+            writeU8(NoGround);
+        }
+
+        DEBUG_ASSERT(tile._items.size() <= UINT16_MAX, "Too many items on a tile.");
+        writeU16(static_cast<uint16_t>(tile._items.size()));
+        for (const auto &item : tile._items)
+        {
+            writeItem(*item);
+        }
+    }
+
+    SpillReader::SpillReader(std::vector<uint8_t> &&bytes)
+        : buffer(std::move(bytes)) {}
+
+    uint8_t SpillReader::nextU8()
+    {
+        DEBUG_ASSERT(cursor < buffer.size(), "Read past the end of the spilled data.");
+        return buffer[cursor++];
+    }
+
+    uint16_t SpillReader::nextU16()
+    {
+        uint16_t low = nextU8();
+        uint16_t high = nextU8();
+        return static_cast<uint16_t>(low | (high << 8));
+    }
+
+    uint32_t SpillReader::nextU32()
+    {
+        uint32_t low = nextU16();
+        uint32_t high = nextU16();
+        return low | (high << 16);
+    }
+
+    Position SpillReader::readPosition()
+    {
+        auto x = static_cast<Position::value_type>(nextU32());
+        auto y = static_cast<Position::value_type>(nextU32());
+        auto z = static_cast<Position::z_type>(nextU8());
+
+        return Position(x, y, z);
+    }
+
+    Tile SpillReader::readTile()
+    {
+        Tile tile(readPosition());
+        tile._flags = nextU32();
+
+        auto readTileItem = [this, &tile]() {
+            auto item = readItem();
+            if (item->selected)
+                ++tile._selectionCount;
+
+            return item;
+        };
+
+        if (nextU8() == HasGround)
+        {
+            tile._ground = readTileItem();
+        }
+
+        uint16_t itemCount = nextU16();
+        tile._items.reserve(itemCount);
+        for (uint16_t i = 0; i < itemCount; ++i)
+        {
+            tile._items.emplace_back(readTileItem());
+        }
+
+        return tile;
+    }
+
+    std::shared_ptr<Item> SpillReader::readItem()
+    {
+        auto item = std::make_shared<Item>(nextU32());
+        item->setSubtype(nextU8());
+        item->selected = nextU8() != 0;
+
+        return item;
+    }
+
+    SpillFile::SpillFile(std::filesystem::path path)
+        : _path(std::move(path))
+    {
+        stream.open(_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+        {
+            VME_LOG_ERROR("Could not create the history spill file " << _path);
+        }
+    }
+
+    SpillFile::~SpillFile()
+    {
+        stream.close();
+
+        std::error_code error;
+        std::filesystem::remove(_path, error);
+    }
+
+    std::optional<SpillFile::Entry> SpillFile::write(const std::vector<uint8_t> &bytes)
+    {
+        if (!stream.is_open())
+        {
+            return std::nullopt;
+        }
+
+        stream.clear();
+        stream.seekp(static_cast<std::streamoff>(fileSize));
+        stream.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        stream.flush();
+
+        if (!stream)
+        {
+            VME_LOG_ERROR("Could not write to the history spill file " << _path);
+            stream.clear();
+            return std::nullopt;
+        }
+
+        Entry entry{fileSize, bytes.size()};
+        fileSize += bytes.size();
+        usedBytes += bytes.size();
+        ++usedEntries;
+
+        return entry;
+    }
+
+    std::vector<uint8_t> SpillFile::read(const Entry &entry)
+    {
+        std::vector<uint8_t> bytes(entry.size);
+
+        stream.clear();
+        stream.seekg(static_cast<std::streamoff>(entry.offset));
+        stream.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(entry.size));
+
+        if (!stream)
+        {
+            ABORT_PROGRAM("Could not read from the history spill file " << _path);
+        }
+
+        return bytes;
+    }
+
+    void SpillFile::release(const Entry &entry)
+    {
+        DEBUG_ASSERT(usedEntries > 0 && usedBytes >= entry.size, "Released an entry that is not in use.");
+
+        usedBytes -= entry.size;
+        --usedEntries;
+
+        if (usedEntries == 0)
+        {
+            truncate();
+        }
+    }
+
+    void SpillFile::truncate()
+    {
+        stream.close();
+        stream.open(_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        fileSize = 0;
+    }
+} // namespace MapHistory
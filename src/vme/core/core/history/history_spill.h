@@ -0,0 +1,131 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+#include "../position.h"
+
+class Item;
+class Tile;
+
+namespace MapHistory
+{
+    /*
+        Writes the binary form of history changes that are moved out of memory. The format is only ever read back
+        by SpillReader in the same session, so it has no versioning.
+    */
+    class SpillWriter
+    {
+      public:
+        void writeU8(uint8_t value);
+        void writeU16(uint16_t value);
+        void writeU32(uint32_t value);
+        void writePosition(const Position &position);
+
+        /*
+            Only tiles and items for which canWrite is true can be written.
+        */
+        void writeTile(const Tile &tile);
+        void writeItem(const Item &item);
+
+        /*
+            True if the tile can be written and read back without losing anything. That is the case for tiles
+            without creatures whose items have no attributes or item data (containers, teleports, ...), and whose
+            items are not shared with another tile (for example the tile in the map).
+
+            A shared item can still be changed in place through the other tile (see Tile::copyForHistory), so
+            writing it would record its state at the time of the spill instead of its state in the snapshot.
+        */
+        static bool canWrite(const Tile &tile);
+        static bool canWrite(const std::shared_ptr<Item> &item);
+
+        const std::vector<uint8_t> &bytes() const noexcept
+        {
+            return buffer;
+        }
+
+        bool empty() const noexcept
+        {
+            return buffer.empty();
+        }
+
+      private:
+        std::vector<uint8_t> buffer;
+    };
+
+    class SpillReader
+    {
+      public:
+        SpillReader(std::vector<uint8_t> &&bytes);
+
+        uint8_t nextU8();
+        uint16_t nextU16();
+        uint32_t nextU32();
+        Position readPosition();
+        Tile readTile();
+        std::shared_ptr<Item> readItem();
+
+        bool finished() const noexcept
+        {
+            return cursor == buffer.size();
+        }
+
+      private:
+        std::vector<uint8_t> buffer;
+        size_t cursor = 0;
+    };
+
+    /*
+        Append-only file for spilled history transactions. The file is removed when the SpillFile is destroyed.
+        Space is not reclaimed when an entry is read back; the file is truncated once no entries are in use.
+    */
+    class SpillFile
+    {
+      public:
+        struct Entry
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        SpillFile(std::filesystem::path path);
+        ~SpillFile();
+
+        SpillFile(const SpillFile &other) = delete;
+        SpillFile &operator=(const SpillFile &other) = delete;
+
+        /*
+            Returns std::nullopt if the bytes could not be written.
+        */
+        std::optional<Entry> write(const std::vector<uint8_t> &bytes);
+        std::vector<uint8_t> read(const Entry &entry);
+
+        // Marks an entry as no longer in use.
+        void release(const Entry &entry);
+
+        // Bytes of the entries that are in use
+        uint64_t size() const noexcept
+        {
+            return usedBytes;
+        }
+
+        const std::filesystem::path &path() const noexcept
+        {
+            return _path;
+        }
+
+      private:
+        void truncate();
+
+        std::filesystem::path _path;
+        std::fstream stream;
+
+        uint64_t fileSize = 0;
+        uint64_t usedBytes = 0;
+        size_t usedEntries = 0;
+    };
+} // namespace MapHistory
@@ -62,6 +62,7 @@ Item &Item::operator=(Item &&other) noexcept
 
 Item::~Item()
 {
+    Items::items.itemDestroyed(this);
     Items::items.guidRefDestroyed(_guid);
 }
 
@@ -91,7 +92,7 @@ Item Item::deepCopy() const
     return item;
 }
 
-uint32_t Item::getSpriteId(const Position &pos) const
+uint32_t Item::getSpriteIndex(const Position &pos) const
 {
     uint32_t offset = getPatternIndex(pos);
     const SpriteInfo &spriteInfo = itemType->getSpriteInfo(0);
@@ -100,12 +101,27 @@ uint32_t Item::getSpriteId(const Position &pos) const
         offset += _animation->state.phaseIndex * spriteInfo.patternSize;
     }
 
-    return spriteInfo.spriteIds.at(offset);
+    return offset;
+}
+
+uint32_t Item::getSpriteId(const Position &pos) const
+{
+    return itemType->getSpriteInfo(0).spriteIds.at(getSpriteIndex(pos));
+}
+
+const SpriteDrawInfo &Item::getSpriteDrawInfo(const Position &pos) const
+{
+    return itemType->getSpriteDrawInfo(getSpriteIndex(pos));
 }
 
 const TextureInfo Item::getTextureInfo(const Position &pos, TextureInfo::CoordinateType coordinateType) const
 {
     // TODO Add more pattern checks like hanging item types
+    if (coordinateType == TextureInfo::CoordinateType::Normalized)
+    {
+        return getSpriteDrawInfo(pos).textureInfo();
+    }
+
     uint32_t spriteId = getSpriteId(pos);
 
     return itemType->getTextureInfo(spriteId, coordinateType);
@@ -173,6 +189,29 @@ void Item::setAttribute(ItemAttribute &&attribute)
     _attributes->emplace(attribute.type(), std::move(attribute));
 }
 
+std::optional<ItemAttribute> Item::swapAttribute(ItemAttribute_t type, std::optional<ItemAttribute> &&attribute)
+{
+    std::optional<ItemAttribute> previous;
+
+    if (_attributes)
+    {
+        auto found = _attributes->find(type);
+        if (found != _attributes->end())
+        {
+            previous.emplace(std::move(found->second));
+            _attributes->erase(found);
+        }
+    }
+
+    if (attribute)
+    {
+        DEBUG_ASSERT(attribute->type() == type, "The attribute must be of type 'type'.");
+        setAttribute(std::move(*attribute));
+    }
+
+    return previous;
+}
+
 uint16_t Item::actionId() const
 {
     if (!_attributes)
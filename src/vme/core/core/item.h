@@ -51,6 +51,7 @@ class Item
     inline bool hasAttributes() const noexcept;
     // [[nodiscard]] inline const TileStackOrder TileStackOrder() const noexcept;
     uint32_t getSpriteId(const Position &pos) const;
+    const SpriteDrawInfo &getSpriteDrawInfo(const Position &pos) const;
     const TextureInfo getTextureInfo(
         const Position &pos,
         TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
@@ -71,6 +72,11 @@ class Item
     void setDescription(const std::string &description);
     void setDescription(std::string &&description);
     void setAttribute(ItemAttribute &&attribute);
+    /*
+        Replaces the attribute of type 'type' with 'attribute', or removes it if 'attribute' is empty.
+        Returns the previous attribute.
+    */
+    std::optional<ItemAttribute> swapAttribute(ItemAttribute_t type, std::optional<ItemAttribute> &&attribute);
     inline void setSubtype(uint8_t subtype) noexcept;
     void setCount(uint8_t count);
     inline void setCharges(uint8_t charges) noexcept;
@@ -112,6 +118,7 @@ class Item
     ItemAttribute &getOrCreateAttribute(const ItemAttribute_t attributeType);
 
     const uint32_t getPatternIndex(const Position &pos) const;
+    uint32_t getSpriteIndex(const Position &pos) const;
 
     mutable std::shared_ptr<ItemAnimation> _animation = nullptr;
 
@@ -96,10 +96,24 @@ const uint32_t ItemType::getPatternIndexForSubtype(uint8_t subtype) const
     }
 }
 
+uint32_t ItemType::getSpriteIndex(const Position &pos) const
+{
+    return usesSubType() ? 0 : getPatternIndex(pos);
+}
+
 uint32_t ItemType::getSpriteId(const Position &pos) const
 {
-    uint32_t spriteIndex = usesSubType() ? 0 : getPatternIndex(pos);
-    return appearance->getSpriteInfo().spriteIds.at(spriteIndex);
+    return appearance->getSpriteInfo().spriteIds.at(getSpriteIndex(pos));
+}
+
+const SpriteDrawInfo &ItemType::getSpriteDrawInfo(const Position &pos) const
+{
+    return getSpriteDrawInfo(getSpriteIndex(pos));
+}
+
+const SpriteDrawInfo &ItemType::getSpriteDrawInfo(uint32_t spriteIndex) const
+{
+    return appearance->spriteDrawInfo(0, spriteIndex);
 }
 
 const TextureInfo ItemType::getTextureInfo(TextureInfo::CoordinateType coordinateType) const
@@ -177,6 +191,7 @@ std::vector<TextureAtlas *> ItemType::getTextureAtlases() const
 void ItemType::cacheTextureAtlases()
 {
     appearance->cacheTextureAtlases();
+    appearance->cacheSpriteDrawInfo();
 }
 
 const std::vector<FrameGroup> &ItemType::frameGroups() const noexcept
@@ -186,19 +201,6 @@ const std::vector<FrameGroup> &ItemType::frameGroups() const noexcept
 
 TextureAtlas *ItemType::getTextureAtlas(uint32_t spriteId) const
 {
-    for (const auto atlas : appearance->atlases())
-    {
-        if (atlas == nullptr)
-        {
-            return nullptr;
-        }
-
-        if (atlas->firstSpriteId <= spriteId && spriteId <= atlas->lastSpriteId)
-        {
-            return atlas;
-        }
-    }
-
     return Appearances::getTextureAtlas(spriteId);
 }
 
@@ -389,7 +389,10 @@ class ItemType
     const uint32_t getPatternIndex(const Position &pos) const;
     const uint32_t getPatternIndexForSubtype(uint8_t subtype) const;
 
+    uint32_t getSpriteIndex(const Position &pos) const;
     uint32_t getSpriteId(const Position &pos) const;
+    const SpriteDrawInfo &getSpriteDrawInfo(const Position &pos) const;
+    const SpriteDrawInfo &getSpriteDrawInfo(uint32_t spriteIndex) const;
 
     const TextureInfo getTextureInfo(TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
     const TextureInfo getTextureInfo(uint32_t spriteId, TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
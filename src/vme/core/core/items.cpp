@@ -6,6 +6,7 @@
 #include <memory>
 #include <utility>
 
+#include "debug.h"
 #include "file.h"
 #include "logger.h"
 #include "otb.h"
@@ -59,6 +60,11 @@ namespace
         {"eastex", FloorChange::EastEx},
         {"southalt", FloorChange::SouthAlt},
         {"eastalt", FloorChange::EastAlt}};
+
+    uint64_t propertyChangeKey(uint32_t guid, ItemChangeType changeType) noexcept
+    {
+        return (static_cast<uint64_t>(guid) << 32) | static_cast<uint32_t>(changeType);
+    }
 } // namespace
 
 Items::Items()
@@ -190,18 +196,99 @@ void Items::loadFromXml(const std::filesystem::path path)
 void Items::itemAddressChanged(Item *item)
 {
     auto found = itemSignals.find(item->guid());
-    if (found != itemSignals.end())
+    if (found == itemSignals.end())
     {
-        found->second.address.fire(item);
+        return;
     }
+
+    if (notificationBatchDepth > 0)
+    {
+        auto [pending, inserted] = pendingAddressChanges.insert_or_assign(item->guid(), item);
+        if (!inserted)
+        {
+            ++_coalescedNotifications;
+        }
+        return;
+    }
+
+    found->second.address.fire(item);
 }
 
 void Items::itemPropertyChanged(Item *item, const ItemChangeType changeType)
 {
     auto found = itemSignals.find(item->guid());
-    if (found != itemSignals.end())
+    if (found == itemSignals.end())
+    {
+        return;
+    }
+
+    if (notificationBatchDepth > 0)
+    {
+        if (pendingPropertyChangeKeys.insert(propertyChangeKey(item->guid(), changeType)).second)
+        {
+            pendingPropertyChanges.emplace_back(item->guid(), changeType);
+        }
+        else
+        {
+            ++_coalescedNotifications;
+        }
+        return;
+    }
+
+    found->second.property.fire(changeType);
+}
+
+void Items::beginNotificationBatch()
+{
+    ++notificationBatchDepth;
+}
+
+void Items::endNotificationBatch()
+{
+    DEBUG_ASSERT(notificationBatchDepth > 0, "There is no notification batch to end.");
+    if (--notificationBatchDepth > 0)
+    {
+        return;
+    }
+
+    // A signal handler can change items (and so add new pending signals), so take the pending signals first.
+    auto addressChanges = std::move(pendingAddressChanges);
+    auto propertyChanges = std::move(pendingPropertyChanges);
+    pendingAddressChanges.clear();
+    pendingPropertyChanges.clear();
+    pendingPropertyChangeKeys.clear();
+
+    for (const auto &[guid, item] : addressChanges)
+    {
+        // The observer may have stopped tracking the item during the batch.
+        auto found = itemSignals.find(guid);
+        if (found != itemSignals.end())
+        {
+            found->second.address.fire(item);
+        }
+    }
+
+    for (const auto &[guid, changeType] : propertyChanges)
+    {
+        auto found = itemSignals.find(guid);
+        if (found != itemSignals.end())
+        {
+            found->second.property.fire(changeType);
+        }
+    }
+}
+
+void Items::itemDestroyed(Item *item)
+{
+    if (pendingAddressChanges.empty())
+    {
+        return;
+    }
+
+    auto found = pendingAddressChanges.find(item->guid());
+    if (found != pendingAddressChanges.end() && found->second == item)
     {
-        found->second.property.fire(changeType);
+        pendingAddressChanges.erase(found);
     }
 }
 
@@ -8,6 +8,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "const.h"
@@ -68,6 +69,24 @@ class Items
     void itemPropertyChanged(Item *item, const ItemChangeType changeType);
     void containerChanged(Item *containerItem, const ContainerChange &containerChange);
 
+    /*
+        Between beginNotificationBatch and endNotificationBatch (see History::beginTransaction), the address and
+        property signals of tracked items are not fired right away. They are deduplicated per item and fired
+        once when the outermost batch ends: the latest address of every moved item, then every distinct property
+        change. Batches can be nested.
+    */
+    void beginNotificationBatch();
+    void endNotificationBatch();
+
+    // Must be called when an item is destroyed, so that a pending address signal never refers to it.
+    void itemDestroyed(Item *item);
+
+    // The number of item signals that were not fired because an equivalent signal was already pending.
+    size_t coalescedNotifications() const noexcept
+    {
+        return _coalescedNotifications;
+    }
+
     const std::vector<ItemType> &getItemTypes() const;
 
     /**
@@ -155,6 +174,15 @@ class Items
     std::queue<uint32_t> freedItemGuids;
 
     std::vector<uint16_t> guidRefCounts;
+
+    int notificationBatchDepth = 0;
+    // The latest address of every tracked item that moved during the batch. The key is an entity ID.
+    std::unordered_map<uint32_t, Item *> pendingAddressChanges;
+    // The distinct property changes of tracked items during the batch, in the order that they happened.
+    std::vector<std::pair<uint32_t, ItemChangeType>> pendingPropertyChanges;
+    // The entity ID and change type of every entry in pendingPropertyChanges, for constant-time deduplication.
+    std::unordered_set<uint64_t> pendingPropertyChangeKeys;
+    size_t _coalescedNotifications = 0;
 };
 
 template <auto AddressFunction, auto PropertyFunction, typename T>
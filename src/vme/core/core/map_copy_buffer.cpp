@@ -32,16 +32,18 @@ bool MapCopyBuffer::copySelection(const MapView &mapView)
     topLeft = *selection.getCorner(0, 0, 0);
     bottomRight = *selection.getCorner(1, 1, 1);
 
-    for (const auto &pos : selection.allPositions())
+    for (const auto &span : selection.spans())
     {
-        ++_tileCount;
+        span.forEach([this, &mapView](const Position pos) {
+            ++_tileCount;
 
-        auto mapTile = mapView.getTile(pos);
-        DEBUG_ASSERT(mapTile != nullptr, "No tile at " << pos);
+            auto mapTile = mapView.getTile(pos);
+            DEBUG_ASSERT(mapTile != nullptr, "No tile at " << pos);
 
-        Tile copiedTile = mapTile->deepCopy(true);
-        _itemCount += copiedTile.itemCount();
-        bufferMap.insertTile(std::move(copiedTile));
+            Tile copiedTile = mapTile->deepCopy(true);
+            _itemCount += copiedTile.itemCount();
+            bufferMap.insertTile(std::move(copiedTile));
+        });
     }
 
     auto tileInflection = _tileCount == 1 ? "tile" : "tiles";
@@ -11,6 +11,7 @@
 #include "debug.h"
 #include "file.h"
 #include "graphics/appearances.h"
+#include "graphics/hot_atlas_repacker.h"
 #include "logger.h"
 #include "map_view.h"
 #include "position.h"
@@ -91,11 +92,16 @@ MapRenderer::MapRenderer(std::shared_ptr<VulkanInfo> &vulkanInfo, std::shared_pt
 
     size_t ArbitraryGeneralReserveAmount = 8;
     vulkanTextures.reserve(ArbitraryGeneralReserveAmount);
+
+    auto &repacker = HotAtlasRepacker::global();
+    hotAtlasRendererId = repacker.addRenderer();
+    hotAtlasGeneration = repacker.generation();
 }
 
 MapRenderer::~MapRenderer()
 {
     releaseResources();
+    HotAtlasRepacker::global().removeRenderer(hotAtlasRendererId);
 }
 
 void MapRenderer::initResources()
@@ -223,6 +229,8 @@ void MapRenderer::render(VkFramebuffer frameBuffer, util::Size swapChainSize)
     glm::mat4 projection = vulkanInfo->projectionMatrix(mapView.get(), vulkanSwapChainImageSize);
     updateUniformBuffer(projection);
 
+    updateHotTextureAtlases();
+
     beginRenderPass();
 
     setupFrame();
@@ -246,6 +254,41 @@ void MapRenderer::render(VkFramebuffer frameBuffer, util::Size swapChainSize)
     currentDescriptorSet = nullptr;
 }
 
+void MapRenderer::updateHotTextureAtlases()
+{
+    auto &repacker = HotAtlasRepacker::global();
+
+    if (Settings::HOT_TEXTURE_ATLASES)
+    {
+        repacker.nextFrame(hotAtlasRendererId);
+        if (repacker.repackDue())
+        {
+            repacker.repack();
+        }
+    }
+    else if (!repacker.empty())
+    {
+        repacker.reset();
+    }
+
+    if (hotAtlasGeneration != repacker.generation())
+    {
+        // Hot atlases were replaced. Their GPU textures might still be used by frames in flight.
+        vulkanInfo->vkDeviceWaitIdle();
+
+        repacker.forEachRetiredTextureId(hotAtlasGeneration, [this](uint32_t id) {
+            if (id < vulkanTexturesForAppearances.size() && vulkanTexturesForAppearances[id].hasResources())
+            {
+                vulkanTexturesForAppearances[id].releaseResources();
+                activeTextureAtlasIds.erase(std::remove(activeTextureAtlasIds.begin(), activeTextureAtlasIds.end(), id), activeTextureAtlasIds.end());
+            }
+        });
+
+        hotAtlasGeneration = repacker.generation();
+        repacker.releasedGeneration(hotAtlasRendererId, hotAtlasGeneration);
+    }
+}
+
 void MapRenderer::setupFrame()
 {
     auto cb = _currentFrame->commandBuffer;
@@ -483,7 +526,7 @@ void MapRenderer::drawPreview(ThingDrawInfo drawInfo, const Position &position)
                 info.color = colors::ItemPreview;
                 info.itemType = draw.itemType;
                 info.worldPos = drawPos.worldPos();
-                info.spriteId = draw.itemType->getSpriteId(drawPos);
+                info.sprite = &draw.itemType->getSpriteDrawInfo(drawPos);
 
                 if (!draw.itemType->isGround())
                 {
@@ -568,7 +611,7 @@ void MapRenderer::drawPreviewItem(uint32_t serverId, Position pos)
     info.color = colors::ItemPreview;
     info.itemType = itemType;
     info.worldPos = pos.worldPos();
-    info.spriteId = itemType->getSpriteId(pos);
+    info.sprite = &itemType->getSpriteDrawInfo(pos);
 
     if (!itemType->isGround())
     {
@@ -740,7 +783,11 @@ void MapRenderer::drawTile(Tile *tile, uint32_t flags, const Position offset, co
 
 void MapRenderer::issueDraw(const DrawInfo::Base &info, const WorldPosition &worldPos)
 {
-    const auto atlas = info.textureInfo.atlas;
+    issueDraw(info, worldPos, info.textureInfo.atlas->getFragmentBounds(info.textureInfo.window));
+}
+
+void MapRenderer::issueDraw(const DrawInfo::Base &info, const WorldPosition &worldPos, const glm::vec4 &fragmentBounds)
+{
     const auto &window = info.textureInfo.window;
     PushConstantData pushConstant{};
 
@@ -756,7 +803,7 @@ void MapRenderer::issueDraw(const DrawInfo::Base &info, const WorldPosition &wor
     pushConstant.size = size;
     pushConstant.color = info.color;
     pushConstant.textureQuad = glm::vec4(window.x0, window.y0, window.x1, window.y1);
-    pushConstant.fragQuad = atlas->getFragmentBounds(window);
+    pushConstant.fragQuad = fragmentBounds;
 
     vulkanInfo->vkCmdBindDescriptorSets(
         _currentFrame->commandBuffer,
@@ -893,7 +940,7 @@ void MapRenderer::drawBrushPreviewAtWorldPos(Brush *brush, const WorldPosition &
                     ItemTypeDrawInfo info{};
                     info.color = colors::ItemPreview;
                     info.itemType = draw.itemType;
-                    info.spriteId = draw.itemType->appearance->getFirstSpriteId();
+                    info.sprite = &draw.itemType->getSpriteDrawInfo(0);
 
                     Position pos = draw.relativePosition;
                     // Position::worldPos() skews x and y depending on z. Since the preview is z-irrelevant, we need to add
@@ -1117,20 +1164,25 @@ void MapRenderer::drawItemType(const ItemTypeDrawInfo &drawInfo, QuadrantRenderT
             DrawInfo::Object info{};
 
             info.color = drawInfo.color;
-            info.textureInfo = itemType->getTextureInfo(drawInfo.spriteId);
+            if (Settings::HOT_TEXTURE_ATLASES)
+            {
+                HotAtlasRepacker::global().recordUsage(drawInfo.sprite->spriteId);
+            }
+
+            info.textureInfo = drawInfo.sprite->textureInfo();
             info.descriptorSet = objectDescriptorSet(info.textureInfo.atlas);
             info.width = info.textureInfo.atlas->spriteWidth;
             info.height = info.textureInfo.atlas->spriteHeight;
 
             auto worldPos = getWorldPosForDraw(drawInfo, info.textureInfo.atlas);
-            issueDraw(info, worldPos);
+            issueDraw(info, worldPos, drawInfo.sprite->fragmentBounds);
             break;
         }
         case QuadrantRenderType::TopLeft:
         {
             DrawInfo::ObjectQuadrant info{};
             info.color = drawInfo.color;
-            info.textureInfo = itemType->getTextureInfoTopLeftQuadrant(drawInfo.spriteId);
+            info.textureInfo = itemType->getTextureInfoTopLeftQuadrant(drawInfo.sprite->spriteId);
             info.width = info.textureInfo.atlas->spriteWidth / 2;
             info.height = info.textureInfo.atlas->spriteHeight / 2;
             info.descriptorSet = objectDescriptorSet(info.textureInfo.atlas);
@@ -1146,7 +1198,7 @@ void MapRenderer::drawItemType(const ItemTypeDrawInfo &drawInfo, QuadrantRenderT
             info.color = drawInfo.color;
 
             const auto [topLeftTextureInfo,
-                        bottomRightTextureInfo] = itemType->getTextureInfoTopLeftBottomRightQuadrant(drawInfo.spriteId);
+                        bottomRightTextureInfo] = itemType->getTextureInfoTopLeftBottomRightQuadrant(drawInfo.sprite->spriteId);
 
             auto atlas = topLeftTextureInfo.atlas;
 
@@ -1171,7 +1223,7 @@ void MapRenderer::drawItemType(const ItemTypeDrawInfo &drawInfo, QuadrantRenderT
 
             const auto [topRightTextureInfo,
                         bottomRightTextureInfo,
-                        bottomLeftTextureInfo] = itemType->getTextureInfoTopRightBottomRightBottomLeftQuadrant(drawInfo.spriteId);
+                        bottomLeftTextureInfo] = itemType->getTextureInfoTopRightBottomRightBottomLeftQuadrant(drawInfo.sprite->spriteId);
 
             auto atlas = topRightTextureInfo.atlas;
 
@@ -1211,7 +1263,7 @@ void MapRenderer::drawItem(const ItemDrawInfo &itemDrawInfo)
     info.color = getItemDrawColor(*itemDrawInfo.item, itemDrawInfo.position, itemDrawInfo.drawFlags);
     info.itemType = itemDrawInfo.item->itemType;
     info.worldPos = itemDrawInfo.position.worldPos();
-    info.spriteId = itemDrawInfo.item->getSpriteId(itemDrawInfo.position);
+    info.sprite = &itemDrawInfo.item->getSpriteDrawInfo(itemDrawInfo.position);
     info.worldPosOffset = itemDrawInfo.worldPosOffset;
 
     drawItemType(info);
@@ -1274,9 +1326,10 @@ VkDescriptorSet MapRenderer::objectDescriptorSet(const Texture &texture)
     descriptor.pool = descriptorPool;
     uint32_t id = texture.id();
 
-    if (vulkanTexturesForAppearances.size() < id)
+    if (vulkanTexturesForAppearances.size() <= id)
     {
-        vulkanTexturesForAppearances.resize(vulkanTexturesForAppearances.size() * 1.25);
+        // Runtime atlases (see HotAtlasRepacker) can have texture IDs far beyond the number of client atlases.
+        vulkanTexturesForAppearances.resize(std::max<size_t>(vulkanTexturesForAppearances.size() * 1.25, id + 1));
     }
 
     VulkanTexture &vulkanTexture = vulkanTexturesForAppearances.at(id);
@@ -14,6 +14,7 @@
 #include "brushes/brush.h"
 #include "editor_action.h"
 #include "graphics/buffer.h"
+#include "graphics/hot_atlas_repacker.h"
 #include "graphics/texture.h"
 #include "graphics/texture_atlas.h"
 #include "graphics/vulkan_helpers.h"
@@ -153,7 +154,7 @@ struct ItemDrawInfo
 
 struct ItemTypeDrawInfo
 {
-    uint32_t spriteId;
+    const SpriteDrawInfo *sprite = nullptr;
     glm::vec4 color = colors::Default;
     const ItemType *itemType = nullptr;
     WorldPosition worldPos;
@@ -346,6 +347,7 @@ class MapRenderer
 
     void beginRenderPass();
     void setupFrame();
+    void updateHotTextureAtlases();
 
     VkCommandBuffer beginSingleTimeCommands(VulkanInfo *info);
     uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -403,6 +405,7 @@ class MapRenderer
     void drawPreview(ThingDrawInfo drawInfo, const Position &position);
 
     void issueDraw(const DrawInfo::Base &info, const WorldPosition &worldPos);
+    void issueDraw(const DrawInfo::Base &info, const WorldPosition &worldPos, const glm::vec4 &fragmentBounds);
     void issueRectangleDraw(DrawInfo::Rectangle &info);
 
     MouseAction_t mouseAction() const;
@@ -469,4 +472,8 @@ class MapRenderer
     VkDescriptorSet currentDescriptorSet;
 
     bool isDefaultZoom = true;
+
+    HotAtlasRepacker::RendererId hotAtlasRendererId;
+    // The HotAtlasRepacker generation that the Vulkan textures of this renderer are in sync with
+    uint32_t hotAtlasGeneration = 0;
 };
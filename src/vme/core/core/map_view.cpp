@@ -2,7 +2,9 @@
 
 #include "brushes/border_brush.h"
 #include "brushes/brush.h"
+#include "brushes/brushes.h"
 #include "brushes/creature_brush.h"
+#include "brushes/doodad_brush.h"
 #include "brushes/ground_brush.h"
 #include "brushes/mountain_brush.h"
 #include "brushes/raw_brush.h"
@@ -37,6 +39,38 @@ inline std::ostream &operator<<(std::ostream &os, const TileQuadrant &quadrant)
     return os;
 }
 
+namespace
+{
+    /*
+        Adds a delta to 'action' for every item on 'tile' (including the ground) that matches 'predicate'.
+        Returns the number of items that will be removed.
+    */
+    size_t addRemovalDeltas(Action &action, const Tile &tile, const std::function<bool(const Item &)> &predicate)
+    {
+        size_t removed = 0;
+        const Position position = tile.position();
+
+        // Descending, so that the indices of the remaining removals are not affected.
+        const auto &items = tile.items();
+        for (size_t i = items.size(); i-- > 0;)
+        {
+            if (predicate(*items[i]))
+            {
+                action.addChange(TileDelta::removeItem(position, static_cast<uint16_t>(i)));
+                ++removed;
+            }
+        }
+
+        if (tile.hasGround() && predicate(*tile.ground()))
+        {
+            action.addChange(TileDelta::removeGround(position));
+            ++removed;
+        }
+
+        return removed;
+    }
+} // namespace
+
 std::unordered_set<MapView *> MapView::instances;
 
 MapView::MapView(std::unique_ptr<UIUtils> uiUtils, EditorAction &action)
@@ -172,14 +206,14 @@ void MapView::clearSelection()
     {
         history.commit(
             ActionType::Selection,
-            SelectMultiple(*this, _selection.allPositions(), false));
+            SelectMultiple(*this, _selection.spans(), false));
     }
 }
 
 void MapView::modifyTile(const Position pos, std::function<void(Tile &)> f)
 {
     Tile &currentTile = _map->getOrCreateTile(pos);
-    Tile newTile = currentTile.deepCopy();
+    Tile newTile = currentTile.copyForHistory();
     f(newTile);
 
     history.commit(ActionType::SetTile, SetTile(std::move(newTile)));
@@ -204,34 +238,40 @@ void MapView::endTransaction(TransactionType transactionType)
 
 void MapView::addItem(Tile &tile, Item &&item, int insertionOffset)
 {
-    Tile newTile = tile.deepCopy();
-    newTile.addItem(std::move(item), insertionOffset);
-
     Action action(ActionType::SetTile);
-    action.addChange(SetTile(std::move(newTile)));
+    action.addChange(TileDelta::addItem(tile.position(), std::move(item), insertionOffset));
 
     history.commit(std::move(action));
 }
 
 void MapView::setGround(Tile &tile, Item &&ground, bool clearBorders)
 {
-    Tile newTile = tile.deepCopy();
+    Action action(ActionType::SetTile);
 
     if (clearBorders)
     {
-        newTile.clearBorders();
+        // Same as Tile::clearBorders: the borders at the bottom of the stack are removed.
+        const auto &items = tile.items();
+        size_t borderCount = 0;
+        while (borderCount < items.size() && items[borderCount]->itemType->isBorder())
+        {
+            ++borderCount;
+        }
+
+        for (size_t i = borderCount; i-- > 0;)
+        {
+            action.addChange(TileDelta::removeItem(tile.position(), static_cast<uint16_t>(i)));
+        }
     }
-    newTile.addItem(std::move(ground));
 
-    Action action(ActionType::SetTile);
-    action.addChange(SetTile(std::move(newTile)));
+    action.addChange(TileDelta::addItem(tile.position(), std::move(ground)));
 
     history.commit(std::move(action));
 }
 
 void MapView::replaceItemByServerId(Tile &tile, uint32_t oldServerId, uint32_t newServerId)
 {
-    Tile newTile = tile.deepCopy();
+    Tile newTile = tile.copyForHistory();
 
     newTile.replaceItemByServerId(oldServerId, newServerId);
 
@@ -249,7 +289,7 @@ void MapView::addBorder(const Position &pos, uint32_t id, uint32_t zOrder)
     auto &tile = _map->getOrCreateTile(pos);
     Item item = Item(id);
 
-    Tile newTile = tile.deepCopy();
+    Tile newTile = tile.copyForHistory();
     newTile.addBorder(std::move(item), zOrder);
 
     Action action(ActionType::SetTile);
@@ -260,13 +300,17 @@ void MapView::addBorder(const Position &pos, uint32_t id, uint32_t zOrder)
 
 void MapView::addItem(const Position &pos, Item &&item, bool onBlocking)
 {
-    auto &tile = _map->getOrCreateTile(pos);
-    if (!onBlocking && tile.hasBlockingItem())
+    Tile *tile = _map->getTile(pos);
+    if (!onBlocking && tile && tile->hasBlockingItem())
     {
         return;
     }
 
-    addItem(_map->getOrCreateTile(pos), std::move(item));
+    // The delta creates the tile if needed, so that undoing it removes the tile again.
+    Action action(ActionType::SetTile);
+    action.addChange(TileDelta::addItem(pos, std::move(item)));
+
+    history.commit(std::move(action));
 }
 
 void MapView::addItem(const Position &pos, uint32_t id)
@@ -285,15 +329,12 @@ void MapView::removeItems(const Position position, const std::set<size_t, std::g
 
     Action action(ActionType::RemoveTile);
 
-    Tile newTile = deepCopyTile(position);
-
+    // The indices are in descending order, so each removal leaves the remaining indices valid.
     for (const auto index : indices)
     {
-        newTile.removeItem(index);
+        action.addChange(TileDelta::removeItem(position, static_cast<uint16_t>(index)));
     }
 
-    action.addChange(SetTile(std::move(newTile)));
-
     history.commit(std::move(action));
 }
 
@@ -301,7 +342,7 @@ void MapView::removeSelectedThings(const Tile &tile)
 {
     Action action(ActionType::ModifyTile);
 
-    Tile newTile = tile.deepCopy();
+    Tile newTile = tile.copyForHistory();
     newTile.removeSelectedThings();
 
     action.addChange(SetTile(std::move(newTile)));
@@ -333,7 +374,7 @@ void MapView::setBottomItem(const Position &position, Item &&item)
 
 void MapView::setBottomItem(const Tile &tile, Item &&item)
 {
-    Tile newTile = tile.deepCopy();
+    Tile newTile = tile.copyForHistory();
 
     newTile.clearBottomItems();
     newTile.addItem(std::move(item));
@@ -355,27 +396,18 @@ void MapView::removeItems(const Position &position, std::function<bool(const Ite
 
 void MapView::removeItems(const Tile &tile, std::function<bool(const Item &)> predicate)
 {
-    Tile newTile = tile.deepCopy();
-    if (newTile.removeItemsIf(predicate) > 0)
+    Action action(ActionType::ModifyTile);
+    if (addRemovalDeltas(action, tile, predicate) > 0)
     {
-        Action action(ActionType::ModifyTile);
-        action.addChange(SetTile(std::move(newTile)));
-
         history.commit(std::move(action));
     }
 }
 
 void MapView::removeItemsWithBorderize(const Tile &tile, std::function<bool(const Item &)> predicate)
 {
-
-    Tile newTile = tile.deepCopy();
-    bool newTileHasGround = newTile.hasGround();
-    if (newTile.removeItemsIf(predicate) > 0)
+    Action action(ActionType::ModifyTile);
+    if (addRemovalDeltas(action, tile, predicate) > 0)
     {
-        newTileHasGround = newTile.hasGround();
-        Action action(ActionType::ModifyTile);
-        action.addChange(SetTile(std::move(newTile)));
-
         history.commit(std::move(action));
     }
 
@@ -503,7 +535,7 @@ void MapView::moveSelection(const Position &offset)
     {
         Action action(ActionType::Selection);
 
-        auto moveSelection = std::make_unique<MoveSelection>(_selection.allPositions(), offset);
+        auto moveSelection = std::make_unique<MoveSelection>(_selection.spans(), offset);
         action.addChange(std::move(moveSelection));
 
         history.commit(std::move(action));
@@ -520,12 +552,17 @@ void MapView::deleteSelectedThings()
 
     history.beginTransaction(TransactionType::RemoveMapItem);
 
-    if (Settings::AUTO_BORDER)
-    {
-        std::unordered_set<Position> modifiedPositions;
+    // The changes below modify the selection, so we can not iterate it while committing them.
+    std::vector<SelectionSpan> spans = _selection.spans();
 
-        for (const auto &pos : _selection)
-        {
+    // Clear the selection up front. Otherwise every committed change would remove its position
+    // from the selection one at a time (recomputing the selection bounds along the way).
+    // TODO: Save the selected item state
+    _selection.clear();
+
+    for (const auto &span : spans)
+    {
+        span.forEach([this](const Position pos) {
             const Tile &tile = *getTile(pos);
             if (tile.allSelected())
             {
@@ -535,34 +572,17 @@ void MapView::deleteSelectedThings()
             {
                 removeSelectedThings(tile);
             }
-
-            modifiedPositions.emplace(pos);
-        }
-
-        for (const auto &pos : modifiedPositions)
-        {
-            borderize(pos);
-        }
+        });
     }
-    else
+
+    if (Settings::AUTO_BORDER)
     {
-        for (const auto &pos : _selection)
+        for (const auto &span : spans)
         {
-            const Tile &tile = *getTile(pos);
-            if (tile.allSelected())
-            {
-                removeTile(tile.position());
-            }
-            else
-            {
-                removeSelectedThings(tile);
-            }
+            span.forEach([this](const Position pos) { borderize(pos); });
         }
     }
 
-    // TODO: Save the selected item state
-    _selection.clear();
-
     history.endTransaction(TransactionType::RemoveMapItem);
     requestDraw();
     requestMinimapDraw();
@@ -576,25 +596,17 @@ void MapView::borderize(const Position &position)
 
 void MapView::selectRegion(const Position &from, const Position &to)
 {
-    std::vector<Position> positions;
-
-    for (auto &location : _map->getRegion(from, to))
-    {
-        Tile *tile = location.tile();
-        if (tile && !tile->isEmpty())
-        {
-            positions.emplace_back(location.position());
-        }
-    }
+    // The selection storage is changed by box rather than by position (see SelectMultiple).
+    SelectMultiple change(*this, from, to);
 
-    // Only commit a change if anything was dragged over
-    if (!positions.empty())
+    // Only commit a change if anything was selected
+    if (!change.empty())
     {
         history.beginTransaction(TransactionType::Selection);
 
         Action action(ActionType::Selection);
 
-        action.addChange(SelectMultiple(*this, std::move(positions)));
+        action.addChange(std::move(change));
 
         history.commit(std::move(action));
         history.endTransaction(TransactionType::Selection);
@@ -622,12 +634,7 @@ void MapView::fillRegion(const Position &from, const Position &to, uint32_t serv
 
     for (const auto &pos : MapArea(*_map, from, to))
     {
-        auto location = _map->getTileLocation(pos);
-
-        Tile newTile = location && location->hasTile() ? location->tile()->deepCopy() : Tile(pos);
-        newTile.addItem(Item(serverId));
-
-        action.changes.emplace_back<SetTile>(std::move(newTile));
+        action.changes.emplace_back(TileDelta::addItem(pos, Item(serverId)));
     }
 
     history.commit(std::move(action));
@@ -638,23 +645,12 @@ void MapView::fillRegionByGroundBrush(const Position &from, const Position &to,
 {
     history.beginTransaction(TransactionType::AddMapItem);
 
-    bool hasPlacementRestriction = GroundBrush::hasReplacementFilter();
-
-    MapView &mapView = *this;
-
     if (Settings::AUTO_BORDER)
     {
-        for (const auto &pos : MapArea(*_map, from, to))
+        MapArea area(*_map, from, to);
+        if (!area.empty)
         {
-            auto location = _map->getTileLocation(pos);
-            if (!location || !location->hasTile() || GroundBrush::mayPlaceOnTile(*location->tile()))
-            {
-                brush->apply(mapView, pos);
-            }
-            else
-            {
-                GroundBrush::borderize(mapView, pos);
-            }
+            brush->applyInRegion(*this, area.from, area.to);
         }
     }
     else
@@ -662,20 +658,13 @@ void MapView::fillRegionByGroundBrush(const Position &from, const Position &to,
         Action action(ActionType::SetTile);
         action.reserve(Position::tilesInRegion(from, to));
 
+        CounterRandom random(Random::global().nextUint64());
         for (const auto &pos : MapArea(*_map, from, to))
         {
             auto location = _map->getTileLocation(pos);
-            if (!location || !location->hasTile())
-            {
-                auto tile = Tile(pos);
-                tile.addItem(Item(brush->nextServerId()));
-                action.changes.emplace_back<SetTile>(std::move(tile));
-            }
-            else if (GroundBrush::mayPlaceOnTile(*location->tile()))
+            if (!location || !location->hasTile() || GroundBrush::mayPlaceOnTile(*location->tile()))
             {
-                auto tile = getTile(pos)->deepCopy();
-                tile.addItem(Item(brush->nextServerId()));
-                action.changes.emplace_back<SetTile>(std::move(tile));
+                action.changes.emplace_back(TileDelta::addItem(pos, Item(brush->serverIdAt(random, pos))));
             }
         }
 
@@ -685,17 +674,39 @@ void MapView::fillRegionByGroundBrush(const Position &from, const Position &to,
     history.endTransaction(TransactionType::AddMapItem);
 }
 
-void MapView::fillRegionByMountainBrush(const Position &from, const Position &to, MountainBrush *brush)
+void MapView::fillRegionByDoodadBrush(const Position &from, const Position &to, DoodadBrush *brush)
 {
     history.beginTransaction(TransactionType::AddMapItem);
+    brush->applyInRegion(*this, from, to);
+    history.endTransaction(TransactionType::AddMapItem);
+}
 
-    MapView &mapView = *this;
+void MapView::fillRegionByMountainBrush(const Position &from, const Position &to, MountainBrush *brush)
+{
+    history.beginTransaction(TransactionType::AddMapItem);
 
     if (Settings::AUTO_BORDER)
     {
-        for (const auto &pos : MapArea(*_map, from, to))
+        MapArea area(*_map, from, to);
+        if (!area.empty)
         {
-            brush->apply(mapView, pos);
+            Action action(ActionType::SetTile);
+            action.reserve(Position::tilesInRegion(from, to));
+
+            for (const auto &pos : area)
+            {
+                action.changes.emplace_back(TileDelta::addItem(pos, Item(brush->nextGroundServerId())));
+            }
+
+            history.commit(std::move(action));
+
+            GroundBrush::borderizeRegion(*this, area.from, area.to);
+
+            auto footprint = BrushFootprint::rectangle(area.from.x, area.from.y, area.to.x, area.to.y);
+            for (int z = area.from.z; z <= area.to.z; ++z)
+            {
+                MountainBrush::borderizeRegion(*this, footprint, z);
+            }
         }
     }
     else
@@ -725,14 +736,7 @@ void MapView::fillRegion(const Position &from, const Position &to, std::function
 
     for (const auto &pos : MapArea(*_map, from, to))
     {
-        auto location = _map->getTileLocation(pos);
-
-        Tile newTile = location && location->hasTile() ? location->tile()->deepCopy() : Tile(pos);
-
-        uint32_t serverId = itemSupplier();
-        newTile.addItem(Item(serverId));
-
-        action.changes.emplace_back<SetTile>(std::move(newTile));
+        action.changes.emplace_back(TileDelta::addItem(pos, Item(itemSupplier())));
     }
 
     history.commit(std::move(action));
@@ -1094,6 +1098,12 @@ void MapView::endDragging(VME::ModifierKeys modifiers)
                                 fillRegionByMountainBrush(from, to, mountainBrush);
                                 break;
                             }
+                            case BrushType::Doodad:
+                            {
+                                auto doodadBrush = static_cast<DoodadBrush *>(brush.brush);
+                                fillRegionByDoodadBrush(from, to, doodadBrush);
+                                break;
+                            }
                             default:
                                 // TODO Handle other cases
                                 VME_LOG("Drag with this brush is not implemented.");
@@ -1261,11 +1271,36 @@ void MapView::applyBrushAction(const MouseAction::MapBrush &brushAction, Positio
             {
                 return;
             }
-            for (const auto position : Position::bresenHamsWithCorners(this->_previousMouseGamePos, applyPos))
+            // The walls between two mouse samples are connected as one stroke
+            auto positions = Position::bresenHamsWithCorners(this->_previousMouseGamePos, applyPos);
+            std::erase_if(positions, [this](const Position &position) { return !_map->contains(position); });
+
+            static_cast<WallBrush *>(brush)->applyStroke(*this, positions);
+            break;
+        }
+        case BrushType::Ground:
+        {
+            if (!isNewTile)
+            {
+                return;
+            }
+
+            if (Settings::SHAPED_GROUND_BRUSHES)
             {
-                if (_map->contains(position))
+                // The shape at every position between the two mouse samples, applied as one area
+                auto path = Position::bresenHams(this->_previousMouseGamePos, applyPos);
+                auto area = Brushes::brushShape().footprint().sweep(path).clipped(0, 0, _map->width() - 1, _map->height() - 1);
+
+                brush->applyArea(*this, area, applyPos.z);
+            }
+            else
+            {
+                for (const auto position : Position::bresenHams(this->_previousMouseGamePos, applyPos))
                 {
-                    brush->apply(*this, position);
+                    if (_map->contains(position))
+                    {
+                        brush->apply(*this, position);
+                    }
                 }
             }
             break;
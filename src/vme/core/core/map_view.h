@@ -20,11 +20,13 @@
 #include "tile.h"
 #include "util.h"
 
+class DoodadBrush;
 class GroundBrush;
 class MountainBrush;
 
 namespace MapHistory
 {
+    class Action;
     class ChangeItem;
 }
 
@@ -328,6 +330,7 @@ class MapView
     void mapRenderFinished();
 
   private:
+    friend class MapHistory::Action;
     friend class MapHistory::ChangeItem;
 
     void borderize(const Position &position);
@@ -340,6 +343,7 @@ class MapView
     void fillRegion(const Position &from, const Position &to, std::function<uint32_t()> itemSupplier);
     void applyBrushAction(const MouseAction::MapBrush &brushAction, Position position, bool isNewQuadrant, bool isNewTile, bool erase);
     void fillRegionByGroundBrush(const Position &from, const Position &to, GroundBrush *brush);
+    void fillRegionByDoodadBrush(const Position &from, const Position &to, DoodadBrush *brush);
     void fillRegionByMountainBrush(const Position &from, const Position &to, MountainBrush *brush);
     void endCurrentAction(VME::ModifierKeys modifiers);
 
@@ -1,5 +1,8 @@
 #include "octree.h"
 
+#include <algorithm>
+#include <bit>
+
 #include "debug.h"
 
 namespace vme
@@ -325,6 +328,126 @@ namespace vme
             return changed;
         }
 
+        bool Tree::add(const std::vector<Position> &positions)
+        {
+            return setMany(positions, true);
+        }
+
+        bool Tree::remove(const std::vector<Position> &positions)
+        {
+            return setMany(positions, false);
+        }
+
+        bool Tree::setMany(const std::vector<Position> &positions, bool value)
+        {
+            long sizeBefore = _size;
+            std::vector<std::pair<CachedNode *, Leaf *>> touched;
+
+            for (const auto &pos : positions)
+            {
+                if (!value && getLeaf(pos) == nullptr)
+                    continue;
+
+                auto [cached, leaf] = getOrCreateLeaf(pos);
+                if (!leaf->setUnbounded(pos, value))
+                    continue;
+
+                _size += value ? 1 : -1;
+
+                if (touched.empty() || touched.back().second != leaf)
+                    touched.emplace_back(cached, leaf);
+            }
+
+            if (touched.empty())
+                return false;
+
+            std::sort(touched.begin(), touched.end());
+            touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+            for (auto [cached, leaf] : touched)
+            {
+                if (leaf->finishBulkUpdate().bboxChange)
+                    cached->updateBoundingBoxCached(*this);
+            }
+
+            updateSingle();
+
+            return _size != sizeBefore;
+        }
+
+        bool Tree::addRegion(const Position from, const Position to)
+        {
+            return updateRegion(from, to, &Leaf::addRegion, true);
+        }
+
+        bool Tree::removeRegion(const Position from, const Position to)
+        {
+            return updateRegion(from, to, &Leaf::removeRegion, false);
+        }
+
+        bool Tree::toggleRegion(const Position from, const Position to)
+        {
+            return updateRegion(from, to, &Leaf::toggleRegion, true);
+        }
+
+        bool Tree::updateRegion(const Position from, const Position to, Leaf::UpdateResult (Leaf::*update)(const Position, const Position), bool createLeaves)
+        {
+            int x0 = std::max(std::min(from.x, to.x), 0);
+            int y0 = std::max(std::min(from.y, to.y), 0);
+            int z0 = std::max<int>(std::min(from.z, to.z), 0);
+            int x1 = std::min<int>(std::max(from.x, to.x), width - 1);
+            int y1 = std::min<int>(std::max(from.y, to.y), height - 1);
+            int z1 = std::min<int>(std::max(from.z, to.z), floors - 1);
+
+            if (x0 > x1 || y0 > y1 || z0 > z1)
+                return false;
+
+            Position low(x0, y0, static_cast<Position::z_type>(z0));
+            Position high(x1, y1, static_cast<Position::z_type>(z1));
+
+            bool changed = false;
+
+            // Visit each leaf that overlaps the region once
+            for (int z = z0 - z0 % ChunkSize.depth; z <= z1; z += ChunkSize.depth)
+            {
+                for (int y = y0 - y0 % ChunkSize.height; y <= y1; y += ChunkSize.height)
+                {
+                    for (int x = x0 - x0 % ChunkSize.width; x <= x1; x += ChunkSize.width)
+                    {
+                        Position pos(std::max(x, x0), std::max(y, y0), static_cast<Position::z_type>(std::max(z, z0)));
+
+                        if (!createLeaves && getLeaf(pos) == nullptr)
+                            continue;
+
+                        auto [cached, leaf] = getOrCreateLeaf(pos);
+
+                        long leafSizeBefore = leaf->size();
+                        const auto [leafChanged, bboxChanged] = (leaf->*update)(low, high);
+                        if (!leafChanged)
+                            continue;
+
+                        changed = true;
+                        _size += static_cast<long>(leaf->size()) - leafSizeBefore;
+
+                        if (bboxChanged)
+                            cached->updateBoundingBoxCached(*this);
+                    }
+                }
+            }
+
+            if (changed)
+                updateSingle();
+
+            return changed;
+        }
+
+        void Tree::updateSingle()
+        {
+            _single.reset();
+            if (_size == 1)
+                _single = findOnlyPosition();
+        }
+
         Position Tree::findOnlyPosition() const
         {
             DEBUG_ASSERT(_size == 1, "Impossible to find >only< position if there is more than one position in the tree.");
@@ -434,17 +557,12 @@ namespace vme
             // VME_LOG_D("updateBoundingBoxCached before: " << boundingBox);
             _boundingBox = {};
 
-            int splits = 0;
-            if (cacheIndex < tree.cacheInfo.endXIndex)
-                ++splits;
-            if (cacheIndex < tree.cacheInfo.endYIndex)
-                ++splits;
-            if (cacheIndex < tree.cacheInfo.endZIndex)
-                ++splits;
+            // The end indices are offsets into the cache, so the amount of splits depends on where the children
+            // start (see Tree::initializeCache), not on the index of this node.
+            int amountOfChildren = _childCount;
 
-            DEBUG_ASSERT(splits != 0, "Update bounding box for leaf node? Bug?");
+            DEBUG_ASSERT(amountOfChildren > 1, "Update bounding box for leaf node? Bug?");
 
-            int amountOfChildren = util::power(2, splits);
             for (int i = 0; i < amountOfChildren; ++i)
             {
                 HeapNode *node = nullptr;
@@ -505,10 +623,10 @@ namespace vme
         bool Leaf::contains(const Position pos) const
         {
             uint16_t index = getIndex(pos);
-            if (index >= values.size())
+            if (index >= RowCount * ChunkSize.width)
                 return false;
 
-            return values[index];
+            return (rows[index >> 6] >> (index & 63)) & 1;
         }
 
         bool Leaf::encloses(const Position pos) const
@@ -524,108 +642,42 @@ namespace vme
             // return ((pos.x - position.x) * ChunkSize.height + (pos.y - position.y)) * ChunkSize.depth + (pos.z - position.z);
         }
 
-        bool Leaf::addToBoundingBox(const Position pos)
+        bool Leaf::setBounds(const Indices &newLow, const Indices &newHigh)
         {
-            int x = pos.x % ChunkSize.width;
-            int y = pos.y % ChunkSize.height;
-            int z = pos.z % ChunkSize.depth;
-
-            // Must be before changing the xs, ys, zs values.
-            auto a = std::holds_alternative<BoundingBox>(_boundingBox);
-            auto b = (x < low.x || x > high.x) ||
-                     (y < low.y || y > high.y) ||
-                     (z < low.z || z > high.z);
-            auto c = (xs[x] == 0 || ys[y] == 0 || zs[z] == 0);
-            bool bboxChange = !a || (b && c);
-
-            xs[x] += 1;
-            ys[y] += 1;
-            zs[z] += 1;
-
-#ifdef _DEBUG_VME
-            {
-                size_t total = 0;
-                for (int i = 0; i < ChunkSize.width; ++i)
-                    total += xs[i];
-                for (int i = 0; i < ChunkSize.height; ++i)
-                    total += ys[i];
-                for (int i = 0; i < ChunkSize.depth; ++i)
-                    total += zs[i];
-
-                DEBUG_ASSERT((total / 3) == _count, "Total indices count must be equal to _count.");
-            }
-#endif
-
-            // std::ostringstream s;
-            // int t = 0;
-            // s << "Count: " << _count << "( ";
-            // {
-            //   int total = 0;
-            //   for (int i = 0; i < ChunkSize.width; ++i)
-            //     total += xs[i];
-            //   s << "x: " << total << ", ";
-            //   t += total;
-            // }
-            // {
-            //   int total = 0;
-            //   for (int i = 0; i < ChunkSize.height; ++i)
-            //     total += ys[i];
-            //   s << "y: " << total << ", ";
-            //   t += total;
-            // }
-            // {
-            //   int total = 0;
-            //   for (int i = 0; i < ChunkSize.depth; ++i)
-            //     total += zs[i];
-            //   s << "z: " << total << ")";
-            //   t += total;
-            // }
-            // s << ", diff: " << (int)_count - t / 3;
-            // VME_LOG_D(s.str());
-
-            if (!bboxChange)
-            {
+            if (std::holds_alternative<BoundingBox>(_boundingBox) && newLow == low && newHigh == high)
                 return false;
-            }
 
-            if (_count == 1)
-            {
-                low = {x, y, z};
-                high = low;
-            }
-            else
-            {
-                low = {
-                    std::min(x, low.x),
-                    std::min(y, low.y),
-                    std::min(z, low.z),
-                };
-
-                high = {
-                    std::max(x, high.x),
-                    std::max(y, high.y),
-                    std::max(z, high.z),
-                };
-            }
+            low = newLow;
+            high = newHigh;
 
             Position from(position.x + low.x, position.y + low.y, position.z + low.z);
             Position to(position.x + high.x, position.y + high.y, position.z + high.z);
 
             _boundingBox = BoundingBox(from, to);
-
             return true;
-        } // namespace octree
+        }
 
-        bool Leaf::removeFromBoundingBox(const Position pos)
+        bool Leaf::addToBoundingBox(const Position pos)
         {
-            uint16_t x = pos.x % ChunkSize.width;
-            uint16_t y = pos.y % ChunkSize.height;
-            uint16_t z = pos.z % ChunkSize.depth;
+            int x = pos.x - position.x;
+            int y = pos.y - position.y;
+            int z = pos.z - position.z;
+
+            if (_count == 1)
+                return setBounds({x, y, z}, {x, y, z});
+
+            bool inside = (low.x <= x && x <= high.x) &&
+                          (low.y <= y && y <= high.y) &&
+                          (low.z <= z && z <= high.z);
+            if (inside)
+                return false;
 
-            xs[x] -= 1;
-            ys[y] -= 1;
-            zs[z] -= 1;
+            return setBounds({std::min(x, low.x), std::min(y, low.y), std::min(z, low.z)},
+                             {std::max(x, high.x), std::max(y, high.y), std::max(z, high.z)});
+        }
 
+        bool Leaf::removeFromBoundingBox(const Position pos)
+        {
             if (_count == 0)
             {
                 _boundingBox = {};
@@ -634,72 +686,80 @@ namespace vme
                 return true;
             }
 
-            bool bboxChange = ((x == low.x || x == high.x) ||
-                               (y == low.y || y == high.y) ||
-                               (z == low.z || z == high.z)) &&
-                              (xs[x] == 0 || ys[y] == 0 || zs[z] == 0);
-            if (!bboxChange)
+            int x = pos.x - position.x;
+            int y = pos.y - position.y;
+            int z = pos.z - position.z;
+
+            // Only a position on the boundary can shrink the bounding box
+            bool onBoundary = (x == low.x || x == high.x) ||
+                              (y == low.y || y == high.y) ||
+                              (z == low.z || z == high.z);
+            if (!onBoundary)
                 return false;
 
-            // Low
+            return recomputeBoundingBox();
+        }
+
+        bool Leaf::recomputeBoundingBox()
+        {
+            if (_count == 0)
             {
-                if (x == low.x)
-                {
-                    uint16_t xIndex = low.x;
-                    for (; xIndex < ChunkSize.width && xs[xIndex] == 0; ++xIndex)
-                        ;
-                    low.x = xIndex;
-                }
+                bool hadBoundingBox = std::holds_alternative<BoundingBox>(_boundingBox);
+                _boundingBox = {};
+                low = {};
+                high = {};
+                return hadBoundingBox;
+            }
 
-                if (y == low.y)
-                {
-                    uint16_t yIndex = low.y;
-                    for (; yIndex >= 0 && ys[yIndex] == 0; ++yIndex)
-                        ;
-                    low.y = yIndex;
-                }
+            DEBUG_ASSERT(!low.empty(), "A non-empty leaf must have bounds.");
 
-                if (z == low.z)
-                {
-                    uint16_t zIndex = low.z;
-                    for (; zIndex >= 0 && zs[zIndex] == 0; ++zIndex)
-                        ;
-                    low.z = zIndex;
-                }
-            }
+            Indices newLow = low;
+            Indices newHigh = high;
+            scanBounds(newLow, newHigh);
+
+            return setBounds(newLow, newHigh);
+        }
 
-            // High
+        void Leaf::scanBounds(Indices &from, Indices &to) const
+        {
+            Indices newLow{ChunkSize.width, ChunkSize.height, ChunkSize.depth};
+            Indices newHigh{-1, -1, -1};
+            uint64_t xMask = 0;
+
+            for (int z = from.z; z <= to.z; ++z)
             {
-                if (x == high.x)
-                {
-                    uint16_t xIndex = high.x;
-                    for (; xIndex >= 0 && xs[xIndex] == 0; --xIndex)
-                        ;
-                    high.x = xIndex;
-                }
+                const uint64_t *slice = rows.data() + z * ChunkSize.height;
 
-                if (y == high.y)
-                {
-                    uint16_t yIndex = high.y;
-                    for (; yIndex >= 0 && ys[yIndex] == 0; --yIndex)
-                        ;
-                    high.y = yIndex;
-                }
+                // Branch-free reduction over the rows of the slice, which the compiler can vectorize.
+                uint64_t sliceMask = 0;
+                for (int y = from.y; y <= to.y; ++y)
+                    sliceMask |= slice[y];
 
-                if (z == high.z)
-                {
-                    uint16_t zIndex = high.z;
-                    for (; zIndex >= 0 && zs[zIndex] == 0; --zIndex)
-                        ;
-                    high.z = zIndex;
-                }
+                if (sliceMask == 0)
+                    continue;
+
+                xMask |= sliceMask;
+                newLow.z = std::min(newLow.z, z);
+                newHigh.z = z;
+
+                int y = from.y;
+                while (slice[y] == 0)
+                    ++y;
+                newLow.y = std::min(newLow.y, y);
+
+                y = to.y;
+                while (slice[y] == 0)
+                    --y;
+                newHigh.y = std::max(newHigh.y, y);
             }
 
-            Position from(position.x + low.x, position.y + low.y, position.z + low.z);
-            Position to(position.x + high.x, position.y + high.y, position.z + high.z);
+            DEBUG_ASSERT(xMask != 0, "There must be at least one position within the scanned bounds.");
 
-            _boundingBox = BoundingBox(from, to);
-            return true;
+            newLow.x = std::countr_zero(xMask);
+            newHigh.x = 63 - std::countl_zero(xMask);
+
+            from = newLow;
+            to = newHigh;
         }
 
         Leaf::UpdateResult Leaf::add(const Position pos)
@@ -711,12 +771,14 @@ namespace vme
                 "The position does not belong to this chunk.");
 
             auto index = getIndex(pos);
+            uint64_t &row = rows[index >> 6];
+            uint64_t bit = uint64_t(1) << (index & 63);
 
-            if (values[index])
+            if (row & bit)
                 return {.change = false, .bboxChange = false};
 
             ++_count;
-            values[index] = true;
+            row |= bit;
             bool bboxChanged = addToBoundingBox(pos);
 
             if (bboxChanged && !parent->isCachedNode())
@@ -734,11 +796,14 @@ namespace vme
                 "The position does not belong to this chunk.");
 
             auto index = getIndex(pos);
-            if (!values[index])
+            uint64_t &row = rows[index >> 6];
+            uint64_t bit = uint64_t(1) << (index & 63);
+
+            if (!(row & bit))
                 return {false, false};
 
             --_count;
-            values[getIndex(pos)] = false;
+            row &= ~bit;
             bool bboxChanged = removeFromBoundingBox(pos);
             if (bboxChanged && !parent->isCachedNode())
                 parent->updateBoundingBox();
@@ -746,6 +811,147 @@ namespace vme
             return {true, bboxChanged};
         }
 
+        bool Leaf::setUnbounded(const Position pos, bool value)
+        {
+            DEBUG_ASSERT(encloses(pos), "The position does not belong to this chunk.");
+
+            auto index = getIndex(pos);
+            uint64_t &row = rows[index >> 6];
+            uint64_t bit = uint64_t(1) << (index & 63);
+
+            if (static_cast<bool>(row & bit) == value)
+                return false;
+
+            if (value)
+            {
+                row |= bit;
+                ++_count;
+            }
+            else
+            {
+                row &= ~bit;
+                --_count;
+            }
+
+            return true;
+        }
+
+        Leaf::UpdateResult Leaf::finishBulkUpdate()
+        {
+            bool bboxChanged;
+            if (_count == 0)
+            {
+                bboxChanged = recomputeBoundingBox();
+            }
+            else
+            {
+                Indices newLow{0, 0, 0};
+                Indices newHigh{ChunkSize.width - 1, ChunkSize.height - 1, ChunkSize.depth - 1};
+                scanBounds(newLow, newHigh);
+
+                bboxChanged = setBounds(newLow, newHigh);
+            }
+
+            if (bboxChanged && !parent->isCachedNode())
+                parent->updateBoundingBox();
+
+            return {true, bboxChanged};
+        }
+
+        Leaf::UpdateResult Leaf::addRegion(const Position from, const Position to)
+        {
+            return updateRegion(from, to, RegionOp::Add);
+        }
+
+        Leaf::UpdateResult Leaf::removeRegion(const Position from, const Position to)
+        {
+            return updateRegion(from, to, RegionOp::Remove);
+        }
+
+        Leaf::UpdateResult Leaf::toggleRegion(const Position from, const Position to)
+        {
+            return updateRegion(from, to, RegionOp::Toggle);
+        }
+
+        Leaf::UpdateResult Leaf::updateRegion(const Position from, const Position to, RegionOp op)
+        {
+            if (op == RegionOp::Remove && _count == 0)
+                return {false, false};
+
+            int x0 = std::max<int>(from.x, position.x) - position.x;
+            int y0 = std::max<int>(from.y, position.y) - position.y;
+            int z0 = std::max<int>(from.z, position.z) - position.z;
+            int x1 = std::min<int>(to.x, position.x + ChunkSize.width - 1) - position.x;
+            int y1 = std::min<int>(to.y, position.y + ChunkSize.height - 1) - position.y;
+            int z1 = std::min<int>(to.z, position.z + ChunkSize.depth - 1) - position.z;
+
+            if (x0 > x1 || y0 > y1 || z0 > z1)
+                return {false, false};
+
+            uint64_t mask = (~uint64_t(0) >> (63 - (x1 - x0))) << x0;
+
+            uint32_t added = 0;
+            uint32_t removed = 0;
+            for (int z = z0; z <= z1; ++z)
+            {
+                uint64_t *slice = rows.data() + z * ChunkSize.height;
+                for (int y = y0; y <= y1; ++y)
+                {
+                    uint64_t row = slice[y];
+                    switch (op)
+                    {
+                        case RegionOp::Add:
+                            added += std::popcount(mask & ~row);
+                            slice[y] = row | mask;
+                            break;
+                        case RegionOp::Remove:
+                            removed += std::popcount(mask & row);
+                            slice[y] = row & ~mask;
+                            break;
+                        case RegionOp::Toggle:
+                            added += std::popcount(mask & ~row);
+                            removed += std::popcount(mask & row);
+                            slice[y] = row ^ mask;
+                            break;
+                    }
+                }
+            }
+
+            if (added == 0 && removed == 0)
+                return {false, false};
+
+            bool wasEmpty = _count == 0;
+            _count = _count + added - removed;
+
+            bool bboxChanged;
+            if (_count == 0)
+            {
+                bboxChanged = recomputeBoundingBox();
+            }
+            else
+            {
+                // Every remaining position is within the old bounds or the region.
+                Indices newLow{x0, y0, z0};
+                Indices newHigh{x1, y1, z1};
+                if (!wasEmpty)
+                {
+                    newLow = {std::min(x0, low.x), std::min(y0, low.y), std::min(z0, low.z)};
+                    newHigh = {std::max(x1, high.x), std::max(y1, high.y), std::max(z1, high.z)};
+                }
+
+                // With only additions the union is exact
+                if (removed != 0)
+                    scanBounds(newLow, newHigh);
+
+                bboxChanged = setBounds(newLow, newHigh);
+            }
+
+            if (bboxChanged && !parent->isCachedNode())
+                parent->updateBoundingBox();
+
+            return {true, bboxChanged};
+        }
+
         std::string Leaf::show() const
         {
             std::ostringstream s;
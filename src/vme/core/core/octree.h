@@ -259,7 +259,6 @@ namespace vme
             void clear() override;
 
             [[nodiscard]] uint32_t size() const noexcept;
-            [[nodiscard]] uint32_t count() const noexcept;
 
             /*
         Returns true if the leaf has the position 'pos'.
@@ -278,11 +277,37 @@ namespace vme
             Position min() const noexcept;
             Position max() const noexcept;
 
-            std::array<bool, ChunkSize.width * ChunkSize.height * ChunkSize.depth> values = {false};
+            /*
+        Adds/removes every position in the box [from, to] (inclusive) that lies in this leaf. The box
+        is clamped to the leaf. Whole rows are updated a 64-bit word at a time.
+      */
+            UpdateResult addRegion(const Position from, const Position to);
+            UpdateResult removeRegion(const Position from, const Position to);
+            UpdateResult toggleRegion(const Position from, const Position to);
+
+            /*
+        Sets the bit of 'pos' without updating the bounding box. Used to apply many scattered
+        positions at once; call finishBulkUpdate() when done. Returns true if the bit changed.
+      */
+            bool setUnbounded(const Position pos, bool value);
+
+            /*
+        Recomputes the bounding box after one or more setUnbounded() calls.
+      */
+            UpdateResult finishBulkUpdate();
+
+            /*
+        One bit per position. Bit x of word (z * height + y) is the position
+        (position.x + x, position.y + y, position.z + z), i.e. a word holds one row along the x axis.
+      */
+            static constexpr size_t RowCount = ChunkSize.height * ChunkSize.depth;
+            std::array<uint64_t, RowCount> rows = {};
 
             Position position;
 
           private:
+            static_assert(ChunkSize.width == 64, "A leaf row must be exactly one 64-bit word.");
+
             uint32_t _count = 0;
             struct Indices
             {
@@ -290,6 +315,8 @@ namespace vme
                 int y = -1;
                 int z = -1;
 
+                bool operator==(const Indices &other) const = default;
+
 #ifdef _DEBUG_VME
                 bool validIndices() const noexcept
                 {
@@ -309,16 +336,12 @@ namespace vme
                 }
             };
             /*
-        Important: Indices hold indices into xs, ys, and zs. To get a position
+        Important: Indices are offsets within the leaf. To get a position
         based on low/high, use min() and max().
       */
             Indices low;
             Indices high;
 
-            uint16_t xs[ChunkSize.width] = {0};
-            uint16_t ys[ChunkSize.height] = {0};
-            uint16_t zs[ChunkSize.depth] = {0};
-
             /*
         Returns true if the bounding box changed.
       */
@@ -328,6 +351,32 @@ namespace vme
         Returns true if the bounding box changed.
       */
             bool removeFromBoundingBox(const Position pos);
+
+            enum class RegionOp
+            {
+                Add,
+                Remove,
+                Toggle
+            };
+
+            UpdateResult updateRegion(const Position from, const Position to, RegionOp op);
+
+            /*
+        Recomputes low/high from the rows. Only rows within the current bounds are scanned.
+        Returns true if the bounding box changed.
+      */
+            bool recomputeBoundingBox();
+
+            /*
+        Shrinks [from, to] to the bounds of the positions within it. There must be at least
+        one position within [from, to].
+      */
+            void scanBounds(Indices &from, Indices &to) const;
+
+            /*
+        Returns true if the bounding box changed.
+      */
+            bool setBounds(const Indices &newLow, const Indices &newHigh);
         };
 
         template <size_t ChildCount>
@@ -514,6 +563,21 @@ namespace vme
             bool add(const Position pos);
             bool remove(const Position pos);
 
+            /*
+        Bulk variants of add/remove. The bounding box of each touched leaf is only
+        recomputed once.
+      */
+            bool add(const std::vector<Position> &positions);
+            bool remove(const std::vector<Position> &positions);
+
+            /*
+        Adds/removes/toggles every position in the box [from, to] (inclusive). The box is
+        clamped to the map. Each leaf is updated a 64-bit row at a time.
+      */
+            bool addRegion(const Position from, const Position to);
+            bool removeRegion(const Position from, const Position to);
+            bool toggleRegion(const Position from, const Position to);
+
             /*
         Clear all positions from the tree.
       */
@@ -563,6 +627,10 @@ namespace vme
             void markAsRecent(CachedNode *cached, Leaf *leaf) const;
 
             Position findOnlyPosition() const;
+            void updateSingle();
+
+            bool setMany(const std::vector<Position> &positions, bool value);
+            bool updateRegion(const Position from, const Position to, Leaf::UpdateResult (Leaf::*update)(const Position, const Position), bool createLeaves);
 
             void initializeCache();
 
@@ -594,7 +662,11 @@ namespace vme
 
         inline void Leaf::clear()
         {
-            values.fill(false);
+            rows.fill(0);
+            _count = 0;
+            low = {};
+            high = {};
+            _boundingBox = {};
         }
 
         inline bool Leaf::empty() const noexcept
@@ -642,7 +714,7 @@ namespace vme
         inline void BaseNode<ChildCount>::updateBoundingBox()
         {
             // VME_LOG_D("updateBoundingBox before: " << boundingBox);
-            bool changed = false;
+            const auto previous = boundingBox();
             _boundingBox = {};
             for (const std::unique_ptr<HeapNode> &node : children)
             {
@@ -650,19 +722,18 @@ namespace vme
                 {
                     auto nodeBbox = node->boundingBox().value();
                     if (!boundingBox())
-                    {
                         _boundingBox = nodeBbox;
-                        changed = true;
-                    }
                     else
-                    {
-                        BoundingBox &box = std::get<BoundingBox>(_boundingBox);
-                        changed = changed || box.include(nodeBbox);
-                    }
+                        std::get<BoundingBox>(_boundingBox).include(nodeBbox);
                 }
             }
             // VME_LOG_D("updateBoundingBox after: " << boundingBox);
 
+            // The box can also shrink or disappear, so compare against the previous box instead of tracking growth.
+            const auto current = boundingBox();
+            bool changed = previous.has_value() != current.has_value() ||
+                           (current && !(previous->min() == current->min() && previous->max() == current->max()));
+
             if (!parent->isCachedNode() && changed)
                 parent->updateBoundingBox();
         }
@@ -868,11 +939,6 @@ namespace vme
             return std::holds_alternative<std::monostate>(_boundingBox);
         }
 
-        inline uint32_t Leaf::count() const noexcept
-        {
-            return _count;
-        }
-
         //>>>>>>>>>>>>>>>>>>>>>>>>>>>
         //>>>>>>>>>>>>>>>>>>>>>>>>>>>
         //>>>>>>>>>BoundingBox>>>>>>>
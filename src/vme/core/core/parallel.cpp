@@ -0,0 +1,10 @@
+#include "parallel.h"
+
+namespace parallel
+{
+    unsigned threadCount()
+    {
+        static const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        return count;
+    }
+} // namespace parallel
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+#include "position.h"
+
+namespace parallel
+{
+    /*
+        The number of threads (including the calling thread) that forEach uses. Always at least 1.
+    */
+    unsigned threadCount();
+
+    /*
+        Calls f(i) for every i in [0, count). The calls are spread over up to threadCount() threads, and the
+        calling thread takes part in the work. Returns once every call has finished.
+
+        Indices are claimed one at a time, so each call should be a chunk of work (for example every tile in a
+        quadtree leaf) rather than a single tile. 'f' must not throw, and calls with different indices must not
+        write to the same data.
+    */
+    template <typename F>
+    void forEach(size_t count, F &&f)
+    {
+        size_t threads = std::min<size_t>(threadCount(), count);
+        if (threads <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                f(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next = 0;
+        auto work = [&next, &f, count]() {
+            for (size_t i = next++; i < count; i = next++)
+            {
+                f(i);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (size_t i = 0; i < threads - 1; ++i)
+        {
+            workers.emplace_back(work);
+        }
+
+        work();
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // The number of bands that forEachBand splits the rows [firstRow, lastRow] into.
+    inline size_t bandCount(int firstRow, int lastRow, int bandRows)
+    {
+        return lastRow < firstRow ? 0 : static_cast<size_t>((lastRow - firstRow) / bandRows + 1);
+    }
+
+    /*
+        Splits the rows [firstRow, lastRow] into bands of 'bandRows' rows (the last band may be shorter) and calls
+        f(band, bandFirstRow, bandLastRow) for every band, in parallel. 'band' is the index of the band, counted
+        from firstRow. A call may read rows outside of its band (a halo), as long as no call writes to them.
+    */
+    template <typename F>
+    void forEachBand(int firstRow, int lastRow, int bandRows, F &&f)
+    {
+        forEach(bandCount(firstRow, lastRow, bandRows), [firstRow, lastRow, bandRows, &f](size_t band) {
+            int bandFirstRow = firstRow + static_cast<int>(band) * bandRows;
+            f(band, bandFirstRow, std::min(bandFirstRow + bandRows - 1, lastRow));
+        });
+    }
+
+    /*
+        The map quadtree stores the tiles of a 4x4 area (on every floor) in the same leaf.
+    */
+    inline uint64_t quadTreeLeafKey(const Position &pos)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(pos.x) >> 2) << 32) | (static_cast<uint32_t>(pos.y) >> 2);
+    }
+
+    /*
+        Calls f(i) for every index in 'positions'. The indices are grouped by quadtree leaf and the groups are
+        processed in parallel. Within a group, the indices are visited in ascending order, so the calls for a
+        position keep their order. Below 'minParallelCount' positions, everything runs on the calling thread.
+    */
+    template <typename F>
+    void forEachByLeaf(const std::vector<Position> &positions, size_t minParallelCount, F &&f)
+    {
+        if (positions.size() < minParallelCount)
+        {
+            for (size_t i = 0; i < positions.size(); ++i)
+                f(i);
+            return;
+        }
+
+        std::vector<std::pair<uint64_t, uint32_t>> keys;
+        keys.reserve(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i)
+            keys.emplace_back(quadTreeLeafKey(positions[i]), static_cast<uint32_t>(i));
+
+        std::ranges::sort(keys);
+
+        std::vector<size_t> groupStarts;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (i == 0 || keys[i].first != keys[i - 1].first)
+                groupStarts.emplace_back(i);
+        }
+        groupStarts.emplace_back(keys.size());
+
+        forEach(groupStarts.size() - 1, [&keys, &groupStarts, &f](size_t group) {
+            for (size_t i = groupStarts[group]; i < groupStarts[group + 1]; ++i)
+                f(keys[i].second);
+        });
+    }
+} // namespace parallel
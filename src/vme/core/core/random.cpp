@@ -31,6 +31,13 @@ double Random::nextDouble()
     return distribution(randomEngine);
 }
 
+uint64_t Random::nextUint64()
+{
+    uint64_t high = randomEngine();
+    uint64_t low = randomEngine();
+    return (high << 32) | low;
+}
+
 Random &Random::global()
 {
     return globalRandom;
@@ -45,4 +52,12 @@ Random &Random::operator=(const Random &other)
     this->distribution = other.distribution;
 
     return *this;
-}
\ No newline at end of file
+}
+
+CounterRandom::CounterRandom(uint64_t seed, uint64_t stream)
+    : key(mix(seed) ^ mix(stream + Increment)) {}
+
+CounterRandom CounterRandom::stream(uint64_t stream) const
+{
+    return CounterRandom(key, stream);
+}
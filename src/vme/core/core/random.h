@@ -33,6 +33,9 @@ class Random
         return static_cast<T>(std::round(from + r * (maxValue - from)));
     }
 
+    // 64 random bits
+    uint64_t nextUint64();
+
     void setSeed(uint32_t seed);
 
     static Random &global();
@@ -43,4 +46,43 @@ class Random
     std::uniform_real_distribution<double> distribution;
 
     void initialize(uint32_t seed);
-};
\ No newline at end of file
+};
+
+/*
+	A counter-based generator: the number at a counter is a hash of the key and the counter, so any number of a
+	stream can be computed without the numbers before it. That makes the result independent of the order and the
+	thread that the numbers are generated on, e.g. when a region is filled in parallel chunks.
+*/
+class CounterRandom
+{
+  public:
+    CounterRandom(uint64_t seed, uint64_t stream = 0);
+
+    uint64_t at(uint64_t counter) const noexcept
+    {
+        return mix(key + counter * Increment);
+    }
+
+    // The number at the current counter, which is then advanced
+    uint64_t next() noexcept
+    {
+        return at(counter++);
+    }
+
+    // A stream that is independent of this one, e.g. for a chunk of a region
+    CounterRandom stream(uint64_t stream) const;
+
+  private:
+    // See SplitMix64
+    static constexpr uint64_t Increment = 0x9E3779B97F4A7C15ull;
+
+    static constexpr uint64_t mix(uint64_t value) noexcept
+    {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t key;
+    uint64_t counter = 0;
+};
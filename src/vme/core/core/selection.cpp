@@ -1,33 +1,83 @@
 #include "selection.h"
 
+#include <algorithm>
+#include <bit>
+
 #include "debug.h"
 #include "history/history_action.h"
 #include "map_view.h"
+#include "settings.h"
 
 Selection::Selection(MapView &mapView, Map &map)
     : map(map),
       mapView(mapView),
-      storage(map.size())
+      storage(Settings::INTERVAL_SELECTION_STORAGE ? std::unique_ptr<SelectionStorage>(std::make_unique<SelectionStorageIntervals>())
+                                                   : std::make_unique<SelectionStorageOctree>(map.size()))
 {
     DEBUG_ASSERT(mapView.map() == &map, "The selection map differs from the mapView map.");
 }
 
 void Selection::select(const std::vector<Position> &positions)
 {
+    applyPendingUpdates();
+    if (positions.empty())
+        return;
+
+    Position low = positions.front();
+    Position high = positions.front();
     for (const auto &pos : positions)
     {
-        bool change = storage.add(pos);
-        _changed = _changed || change;
+        low = Position(std::min(low.x, pos.x), std::min(low.y, pos.y), std::min(low.z, pos.z));
+        high = Position(std::max(high.x, pos.x), std::max(high.y, pos.y), std::max(high.z, pos.z));
     }
+
+    bool change = storage->add(positions, {low.x, low.y, high.x, high.y});
+    _changed = _changed || change;
 }
 
-void Selection::deselect(const std::vector<Position> &positions)
+void Selection::select(const std::vector<SelectionSpan> &spans)
 {
-    for (const auto &pos : positions)
+    applyPendingUpdates();
+    bool change = false;
+    for (const auto &span : spans)
     {
-        bool change = storage.remove(pos);
-        _changed = _changed || change;
+        change = storage->addRegion(span.start, span.end()) || change;
+    }
+
+    _changed = _changed || change;
+}
+
+void Selection::deselect(const std::vector<SelectionSpan> &spans)
+{
+    applyPendingUpdates();
+    bool change = false;
+    for (const auto &span : spans)
+    {
+        change = storage->removeRegion(span.start, span.end()) || change;
     }
+
+    _changed = _changed || change;
+}
+
+void Selection::deselect(const std::vector<Position> &positions)
+{
+    applyPendingUpdates();
+    bool change = storage->remove(positions);
+    _changed = _changed || change;
+}
+
+void Selection::selectRegion(const Position from, const Position to)
+{
+    applyPendingUpdates();
+    bool change = storage->addRegion(from, to);
+    _changed = _changed || change;
+}
+
+void Selection::deselectRegion(const Position from, const Position to)
+{
+    applyPendingUpdates();
+    bool change = storage->removeRegion(from, to);
+    _changed = _changed || change;
 }
 
 bool Selection::isMoving() const noexcept
@@ -38,20 +88,23 @@ bool Selection::isMoving() const noexcept
 
 bool Selection::contains(const Position pos) const
 {
-    return storage.contains(pos);
+    applyPendingUpdates();
+    return storage->contains(pos);
 }
 
 void Selection::select(const Position pos)
 {
+    applyPendingUpdates();
     DEBUG_ASSERT(mapView.getTile(pos)->hasSelection(), "The tile does not have a selection.");
 
-    bool change = storage.add(pos);
+    bool change = storage->add(pos);
     _changed = _changed || change;
 }
 
 void Selection::deselect(const Position pos)
 {
-    bool change = storage.remove(pos);
+    applyPendingUpdates();
+    bool change = storage->remove(pos);
     _changed = _changed || change;
 }
 
@@ -65,20 +118,61 @@ void Selection::setSelected(const Position pos, bool selected)
 
 void Selection::updatePosition(const Position pos)
 {
+    if (batchDepth > 0)
+    {
+        if (!pendingPositions.insert(pos).second)
+        {
+            ++_coalescedNotifications;
+        }
+        return;
+    }
+
     auto tile = mapView.getTile(pos);
     setSelected(pos, tile && tile->hasSelection());
 }
 
+void Selection::applyPendingUpdates() const
+{
+    if (pendingPositions.empty())
+        return;
+
+    for (const auto &pos : pendingPositions)
+    {
+        auto tile = mapView.getTile(pos);
+        bool change = tile && tile->hasSelection() ? storage->add(pos) : storage->remove(pos);
+        _changed = _changed || change;
+    }
+
+    pendingPositions.clear();
+}
+
+void Selection::beginBatch()
+{
+    ++batchDepth;
+}
+
+void Selection::endBatch()
+{
+    DEBUG_ASSERT(batchDepth > 0, "There is no selection batch to end.");
+    if (--batchDepth > 0)
+        return;
+
+    signalDeferred = false;
+    applyPendingUpdates();
+    update();
+}
+
 void Selection::clear()
 {
-    bool change = storage.clear();
+    applyPendingUpdates();
+    bool change = storage->clear();
     _changed = _changed || change;
 }
 
 // bool Selection::deselectAll()
 // {
 //   // There is no need to commit an action if there are no selections
-//   if (storage.empty())
+//   if (storage->empty())
 //   {
 //     VME_LOG_D("[Selection::deselectAll] Storage was empty.");
 //     return false;
@@ -91,18 +185,33 @@ void Selection::clear()
 
 size_t Selection::size() const noexcept
 {
-    return storage.size();
+    applyPendingUpdates();
+    return storage->size();
 }
 
 bool Selection::empty() const
 {
-    return storage.empty();
+    applyPendingUpdates();
+    return storage->empty();
 }
 
 void Selection::update()
 {
-    // storage.update();
+    // storage->update();
+
+    if (batchDepth > 0)
+    {
+        if (_changed)
+        {
+            if (signalDeferred)
+                ++_coalescedNotifications;
+
+            signalDeferred = true;
+        }
+        return;
+    }
 
+    applyPendingUpdates();
     if (_changed)
     {
         selectionChange.fire();
@@ -112,11 +221,13 @@ void Selection::update()
 
 std::optional<Position> Selection::getCorner(bool positiveX, bool positiveY, bool positiveZ) const noexcept
 {
-    return storage.getCorner(positiveX, positiveY, positiveZ);
+    applyPendingUpdates();
+    return storage->getCorner(positiveX, positiveY, positiveZ);
 }
 std::optional<Position> Selection::getCorner(int positiveX, int positiveY, int positiveZ) const noexcept
 {
-    return storage.getCorner(positiveX, positiveY, positiveZ);
+    applyPendingUpdates();
+    return storage->getCorner(positiveX, positiveY, positiveZ);
 }
 
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
@@ -174,9 +285,7 @@ bool SelectionStorageSet::add(Position pos)
     else
         updateBoundingBox(pos);
 
-    values.emplace(pos);
-
-    return true;
+    return values.emplace(pos).second;
 }
 
 bool SelectionStorageSet::remove(Position pos)
@@ -184,12 +293,10 @@ bool SelectionStorageSet::remove(Position pos)
     if (xMin == pos.x || xMax == pos.x || yMin == pos.y || yMax == pos.y)
         staleBoundingBox = true;
 
-    values.erase(pos);
-
-    return true;
+    return values.erase(pos) > 0;
 }
 
-bool SelectionStorageSet::add(std::vector<Position> positions, util::Rectangle<Position::value_type> bbox)
+bool SelectionStorageSet::add(const std::vector<Position> &positions, util::Rectangle<Position::value_type> bbox)
 {
     if (positions.empty())
         return false;
@@ -197,12 +304,84 @@ bool SelectionStorageSet::add(std::vector<Position> positions, util::Rectangle<P
     if (values.empty())
         setBoundingBox(positions.front());
 
+    bool changed = false;
     for (const auto &pos : positions)
-        values.emplace(pos);
+        changed = values.emplace(pos).second || changed;
 
     updateBoundingBox(bbox);
 
-    return true;
+    return changed;
+}
+
+bool SelectionStorageSet::remove(const std::vector<Position> &positions)
+{
+    bool changed = false;
+    for (const auto &pos : positions)
+        changed = remove(pos) || changed;
+
+    return changed;
+}
+
+bool SelectionStorageSet::addRegion(const Position from, const Position to)
+{
+    bool changed = false;
+    for (auto z = from.z; z <= to.z; ++z)
+        for (auto y = from.y; y <= to.y; ++y)
+            for (auto x = from.x; x <= to.x; ++x)
+                changed = add(Position(x, y, z)) || changed;
+
+    return changed;
+}
+
+bool SelectionStorageSet::removeRegion(const Position from, const Position to)
+{
+    bool changed = false;
+    for (auto z = from.z; z <= to.z; ++z)
+        for (auto y = from.y; y <= to.y; ++y)
+            for (auto x = from.x; x <= to.x; ++x)
+                changed = remove(Position(x, y, z)) || changed;
+
+    return changed;
+}
+
+bool SelectionStorageSet::toggleRegion(const Position from, const Position to)
+{
+    bool changed = false;
+    for (auto z = from.z; z <= to.z; ++z)
+        for (auto y = from.y; y <= to.y; ++y)
+            for (auto x = from.x; x <= to.x; ++x)
+            {
+                Position pos(x, y, z);
+                changed = (contains(pos) ? remove(pos) : add(pos)) || changed;
+            }
+
+    return changed;
+}
+
+std::vector<SelectionSpan> SelectionStorageSet::spans() const
+{
+    std::vector<Position> positions(values.begin(), values.end());
+    std::sort(positions.begin(), positions.end(), [](const Position &a, const Position &b) {
+        return std::tie(a.z, a.y, a.x) < std::tie(b.z, b.y, b.x);
+    });
+
+    std::vector<SelectionSpan> result;
+    for (const auto &pos : positions)
+    {
+        if (!result.empty())
+        {
+            SelectionSpan &last = result.back();
+            if (last.start.z == pos.z && last.start.y == pos.y && last.start.x + last.length == pos.x)
+            {
+                ++last.length;
+                continue;
+            }
+        }
+
+        result.emplace_back(SelectionSpan{pos, 1});
+    }
+
+    return result;
 }
 
 void SelectionStorageSet::recomputeBoundingBox()
@@ -232,13 +411,9 @@ bool SelectionStorageOctree::add(Position pos)
     return tree.add(pos);
 }
 
-bool SelectionStorageOctree::add(std::vector<Position> positions, util::Rectangle<Position::value_type> bbox)
+bool SelectionStorageOctree::add(const std::vector<Position> &positions, util::Rectangle<Position::value_type> bbox)
 {
-    bool changed = false;
-    for (const auto &pos : positions)
-        changed = changed || tree.add(pos);
-
-    return changed;
+    return tree.add(positions);
 }
 
 bool SelectionStorageOctree::remove(Position pos)
@@ -246,6 +421,26 @@ bool SelectionStorageOctree::remove(Position pos)
     return tree.remove(pos);
 }
 
+bool SelectionStorageOctree::remove(const std::vector<Position> &positions)
+{
+    return tree.remove(positions);
+}
+
+bool SelectionStorageOctree::addRegion(const Position from, const Position to)
+{
+    return tree.addRegion(from, to);
+}
+
+bool SelectionStorageOctree::removeRegion(const Position from, const Position to)
+{
+    return tree.removeRegion(from, to);
+}
+
+bool SelectionStorageOctree::toggleRegion(const Position from, const Position to)
+{
+    return tree.toggleRegion(from, to);
+}
+
 void SelectionStorageOctree::update()
 {
     // No-op
@@ -286,3 +481,361 @@ std::optional<Position> SelectionStorageOctree::onlyPosition() const
 {
     return tree.onlyPosition();
 }
+
+std::vector<SelectionSpan> SelectionStorageOctree::spans() const
+{
+    using vme::octree::ChunkSize;
+    using vme::octree::Leaf;
+
+    std::vector<SelectionSpan> result;
+    for (auto it = vme::octree::Tree::leafIterator(&tree); !it.finished(); ++it)
+    {
+        const Leaf *leaf = *it;
+        for (size_t rowIndex = 0; rowIndex < Leaf::RowCount; ++rowIndex)
+        {
+            uint64_t row = leaf->rows[rowIndex];
+            int y = leaf->position.y + static_cast<int>(rowIndex % ChunkSize.height);
+            auto z = static_cast<Position::z_type>(leaf->position.z + rowIndex / ChunkSize.height);
+
+            // Each run of set bits is a span
+            while (row != 0)
+            {
+                int start = std::countr_zero(row);
+                int length = std::countr_one(row >> start);
+
+                result.emplace_back(SelectionSpan{Position(leaf->position.x + start, y, z), length});
+
+                row = length == 64 ? 0 : row & ~(((uint64_t(1) << length) - 1) << start);
+            }
+        }
+    }
+
+    // Leaves are not visited in position order, and a span can continue in the neighboring leaf.
+    std::sort(result.begin(), result.end(), [](const SelectionSpan &a, const SelectionSpan &b) {
+        return std::tie(a.start.z, a.start.y, a.start.x) < std::tie(b.start.z, b.start.y, b.start.x);
+    });
+
+    size_t merged = 0;
+    for (size_t i = 1; i < result.size(); ++i)
+    {
+        SelectionSpan &last = result[merged];
+        const SelectionSpan &span = result[i];
+        if (last.start.z == span.start.z && last.start.y == span.start.y && last.start.x + last.length == span.start.x)
+        {
+            last.length += span.length;
+        }
+        else
+        {
+            result[++merged] = span;
+        }
+    }
+
+    if (!result.empty())
+        result.resize(merged + 1);
+
+    return result;
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+//>>>>SelectionStorageIntervals>>>
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+
+size_t SelectionStorageIntervals::addInterval(Row &row, Position::value_type x1, Position::value_type x2)
+{
+    // First interval that overlaps or touches [x1, x2]
+    auto first = std::lower_bound(row.begin(), row.end(), x1, [](const Interval &interval, Position::value_type x) {
+        return interval.x2 < x - 1;
+    });
+
+    auto last = first;
+    while (last != row.end() && last->x1 <= x2 + 1)
+    {
+        x1 = std::min(x1, last->x1);
+        x2 = std::max(x2, last->x2);
+        ++last;
+    }
+
+    size_t added;
+    if (first == last)
+    {
+        added = static_cast<size_t>(x2 - x1 + 1);
+        row.insert(first, Interval{x1, x2});
+    }
+    else
+    {
+        // The merged interval also contains the positions of the merged intervals.
+        size_t merged = 0;
+        for (auto it = first; it != last; ++it)
+            merged += static_cast<size_t>(it->x2 - it->x1 + 1);
+
+        added = static_cast<size_t>(x2 - x1 + 1) - merged;
+
+        *first = Interval{x1, x2};
+        row.erase(first + 1, last);
+    }
+
+    return added;
+}
+
+size_t SelectionStorageIntervals::removeInterval(Row &row, Position::value_type x1, Position::value_type x2)
+{
+    // First interval that overlaps [x1, x2]
+    auto it = std::lower_bound(row.begin(), row.end(), x1, [](const Interval &interval, Position::value_type x) {
+        return interval.x2 < x;
+    });
+
+    size_t removed = 0;
+    while (it != row.end() && it->x1 <= x2)
+    {
+        Position::value_type overlapStart = std::max(it->x1, x1);
+        Position::value_type overlapEnd = std::min(it->x2, x2);
+        removed += static_cast<size_t>(overlapEnd - overlapStart + 1);
+
+        bool keepLeft = it->x1 < x1;
+        bool keepRight = it->x2 > x2;
+
+        if (keepLeft && keepRight)
+        {
+            Interval right{x2 + 1, it->x2};
+            it->x2 = x1 - 1;
+            row.insert(it + 1, right);
+            break;
+        }
+        else if (keepLeft)
+        {
+            it->x2 = x1 - 1;
+            ++it;
+        }
+        else if (keepRight)
+        {
+            it->x1 = x2 + 1;
+            break;
+        }
+        else
+        {
+            it = row.erase(it);
+        }
+    }
+
+    return removed;
+}
+
+bool SelectionStorageIntervals::add(Position pos)
+{
+    return addRegion(pos, pos);
+}
+
+bool SelectionStorageIntervals::add(const std::vector<Position> &positions, util::Rectangle<Position::value_type> bbox)
+{
+    bool changed = false;
+    for (const auto &pos : positions)
+        changed = add(pos) || changed;
+
+    return changed;
+}
+
+bool SelectionStorageIntervals::remove(Position pos)
+{
+    return removeRegion(pos, pos);
+}
+
+bool SelectionStorageIntervals::remove(const std::vector<Position> &positions)
+{
+    bool changed = false;
+    for (const auto &pos : positions)
+        changed = remove(pos) || changed;
+
+    return changed;
+}
+
+bool SelectionStorageIntervals::addRegion(const Position from, const Position to)
+{
+    size_t added = 0;
+    for (int z = std::min(from.z, to.z); z <= std::max(from.z, to.z); ++z)
+    {
+        for (int y = std::min(from.y, to.y); y <= std::max(from.y, to.y); ++y)
+        {
+            Row &row = rows[{static_cast<Position::z_type>(z), y}];
+            added += addInterval(row, std::min(from.x, to.x), std::max(from.x, to.x));
+        }
+    }
+
+    if (added == 0)
+        return false;
+
+    _size += added;
+    staleBoundingBox = true;
+    return true;
+}
+
+bool SelectionStorageIntervals::removeRegion(const Position from, const Position to)
+{
+    size_t removed = 0;
+    for (int z = std::min(from.z, to.z); z <= std::max(from.z, to.z); ++z)
+    {
+        for (int y = std::min(from.y, to.y); y <= std::max(from.y, to.y); ++y)
+        {
+            auto found = rows.find({static_cast<Position::z_type>(z), y});
+            if (found == rows.end())
+                continue;
+
+            removed += removeInterval(found->second, std::min(from.x, to.x), std::max(from.x, to.x));
+            if (found->second.empty())
+                rows.erase(found);
+        }
+    }
+
+    if (removed == 0)
+        return false;
+
+    _size -= removed;
+    staleBoundingBox = true;
+    return true;
+}
+
+bool SelectionStorageIntervals::toggleRegion(const Position from, const Position to)
+{
+    Position::value_type x1 = std::min(from.x, to.x);
+    Position::value_type x2 = std::max(from.x, to.x);
+
+    for (int z = std::min(from.z, to.z); z <= std::max(from.z, to.z); ++z)
+    {
+        for (int y = std::min(from.y, to.y); y <= std::max(from.y, to.y); ++y)
+        {
+            Row &row = rows[{static_cast<Position::z_type>(z), y}];
+
+            // The unselected parts of [x1, x2] become the new intervals
+            Row gaps;
+            Position::value_type x = x1;
+            for (const auto &interval : row)
+            {
+                if (interval.x2 < x1 || interval.x1 > x2)
+                    continue;
+
+                if (interval.x1 > x)
+                    gaps.emplace_back(Interval{x, interval.x1 - 1});
+                x = interval.x2 + 1;
+            }
+            if (x <= x2)
+                gaps.emplace_back(Interval{x, x2});
+
+            _size -= removeInterval(row, x1, x2);
+            for (const auto &gap : gaps)
+                _size += addInterval(row, gap.x1, gap.x2);
+
+            if (row.empty())
+                rows.erase({static_cast<Position::z_type>(z), y});
+        }
+    }
+
+    staleBoundingBox = true;
+    return true;
+}
+
+void SelectionStorageIntervals::update()
+{
+    // No-op
+}
+
+bool SelectionStorageIntervals::empty() const noexcept
+{
+    return _size == 0;
+}
+
+size_t SelectionStorageIntervals::size() const noexcept
+{
+    return _size;
+}
+
+bool SelectionStorageIntervals::contains(const Position pos) const
+{
+    auto found = rows.find({pos.z, pos.y});
+    if (found == rows.end())
+        return false;
+
+    const Row &row = found->second;
+    auto it = std::lower_bound(row.begin(), row.end(), pos.x, [](const Interval &interval, Position::value_type x) {
+        return interval.x2 < x;
+    });
+
+    return it != row.end() && it->x1 <= pos.x;
+}
+
+bool SelectionStorageIntervals::clear()
+{
+    bool changed = _size != 0;
+
+    rows.clear();
+    _size = 0;
+    staleBoundingBox = true;
+
+    return changed;
+}
+
+void SelectionStorageIntervals::recomputeBoundingBox() const
+{
+    if (rows.empty())
+        return;
+
+    // Rows are ordered by (z, y), so z is bounded by the first and last row.
+    low = Position(rows.begin()->second.front().x1, rows.begin()->first.second, rows.begin()->first.first);
+    high = Position(rows.rbegin()->second.back().x2, rows.rbegin()->first.second, rows.rbegin()->first.first);
+
+    for (const auto &[key, row] : rows)
+    {
+        low.x = std::min(low.x, row.front().x1);
+        low.y = std::min(low.y, key.second);
+        high.x = std::max(high.x, row.back().x2);
+        high.y = std::max(high.y, key.second);
+    }
+
+    staleBoundingBox = false;
+}
+
+std::optional<Position> SelectionStorageIntervals::getCorner(bool positiveX, bool positiveY, bool positiveZ) const noexcept
+{
+    if (_size == 0)
+        return std::nullopt;
+
+    if (staleBoundingBox)
+        recomputeBoundingBox();
+
+    return Position(
+        positiveX ? high.x : low.x,
+        positiveY ? high.y : low.y,
+        positiveZ ? high.z : low.z);
+}
+
+std::vector<Position> SelectionStorageIntervals::allPositions() const
+{
+    std::vector<Position> positions;
+    positions.reserve(_size);
+
+    for (const auto &span : spans())
+        span.forEach([&positions](const Position pos) { positions.emplace_back(pos); });
+
+    return positions;
+}
+
+std::optional<Position> SelectionStorageIntervals::onlyPosition() const
+{
+    if (_size != 1)
+        return std::nullopt;
+
+    const auto &[key, row] = *rows.begin();
+    return Position(row.front().x1, key.second, key.first);
+}
+
+std::vector<SelectionSpan> SelectionStorageIntervals::spans() const
+{
+    std::vector<SelectionSpan> result;
+    for (const auto &[key, row] : rows)
+    {
+        for (const auto &interval : row)
+            result.emplace_back(SelectionSpan{Position(interval.x1, key.second, key.first), interval.x2 - interval.x1 + 1});
+    }
+
+    return result;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <map>
+#include <memory>
 #include <optional>
 #include <unordered_set>
 
@@ -11,13 +13,42 @@
 
 class Map;
 
+/*
+    A run of 'length' consecutive positions along the x axis, starting at 'start'.
+*/
+struct SelectionSpan
+{
+    Position start;
+    int length;
+
+    Position end() const noexcept
+    {
+        return Position(start.x + length - 1, start.y, start.z);
+    }
+
+    template <typename F>
+    void forEach(F &&f) const
+    {
+        for (int i = 0; i < length; ++i)
+            f(Position(start.x + i, start.y, start.z));
+    }
+};
+
 class SelectionStorage
 {
   public:
     virtual bool add(Position pos) = 0;
-    virtual bool add(std::vector<Position> positions, util::Rectangle<Position::value_type> bbox) = 0;
+    virtual bool add(const std::vector<Position> &positions, util::Rectangle<Position::value_type> bbox) = 0;
 
     virtual bool remove(Position pos) = 0;
+    virtual bool remove(const std::vector<Position> &positions) = 0;
+
+    /*
+        Adds/removes/toggles every position in the box [from, to] (inclusive).
+    */
+    virtual bool addRegion(const Position from, const Position to) = 0;
+    virtual bool removeRegion(const Position from, const Position to) = 0;
+    virtual bool toggleRegion(const Position from, const Position to) = 0;
 
     virtual void update() = 0;
 
@@ -33,6 +64,11 @@ class SelectionStorage
 
     virtual std::vector<Position> allPositions() const = 0;
     virtual std::optional<Position> onlyPosition() const = 0;
+
+    /*
+        The selected positions as runs along the x axis, ordered by (z, y, x). Adjacent runs are merged.
+    */
+    virtual std::vector<SelectionSpan> spans() const = 0;
 };
 
 class SelectionStorageOctree : public SelectionStorage
@@ -41,9 +77,14 @@ class SelectionStorageOctree : public SelectionStorage
     SelectionStorageOctree(const util::Volume<uint16_t, uint16_t, uint8_t> mapSize);
 
     bool add(Position pos) override;
-    bool add(std::vector<Position> positions, util::Rectangle<Position::value_type> bbox) override;
+    bool add(const std::vector<Position> &positions, util::Rectangle<Position::value_type> bbox) override;
 
     bool remove(Position pos) override;
+    bool remove(const std::vector<Position> &positions) override;
+
+    bool addRegion(const Position from, const Position to) override;
+    bool removeRegion(const Position from, const Position to) override;
+    bool toggleRegion(const Position from, const Position to) override;
 
     void update() override;
 
@@ -70,6 +111,8 @@ class SelectionStorageOctree : public SelectionStorage
     std::vector<Position> allPositions() const override;
     std::optional<Position> onlyPosition() const override;
 
+    std::vector<SelectionSpan> spans() const override;
+
   private:
     vme::octree::Tree tree;
 };
@@ -83,15 +126,84 @@ inline std::optional<Position> SelectionStorageOctree::getCorner(int positiveX,
     return tree.getCorner(positiveX == 1, positiveY == 1, positiveZ == 1);
 }
 
+/*
+    Stores the selection as sorted, disjoint x-intervals per (z, y) row. A rectangular selection costs one
+    interval per row regardless of its width, so this is much smaller than the octree for huge rectangular
+    selections (e.g. a 2000x2000 selection is 2000 intervals).
+*/
+class SelectionStorageIntervals : public SelectionStorage
+{
+  public:
+    bool add(Position pos) override;
+    bool add(const std::vector<Position> &positions, util::Rectangle<Position::value_type> bbox) override;
+
+    bool remove(Position pos) override;
+    bool remove(const std::vector<Position> &positions) override;
+
+    bool addRegion(const Position from, const Position to) override;
+    bool removeRegion(const Position from, const Position to) override;
+    bool toggleRegion(const Position from, const Position to) override;
+
+    void update() override;
+
+    bool empty() const noexcept override;
+
+    bool contains(const Position pos) const override;
+
+    bool clear() override;
+    size_t size() const noexcept override;
+
+    std::optional<Position> getCorner(bool positiveX, bool positiveY, bool positiveZ) const noexcept override;
+    std::optional<Position> getCorner(int positiveX, int positiveY, int positiveZ) const noexcept override;
+
+    std::vector<Position> allPositions() const override;
+    std::optional<Position> onlyPosition() const override;
+
+    std::vector<SelectionSpan> spans() const override;
+
+  private:
+    struct Interval
+    {
+        Position::value_type x1;
+        Position::value_type x2;
+    };
+
+    using RowKey = std::pair<Position::z_type, Position::value_type>;
+    using Row = std::vector<Interval>;
+
+    // Returns the amount of positions that were added/removed.
+    static size_t addInterval(Row &row, Position::value_type x1, Position::value_type x2);
+    static size_t removeInterval(Row &row, Position::value_type x1, Position::value_type x2);
+
+    void recomputeBoundingBox() const;
+
+    std::map<RowKey, Row> rows;
+    size_t _size = 0;
+
+    mutable bool staleBoundingBox = false;
+    mutable Position low;
+    mutable Position high;
+};
+
+inline std::optional<Position> SelectionStorageIntervals::getCorner(int positiveX, int positiveY, int positiveZ) const noexcept
+{
+    return getCorner(positiveX == 1, positiveY == 1, positiveZ == 1);
+}
+
 class SelectionStorageSet : public SelectionStorage
 {
   public:
     SelectionStorageSet();
 
     bool add(Position pos) override;
-    bool add(std::vector<Position> positions, util::Rectangle<Position::value_type> bbox) override;
+    bool add(const std::vector<Position> &positions, util::Rectangle<Position::value_type> bbox) override;
 
     bool remove(Position pos) override;
+    bool remove(const std::vector<Position> &positions) override;
+
+    bool addRegion(const Position from, const Position to) override;
+    bool removeRegion(const Position from, const Position to) override;
+    bool toggleRegion(const Position from, const Position to) override;
 
     void update() override;
 
@@ -107,6 +219,8 @@ class SelectionStorageSet : public SelectionStorage
 
     bool clear() override;
 
+    std::vector<SelectionSpan> spans() const override;
+
   private:
     std::unordered_set<Position, PositionHash> values;
 
@@ -128,15 +242,6 @@ class Selection
     Selection(MapView &mapView, Map &map);
     bool blockDeselect = false;
 
-    vme::octree::Tree::iterator begin()
-    {
-        return storage.begin();
-    }
-    vme::octree::Tree::iterator end()
-    {
-        return storage.end();
-    }
-
     std::optional<Position> getCorner(bool positiveX, bool positiveY, bool positiveZ) const noexcept;
     std::optional<Position> getCorner(int positiveX, int positiveY, int positiveZ) const noexcept;
 
@@ -147,6 +252,19 @@ class Selection
     void select(const std::vector<Position> &positions);
     void deselect(const Position pos);
     void deselect(const std::vector<Position> &positions);
+
+    /*
+        Selects/deselects every position of the runs, one box per run (see selectRegion).
+    */
+    void select(const std::vector<SelectionSpan> &spans);
+    void deselect(const std::vector<SelectionSpan> &spans);
+
+    /*
+        Selects/deselects every position in the box [from, to] (inclusive). NOTE: Like select(positions),
+        this only changes the selection storage, not the selection state of the tiles.
+    */
+    void selectRegion(const Position from, const Position to);
+    void deselectRegion(const Position from, const Position to);
     void setSelected(const Position pos, bool selected);
     void updatePosition(const Position pos);
     // bool deselectAll();
@@ -154,6 +272,12 @@ class Selection
     inline std::vector<Position> allPositions() const;
     inline std::optional<Position> onlyPosition() const;
 
+    /*
+        The selection as runs of positions along the x axis. Prefer this over allPositions() for large
+        selections, since it does not expand the selection into individual positions.
+    */
+    inline std::vector<SelectionSpan> spans() const;
+
     size_t size() const noexcept;
 
     bool empty() const;
@@ -169,7 +293,24 @@ class Selection
     template <auto MemberFunction, typename T>
     void onChanged(T *instance);
 
+    /*
+        Between beginBatch and endBatch (see History::beginTransaction), updatePosition only records the position
+        and update() does not fire the selection signal. The recorded positions are applied, once each, before
+        the selection is used in any other way. When the outermost batch ends, the signal fires once if the
+        selection changed. Batches can be nested.
+    */
+    void beginBatch();
+    void endBatch();
+
+    // The number of position updates and selection signals that batching merged into an earlier one.
+    size_t coalescedNotifications() const noexcept
+    {
+        return _coalescedNotifications;
+    }
+
   private:
+    void applyPendingUpdates() const;
+
     Nano::Signal<void()> selectionChange;
 
     /**
@@ -181,22 +322,38 @@ class Selection
    * 
    * @see MapHistory::Transaction
    */
-    bool _changed = false;
+    mutable bool _changed = false;
+
+    int batchDepth = 0;
+    // True if update() was called with a change during the batch
+    bool signalDeferred = false;
+    // Positions passed to updatePosition during a batch that have not been applied yet
+    mutable vme_unordered_set<Position> pendingPositions;
+    size_t _coalescedNotifications = 0;
 
     Map &map;
     MapView &mapView;
 
-    SelectionStorageOctree storage;
+    // See Settings::INTERVAL_SELECTION_STORAGE
+    std::unique_ptr<SelectionStorage> storage;
 };
 
 inline std::vector<Position> Selection::allPositions() const
 {
-    return storage.allPositions();
+    applyPendingUpdates();
+    return storage->allPositions();
 }
 
 inline std::optional<Position> Selection::onlyPosition() const
 {
-    return storage.onlyPosition();
+    applyPendingUpdates();
+    return storage->onlyPosition();
+}
+
+inline std::vector<SelectionSpan> Selection::spans() const
+{
+    applyPendingUpdates();
+    return storage->spans();
 }
 
 template <auto MemberFunction, typename T>
@@ -8,4 +8,9 @@ int Settings::DEFAULT_CREATURE_SPAWN_INTERVAL = 60;
 bool Settings::HIGHLIGHT_BRUSH_IN_PALETTE_ON_SELECT = false;
 bool Settings::RENDER_ANIMATIONS = false;
 bool Settings::PLACE_MOUNTAIN_FEATURES = false;
+bool Settings::SHAPED_GROUND_BRUSHES = false;
+bool Settings::HOT_TEXTURE_ATLASES = false;
+bool Settings::CACHE_THUMBNAILS_ON_DISK = false;
+bool Settings::INTERVAL_SELECTION_STORAGE = false;
 int Settings::BRUSH_INSERTION_OFFSET = 0;
+int Settings::HISTORY_MEMORY_BUDGET_MB = 512;
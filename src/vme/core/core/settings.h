@@ -25,4 +25,35 @@ struct Settings
     static bool RENDER_ANIMATIONS;
 
     static bool PLACE_MOUNTAIN_FEATURES;
+
+    /**
+     * @brief If true, ground brushes paint the whole brush shape (see Brushes::brushShape) instead of a single tile.
+     * The area that the shape covers between two mouse samples is placed and borderized as one batch.
+     */
+    static bool SHAPED_GROUND_BRUSHES;
+
+    /**
+     * @brief If true, the renderer moves frequently drawn sprites into larger "hot" texture atlases at runtime.
+     * This reduces the number of atlases bound per frame. It does not reduce decompressed texture memory, since
+     * the client atlases stay loaded for lookups by sprite ID. See HotAtlasRepacker.
+     */
+    static bool HOT_TEXTURE_ATLASES;
+
+    /**
+     * @brief If true, item thumbnails for the palettes are also stored on disk so that they do not have to be
+     * created from the texture atlases in later sessions. See ThumbnailCache.
+     */
+    static bool CACHE_THUMBNAILS_ON_DISK;
+
+    /**
+     * @brief If true, the selection is stored as x-intervals per row instead of in an octree. This uses far less
+     * memory for large rectangular selections. See SelectionStorageIntervals.
+     */
+    static bool INTERVAL_SELECTION_STORAGE;
+
+    /**
+     * @brief Memory budget of the undo history of each map view, in megabytes. Older transactions over the budget
+     * are moved to a file in the temporary directory or dropped. See MapHistory::History::setMemoryBudget.
+     */
+    static int HISTORY_MEMORY_BUDGET_MB;
 };
\ No newline at end of file
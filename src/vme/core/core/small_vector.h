@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "debug.h"
+
+/*
+    A vector that stores up to N elements inline, and only allocates when it grows past that. Used for small
+    per-tile lists (like the border layers of a tile) that are created and dropped in hot loops.
+
+    Limited to trivially copyable types, so that elements can be moved with memcpy.
+*/
+template <typename T, size_t N>
+class SmallVector
+{
+    static_assert(N > 0, "SmallVector needs an inline capacity.");
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "SmallVector only supports trivially copyable types.");
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "SmallVector does not support over-aligned types.");
+
+  public:
+    using value_type = T;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    SmallVector() = default;
+
+    SmallVector(std::initializer_list<T> values)
+    {
+        reserve(values.size());
+        for (const T &value : values)
+        {
+            push_back(value);
+        }
+    }
+
+    SmallVector(const SmallVector &other)
+    {
+        assign(other);
+    }
+
+    SmallVector(SmallVector &&other) noexcept
+    {
+        take(other);
+    }
+
+    SmallVector &operator=(const SmallVector &other)
+    {
+        if (this != &other)
+        {
+            _size = 0;
+            assign(other);
+        }
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        release();
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (_size == _capacity)
+        {
+            // The arguments may refer to an element of this vector (like v.push_back(v.back())), and grow frees
+            // the elements, so the new element is constructed first.
+            T value(std::forward<Args>(args)...);
+            grow(_capacity * 2);
+
+            T *element = ::new (static_cast<void *>(_data + _size)) T(value);
+            ++_size;
+            return *element;
+        }
+
+        T *element = ::new (static_cast<void *>(_data + _size)) T(std::forward<Args>(args)...);
+        ++_size;
+        return *element;
+    }
+
+    void push_back(const T &value)
+    {
+        emplace_back(value);
+    }
+
+    void pop_back()
+    {
+        DEBUG_ASSERT(_size > 0, "pop_back on an empty SmallVector.");
+        --_size;
+    }
+
+    iterator erase(const_iterator position)
+    {
+        auto index = static_cast<size_t>(position - _data);
+        DEBUG_ASSERT(index < _size, "Erased position is out of range.");
+
+        std::memmove(static_cast<void *>(_data + index), _data + index + 1, (_size - index - 1) * sizeof(T));
+        --_size;
+        return _data + index;
+    }
+
+    // Keeps the capacity, so that a cleared vector can be refilled without allocating.
+    void clear() noexcept
+    {
+        _size = 0;
+    }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity > _capacity)
+        {
+            grow(capacity);
+        }
+    }
+
+    T &operator[](size_t index)
+    {
+        return _data[index];
+    }
+
+    const T &operator[](size_t index) const
+    {
+        return _data[index];
+    }
+
+    T &back()
+    {
+        return _data[_size - 1];
+    }
+
+    const T &back() const
+    {
+        return _data[_size - 1];
+    }
+
+    T *data() noexcept
+    {
+        return _data;
+    }
+
+    const T *data() const noexcept
+    {
+        return _data;
+    }
+
+    iterator begin() noexcept
+    {
+        return _data;
+    }
+
+    iterator end() noexcept
+    {
+        return _data + _size;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return _data;
+    }
+
+    const_iterator end() const noexcept
+    {
+        return _data + _size;
+    }
+
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    // True if the elements are stored inline, without a heap allocation.
+    bool isInline() const noexcept
+    {
+        return _data == inlineData();
+    }
+
+    friend bool operator==(const SmallVector &lhs, const SmallVector &rhs)
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+  private:
+    T *inlineData() noexcept
+    {
+        return reinterpret_cast<T *>(inlineStorage);
+    }
+
+    const T *inlineData() const noexcept
+    {
+        return reinterpret_cast<const T *>(inlineStorage);
+    }
+
+    void grow(size_t capacity)
+    {
+        T *data = static_cast<T *>(::operator new(capacity * sizeof(T)));
+        if (_size > 0)
+        {
+            std::memcpy(static_cast<void *>(data), _data, _size * sizeof(T));
+        }
+
+        release();
+        _data = data;
+        _capacity = capacity;
+    }
+
+    void assign(const SmallVector &other)
+    {
+        reserve(other._size);
+        if (other._size > 0)
+        {
+            std::memcpy(static_cast<void *>(_data), other._data, other._size * sizeof(T));
+        }
+        _size = other._size;
+    }
+
+    // Expects this vector to hold no heap allocation
+    void take(SmallVector &other) noexcept
+    {
+        if (other.isInline())
+        {
+            _data = inlineData();
+            _capacity = N;
+            if (other._size > 0)
+            {
+                std::memcpy(static_cast<void *>(_data), other._data, other._size * sizeof(T));
+            }
+        }
+        else
+        {
+            _data = other._data;
+            _capacity = other._capacity;
+
+            other._data = other.inlineData();
+            other._capacity = N;
+        }
+
+        _size = other._size;
+        other._size = 0;
+    }
+
+    // Frees the heap allocation, if any, and goes back to the inline storage.
+    void release() noexcept
+    {
+        if (!isInline())
+        {
+            ::operator delete(static_cast<void *>(_data));
+            _data = inlineData();
+            _capacity = N;
+        }
+    }
+
+    alignas(T) std::byte inlineStorage[N * sizeof(T)];
+    T *_data = inlineData();
+    size_t _size = 0;
+    size_t _capacity = N;
+};
@@ -321,27 +321,54 @@ void Tile::moveItemsWithBroadcast(Tile &other)
 
 void Tile::moveSelected(Tile &other)
 {
+    other.addSelected(dropSelected());
+}
+
+Tile::SelectedThings Tile::dropSelected()
+{
+    SelectedThings things;
+
     if (_ground && _ground->selected)
     {
-        other.clearItems();
-        other.removeCreature();
-        other.setGround(dropGround());
+        things.ground = dropGround();
     }
 
     if (_creature && _creature->selected)
     {
-        other.setCreature(dropCreature());
+        things.creature = dropCreature();
     }
 
     std::erase_if(_items, [&](const auto &item) {
         if (item->selected)
         {
-            other.addItem(std::move(item));
+            things.items.emplace_back(item);
             --_selectionCount;
             return true;
         }
         return false;
     });
+
+    return things;
+}
+
+void Tile::addSelected(SelectedThings &&things)
+{
+    if (things.ground)
+    {
+        clearItems();
+        removeCreature();
+        setGround(std::move(things.ground));
+    }
+
+    if (things.creature)
+    {
+        setCreature(std::move(things.creature));
+    }
+
+    for (auto &item : things.items)
+    {
+        addItem(std::move(item));
+    }
 }
 
 Item *Tile::itemAt(size_t index)
@@ -356,11 +383,17 @@ Item *Tile::itemAt(size_t index) const
 
 void Tile::insertItem(std::shared_ptr<Item> item, size_t index)
 {
+    if (item->selected)
+        ++_selectionCount;
+
     _items.emplace(_items.begin() + index, item);
 }
 
 void Tile::insertItem(Item &&item, size_t index)
 {
+    if (item.selected)
+        ++_selectionCount;
+
     _items.emplace(_items.begin() + index, std::make_shared<Item>(std::move(item)));
 }
 
@@ -928,6 +961,19 @@ Tile Tile::copyForHistory() const
     return tile;
 }
 
+void Tile::recountSelection()
+{
+    size_t count = std::ranges::count_if(_items, [](const std::shared_ptr<Item> &item) { return item->selected; });
+    if (_ground && _ground->selected)
+        ++count;
+
+    if (_creature && _creature->selected)
+        ++count;
+
+    DEBUG_ASSERT(count < UINT16_MAX, "Count too large.");
+    _selectionCount = static_cast<uint16_t>(count);
+}
+
 Tile Tile::deepCopy(Position newPosition) const
 {
     Tile tile(newPosition);
@@ -1237,9 +1283,8 @@ TileCover Tile::getTileCover(const MountainBrush *brush) const
     return result;
 }
 
-TileBorderBlock Tile::getFullBorderTileCover(TileCover excludeMask) const
+GroundBrush *Tile::borderGround() const
 {
-    TileBorderBlock block;
     if (_ground)
     {
         ItemType *itemType = _ground->itemType;
@@ -1273,32 +1318,61 @@ TileBorderBlock Tile::getFullBorderTileCover(TileCover excludeMask) const
             if (brush->type() == BrushType::Ground)
             {
                 auto *groundBrush = static_cast<GroundBrush *>(brush);
-                block.ground = groundBrush;
+                return groundBrush;
             }
         }
     }
 
+    return nullptr;
+}
+
+template <typename F>
+void Tile::forEachBorderItemCover(F &&f) const
+{
     for (const auto &item : _items)
     {
         ItemType *itemType = item->itemType;
 
         if (!itemType->isBorder())
-            return block;
+            return;
 
         auto brush = itemType->getBrush(BrushType::Border);
 
         if (brush)
         {
             auto borderBrush = static_cast<BorderBrush *>(brush);
-            auto cover = borderBrush->getTileCover(item->serverId());
-            cover &= ~(excludeMask);
-
-            if (cover != TILE_COVER_NONE)
-            {
-                block.add(cover, borderBrush);
-            }
+            f(borderBrush->getTileCover(item->serverId()), borderBrush);
         }
     }
+}
+
+TileBorderBlock Tile::getFullBorderTileCover(TileCover excludeMask) const
+{
+    TileBorderBlock block;
+    block.ground = borderGround();
+
+    forEachBorderItemCover([&block, excludeMask](TileCover cover, BorderBrush *brush) {
+        cover &= ~(excludeMask);
+        if (cover != TILE_COVER_NONE)
+        {
+            block.add(cover, brush);
+        }
+    });
+
+    return block;
+}
+
+TileBorderBlock Tile::getBorderItemCovers() const
+{
+    TileBorderBlock block;
+    block.ground = borderGround();
+
+    forEachBorderItemCover([&block](TileCover cover, BorderBrush *brush) {
+        if (cover != TILE_COVER_NONE)
+        {
+            block.covers.emplace_back(cover, brush);
+        }
+    });
 
     return block;
 }
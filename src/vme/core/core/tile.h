@@ -18,6 +18,12 @@ class WallBrush;
 class GroundBrush;
 struct TileBorderBlock;
 
+namespace MapHistory
+{
+    class SpillWriter;
+    class SpillReader;
+}
+
 struct BorderCover
 {
     BorderCover(TileCover cover, BorderBrush *brush);
@@ -31,6 +37,16 @@ using TileThing = std::variant<std::monostate, Item *, Creature *>;
 class Tile
 {
   public:
+    /*
+        The selected things of a tile, taken out of it with dropSelected.
+    */
+    struct SelectedThings
+    {
+        std::shared_ptr<Item> ground;
+        std::shared_ptr<Creature> creature;
+        std::vector<std::shared_ptr<Item>> items;
+    };
+
     Tile(Position position);
 
     Tile(TileLocation &location);
@@ -50,10 +66,25 @@ class Tile
 
     /**
      * @brief Creates a copy of the tile for history purposes.
-     * @details This does NOT create a deep copy!
+     * @details This does NOT create a deep copy! The copy shares its items and creature with this tile.
+     * Edits replace the tile in the map with a modified copy and keep the previous version in the history,
+     * so the copy may be restructured (items added, removed or replaced), but shared items must not be changed
+     * in place unless the change is itself recorded in the history.
+     *
+     * A shared item stays consistent across the versions only as long as every version refers to the same item:
+     * undoing the recorded in-place changes in order then restores it for each version. Anything that replaces
+     * a shared item with a copy breaks this. This is why the history never spills an item that is shared (see
+     * MapHistory::SpillWriter::canWrite), and why a version that is kept must never be deep-copied in its place.
      */
     Tile copyForHistory() const;
 
+    /**
+     * @brief Recomputes the selection count from the selected flags of the things on the tile.
+     * @details Selection flags live on the (shared) items, so a tile version that was kept in the history
+     * can have a stale count when it is put back into the map.
+     */
+    void recountSelection();
+
     void merge(const Tile &tile);
 
     inline bool itemSelected(uint16_t itemIndex) const
@@ -107,6 +138,13 @@ class Tile
     void moveItems(Tile &other);
     void moveItemsWithBroadcast(Tile &other);
     void moveSelected(Tile &other);
+
+    /*
+        dropSelected followed by addSelected on another tile is the same as moveSelected. Splitting the two lets
+        many tiles be moved at once without the order of the moves mattering.
+    */
+    SelectedThings dropSelected();
+    void addSelected(SelectedThings &&things);
     void clearItems();
     void clearAll();
     void clearBorders();
@@ -150,6 +188,12 @@ class Tile
 
     TileBorderBlock getFullBorderTileCover(TileCover excludeMask) const;
 
+    /*
+        The border covers of the tile without merging them by brush: one cover per border item, in stack order.
+        Merging them with an exclude mask gives getFullBorderTileCover(excludeMask).
+    */
+    TileBorderBlock getBorderItemCovers() const;
+
     bool hasItems() const;
     inline bool hasGround() const noexcept;
     bool hasBlockingItem() const noexcept;
@@ -169,6 +213,12 @@ class Tile
         return _items;
     }
 
+    // The ground, as it is shared with other versions of the tile (see copyForHistory)
+    const std::shared_ptr<Item> &sharedGround() const noexcept
+    {
+        return _ground;
+    }
+
     const size_t itemCount() const noexcept
     {
         return _items.size();
@@ -214,6 +264,8 @@ class Tile
 
   private:
     friend class MapView;
+    friend class MapHistory::SpillWriter;
+    friend class MapHistory::SpillReader;
 
     void deepCopyInto(Tile &tile, bool onlySelected) const;
 
@@ -225,6 +277,13 @@ class Tile
     Item *replaceItem(size_t index, Item &&item);
     Creature *replaceCreature(Creature &&creature);
 
+    // The ground brush that the borders of the tile are computed from. For a mountain ground, its ground brush.
+    GroundBrush *borderGround() const;
+
+    // Calls f(cover, brush) for the border items at the bottom of the stack.
+    template <typename F>
+    void forEachBorderItemCover(F &&f) const;
+
     /**
      * These are shared pointers because they are shared with the history system.
      */
@@ -1,6 +1,136 @@
 #include "tile_cover.h"
 
+#include <bit>
 #include <sstream>
+#include <vector>
+
+namespace
+{
+    constexpr size_t QuadrantCount = 4;
+    // None, or one of the four diagonals
+    constexpr size_t PreferredDiagonalCount = 5;
+
+    enum MirrorTable
+    {
+        MirrorNorthCorner,
+        MirrorNorth,
+        MirrorEast,
+        MirrorSouth,
+        MirrorWest,
+        MirrorTableCount
+    };
+
+    struct TileCoverTables
+    {
+        TileCoverTables();
+
+        // Indexed by [quadrant][preferred diagonal][cover]
+        std::vector<uint16_t> unified;
+        std::array<std::array<uint16_t, TileCovers::CoverCount>, MirrorTableCount> mirrored;
+    };
+
+    TileCoverTables::TileCoverTables()
+        : unified(QuadrantCount * PreferredDiagonalCount * TileCovers::CoverCount)
+    {
+        using namespace TileCoverShortHands;
+
+        constexpr std::array<TileCover, PreferredDiagonalCount> preferredDiagonals = {None, NorthWest, NorthEast, SouthWest, SouthEast};
+
+        for (size_t quadrant = 0; quadrant < QuadrantCount; ++quadrant)
+        {
+            for (size_t preferred = 0; preferred < PreferredDiagonalCount; ++preferred)
+            {
+                uint16_t *table = &unified[(quadrant * PreferredDiagonalCount + preferred) * TileCovers::CoverCount];
+                for (size_t cover = 0; cover < TileCovers::CoverCount; ++cover)
+                {
+                    table[cover] = static_cast<uint16_t>(TileCovers::computeUnifiedTileCover(
+                        static_cast<TileCover>(cover), static_cast<TileQuadrant>(1 << quadrant), preferredDiagonals[preferred]));
+                }
+            }
+        }
+
+        for (size_t cover = 0; cover < TileCovers::CoverCount; ++cover)
+        {
+            TileCover value = static_cast<TileCover>(cover);
+            mirrored[MirrorNorthCorner][cover] = static_cast<uint16_t>(TileCovers::computeMirrorNorth(value, true));
+            mirrored[MirrorNorth][cover] = static_cast<uint16_t>(TileCovers::computeMirrorNorth(value, false));
+            mirrored[MirrorEast][cover] = static_cast<uint16_t>(TileCovers::computeMirrorEast(value));
+            mirrored[MirrorSouth][cover] = static_cast<uint16_t>(TileCovers::computeMirrorSouth(value));
+            mirrored[MirrorWest][cover] = static_cast<uint16_t>(TileCovers::computeMirrorWest(value));
+        }
+    }
+
+    const TileCoverTables &tables()
+    {
+        static const TileCoverTables tileCoverTables;
+        return tileCoverTables;
+    }
+
+    // Returns PreferredDiagonalCount if there is no table for the diagonal.
+    size_t preferredDiagonalIndex(TileCover preferredDiagonal)
+    {
+        using namespace TileCoverShortHands;
+
+        switch (preferredDiagonal)
+        {
+            case None:
+                return 0;
+            case NorthWest:
+                return 1;
+            case NorthEast:
+                return 2;
+            case SouthWest:
+                return 3;
+            case SouthEast:
+                return 4;
+            default:
+                return PreferredDiagonalCount;
+        }
+    }
+
+    TileCover mirrorLookup(MirrorTable table, TileCover cover)
+    {
+        return static_cast<TileCover>(tables().mirrored[table][cover]);
+    }
+} // namespace
+
+void TileCovers::initializeLookupTables()
+{
+    tables();
+}
+
+TileCover TileCovers::unifyTileCover(TileCover cover, TileQuadrant quadrant, TileCover preferredDiagonal)
+{
+    auto quadrantBits = static_cast<unsigned>(quadrant);
+    size_t preferred = preferredDiagonalIndex(preferredDiagonal);
+    if (static_cast<unsigned>(cover) >= CoverCount || !std::has_single_bit(quadrantBits) || quadrantBits >= (1u << QuadrantCount) || preferred == PreferredDiagonalCount)
+    {
+        return computeUnifiedTileCover(cover, quadrant, preferredDiagonal);
+    }
+
+    size_t quadrantIndex = std::countr_zero(quadrantBits);
+    return static_cast<TileCover>(tables().unified[(quadrantIndex * PreferredDiagonalCount + preferred) * CoverCount + cover]);
+}
+
+TileCover TileCovers::mirrorNorth(TileCover tileCover, bool corner)
+{
+    return mirrorLookup(corner ? MirrorNorthCorner : MirrorNorth, tileCover);
+}
+
+TileCover TileCovers::mirrorEast(TileCover cover)
+{
+    return mirrorLookup(MirrorEast, cover);
+}
+
+TileCover TileCovers::mirrorSouth(TileCover tileCover)
+{
+    return mirrorLookup(MirrorSouth, tileCover);
+}
+
+TileCover TileCovers::mirrorWest(TileCover cover)
+{
+    return mirrorLookup(MirrorWest, cover);
+}
 
 void TileCovers::clearCoverFlags(TileCover &cover, TileCover flags)
 {
@@ -110,7 +240,7 @@ TileCover TileCovers::mergeTileCover(TileCover a, TileCover b)
     }
 }
 
-TileCover TileCovers::unifyTileCover(TileCover cover, TileQuadrant quadrant, TileCover preferredDiagonal)
+TileCover TileCovers::computeUnifiedTileCover(TileCover cover, TileQuadrant quadrant, TileCover preferredDiagonal)
 {
     // DEBUG_ASSERT((preferredDiagonal == None) || exactlyOneSet(preferredDiagonal & Diagonals), "Preferred diagonal must be None or have exactly one diagonal set.");
 
@@ -267,7 +397,7 @@ TileCover TileCovers::unifyTileCover(TileCover cover, TileQuadrant quadrant, Til
     return cover;
 }
 
-TileCover TileCovers::mirrorEast(TileCover cover)
+TileCover TileCovers::computeMirrorEast(TileCover cover)
 {
     if (cover & FullEast)
     {
@@ -349,7 +479,7 @@ TileCover TileCovers::mirrorWest(TileCover source, TileCover cover)
     }
 }
 
-TileCover TileCovers::mirrorWest(TileCover cover)
+TileCover TileCovers::computeMirrorWest(TileCover cover)
 {
     if (cover & FullWest)
     {
@@ -369,7 +499,7 @@ TileCover TileCovers::mirrorWest(TileCover cover)
     return result;
 }
 
-TileCover TileCovers::mirrorNorth(TileCover tileCover, bool corner)
+TileCover TileCovers::computeMirrorNorth(TileCover tileCover, bool corner)
 {
     if (tileCover & FullNorth)
     {
@@ -389,7 +519,7 @@ TileCover TileCovers::mirrorNorth(TileCover tileCover, bool corner)
     return result;
 }
 
-TileCover TileCovers::mirrorSouth(TileCover tileCover)
+TileCover TileCovers::computeMirrorSouth(TileCover tileCover)
 {
     if (tileCover & FullSouth)
     {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <stdint.h>
 #include <string>
 #include <type_traits>
 
@@ -84,6 +86,23 @@ class TileCovers
     static TileCover mirrorWest(TileCover cover);
     static TileCover mirrorWest(TileCover source, TileCover cover);
     static TileCover unifyTileCover(TileCover cover, TileQuadrant quadrant, TileCover preferredDiagonal = TILE_COVER_NONE);
+
+    /*
+        unifyTileCover and the single-cover mirror functions are lookups in tables that are computed once from the
+        compute* functions below (about 400 KB). There is a table entry for every cover, quadrant and preferred
+        diagonal (none or exactly one diagonal); other arguments are computed directly.
+        The tables are built on first use, or by initializeLookupTables (done when the brushes are loaded).
+    */
+    static void initializeLookupTables();
+
+    static TileCover computeUnifiedTileCover(TileCover cover, TileQuadrant quadrant, TileCover preferredDiagonal = TILE_COVER_NONE);
+    static TileCover computeMirrorNorth(TileCover tileCover, bool corner = true);
+    static TileCover computeMirrorEast(TileCover cover);
+    static TileCover computeMirrorSouth(TileCover tileCover);
+    static TileCover computeMirrorWest(TileCover cover);
+
+    // Every cover is a combination of the 13 TileCover flags.
+    static constexpr size_t CoverCount = 1 << 13;
     static TileCover mergeTileCover(TileCover a, TileCover b);
     static bool exactlyOneSet(TileCover cover)
     {
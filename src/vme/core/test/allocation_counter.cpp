@@ -0,0 +1,40 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local size_t allocations = 0;
+} // namespace
+
+void *operator new(size_t size)
+{
+    ++allocations;
+
+    void *memory = std::malloc(size == 0 ? 1 : size);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+AllocationCounter::AllocationCounter()
+    : start(allocations) {}
+
+size_t AllocationCounter::count() const noexcept
+{
+    return allocations - start;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+    Counts the heap allocations (calls to operator new) that the current thread makes while it is alive. The test
+    executable replaces the global operator new to make this possible (see allocation_counter.cpp).
+*/
+class AllocationCounter
+{
+  public:
+    AllocationCounter();
+
+    size_t count() const noexcept;
+
+  private:
+    size_t start;
+};
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "core/brushes/brush.h"
+#include "core/brushes/brush_footprint.h"
+#include "core/position.h"
+
+namespace
+{
+    std::set<std::pair<int, int>> tilesOf(const BrushFootprint &footprint)
+    {
+        std::set<std::pair<int, int>> tiles;
+        footprint.forEachPosition(7, [&tiles](const Position &position) { tiles.emplace(position.x, position.y); });
+        return tiles;
+    }
+
+    void requireContainsExactly(const BrushFootprint &footprint, const std::set<std::pair<int, int>> &tiles)
+    {
+        REQUIRE(footprint.size() == tiles.size());
+        REQUIRE(tilesOf(footprint) == tiles);
+
+        for (int y = -20; y <= 20; ++y)
+        {
+            for (int x = -20; x <= 20; ++x)
+            {
+                REQUIRE(footprint.contains(x, y) == tiles.contains({x, y}));
+            }
+        }
+    }
+} // namespace
+
+TEST_CASE("brush_footprint.h", "[core][brush]")
+{
+    SECTION("Overlapping and touching spans are merged")
+    {
+        BrushFootprint footprint({{1, 4, 6}, {0, 0, 2}, {1, 0, 3}, {1, 8, 9}, {0, 1, 1}});
+
+        REQUIRE(footprint.spans().size() == 3);
+        requireContainsExactly(footprint, {{0, 0}, {1, 0}, {2, 0}, {0, 1}, {1, 1}, {2, 1}, {3, 1}, {4, 1}, {5, 1}, {6, 1}, {8, 1}, {9, 1}});
+
+        REQUIRE(footprint.minX() == 0);
+        REQUIRE(footprint.maxX() == 9);
+        REQUIRE(footprint.minY() == 0);
+        REQUIRE(footprint.maxY() == 1);
+    }
+
+    SECTION("A swept footprint is the union of the translated footprints")
+    {
+        // A plus shape moved along a diagonal and back
+        BrushFootprint plus({{-1, 0, 0}, {0, -1, 1}, {1, 0, 0}});
+        std::vector<Position> path = {Position(0, 0, 7), Position(1, 1, 7), Position(2, 2, 7), Position(5, -3, 7)};
+
+        std::set<std::pair<int, int>> expected;
+        for (const Position &position : path)
+        {
+            for (const auto &[x, y] : tilesOf(plus))
+            {
+                expected.emplace(x + position.x, y + position.y);
+            }
+        }
+
+        requireContainsExactly(plus.sweep(path), expected);
+    }
+
+    SECTION("expanded and clipped")
+    {
+        auto footprint = BrushFootprint::rectangle(0, 0, 2, 1);
+
+        std::set<std::pair<int, int>> expanded;
+        for (int y = -1; y <= 2; ++y)
+        {
+            for (int x = -1; x <= 3; ++x)
+            {
+                expanded.emplace(x, y);
+            }
+        }
+        requireContainsExactly(footprint.expanded(1), expanded);
+
+        requireContainsExactly(footprint.clipped(1, 1, 10, 10), {{1, 1}, {2, 1}});
+        REQUIRE(footprint.clipped(5, 5, 10, 10).empty());
+    }
+
+    SECTION("An empty footprint contains nothing")
+    {
+        BrushFootprint footprint;
+        REQUIRE(footprint.empty());
+        REQUIRE(footprint.size() == 0);
+        REQUIRE(!footprint.contains(0, 0));
+        REQUIRE(footprint.sweep({Position(0, 0, 7)}).empty());
+    }
+}
+
+TEST_CASE("Brush shape footprints", "[core][brush]")
+{
+    SECTION("A rectangular shape of size N covers N x N tiles around the brush position")
+    {
+        for (uint16_t size = 1; size <= 3; ++size)
+        {
+            RectangularBrushShape shape(size, size);
+            const BrushFootprint &footprint = shape.footprint();
+
+            REQUIRE(footprint.size() == static_cast<size_t>(size) * size);
+            REQUIRE(footprint.contains(0, 0));
+            REQUIRE(footprint.maxX() - footprint.minX() + 1 == size);
+            REQUIRE(footprint.maxY() - footprint.minY() + 1 == size);
+        }
+
+        REQUIRE(RectangularBrushShape(3, 2).footprint().size() == 6);
+        requireContainsExactly(RectangularBrushShape(3, 3).footprint(), {{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}});
+    }
+
+    SECTION("A circular shape covers the tiles within its radius")
+    {
+        REQUIRE(CircularBrushShape(0).footprint().size() == 1);
+        REQUIRE(CircularBrushShape(1).footprint().size() == 5);
+        REQUIRE(CircularBrushShape(2).footprint().size() == 13);
+        REQUIRE(CircularBrushShape(3).footprint().size() == 29);
+
+        requireContainsExactly(CircularBrushShape(1).footprint(), {{0, -1}, {-1, 0}, {0, 0}, {1, 0}, {0, 1}});
+    }
+}
@@ -0,0 +1,125 @@
+#include "catch.hpp"
+
+#include <memory>
+#include <vector>
+
+#include "core/brushes/brushes.h"
+#include "core/brushes/doodad_brush.h"
+#include "test_items.h"
+#include "test_map_view.h"
+
+using TestItems::Kind;
+
+namespace
+{
+    // A doodad of two blocking items side by side: the first at the position of the doodad, the second east of it.
+    DoodadBrush *doodadPair()
+    {
+        static DoodadBrush *brush = [] {
+            std::vector<DoodadBrush::CompositeTile> tiles{
+                DoodadBrush::CompositeTile{0, 0, 0, TestItems::doodadId(0)},
+                DoodadBrush::CompositeTile{1, 0, 0, TestItems::doodadId(1)}};
+
+            std::vector<std::unique_ptr<DoodadBrush::DoodadEntry>> choices;
+            choices.emplace_back(std::make_unique<DoodadBrush::DoodadComposite>(std::move(tiles), 1));
+
+            return Brushes::addDoodadBrush(std::make_unique<DoodadBrush>(
+                "test_doodad_pair", "Test doodad pair", DoodadBrush::DoodadAlternative(std::move(choices)), TestItems::doodadId(0)));
+        }();
+
+        return brush;
+    }
+
+    void addGrounds(MapView &mapView, const Position &from, const Position &to)
+    {
+        for (int y = from.y; y <= to.y; ++y)
+        {
+            for (int x = from.x; x <= to.x; ++x)
+            {
+                mapView.getOrCreateTile(Position(x, y, from.z)).addItem(Item(TestItems::id(Kind::Ground)));
+            }
+        }
+    }
+
+    void applyInRegion(MapView &mapView, DoodadBrush &brush, const Position &from, const Position &to)
+    {
+        mapView.beginTransaction(TransactionType::AddMapItem);
+        brush.applyInRegion(mapView, from, to, 1.0f);
+        mapView.endTransaction(TransactionType::AddMapItem);
+    }
+} // namespace
+
+TEST_CASE("doodad_brush.h applyInRegion", "[core][brush]")
+{
+    DoodadBrush &brush = *doodadPair();
+    auto mapView = makeTestMapView();
+
+    const uint32_t west = TestItems::doodadId(0);
+    const uint32_t east = TestItems::doodadId(1);
+
+    auto items = [&mapView](const Position &position) {
+        return tileContents(*mapView, position).value().items;
+    };
+
+    SECTION("Overlapping doodads are placed once")
+    {
+        addGrounds(*mapView, Position(10, 10, 7), Position(12, 10, 7));
+        const auto before = tileContents(*mapView, std::vector{Position(10, 10, 7), Position(11, 10, 7), Position(12, 10, 7)});
+
+        // The doodad at 11 would cover the east tile of the doodad at 10.
+        applyInRegion(*mapView, brush, Position(10, 10, 7), Position(11, 10, 7));
+
+        REQUIRE(items(Position(10, 10, 7)) == std::vector{west});
+        REQUIRE(items(Position(11, 10, 7)) == std::vector{east});
+        REQUIRE(items(Position(12, 10, 7)).empty());
+
+        mapView->undo();
+        REQUIRE(tileContents(*mapView, std::vector{Position(10, 10, 7), Position(11, 10, 7), Position(12, 10, 7)}) == before);
+    }
+
+    SECTION("Positions without a tile are not blocked, like in apply")
+    {
+        applyInRegion(*mapView, brush, Position(20, 20, 7), Position(20, 20, 7));
+
+        REQUIRE(items(Position(20, 20, 7)) == std::vector{west});
+        REQUIRE(items(Position(21, 20, 7)) == std::vector{east});
+
+        mapView->undo();
+        REQUIRE(!mapView->hasTile(Position(20, 20, 7)));
+        REQUIRE(!mapView->hasTile(Position(21, 20, 7)));
+    }
+
+    SECTION("Tiles without a ground are blocked")
+    {
+        mapView->getOrCreateTile(Position(31, 30, 7)).addItem(Item(TestItems::id(Kind::Normal)));
+        addGrounds(*mapView, Position(30, 30, 7), Position(30, 30, 7));
+
+        applyInRegion(*mapView, brush, Position(30, 30, 7), Position(30, 30, 7));
+
+        REQUIRE(items(Position(30, 30, 7)).empty());
+        REQUIRE(items(Position(31, 30, 7)) == std::vector{TestItems::id(Kind::Normal)});
+    }
+
+    SECTION("Tiles with this doodad are blocked, unless it is replaced")
+    {
+        addGrounds(*mapView, Position(40, 40, 7), Position(41, 41, 7));
+        // This doodad at the first row, and another blocking item at the second row
+        mapView->getTile(Position(41, 40, 7))->addItem(Item(east));
+        mapView->getTile(Position(41, 41, 7))->addItem(Item(TestItems::id(Kind::Blocking)));
+
+        applyInRegion(*mapView, brush, Position(40, 40, 7), Position(40, 41, 7));
+        REQUIRE(items(Position(40, 40, 7)).empty());
+        REQUIRE(items(Position(41, 40, 7)) == std::vector{east});
+        REQUIRE(items(Position(40, 41, 7)).empty());
+
+        brush.replaceBehavior = DoodadBrush::ReplaceBehavior::Replace;
+        applyInRegion(*mapView, brush, Position(40, 40, 7), Position(40, 41, 7));
+        brush.replaceBehavior = DoodadBrush::ReplaceBehavior::Block;
+
+        // The doodad on the first row is replaced, and the second row stays blocked.
+        REQUIRE(items(Position(40, 40, 7)) == std::vector{west});
+        REQUIRE(items(Position(41, 40, 7)) == std::vector{east});
+        REQUIRE(items(Position(40, 41, 7)).empty());
+        REQUIRE(items(Position(41, 41, 7)) == std::vector{TestItems::id(Kind::Blocking)});
+    }
+}
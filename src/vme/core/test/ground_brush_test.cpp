@@ -0,0 +1,284 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "allocation_counter.h"
+#include "core/brushes/brushes.h"
+#include "core/brushes/ground_brush.h"
+#include "core/tile_cover.h"
+#include "test_items.h"
+#include "test_map_view.h"
+
+namespace
+{
+    struct TestGrounds
+    {
+        GroundBrush *grass;
+        GroundBrush *sand;
+        GroundBrush *dirt;
+    };
+
+    // Grass and sand have outer borders towards any other ground, and grass is above sand. Dirt has no borders.
+    const TestGrounds &testGrounds()
+    {
+        static const TestGrounds grounds = [] {
+            int borderBrushes = 0;
+            auto addGround = [&borderBrushes](const std::string &id, int groundIndex, uint32_t zOrder, bool bordered) {
+                GroundBrush *ground = Brushes::addGroundBrush(std::make_unique<GroundBrush>(
+                    id, std::vector<WeightedItemId>{WeightedItemId(TestItems::groundId(groundIndex), 1)}, zOrder));
+
+                if (bordered)
+                {
+                    std::array<uint32_t, BORDER_COUNT_FOR_GROUND_TILE> borderIds;
+                    for (int i = 0; i < BORDER_COUNT_FOR_GROUND_TILE; ++i)
+                    {
+                        borderIds[i] = TestItems::borderId(borderBrushes * BORDER_COUNT_FOR_GROUND_TILE + i);
+                    }
+                    ++borderBrushes;
+
+                    BorderBrush *border = Brushes::addBorderBrush(BorderBrush(id + "_border", id + " border", borderIds, ground));
+                    ground->addBorder(GroundBorder{border, std::nullopt, BorderAlign::Outer});
+                }
+
+                return ground;
+            };
+
+            TestGrounds result;
+            result.grass = addGround("test_grass", 0, 300, true);
+            result.sand = addGround("test_sand", 1, 200, true);
+            result.dirt = addGround("test_dirt", 2, 100, false);
+            return result;
+        }();
+
+        return grounds;
+    }
+
+    std::vector<Position> positionsIn(const Position &from, const Position &to)
+    {
+        std::vector<Position> positions;
+        for (int y = from.y; y <= to.y; ++y)
+        {
+            for (int x = from.x; x <= to.x; ++x)
+            {
+                positions.emplace_back(x, y, from.z);
+            }
+        }
+
+        return positions;
+    }
+} // namespace
+
+TEST_CASE("ground_brush.h", "[core][brush]")
+{
+    using namespace TileCoverShortHands;
+
+    // The brushes are only compared by the neighbor map, never used.
+    std::array<int, 3> brushStorage{};
+    auto brush = [&brushStorage](int i) { return reinterpret_cast<BorderBrush *>(&brushStorage[i]); };
+
+    TileCovers::initializeLookupTables();
+
+    // Tiles with up to three border layers, and some with the same brush on several items
+    auto load = [&brush](const Position &position) {
+        TileBorderBlock block;
+        int layers = (position.x + 2 * position.y) % 4;
+        for (int i = 0; i < layers; ++i)
+        {
+            TileCover cover = (i % 2 == 0) ? (North | East) : (SouthWest | NorthWestCorner);
+            block.covers.emplace_back(cover, brush((position.x + i) % 2));
+        }
+        return block;
+    };
+
+    // Only the neighbor maps are checked: borderize itself allocates for the items and history changes it commits.
+    SECTION("Building neighbor maps during a drag does not allocate")
+    {
+        SlidingNeighborCache<TileBorderBlock> cache;
+        cache.moveTo(Position(100, 100, 7), load);
+
+        AllocationCounter allocations;
+        for (int x = 101; x < 200; ++x)
+        {
+            Position position(x, 100 + x % 3, 7);
+            cache.invalidate(position, 1);
+            cache.moveTo(position, load);
+
+            GroundNeighborMap neighbors(nullptr, cache);
+
+            TileBorderBlock merged = neighbors.at(0, 0);
+            merged.merge(neighbors.at(1, 0));
+            merged.merge(neighbors.at(0, 1));
+            neighbors.set(0, 0, merged);
+            neighbors.addExpandedCover(0, 0);
+        }
+
+        REQUIRE(allocations.count() == 0);
+    }
+
+    SECTION("The neighbor map merges the border layers of a tile by brush")
+    {
+        SlidingNeighborCache<TileBorderBlock> cache;
+        cache.moveTo(Position(10, 10, 7), load);
+
+        GroundNeighborMap neighbors(nullptr, cache);
+        for (int dy = -2; dy <= 2; ++dy)
+        {
+            for (int dx = -2; dx <= 2; ++dx)
+            {
+                const auto &block = neighbors.at(dx, dy).covers;
+                for (auto it = block.begin(); it != block.end(); ++it)
+                {
+                    REQUIRE(std::none_of(it + 1, block.end(), [it](const BorderCover &cover) { return cover.brush == it->brush; }));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ground_brush.h borderizeRegion", "[core][brush]")
+{
+    TileCovers::initializeLookupTables();
+    const TestGrounds &grounds = testGrounds();
+
+    const Position from(10, 10, 7);
+    const Position to(45, 62, 7);
+
+    // The region, its rim and the tiles that the rim reads
+    const auto positions = positionsIn(Position(7, 7, 7), Position(48, 65, 7));
+
+    // Patches of the three grounds and tiles without a ground, with stale grass borders on some tiles
+    auto createLayout = [&grounds, &positions](MapView &mapView) {
+        const std::array<GroundBrush *, 4> patches{grounds.grass, grounds.sand, grounds.dirt, nullptr};
+        for (const auto &position : positions)
+        {
+            uint32_t hash = (static_cast<uint32_t>(position.x / 3) * 73856093u) ^ (static_cast<uint32_t>(position.y / 2) * 19349663u);
+            size_t patch = (hash >> 4) % patches.size();
+            if (position.x * position.y % 5 == 0)
+            {
+                patch = (patch + 1) % patches.size();
+            }
+
+            Tile &tile = mapView.getOrCreateTile(position);
+            if (patches[patch])
+            {
+                tile.addItem(Item(patches[patch]->nextServerId()));
+            }
+
+            if ((hash >> 8) % 7 == 0)
+            {
+                tile.addItem(Item(TestItems::borderId(hash % BORDER_COUNT_FOR_GROUND_TILE)));
+            }
+        }
+    };
+
+    // A single band, then bands of fewer rows than the halo that each band reads around it, then a few rows
+    const std::array<GroundBrush::RegionBands, 3> bandings{
+        GroundBrush::RegionBands{std::numeric_limits<size_t>::max(), GroundBrush::regionBands.bandRows},
+        GroundBrush::RegionBands{0, 1},
+        GroundBrush::RegionBands{0, 3}};
+
+    std::array<std::unique_ptr<MapView>, 3> mapViews;
+    for (auto &mapView : mapViews)
+    {
+        mapView = makeTestMapView();
+        createLayout(*mapView);
+    }
+
+    auto &serial = *mapViews.front();
+    const auto before = tileContents(serial, positions);
+
+    // Runs 'f' on each map, with the region split into bands as in 'bandings'.
+    auto sweep = [&mapViews, &bandings](auto &&f) {
+        const GroundBrush::RegionBands defaultBands = GroundBrush::regionBands;
+        for (size_t i = 0; i < mapViews.size(); ++i)
+        {
+            GroundBrush::regionBands = bandings[i];
+            f(*mapViews[i]);
+        }
+        GroundBrush::regionBands = defaultBands;
+    };
+
+    auto requireSameTiles = [&mapViews, &positions]() {
+        const auto expected = tileContents(*mapViews.front(), positions);
+        for (size_t i = 1; i < mapViews.size(); ++i)
+        {
+            REQUIRE(tileContents(*mapViews[i], positions) == expected);
+        }
+    };
+
+    auto borderize = [&from, &to](MapView &mapView) {
+        mapView.beginTransaction(TransactionType::AddMapItem);
+        GroundBrush::borderizeRegion(mapView, from, to);
+        mapView.endTransaction(TransactionType::AddMapItem);
+    };
+
+    SECTION("Borderizing in bands gives the same tiles as borderizing in a single band")
+    {
+        sweep(borderize);
+
+        REQUIRE(tileContents(serial, positions) != before);
+        requireSameTiles();
+
+        serial.undo();
+        REQUIRE(tileContents(serial, positions) == before);
+    }
+
+    SECTION("Filling in bands gives the same tiles as filling in a single band")
+    {
+        auto fill = [&grounds](MapView &mapView) {
+            mapView.fillRegionByGroundBrush(Position(14, 12, 7), Position(30, 50, 7), grounds.grass);
+            mapView.fillRegionByGroundBrush(Position(25, 40, 7), Position(44, 61, 7), grounds.sand);
+        };
+
+        sweep(borderize);
+        sweep(fill);
+
+        requireSameTiles();
+        REQUIRE(tileContents(serial, Position(20, 20, 7))->ground == TestItems::groundId(0));
+        REQUIRE(tileContents(serial, Position(40, 55, 7))->ground == TestItems::groundId(1));
+    }
+}
+
+TEST_CASE("ground_brush.h applyInRegion borders the filled area", "[core][brush]")
+{
+    TileCovers::initializeLookupTables();
+    const TestGrounds &grounds = testGrounds();
+
+    auto mapView = makeTestMapView();
+    for (const auto &position : positionsIn(Position(10, 10, 7), Position(20, 20, 7)))
+    {
+        mapView->getOrCreateTile(position).addItem(Item(grounds.dirt->nextServerId()));
+    }
+
+    mapView->fillRegionByGroundBrush(Position(14, 14, 7), Position(16, 16, 7), grounds.grass);
+
+    auto isGrassBorder = [](uint32_t serverId) {
+        for (int i = 0; i < BORDER_COUNT_FOR_GROUND_TILE; ++i)
+        {
+            if (serverId == TestItems::borderId(i))
+                return true;
+        }
+        return false;
+    };
+
+    for (const auto &position : positionsIn(Position(10, 10, 7), Position(20, 20, 7)))
+    {
+        const auto contents = tileContents(*mapView, position).value();
+        bool filled = position.x >= 14 && position.x <= 16 && position.y >= 14 && position.y <= 16;
+        bool rim = !filled && position.x >= 13 && position.x <= 17 && position.y >= 13 && position.y <= 17;
+
+        REQUIRE(contents.ground == (filled ? TestItems::groundId(0) : TestItems::groundId(2)));
+        if (rim)
+        {
+            // Each tile around the grass gets one border: a side or a corner.
+            REQUIRE(contents.items.size() == 1);
+            REQUIRE(isGrassBorder(contents.items.front()));
+        }
+        else
+        {
+            REQUIRE(contents.items.empty());
+        }
+    }
+}
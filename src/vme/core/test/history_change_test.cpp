@@ -0,0 +1,254 @@
+#include "catch.hpp"
+
+#include <set>
+
+#include "core/history/history_change.h"
+#include "test_items.h"
+#include "test_map_view.h"
+
+using namespace MapHistory;
+using TestItems::Kind;
+
+namespace
+{
+    // A tile with a ground and four items, of which the ground and the second item are selected.
+    void createStack(MapView &mapView, const Position &position)
+    {
+        Tile &tile = mapView.getOrCreateTile(position);
+        tile.addItem(Item(TestItems::id(Kind::Ground)));
+        tile.addItem(Item(TestItems::id(Kind::Bottom)));
+        tile.addItem(Item(TestItems::id(Kind::Normal)));
+        tile.addItem(Item(TestItems::id(Kind::OtherNormal)));
+        tile.addItem(Item(TestItems::id(Kind::Top)));
+
+        tile.selectGround();
+        tile.selectItemAtIndex(1);
+        mapView.selection().select(position);
+    }
+
+    /*
+        Runs 'f' as one transaction, then checks that undo restores the tile at 'position' and the selection, and
+        that redo restores the result of the transaction.
+    */
+    template <typename F>
+    void requireUndoRedo(MapView &mapView, const Position &position, F &&f)
+    {
+        auto before = tileContents(mapView, position);
+        size_t selectedBefore = mapView.selection().size();
+
+        // Not a brush transaction, so that changes to the same tile are not merged (see History::commit).
+        mapView.beginTransaction(TransactionType::AddMapItem);
+        f();
+        mapView.endTransaction(TransactionType::AddMapItem);
+
+        auto after = tileContents(mapView, position);
+        size_t selectedAfter = mapView.selection().size();
+        REQUIRE(after != before);
+
+        mapView.undo();
+        REQUIRE(tileContents(mapView, position) == before);
+        REQUIRE(mapView.selection().size() == selectedBefore);
+
+        mapView.redo();
+        REQUIRE(tileContents(mapView, position) == after);
+        REQUIRE(mapView.selection().size() == selectedAfter);
+
+        mapView.undo();
+        REQUIRE(tileContents(mapView, position) == before);
+        REQUIRE(mapView.selection().size() == selectedBefore);
+    }
+} // namespace
+
+TEST_CASE("history_change.h TileDelta", "[core][history]")
+{
+    auto mapView = makeTestMapView();
+    const Position position(10, 10, 7);
+    createStack(*mapView, position);
+
+    const auto original = tileContents(*mapView, position).value();
+    REQUIRE(original.items.size() == 4);
+    REQUIRE(original.selected == 2);
+
+    SECTION("AddItem places the item by stack order and removes it again on undo")
+    {
+        requireUndoRedo(*mapView, position, [&] {
+            mapView->addItem(*mapView->getTile(position), Item(TestItems::id(Kind::Normal)));
+        });
+
+        mapView->redo();
+        auto contents = tileContents(*mapView, position).value();
+        REQUIRE(contents.items.size() == original.items.size() + 1);
+        // Below the top item
+        REQUIRE(contents.items.back() == TestItems::id(Kind::Top));
+    }
+
+    SECTION("AddItem with an insertion offset")
+    {
+        requireUndoRedo(*mapView, position, [&] {
+            mapView->addItem(*mapView->getTile(position), Item(TestItems::id(Kind::Border)), 1);
+        });
+    }
+
+    SECTION("RemoveItem removes several items in descending index order")
+    {
+        requireUndoRedo(*mapView, position, [&] {
+            mapView->removeItems(position, std::set<size_t, std::greater<size_t>>{3, 1, 0});
+        });
+
+        mapView->redo();
+        auto contents = tileContents(*mapView, position).value();
+        REQUIRE(contents.items == std::vector<uint32_t>{original.items[2]});
+        REQUIRE(contents.ground == original.ground);
+        // The selected item at index 1 is gone.
+        REQUIRE(contents.selected == 1);
+    }
+
+    SECTION("RemoveItem and removeGround by predicate")
+    {
+        requireUndoRedo(*mapView, position, [&] {
+            mapView->removeItems(position, [](const Item &item) { return item.selected; });
+        });
+
+        mapView->redo();
+        auto contents = tileContents(*mapView, position).value();
+        REQUIRE(!contents.ground.has_value());
+        REQUIRE(contents.items.size() == original.items.size() - 1);
+        REQUIRE(contents.selected == 0);
+        REQUIRE(mapView->selection().size() == 0);
+    }
+
+    SECTION("ReplaceGround puts the previous ground back on undo")
+    {
+        requireUndoRedo(*mapView, position, [&] {
+            mapView->setGround(*mapView->getTile(position), Item(TestItems::id(Kind::OtherGround)));
+        });
+
+        mapView->redo();
+        REQUIRE(tileContents(*mapView, position)->ground == TestItems::id(Kind::OtherGround));
+    }
+
+    SECTION("SetAttribute swaps the attribute with the one in the map")
+    {
+        mapView->getTile(position)->itemAt(2)->setActionId(100);
+
+        auto actionId = [&] { return mapView->getTile(position)->itemAt(2)->actionId(); };
+
+        ItemAttribute attribute(ItemAttribute_t::ActionId);
+        attribute.setInt(200);
+
+        mapView->beginTransaction(TransactionType::ModifyItem);
+        mapView->history.commit(ActionType::ModifyItem, TileDelta::setAttribute(position, 2, ItemAttribute_t::ActionId, std::move(attribute)));
+        mapView->endTransaction(TransactionType::ModifyItem);
+        REQUIRE(actionId() == 200);
+
+        mapView->undo();
+        REQUIRE(actionId() == 100);
+
+        mapView->redo();
+        REQUIRE(actionId() == 200);
+
+        // Removing the attribute
+        mapView->beginTransaction(TransactionType::ModifyItem);
+        mapView->history.commit(ActionType::ModifyItem, TileDelta::setAttribute(position, 2, ItemAttribute_t::ActionId, std::nullopt));
+        mapView->endTransaction(TransactionType::ModifyItem);
+        REQUIRE(actionId() == 0);
+
+        mapView->undo();
+        REQUIRE(actionId() == 200);
+        mapView->undo();
+        REQUIRE(actionId() == 100);
+    }
+
+    SECTION("A delta that creates a tile removes it again on undo")
+    {
+        const Position empty(20, 20, 7);
+        REQUIRE(!mapView->hasTile(empty));
+
+        requireUndoRedo(*mapView, empty, [&] {
+            mapView->addItem(empty, Item(TestItems::id(Kind::Normal)));
+            mapView->addItem(empty, Item(TestItems::id(Kind::OtherNormal)));
+        });
+
+        REQUIRE(!mapView->hasTile(empty));
+        REQUIRE(tileContents(*mapView, position) == original);
+    }
+}
+
+TEST_CASE("history.h merges brush changes to the same tile", "[core][history]")
+{
+    auto mapView = makeTestMapView();
+    auto &history = mapView->history;
+
+    const Position a(10, 10, 7);
+    const Position b(11, 10, 7);
+    const std::vector<Position> positions{a, b};
+
+    Tile &tileA = mapView->getOrCreateTile(a);
+    tileA.addItem(Item(TestItems::id(Kind::Ground)));
+    tileA.addItem(Item(TestItems::id(Kind::Normal)));
+
+    Tile &tileB = mapView->getOrCreateTile(b);
+    tileB.addItem(Item(TestItems::id(Kind::Ground)));
+
+    const auto before = tileContents(*mapView, positions);
+    const size_t coalescedBefore = history.coalescedChanges();
+
+    mapView->beginTransaction(TransactionType::BrushAction);
+
+    // A delta, then a tile snapshot and another delta at the same position: merged into one snapshot.
+    mapView->setGround(*mapView->getTile(a), Item(TestItems::id(Kind::OtherGround)));
+    mapView->setBottomItem(a, Item(TestItems::id(Kind::Bottom)));
+    mapView->addItem(*mapView->getTile(a), Item(TestItems::id(Kind::OtherNormal)));
+
+    mapView->setBottomItem(b, Item(TestItems::id(Kind::Bottom)));
+    mapView->setBottomItem(b, Item(TestItems::id(Kind::Bottom)));
+
+    // Not bound to a single position, so the changes after it are not merged into the changes before it.
+    mapView->removeTile(b);
+
+    // The first delta creates the tile again, so the merged snapshot has no tile to restore.
+    mapView->addItem(b, Item(TestItems::id(Kind::Normal)));
+    mapView->addItem(b, Item(TestItems::id(Kind::Normal)));
+
+    mapView->endTransaction(TransactionType::BrushAction);
+
+    REQUIRE(history.coalescedChanges() - coalescedBefore == 4);
+
+    const auto after = tileContents(*mapView, positions);
+    REQUIRE(after[0]->ground == TestItems::id(Kind::OtherGround));
+    REQUIRE(after[0]->items.size() == 3);
+    REQUIRE(!after[1]->ground.has_value());
+    REQUIRE(after[1]->items == std::vector<uint32_t>{TestItems::id(Kind::Normal), TestItems::id(Kind::Normal)});
+
+    mapView->undo();
+    REQUIRE(tileContents(*mapView, positions) == before);
+
+    mapView->redo();
+    REQUIRE(tileContents(*mapView, positions) == after);
+
+    mapView->undo();
+    REQUIRE(tileContents(*mapView, positions) == before);
+}
+
+TEST_CASE("history_change.h SetTile without a tile to restore", "[core][history]")
+{
+    auto mapView = makeTestMapView();
+    const Position position(30, 30, 7);
+
+    // Undoing the change removes the tile at the position, but there is none.
+    Action action(ActionType::SetTile, SetTile::alreadyCommitted(position, nullptr));
+    action.markAsCommitted();
+
+    mapView->beginTransaction(TransactionType::BrushAction);
+    mapView->history.commit(std::move(action));
+    mapView->endTransaction(TransactionType::BrushAction);
+
+    mapView->undo();
+    REQUIRE(!mapView->hasTile(position));
+
+    mapView->redo();
+    REQUIRE(!mapView->hasTile(position));
+
+    mapView->undo();
+    REQUIRE(!mapView->hasTile(position));
+}
@@ -0,0 +1,196 @@
+#include "catch.hpp"
+
+#include <filesystem>
+#include <vector>
+
+#include "core/history/history_spill.h"
+#include "test_items.h"
+#include "test_map_view.h"
+
+using namespace MapHistory;
+
+TEST_CASE("history_spill.h", "[core][history]")
+{
+    SECTION("Written values are read back in order")
+    {
+        SpillWriter writer;
+        writer.writeU8(0xAB);
+        writer.writeU16(0xBEEF);
+        writer.writeU32(0xDEADBEEF);
+        writer.writePosition(Position(65000, 70000, 15));
+
+        SpillReader reader(std::vector<uint8_t>(writer.bytes()));
+        REQUIRE(reader.nextU8() == 0xAB);
+        REQUIRE(reader.nextU16() == 0xBEEF);
+        REQUIRE(reader.nextU32() == 0xDEADBEEF);
+        REQUIRE(reader.readPosition() == Position(65000, 70000, 15));
+        REQUIRE(reader.finished());
+    }
+
+    SECTION("Spill file entries are read back and the file is emptied when no entry is used")
+    {
+        auto path = std::filesystem::temp_directory_path() / "vme_history_spill_test.bin";
+        {
+            SpillFile file(path);
+
+            std::vector<uint8_t> a{1, 2, 3};
+            std::vector<uint8_t> b(1000, 7);
+
+            auto entryA = file.write(a);
+            auto entryB = file.write(b);
+            REQUIRE(entryA.has_value());
+            REQUIRE(entryB.has_value());
+            REQUIRE(file.size() == a.size() + b.size());
+
+            REQUIRE(file.read(*entryB) == b);
+            REQUIRE(file.read(*entryA) == a);
+
+            file.release(*entryA);
+            REQUIRE(file.size() == b.size());
+            REQUIRE(file.read(*entryB) == b);
+
+            file.release(*entryB);
+            REQUIRE(file.size() == 0);
+
+            auto entryC = file.write(a);
+            REQUIRE(entryC->offset == 0);
+            REQUIRE(file.read(*entryC) == a);
+        }
+
+        REQUIRE(!std::filesystem::exists(path));
+    }
+
+    SECTION("A spilled fill is reloaded when it is undone")
+    {
+        using TestItems::Kind;
+
+        auto mapView = makeTestMapView();
+        auto &history = mapView->history;
+        history.setSpillDirectory(std::filesystem::temp_directory_path());
+
+        std::vector<Position> positions;
+        for (int y = 0; y < 32; ++y)
+        {
+            for (int x = 0; x < 32; ++x)
+            {
+                Position position(x, y, 7);
+                positions.emplace_back(position);
+
+                Tile &tile = mapView->getOrCreateTile(position);
+                tile.addItem(Item(TestItems::id(Kind::Ground)));
+                tile.addItem(Item(TestItems::id(Kind::Normal)));
+            }
+        }
+        const Position other(40, 40, 7);
+        positions.emplace_back(other);
+
+        auto before = tileContents(*mapView, positions);
+
+        // Half of the tiles get a snapshot that shares its unchanged items with the map (see Tile::copyForHistory),
+        // the other half only a ground delta. Only the snapshots are kept in memory when the fill is spilled.
+        mapView->beginTransaction(TransactionType::BrushAction);
+        for (const auto &position : positions)
+        {
+            if (position == other)
+                continue;
+
+            if (position.x % 2 == 0)
+            {
+                mapView->setBottomItem(position, Item(TestItems::id(Kind::Bottom)));
+            }
+            mapView->setGround(*mapView->getTile(position), Item(TestItems::id(Kind::OtherGround)));
+        }
+        mapView->endTransaction(TransactionType::BrushAction);
+
+        // The latest transaction is never spilled.
+        mapView->beginTransaction(TransactionType::BrushAction);
+        mapView->addItem(other, Item(TestItems::id(Kind::Normal)));
+        mapView->endTransaction(TransactionType::BrushAction);
+
+        auto after = tileContents(*mapView, positions);
+        REQUIRE(after != before);
+
+        size_t usage = history.memoryUsage();
+        history.setMemoryBudget(usage - 1);
+
+        REQUIRE(history.size() == 2);
+        REQUIRE(history.spilledBytes() > 0);
+        REQUIRE(history.memoryUsage() < usage);
+
+        mapView->undo();
+        mapView->undo();
+        REQUIRE(history.spilledBytes() == 0);
+        REQUIRE(tileContents(*mapView, positions) == before);
+
+        mapView->redo();
+        mapView->redo();
+        REQUIRE(tileContents(*mapView, positions) == after);
+
+        // The fill can be spilled and undone again.
+        history.setMemoryBudget(history.memoryUsage() - 1);
+        REQUIRE(history.spilledBytes() > 0);
+        mapView->undo();
+        mapView->undo();
+        REQUIRE(tileContents(*mapView, positions) == before);
+    }
+
+    SECTION("Items that a snapshot shares with the map are not spilled")
+    {
+        using TestItems::Kind;
+
+        auto mapView = makeTestMapView();
+        auto &history = mapView->history;
+        history.setSpillDirectory(std::filesystem::temp_directory_path());
+
+        const Position position(0, 0, 7);
+        std::vector<Position> positions;
+        for (int x = 0; x < 32; ++x)
+        {
+            positions.emplace_back(x, 0, 7);
+            mapView->getOrCreateTile(positions.back()).addItem(Item(TestItems::id(Kind::Ground)));
+        }
+
+        Item stackable(TestItems::id(Kind::Normal));
+        stackable.setSubtype(5);
+        Item *item = mapView->getTile(position)->addItem(std::move(stackable));
+
+        auto before = tileContents(*mapView, positions);
+
+        // The snapshot of 'position' shares 'item' with the map. The ground deltas of the other tiles can be spilled.
+        mapView->beginTransaction(TransactionType::BrushAction);
+        mapView->setBottomItem(position, Item(TestItems::id(Kind::Bottom)));
+        for (const auto &pos : positions)
+        {
+            if (pos != position)
+            {
+                mapView->setGround(*mapView->getTile(pos), Item(TestItems::id(Kind::OtherGround)));
+            }
+        }
+        mapView->endTransaction(TransactionType::BrushAction);
+
+        // Changes the shared item in place
+        mapView->beginTransaction(TransactionType::ModifyItem);
+        mapView->setSubtype(item, 10);
+        mapView->endTransaction(TransactionType::ModifyItem);
+
+        // The latest transaction is never spilled.
+        mapView->beginTransaction(TransactionType::BrushAction);
+        mapView->addItem(Position(40, 40, 7), Item(TestItems::id(Kind::Normal)));
+        mapView->endTransaction(TransactionType::BrushAction);
+
+        history.setMemoryBudget(history.memoryUsage() - 1);
+        REQUIRE(history.size() == 3);
+        REQUIRE(history.spilledBytes() > 0);
+
+        REQUIRE(mapView->getTile(position)->itemAt(1)->subtype() == 10);
+
+        mapView->undo();
+        mapView->undo();
+        mapView->undo();
+        REQUIRE(tileContents(*mapView, positions) == before);
+
+        Item *restored = mapView->getTile(position)->itemAt(0);
+        REQUIRE(restored->serverId() == TestItems::id(Kind::Normal));
+        REQUIRE(restored->subtype() == 5);
+    }
+}
@@ -0,0 +1,268 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "core/graphics/hot_atlas_repacker.h"
+
+namespace
+{
+    // Every pixel encodes its own position in the atlas, so a copied sprite can be traced back to its source.
+    Texture createPatternTexture(uint32_t seed)
+    {
+        uint32_t size = TextureAtlasSize.width;
+        std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                size_t i = 4 * (static_cast<size_t>(y) * size + x);
+                pixels[i] = static_cast<uint8_t>(x);
+                pixels[i + 1] = static_cast<uint8_t>(y);
+                pixels[i + 2] = static_cast<uint8_t>((x >> 8) | ((y >> 8) << 2) | (seed << 4));
+                pixels[i + 3] = 255;
+            }
+        }
+
+        return Texture(size, size, std::move(pixels));
+    }
+
+    const uint8_t *pixelAt(const Texture &texture, int x, int y)
+    {
+        return texture.pixels().data() + 4 * ((texture.width() - y - 1) * texture.width() + x);
+    }
+
+    bool sameSprite(TextureAtlas &a, uint32_t aSpriteId, TextureAtlas &b, uint32_t bSpriteId)
+    {
+        auto [ax, ay] = a.textureOffset(aSpriteId);
+        auto [bx, by] = b.textureOffset(bSpriteId);
+
+        const Texture &aTexture = a.getOrCreateTexture();
+        const Texture &bTexture = b.getOrCreateTexture();
+
+        for (uint32_t y = 0; y < a.spriteHeight; ++y)
+        {
+            for (uint32_t x = 0; x < a.spriteWidth; ++x)
+            {
+                if (std::memcmp(pixelAt(aTexture, ax + x, ay + y), pixelAt(bTexture, bx + x, by + y), 4) != 0)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+    std::vector<uint32_t> retiredTextureIds(const HotAtlasRepacker &repacker, uint32_t generation)
+    {
+        std::vector<uint32_t> textureIds;
+        repacker.forEachRetiredTextureId(generation, [&textureIds](uint32_t textureId) { textureIds.emplace_back(textureId); });
+        return textureIds;
+    }
+} // namespace
+
+TEST_CASE("hot_atlas_repacker.h", "[graphics][atlas]")
+{
+    std::vector<std::unique_ptr<TextureAtlas>> atlases;
+    atlases.emplace_back(std::make_unique<TextureAtlas>(createPatternTexture(0), 1, 144, SpriteLayout::ONE_BY_ONE));
+    atlases.emplace_back(std::make_unique<TextureAtlas>(createPatternTexture(1), 145, 288, SpriteLayout::ONE_BY_ONE));
+    atlases.emplace_back(std::make_unique<TextureAtlas>(createPatternTexture(2), 289, 360, SpriteLayout::ONE_BY_TWO));
+
+    std::vector<SpriteDrawInfo> infos;
+    for (auto &atlas : atlases)
+    {
+        for (uint32_t spriteId = atlas->firstSpriteId; spriteId <= atlas->lastSpriteId; ++spriteId)
+        {
+            TextureWindow window = atlas->getTextureWindow(spriteId);
+            infos.emplace_back(SpriteDrawInfo{atlas.get(), window, atlas->getFragmentBounds(window), spriteId});
+        }
+    }
+
+    std::vector<SpriteDrawInfo *> sprites;
+    for (auto &info : infos)
+    {
+        sprites.emplace_back(&info);
+    }
+
+    const auto sourceAtlas = [&atlases](uint32_t spriteId) {
+        return atlases[spriteId <= 144 ? 0 : spriteId <= 288 ? 1 : 2].get();
+    };
+
+    HotAtlasRepacker repacker(512, 1, 2);
+    auto renderer = repacker.addRenderer();
+
+    const std::vector<uint32_t> hotSpriteIds = {3, 140, 200, 300, 359};
+    for (int i = 0; i < 4; ++i)
+    {
+        for (uint32_t spriteId : hotSpriteIds)
+        {
+            repacker.recordUsage(spriteId);
+        }
+    }
+    // Drawn too few times to be moved
+    repacker.recordUsage(10);
+
+    repacker.setSprites(sprites);
+    REQUIRE(repacker.repack());
+
+    SECTION("One hot atlas is created per sprite size")
+    {
+        REQUIRE(repacker.atlases().size() == 2);
+    }
+
+    SECTION("Hot sprites are redirected and keep their pixels")
+    {
+        for (const auto &info : infos)
+        {
+            bool hot = std::find(hotSpriteIds.begin(), hotSpriteIds.end(), info.spriteId) != hotSpriteIds.end();
+            TextureAtlas *source = sourceAtlas(info.spriteId);
+
+            if (!hot)
+            {
+                REQUIRE(info.atlas == source);
+                continue;
+            }
+
+            REQUIRE(info.atlas != source);
+            REQUIRE(info.atlas->spriteWidth == source->spriteWidth);
+            REQUIRE(info.atlas->spriteHeight == source->spriteHeight);
+
+            // The window of the sprite within the hot atlas
+            uint32_t index = 0;
+            while (!(info.atlas->getTextureWindow(index).x0 == info.window.x0 && info.atlas->getTextureWindow(index).y0 == info.window.y0))
+            {
+                ++index;
+                REQUIRE(index <= info.atlas->lastSpriteId);
+            }
+
+            REQUIRE(sameSprite(*info.atlas, index, *source, info.spriteId));
+        }
+    }
+
+    SECTION("Repacking the same hot set keeps the atlases")
+    {
+        uint32_t generation = repacker.generation();
+        for (int i = 0; i < 4; ++i)
+        {
+            for (uint32_t spriteId : hotSpriteIds)
+            {
+                repacker.recordUsage(spriteId);
+            }
+        }
+
+        REQUIRE(repacker.repack());
+        REQUIRE(repacker.generation() == generation);
+
+        // The entries stay redirected
+        for (uint32_t spriteId : hotSpriteIds)
+        {
+            REQUIRE(infos[spriteId - 1].atlas != sourceAtlas(spriteId));
+        }
+    }
+
+    SECTION("Sprites that are no longer hot are restored")
+    {
+        // Halves the counts of the old hot set below the minimum
+        repacker.repack();
+
+        const std::vector<uint32_t> newHotSpriteIds = {3, 200, 359};
+        for (int i = 0; i < 4; ++i)
+        {
+            for (uint32_t spriteId : newHotSpriteIds)
+            {
+                repacker.recordUsage(spriteId);
+            }
+        }
+
+        REQUIRE(repacker.repack());
+        REQUIRE(infos[140 - 1].atlas == sourceAtlas(140));
+        REQUIRE(infos[300 - 1].atlas == sourceAtlas(300));
+        for (uint32_t spriteId : newHotSpriteIds)
+        {
+            REQUIRE(infos[spriteId - 1].atlas != sourceAtlas(spriteId));
+        }
+    }
+
+    SECTION("Reset restores the client atlases")
+    {
+        TextureAtlas *hotAtlas = repacker.atlases().front().get();
+        uint32_t textureId = hotAtlas->getTexture()->id();
+        uint32_t generation = repacker.generation();
+
+        repacker.reset();
+
+        REQUIRE(repacker.empty());
+        auto retired = retiredTextureIds(repacker, generation);
+        REQUIRE(retired.size() == 2);
+        REQUIRE(std::find(retired.begin(), retired.end(), textureId) != retired.end());
+
+        for (const auto &info : infos)
+        {
+            REQUIRE(info.atlas == sourceAtlas(info.spriteId));
+
+            TextureWindow window = info.atlas->getTextureWindow(info.spriteId);
+            REQUIRE(info.window.x0 == window.x0);
+            REQUIRE(info.window.y0 == window.y0);
+        }
+    }
+
+    SECTION("Retired texture IDs are kept until every renderer has released them")
+    {
+        auto otherRenderer = repacker.addRenderer();
+        uint32_t generation = repacker.generation();
+
+        repacker.reset();
+        REQUIRE(retiredTextureIds(repacker, generation).size() == 2);
+
+        repacker.releasedGeneration(renderer, repacker.generation());
+        REQUIRE(retiredTextureIds(repacker, generation).size() == 2);
+
+        repacker.releasedGeneration(otherRenderer, repacker.generation());
+        REQUIRE(retiredTextureIds(repacker, generation).empty());
+    }
+
+    SECTION("A removed renderer does not keep retired texture IDs")
+    {
+        auto otherRenderer = repacker.addRenderer();
+        uint32_t generation = repacker.generation();
+
+        repacker.reset();
+        repacker.releasedGeneration(renderer, repacker.generation());
+        REQUIRE_FALSE(retiredTextureIds(repacker, generation).empty());
+
+        repacker.removeRenderer(otherRenderer);
+        REQUIRE(retiredTextureIds(repacker, generation).empty());
+    }
+}
+
+TEST_CASE("HotAtlasRepacker frames", "[graphics][atlas]")
+{
+    HotAtlasRepacker repacker(512, 3, 2);
+    auto first = repacker.addRenderer();
+    auto second = repacker.addRenderer();
+
+    SECTION("Renderers drawing the same frame advance it once")
+    {
+        for (int frame = 0; frame < 2; ++frame)
+        {
+            repacker.nextFrame(first);
+            repacker.nextFrame(second);
+        }
+        REQUIRE_FALSE(repacker.repackDue());
+
+        repacker.nextFrame(second);
+        REQUIRE(repacker.repackDue());
+    }
+
+    SECTION("A single renderer advances every frame")
+    {
+        repacker.removeRenderer(second);
+
+        repacker.nextFrame(first);
+        repacker.nextFrame(first);
+        REQUIRE_FALSE(repacker.repackDue());
+
+        repacker.nextFrame(first);
+        REQUIRE(repacker.repackDue());
+    }
+}
@@ -1,8 +1,79 @@
 #include "catch.hpp"
 
+#include <vector>
+
 #include "core/map_view.h"
+#include "test_items.h"
+#include "test_map_view.h"
+
+using TestItems::Kind;
 
 TEST_CASE("map_view.h", "[core][map view]")
 {
     // SECTION("")
-}
\ No newline at end of file
+}
+
+TEST_CASE("map_view.h selectRegion", "[core][map view][selection]")
+{
+    auto mapView = makeTestMapView();
+    Selection &selection = mapView->selection();
+
+    auto addTile = [&mapView](const Position &position) {
+        mapView->getOrCreateTile(position).addItem(Item(TestItems::id(Kind::Ground)));
+    };
+
+    SECTION("Only positions with a tile are selected")
+    {
+        addTile(Position(10, 10, 7));
+        addTile(Position(12, 10, 7));
+        addTile(Position(12, 11, 7));
+        // An empty tile
+        mapView->getOrCreateTile(Position(11, 11, 7));
+
+        mapView->selectRegion(Position(12, 11, 7), Position(10, 10, 7));
+
+        REQUIRE(selection.size() == 3);
+        REQUIRE(selection.contains(Position(10, 10, 7)));
+        REQUIRE(selection.contains(Position(12, 10, 7)));
+        REQUIRE(selection.contains(Position(12, 11, 7)));
+        REQUIRE_FALSE(selection.contains(Position(11, 10, 7)));
+        REQUIRE_FALSE(selection.contains(Position(11, 11, 7)));
+        REQUIRE(mapView->getTile(Position(12, 11, 7))->allSelected());
+
+        mapView->undo();
+        REQUIRE(selection.empty());
+        REQUIRE_FALSE(mapView->getTile(Position(12, 11, 7))->hasSelection());
+
+        mapView->redo();
+        REQUIRE(selection.size() == 3);
+    }
+
+    SECTION("A box that is fully mapped is selected as a whole")
+    {
+        for (int y = 0; y < 8; ++y)
+        {
+            for (int x = 0; x < 8; ++x)
+            {
+                addTile(Position(x, y, 7));
+            }
+        }
+
+        mapView->selectRegion(Position(1, 1, 7), Position(6, 6, 7));
+        REQUIRE(selection.size() == 36);
+        REQUIRE(selection.spans().size() == 6);
+        REQUIRE_FALSE(selection.contains(Position(0, 1, 7)));
+
+        // Selecting it again changes nothing, so nothing is committed.
+        size_t transactions = mapView->history.size();
+        mapView->selectRegion(Position(1, 1, 7), Position(6, 6, 7));
+        REQUIRE(mapView->history.size() == transactions);
+    }
+
+    SECTION("Duplicate positions do not select the positions between them")
+    {
+        selection.select(std::vector{Position(0, 0, 7), Position(0, 0, 7), Position(2, 0, 7)});
+
+        REQUIRE(selection.size() == 2);
+        REQUIRE_FALSE(selection.contains(Position(1, 0, 7)));
+    }
+}
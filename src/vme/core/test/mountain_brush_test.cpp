@@ -0,0 +1,344 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "core/brushes/border_brush.h"
+#include "core/brushes/brush_footprint.h"
+#include "core/brushes/brushes.h"
+#include "core/brushes/ground_brush.h"
+#include "core/brushes/mountain_brush.h"
+#include "core/items.h"
+#include "core/settings.h"
+#include "test_items.h"
+#include "test_map_view.h"
+
+using TestItems::Kind;
+
+namespace
+{
+    constexpr int InnerWallEast = 100;
+    constexpr int InnerWallSouth = 101;
+    constexpr int InnerWallSouthEast = 102;
+
+    /*
+        A mountain on a ground brush of its own. The outer wall of a border type is mountainWallId(borderType - 1),
+        and the inner walls are mountainWallId(12) (east), mountainWallId(13) (south) and mountainWallId(14)
+        (south east).
+    */
+    MountainBrush *testMountain()
+    {
+        static MountainBrush *brush = [] {
+            GroundBrush *ground = Brushes::addGroundBrush(std::make_unique<GroundBrush>(
+                "test_mountain_ground", std::vector<WeightedItemId>{WeightedItemId(TestItems::groundId(3), 1)}, 50));
+
+            std::array<uint32_t, BORDER_COUNT_FOR_GROUND_TILE> outerWalls;
+            for (int i = 0; i < BORDER_COUNT_FOR_GROUND_TILE; ++i)
+            {
+                outerWalls[i] = TestItems::mountainWallId(i);
+            }
+
+            MountainPart::InnerWall innerWall{TestItems::mountainWallId(12), TestItems::mountainWallId(13), TestItems::mountainWallId(14)};
+
+            MountainBrush *mountain = Brushes::addMountainBrush(std::make_unique<MountainBrush>(
+                "test_mountain", "Test mountain", Brush::LazyGround(ground), innerWall, BorderData(outerWalls), TestItems::mountainWallId(0)));
+
+            // Like the brush loader does on the first use of the ground
+            for (uint32_t serverId : ground->serverIds())
+            {
+                Items::items.getItemTypeByServerId(serverId)->addBrush(mountain);
+                mountain->addServerId(serverId);
+            }
+
+            return mountain;
+        }();
+
+        return brush;
+    }
+
+    // The wall of a border type (as an int) or of one of the inner walls above
+    uint32_t wall(int type)
+    {
+        switch (type)
+        {
+            case InnerWallEast:
+                return TestItems::mountainWallId(12);
+            case InnerWallSouth:
+                return TestItems::mountainWallId(13);
+            case InnerWallSouthEast:
+                return TestItems::mountainWallId(14);
+            default:
+                return TestItems::mountainWallId(type - 1);
+        }
+    }
+
+    // Every tile of the map
+    std::vector<Position> window()
+    {
+        std::vector<Position> positions;
+        for (int y = 0; y <= 16; ++y)
+        {
+            for (int x = 0; x <= 16; ++x)
+            {
+                positions.emplace_back(x, y, 7);
+            }
+        }
+
+        return positions;
+    }
+
+    // A map of plain grounds with the mountain ground at 'mountain'
+    std::unique_ptr<MapView> mountainMap(const std::vector<Position> &mountain)
+    {
+        testMountain();
+
+        auto mapView = makeTestMapView();
+        for (const Position &pos : window())
+        {
+            bool isMountain = std::find(mountain.begin(), mountain.end(), pos) != mountain.end();
+            mapView->getOrCreateTile(pos).addItem(Item(isMountain ? TestItems::groundId(3) : TestItems::id(Kind::Ground)));
+        }
+
+        return mapView;
+    }
+
+    /*
+        Borders 'mountain' with generalBorderize for every position in row-major order (like a fill did before
+        borderizeRegion) and with borderizeRegion, requires that the tiles are the same, and returns them.
+    */
+    std::vector<std::optional<TileContents>> requireSameBorders(const std::vector<Position> &mountain)
+    {
+        auto perTile = mountainMap(mountain);
+        auto region = mountainMap(mountain);
+
+        std::vector<Position> sorted = mountain;
+        std::sort(sorted.begin(), sorted.end(), [](const Position &a, const Position &b) {
+            return std::pair(a.y, a.x) < std::pair(b.y, b.x);
+        });
+
+        perTile->beginTransaction(TransactionType::BrushAction);
+        for (const Position &pos : sorted)
+        {
+            MountainBrush::generalBorderize(*perTile, pos);
+        }
+        perTile->endTransaction(TransactionType::BrushAction);
+
+        std::vector<BrushFootprint::Span> spans;
+        for (const Position &pos : mountain)
+        {
+            spans.emplace_back(BrushFootprint::Span{pos.y, pos.x, pos.x});
+        }
+
+        region->beginTransaction(TransactionType::BrushAction);
+        MountainBrush::borderizeRegion(*region, BrushFootprint(std::move(spans)), 7);
+        region->endTransaction(TransactionType::BrushAction);
+
+        auto result = tileContents(*region, window());
+        REQUIRE(result == tileContents(*perTile, window()));
+
+        return result;
+    }
+
+    // Requires the walls of the tiles in 'expected' (see wall), in stack order. The other tiles have none.
+    void requireWalls(const std::vector<std::optional<TileContents>> &contents, std::vector<std::pair<Position, std::vector<int>>> &&expected)
+    {
+        const auto tiles = window();
+        for (size_t i = 0; i < tiles.size(); ++i)
+        {
+            std::vector<uint32_t> walls;
+            for (const auto &[pos, types] : expected)
+            {
+                if (pos == tiles[i])
+                {
+                    for (int type : types)
+                    {
+                        walls.emplace_back(wall(type));
+                    }
+                }
+            }
+
+            INFO("At " << tiles[i].x << ", " << tiles[i].y);
+            REQUIRE(contents[i]->items == walls);
+        }
+    }
+
+    // Restores Settings::PLACE_MOUNTAIN_FEATURES, also when a requirement fails
+    struct PlaceMountainFeatures
+    {
+        explicit PlaceMountainFeatures(bool value)
+            : previous(Settings::PLACE_MOUNTAIN_FEATURES)
+        {
+            Settings::PLACE_MOUNTAIN_FEATURES = value;
+        }
+
+        ~PlaceMountainFeatures()
+        {
+            Settings::PLACE_MOUNTAIN_FEATURES = previous;
+        }
+
+        bool previous;
+    };
+
+    std::vector<Position> positions(std::vector<std::pair<int, int>> &&xy)
+    {
+        std::vector<Position> result;
+        for (const auto &[x, y] : xy)
+        {
+            result.emplace_back(x, y, 7);
+        }
+
+        return result;
+    }
+} // namespace
+
+TEST_CASE("mountain_brush.h borderizeRegion", "[core][brush]")
+{
+    const auto peak = positions({{8, 8}});
+    const auto ridge = positions({{6, 8}, {7, 8}, {8, 8}, {9, 8}, {10, 8}});
+    const auto diagonal = positions({{6, 6}, {7, 7}, {8, 8}, {9, 9}});
+
+    constexpr int N = static_cast<int>(BorderType::North);
+    constexpr int E = static_cast<int>(BorderType::East);
+    constexpr int S = static_cast<int>(BorderType::South);
+    constexpr int W = static_cast<int>(BorderType::West);
+    constexpr int NWC = static_cast<int>(BorderType::NorthWestCorner);
+    constexpr int NEC = static_cast<int>(BorderType::NorthEastCorner);
+    constexpr int SEC = static_cast<int>(BorderType::SouthEastCorner);
+    constexpr int SWC = static_cast<int>(BorderType::SouthWestCorner);
+    constexpr int NED = static_cast<int>(BorderType::NorthEastDiagonal);
+    constexpr int SWD = static_cast<int>(BorderType::SouthWestDiagonal);
+
+    SECTION("Without mountain features")
+    {
+        PlaceMountainFeatures features(false);
+
+        requireWalls(requireSameBorders(peak), {
+                                                   {Position(7, 7, 7), {SEC}},
+                                                   {Position(8, 7, 7), {S}},
+                                                   {Position(7, 8, 7), {E}},
+                                                   {Position(8, 8, 7), {InnerWallSouthEast}},
+                                               });
+
+        requireWalls(requireSameBorders(ridge), {
+                                                    {Position(5, 7, 7), {SEC}},
+                                                    {Position(6, 7, 7), {S}},
+                                                    {Position(7, 7, 7), {S}},
+                                                    {Position(8, 7, 7), {S}},
+                                                    {Position(9, 7, 7), {S}},
+                                                    {Position(10, 7, 7), {S}},
+                                                    {Position(5, 8, 7), {E}},
+                                                    {Position(6, 8, 7), {InnerWallSouth}},
+                                                    {Position(7, 8, 7), {InnerWallSouth}},
+                                                    {Position(8, 8, 7), {InnerWallSouth}},
+                                                    {Position(9, 8, 7), {InnerWallSouth}},
+                                                    {Position(10, 8, 7), {InnerWallSouthEast}},
+                                                });
+
+        requireWalls(requireSameBorders(diagonal), {
+                                                       {Position(5, 5, 7), {SEC}},
+                                                       {Position(6, 5, 7), {S}},
+                                                       {Position(5, 6, 7), {E}},
+                                                       {Position(6, 6, 7), {InnerWallSouthEast}},
+                                                       {Position(7, 6, 7), {S}},
+                                                       {Position(6, 7, 7), {E}},
+                                                       {Position(7, 7, 7), {InnerWallSouthEast}},
+                                                       {Position(8, 7, 7), {S}},
+                                                       {Position(7, 8, 7), {E}},
+                                                       {Position(8, 8, 7), {InnerWallSouthEast}},
+                                                       {Position(9, 8, 7), {S}},
+                                                       {Position(8, 9, 7), {E}},
+                                                       {Position(9, 9, 7), {InnerWallSouthEast}},
+                                                   });
+    }
+
+    SECTION("With mountain features")
+    {
+        PlaceMountainFeatures features(true);
+
+        requireWalls(requireSameBorders(peak), {
+                                                   {Position(7, 7, 7), {SEC}},
+                                                   {Position(8, 7, 7), {S}},
+                                                   {Position(9, 7, 7), {SWC}},
+                                                   {Position(7, 8, 7), {E}},
+                                                   {Position(8, 8, 7), {InnerWallSouthEast}},
+                                                   {Position(9, 8, 7), {W}},
+                                                   {Position(7, 9, 7), {NEC}},
+                                                   {Position(8, 9, 7), {N}},
+                                                   {Position(9, 9, 7), {NWC}},
+                                               });
+
+        requireWalls(requireSameBorders(ridge), {
+                                                    {Position(5, 7, 7), {SEC}},
+                                                    {Position(6, 7, 7), {S}},
+                                                    {Position(7, 7, 7), {S}},
+                                                    {Position(8, 7, 7), {S}},
+                                                    {Position(9, 7, 7), {S}},
+                                                    {Position(10, 7, 7), {S}},
+                                                    {Position(11, 7, 7), {SWC}},
+                                                    {Position(5, 8, 7), {E}},
+                                                    {Position(6, 8, 7), {InnerWallSouth}},
+                                                    {Position(7, 8, 7), {InnerWallSouth}},
+                                                    {Position(8, 8, 7), {InnerWallSouth}},
+                                                    {Position(9, 8, 7), {InnerWallSouth}},
+                                                    {Position(10, 8, 7), {InnerWallSouthEast}},
+                                                    {Position(11, 8, 7), {W}},
+                                                    {Position(5, 9, 7), {NEC}},
+                                                    {Position(6, 9, 7), {N}},
+                                                    {Position(7, 9, 7), {N}},
+                                                    {Position(8, 9, 7), {N}},
+                                                    {Position(9, 9, 7), {N}},
+                                                    {Position(10, 9, 7), {N}},
+                                                    {Position(11, 9, 7), {NWC}},
+                                                });
+
+        requireWalls(requireSameBorders(diagonal), {
+                                                       {Position(5, 5, 7), {SEC}},
+                                                       {Position(6, 5, 7), {S}},
+                                                       {Position(7, 5, 7), {SWC}},
+                                                       {Position(5, 6, 7), {E}},
+                                                       {Position(6, 6, 7), {InnerWallSouthEast}},
+                                                       {Position(7, 6, 7), {SWD}},
+                                                       {Position(8, 6, 7), {SWC}},
+                                                       {Position(5, 7, 7), {NEC}},
+                                                       {Position(6, 7, 7), {NED}},
+                                                       {Position(7, 7, 7), {InnerWallSouthEast}},
+                                                       {Position(8, 7, 7), {SWD}},
+                                                       {Position(9, 7, 7), {SWC}},
+                                                       {Position(6, 8, 7), {NEC}},
+                                                       {Position(7, 8, 7), {NED}},
+                                                       {Position(8, 8, 7), {InnerWallSouthEast}},
+                                                       {Position(9, 8, 7), {SWD}},
+                                                       {Position(10, 8, 7), {SWC}},
+                                                       {Position(7, 9, 7), {NEC}},
+                                                       {Position(8, 9, 7), {NED}},
+                                                       {Position(9, 9, 7), {InnerWallSouthEast}},
+                                                       {Position(10, 9, 7), {W}},
+                                                       {Position(8, 10, 7), {NEC}},
+                                                       {Position(9, 10, 7), {N}},
+                                                       {Position(10, 10, 7), {NWC}},
+                                                   });
+    }
+
+    SECTION("Irregular layouts")
+    {
+        const std::vector<std::vector<Position>> layouts{
+            positions({{6, 6}, {7, 6}, {8, 6}, {6, 7}, {7, 7}, {8, 7}, {6, 8}, {7, 8}, {8, 8}}),
+            positions({{6, 6}, {6, 7}, {6, 8}, {7, 8}, {8, 8}}),
+            positions({{9, 6}, {8, 7}, {7, 8}, {6, 9}}),
+            positions({{5, 5}, {7, 5}, {6, 6}, {9, 6}, {5, 7}, {8, 7}, {9, 7}, {6, 8}, {10, 9}, {7, 10}, {8, 10}, {11, 11}}),
+        };
+
+        for (bool placeFeatures : {false, true})
+        {
+            PlaceMountainFeatures features(placeFeatures);
+            for (const auto &layout : layouts)
+            {
+                requireSameBorders(layout);
+            }
+        }
+    }
+}
@@ -10,15 +10,22 @@ struct ItemObserver
     void onAddressChanged(Item *item)
     {
         receivedAddressChange = true;
+        latestAddress = item;
+        ++addressChanges;
     }
 
     void onPropertyChanged(Item *item, ItemChangeType changeType)
     {
         latestPropertyChange = changeType;
+        ++propertyChanges;
     }
 
     bool receivedAddressChange = false;
+    Item *latestAddress = nullptr;
+    int addressChanges = 0;
+
     std::optional<ItemChangeType> latestPropertyChange;
+    int propertyChanges = 0;
 };
 
 struct ContainerObserver
@@ -75,6 +82,36 @@ TEST_CASE("observable_item.h", "[observer][item]")
         }
     }
 
+    SECTION("Item signals are coalesced during a notification batch")
+    {
+        Item item(2554);
+        Item moved = item.deepCopy();
+
+        ItemObserver observer;
+        auto tracked = ObservableItem(&item);
+        tracked.onAddressChanged<&ItemObserver::onAddressChanged>(&observer);
+        tracked.onPropertyChanged<&ItemObserver::onPropertyChanged>(&observer);
+
+        size_t coalescedBefore = Items::items.coalescedNotifications();
+
+        Items::items.beginNotificationBatch();
+
+        Items::items.itemAddressChanged(&item);
+        Items::items.itemAddressChanged(&moved);
+        moved.setCount(10);
+        moved.setCount(20);
+
+        REQUIRE(observer.addressChanges == 0);
+        REQUIRE(observer.propertyChanges == 0);
+
+        Items::items.endNotificationBatch();
+
+        REQUIRE(observer.addressChanges == 1);
+        REQUIRE(observer.latestAddress == &moved);
+        REQUIRE(observer.propertyChanges == 1);
+        REQUIRE(Items::items.coalescedNotifications() - coalescedBefore == 2);
+    }
+
     SECTION("Container signals are cleared when no longer needed")
     {
         Item item(1987);
@@ -0,0 +1,71 @@
+#include "catch.hpp"
+
+#include <random>
+#include <set>
+#include <tuple>
+
+#include "core/brushes/occupancy_grid.h"
+#include "core/position.h"
+
+TEST_CASE("occupancy_grid.h", "[core][brush]")
+{
+    OccupancyGrid grid;
+
+    SECTION("Tiles are free until they are set")
+    {
+        REQUIRE_FALSE(grid.test(Position(10, 10, 7)));
+        REQUIRE(grid.chunkCount() == 0);
+
+        grid.set(Position(10, 10, 7));
+        REQUIRE(grid.test(Position(10, 10, 7)));
+
+        REQUIRE_FALSE(grid.test(Position(11, 10, 7)));
+        REQUIRE_FALSE(grid.test(Position(10, 11, 7)));
+        REQUIRE_FALSE(grid.test(Position(10, 10, 6)));
+    }
+
+    SECTION("Tiles at the edges of chunks are separate")
+    {
+        constexpr int Edge = OccupancyGrid::ChunkSize;
+
+        grid.set(Position(Edge - 1, Edge - 1, 7));
+        REQUIRE(grid.chunkCount() == 1);
+
+        REQUIRE_FALSE(grid.test(Position(Edge, Edge - 1, 7)));
+        REQUIRE_FALSE(grid.test(Position(Edge - 1, Edge, 7)));
+        REQUIRE_FALSE(grid.test(Position(0, 0, 7)));
+
+        grid.set(Position(Edge, Edge, 7));
+        REQUIRE(grid.chunkCount() == 2);
+        REQUIRE(grid.test(Position(Edge - 1, Edge - 1, 7)));
+        REQUIRE(grid.test(Position(Edge, Edge, 7)));
+    }
+
+    SECTION("The grid matches a set of positions")
+    {
+        std::mt19937 rng(5);
+        std::set<std::tuple<int, int, int>> expected;
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            Position position(rng() % 300, rng() % 300, rng() % 16);
+            grid.set(position);
+            expected.emplace(position.x, position.y, position.z);
+        }
+
+        for (int z = 0; z < 16; z += 5)
+        {
+            for (int y = 0; y < 300; ++y)
+            {
+                for (int x = 0; x < 300; ++x)
+                {
+                    REQUIRE(grid.test(Position(x, y, z)) == expected.contains({x, y, z}));
+                }
+            }
+        }
+
+        grid.clear();
+        REQUIRE(grid.chunkCount() == 0);
+        REQUIRE_FALSE(grid.test(Position(std::get<0>(*expected.begin()), std::get<1>(*expected.begin()), std::get<2>(*expected.begin()))));
+    }
+}
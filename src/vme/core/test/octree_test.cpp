@@ -0,0 +1,185 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "core/octree.h"
+
+namespace
+{
+    std::optional<vme::octree::BoundingBox> expectedBoundingBox(const std::vector<Position> &positions)
+    {
+        if (positions.empty())
+            return std::nullopt;
+
+        vme::octree::BoundingBox bbox(positions.front(), positions.front());
+        for (const auto &pos : positions)
+            bbox.include(pos);
+
+        return bbox;
+    }
+
+    bool sameBoundingBox(const std::optional<vme::octree::BoundingBox> &a, const std::optional<vme::octree::BoundingBox> &b)
+    {
+        if (!a || !b)
+            return !a && !b;
+
+        return a->min() == b->min() && a->max() == b->max();
+    }
+} // namespace
+
+TEST_CASE("octree.h", "[selection]")
+{
+    auto tree = vme::octree::Tree::create(vme::MapSize(2048, 2048, 16));
+
+    SECTION("A leaf keeps its bounding box when positions on its boundary are removed")
+    {
+        // All positions are in the same leaf
+        std::vector<Position> positions = {
+            Position(64, 128, 7),
+            Position(127, 130, 7),
+            Position(70, 191, 6),
+            Position(100, 150, 0),
+            Position(64, 128, 1),
+        };
+
+        for (const auto &pos : positions)
+            REQUIRE(tree.add(pos));
+
+        REQUIRE_FALSE(tree.add(positions.front()));
+        REQUIRE(tree.size() == static_cast<long>(positions.size()));
+        REQUIRE(sameBoundingBox(tree.boundingBox(), expectedBoundingBox(positions)));
+
+        while (!positions.empty())
+        {
+            Position removed = positions.back();
+            positions.pop_back();
+
+            REQUIRE(tree.remove(removed));
+            REQUIRE_FALSE(tree.contains(removed));
+            REQUIRE(sameBoundingBox(tree.boundingBox(), expectedBoundingBox(positions)));
+        }
+
+        REQUIRE(tree.empty());
+    }
+
+    SECTION("Random adds and removes match a reference set")
+    {
+        std::mt19937 random(1234);
+        std::uniform_int_distribution<int> xy(0, 255);
+        std::uniform_int_distribution<int> z(0, 15);
+
+        std::vector<Position> positions;
+        for (int i = 0; i < 2000; ++i)
+        {
+            Position pos(xy(random), xy(random), z(random));
+            bool present = std::find(positions.begin(), positions.end(), pos) != positions.end();
+
+            if (present)
+            {
+                REQUIRE(tree.remove(pos));
+                positions.erase(std::find(positions.begin(), positions.end(), pos));
+            }
+            else
+            {
+                REQUIRE(tree.add(pos));
+                positions.emplace_back(pos);
+            }
+
+            REQUIRE(tree.contains(pos) == !present);
+            REQUIRE(tree.size() == static_cast<long>(positions.size()));
+        }
+
+        REQUIRE(sameBoundingBox(tree.boundingBox(), expectedBoundingBox(positions)));
+
+        long iterated = 0;
+        for (auto it = tree.begin(); it != tree.end(); ++it)
+        {
+            REQUIRE(std::find(positions.begin(), positions.end(), *it) != positions.end());
+            ++iterated;
+        }
+        REQUIRE(iterated == static_cast<long>(positions.size()));
+    }
+
+    SECTION("Region operations match adding the positions one by one")
+    {
+        auto reference = vme::octree::Tree::create(vme::MapSize(2048, 2048, 16));
+
+        auto forEach = [](Position from, Position to, auto f) {
+            for (int z = from.z; z <= to.z; ++z)
+                for (int y = from.y; y <= to.y; ++y)
+                    for (int x = from.x; x <= to.x; ++x)
+                        f(Position(x, y, z));
+        };
+
+        auto sameContents = [&]() {
+            if (tree.size() != reference.size())
+                return false;
+
+            for (auto it = reference.begin(); it != reference.end(); ++it)
+            {
+                if (!tree.contains(*it))
+                    return false;
+            }
+            return sameBoundingBox(tree.boundingBox(), reference.boundingBox());
+        };
+
+        // Spans several leaves in every dimension
+        Position from(60, 10, 5);
+        Position to(200, 70, 9);
+
+        REQUIRE(tree.addRegion(from, to));
+        forEach(from, to, [&reference](Position pos) { reference.add(pos); });
+        REQUIRE(sameContents());
+
+        REQUIRE_FALSE(tree.addRegion(from, to));
+
+        Position removeFrom(64, 10, 5);
+        Position removeTo(127, 70, 7);
+        REQUIRE(tree.removeRegion(removeFrom, removeTo));
+        forEach(removeFrom, removeTo, [&reference](Position pos) { reference.remove(pos); });
+        REQUIRE(sameContents());
+
+        Position toggleFrom(100, 0, 8);
+        Position toggleTo(300, 20, 12);
+        REQUIRE(tree.toggleRegion(toggleFrom, toggleTo));
+        forEach(toggleFrom, toggleTo, [&reference](Position pos) {
+            if (reference.contains(pos))
+                reference.remove(pos);
+            else
+                reference.add(pos);
+        });
+        REQUIRE(sameContents());
+
+        std::vector<Position> positions;
+        forEach(Position(0, 0, 0), Position(300, 80, 12), [&reference, &positions](Position pos) {
+            if (reference.contains(pos))
+                positions.emplace_back(pos);
+        });
+
+        REQUIRE(tree.remove(positions));
+        REQUIRE(tree.empty());
+        REQUIRE_FALSE(tree.boundingBox().has_value());
+
+        REQUIRE(tree.add(positions));
+        REQUIRE(sameContents());
+    }
+
+    SECTION("Toggling a region twice restores the tree")
+    {
+        tree.add(Position(10, 10, 7));
+        tree.add(Position(70, 10, 7));
+
+        REQUIRE(tree.toggleRegion(Position(0, 0, 7), Position(63, 63, 7)));
+        REQUIRE_FALSE(tree.contains(Position(10, 10, 7)));
+        REQUIRE(tree.contains(Position(11, 10, 7)));
+        REQUIRE(tree.size() == 64 * 64);
+
+        REQUIRE(tree.toggleRegion(Position(0, 0, 7), Position(63, 63, 7)));
+        REQUIRE(tree.size() == 2);
+        REQUIRE(tree.contains(Position(10, 10, 7)));
+        REQUIRE(tree.contains(Position(70, 10, 7)));
+    }
+}
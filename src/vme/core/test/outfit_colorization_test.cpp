@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+
+#include "core/graphics/outfit_colorization.h"
+
+namespace
+{
+    void writePixel(std::vector<uint8_t> &row, size_t index, const Pixel &pixel)
+    {
+        row[index * 4] = pixel.b();
+        row[index * 4 + 1] = pixel.g();
+        row[index * 4 + 2] = pixel.r();
+        row[index * 4 + 3] = pixel.a();
+    }
+} // namespace
+
+TEST_CASE("outfit_colorization.h", "[graphics][outfit]")
+{
+    OutfitColorization::Colors colors{
+        Pixel{200, 100, 50, 255},
+        Pixel{0, 255, 128, 255},
+        Pixel{17, 34, 51, 255},
+        Pixel{255, 255, 255, 255}};
+
+    const Pixel templatePixels[] = {Pixels::Yellow, Pixels::Red, Pixels::Green, Pixels::Blue, Pixels::Magenta};
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> choice(0, 6);
+
+    SECTION("The vectorized kernel is pixel-exact against the scalar kernel")
+    {
+        // 32 and 64 are the real sprite widths, the others exercise the scalar tail.
+        for (uint32_t pixelCount : {1u, 3u, 7u, 32u, 33u, 64u, 71u})
+        {
+            std::vector<uint8_t> templateRow(pixelCount * 4);
+            std::vector<uint8_t> target(pixelCount * 4);
+
+            for (uint32_t i = 0; i < pixelCount; ++i)
+            {
+                int c = choice(rng);
+                if (c < 5)
+                {
+                    writePixel(templateRow, i, templatePixels[c]);
+                }
+                else
+                {
+                    writePixel(templateRow, i, Pixel{uint8_t(byte(rng)), uint8_t(byte(rng)), uint8_t(byte(rng)), uint8_t(byte(rng))});
+                }
+
+                writePixel(target, i, Pixel{uint8_t(byte(rng)), uint8_t(byte(rng)), uint8_t(byte(rng)), uint8_t(byte(rng))});
+            }
+
+            std::vector<uint8_t> expected = target;
+            std::vector<uint8_t> actual = target;
+
+            OutfitColorization::colorizeRowScalar(templateRow.data(), expected.data(), pixelCount, colors);
+            OutfitColorization::colorizeRow(templateRow.data(), actual.data(), pixelCount, colors);
+
+            REQUIRE(actual == expected);
+        }
+    }
+
+    SECTION("Pixels that are not template colors are left untouched")
+    {
+        std::vector<uint8_t> templateRow(8 * 4);
+        std::vector<uint8_t> target(8 * 4);
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            writePixel(templateRow, i, Pixels::Magenta);
+            writePixel(target, i, Pixel{uint8_t(i), uint8_t(i * 2), uint8_t(i * 3), 255});
+        }
+
+        std::vector<uint8_t> original = target;
+        OutfitColorization::colorizeRow(templateRow.data(), target.data(), 8, colors);
+
+        REQUIRE(target == original);
+    }
+}
@@ -0,0 +1,140 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <vector>
+
+#include "core/parallel.h"
+#include "core/position.h"
+
+TEST_CASE("parallel.h", "[core][parallel]")
+{
+    REQUIRE(parallel::threadCount() >= 1);
+
+    SECTION("Every index is visited exactly once")
+    {
+        for (size_t count : {0, 1, 2, 7, 1000})
+        {
+            std::vector<std::atomic<int>> visits(count);
+            parallel::forEach(count, [&visits](size_t i) { ++visits[i]; });
+
+            for (const auto &visit : visits)
+            {
+                REQUIRE(visit == 1);
+            }
+        }
+    }
+
+    SECTION("The work is finished when forEach returns")
+    {
+        std::vector<size_t> results(257, 0);
+        parallel::forEach(results.size(), [&results](size_t i) { results[i] = i * i; });
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            REQUIRE(results[i] == i * i);
+        }
+    }
+
+    SECTION("forEachByLeaf keeps the order of the calls for a position")
+    {
+        // Several calls per position, interleaved with calls for other positions
+        std::vector<Position> positions;
+        for (int round = 0; round < 4; ++round)
+        {
+            for (int x = 0; x < 64; ++x)
+            {
+                for (int y = 0; y < 64; ++y)
+                {
+                    positions.emplace_back(x, y, 7);
+                }
+            }
+        }
+
+        std::vector<std::vector<size_t>> calls(64 * 64);
+        parallel::forEachByLeaf(positions, 0, [&positions, &calls](size_t i) {
+            const Position &pos = positions[i];
+            calls[pos.x * 64 + pos.y].emplace_back(i);
+        });
+
+        for (const auto &indices : calls)
+        {
+            REQUIRE(indices.size() == 4);
+            REQUIRE(std::ranges::is_sorted(indices));
+        }
+    }
+
+    SECTION("forEachBand visits every row exactly once")
+    {
+        for (int lastRow : {-1, 0, 5, 31, 32, 100})
+        {
+            std::vector<std::atomic<int>> visits(lastRow + 1);
+            std::vector<int> bandFirstRows(parallel::bandCount(0, lastRow, 32), -1);
+            parallel::forEachBand(0, lastRow, 32, [&visits, &bandFirstRows](size_t band, int firstRow, int bandLastRow) {
+                bandFirstRows[band] = firstRow;
+                for (int row = firstRow; row <= bandLastRow; ++row)
+                    ++visits[row];
+            });
+
+            for (size_t band = 0; band < bandFirstRows.size(); ++band)
+            {
+                REQUIRE(bandFirstRows[band] == static_cast<int>(band) * 32);
+            }
+
+            for (const auto &visit : visits)
+            {
+                REQUIRE(visit == 1);
+            }
+        }
+    }
+
+    SECTION("Bands with a halo give the same result as a serial pass")
+    {
+        // Like the region borderize pass: two passes that each read the neighbors of a cell, so that a row
+        // depends on the two rows above and below it.
+        constexpr int Width = 37;
+        constexpr int Height = 203;
+
+        std::vector<uint32_t> input(Width * Height);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            input[i] = static_cast<uint32_t>((i * 2654435761u) >> 7);
+        }
+
+        auto at = [](const std::vector<uint32_t> &cells, int x, int y) -> uint32_t {
+            return (x < 0 || y < 0 || x >= Width || y >= Height) ? 0 : cells[y * Width + x];
+        };
+
+        auto stencil = [&at](const std::vector<uint32_t> &cells, int x, int y) {
+            uint32_t result = at(cells, x, y) * 31;
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                    result = (result ^ at(cells, x + dx, y + dy)) * 16777619u;
+            return result;
+        };
+
+        // Computes the rows [firstRow, lastRow] of the second pass, only reading rows up to two rows away.
+        auto computeRows = [&](int firstRow, int lastRow, std::vector<uint32_t> &output) {
+            std::vector<uint32_t> firstPass(Width * Height, 0);
+            for (int y = std::max(firstRow - 1, 0); y <= std::min(lastRow + 1, Height - 1); ++y)
+                for (int x = 0; x < Width; ++x)
+                    firstPass[y * Width + x] = stencil(input, x, y);
+
+            for (int y = firstRow; y <= lastRow; ++y)
+                for (int x = 0; x < Width; ++x)
+                    output[y * Width + x] = stencil(firstPass, x, y);
+        };
+
+        std::vector<uint32_t> serial(Width * Height);
+        computeRows(0, Height - 1, serial);
+
+        for (int bandRows : {1, 2, 7, 32})
+        {
+            std::vector<uint32_t> banded(Width * Height);
+            parallel::forEachBand(0, Height - 1, bandRows, [&computeRows, &banded](size_t, int firstRow, int lastRow) {
+                computeRows(firstRow, lastRow, banded);
+            });
+
+            REQUIRE(banded == serial);
+        }
+    }
+}
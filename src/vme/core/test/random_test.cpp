@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "core/alias_table.h"
+#include "core/logger.h"
+#include "core/random.h"
+#include "core/time_util.h"
+
+TEST_CASE("alias_table.h", "[core][random]")
+{
+    SECTION("Samples follow the weights")
+    {
+        std::vector<uint32_t> weights = {50, 25, 15, 7, 3};
+        AliasTable table(weights);
+        REQUIRE(table.size() == weights.size());
+
+        constexpr int Samples = 200000;
+        std::array<int, 5> counts{};
+
+        CounterRandom random(1234);
+        for (int i = 0; i < Samples; ++i)
+        {
+            uint32_t index = table.sample(random.next());
+            REQUIRE(index < weights.size());
+            ++counts[index];
+        }
+
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            double expected = Samples * weights[i] / 100.0;
+            REQUIRE(std::abs(counts[i] - expected) < expected * 0.05);
+        }
+    }
+
+    SECTION("Indices with no weight are never sampled")
+    {
+        AliasTable table({0, 3, 0, 1});
+
+        CounterRandom random(7);
+        for (int i = 0; i < 10000; ++i)
+        {
+            uint32_t index = table.sample(random.next());
+            REQUIRE((index == 1 || index == 3));
+        }
+    }
+
+    SECTION("A single weight is always sampled")
+    {
+        AliasTable table({5});
+
+        REQUIRE(table.sample(0) == 0);
+        REQUIRE(table.sample(~uint64_t(0)) == 0);
+    }
+
+    SECTION("No weights give an empty table")
+    {
+        REQUIRE(AliasTable(std::vector<uint32_t>{}).empty());
+    }
+}
+
+TEST_CASE("CounterRandom", "[core][random]")
+{
+    SECTION("The numbers do not depend on the order they are generated in")
+    {
+        CounterRandom random(99);
+
+        std::vector<uint64_t> forward;
+        for (uint64_t counter = 0; counter < 64; ++counter)
+        {
+            forward.emplace_back(random.at(counter));
+        }
+
+        for (uint64_t counter = 64; counter-- > 0;)
+        {
+            REQUIRE(random.at(counter) == forward[counter]);
+        }
+
+        CounterRandom sequential(99);
+        for (uint64_t value : forward)
+        {
+            REQUIRE(sequential.next() == value);
+        }
+    }
+
+    SECTION("Seeds and streams give different numbers")
+    {
+        CounterRandom random(1);
+
+        REQUIRE(random.at(0) != CounterRandom(2).at(0));
+        REQUIRE(random.stream(1).at(0) != random.stream(2).at(0));
+        REQUIRE(random.stream(1).at(0) == CounterRandom(1).stream(1).at(0));
+    }
+}
+
+TEST_CASE("Weighted sampling benchmark", "[.benchmark][core][random]")
+{
+    constexpr int Samples = 1 << 22;
+
+    // A ground brush with many variations, most of them rare
+    std::vector<uint32_t> weights;
+    for (uint32_t i = 0; i < 40; ++i)
+    {
+        weights.emplace_back(i < 4 ? 500 : 10);
+    }
+
+    std::vector<uint32_t> cumulative;
+    uint32_t totalWeight = 0;
+    for (uint32_t weight : weights)
+    {
+        totalWeight += weight;
+        cumulative.emplace_back(totalWeight);
+    }
+
+    Random random(42);
+    uint64_t linearChecksum = 0;
+
+    TimePoint linearStart;
+    for (int i = 0; i < Samples; ++i)
+    {
+        uint32_t weight = random.nextInt<uint32_t>(static_cast<uint32_t>(0), totalWeight);
+        uint32_t index = 0;
+        while (index + 1 < cumulative.size() && weight >= cumulative[index])
+        {
+            ++index;
+        }
+        linearChecksum += index;
+    }
+    auto linearMicros = linearStart.elapsedMicros();
+
+    AliasTable table(weights);
+    CounterRandom counterRandom(42);
+    uint64_t aliasChecksum = 0;
+
+    TimePoint aliasStart;
+    for (int i = 0; i < Samples; ++i)
+    {
+        aliasChecksum += table.sample(counterRandom.at(static_cast<uint64_t>(i)));
+    }
+    auto aliasMicros = aliasStart.elapsedMicros();
+
+    VME_LOG("Weighted sampling (" << Samples << " samples, " << weights.size() << " weights): mt19937 + linear search " << linearMicros
+                                  << " us, counter + alias table " << aliasMicros << " us.");
+
+    // Both follow the same distribution, so the mean indices are close.
+    double difference = static_cast<double>(aliasChecksum) - static_cast<double>(linearChecksum);
+    REQUIRE(std::abs(difference) < 0.02 * static_cast<double>(linearChecksum));
+}
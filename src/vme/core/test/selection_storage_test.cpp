@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include <random>
+#include <vector>
+
+#include "core/selection.h"
+
+namespace
+{
+    bool sameSpans(const std::vector<SelectionSpan> &a, const std::vector<SelectionSpan> &b)
+    {
+        if (a.size() != b.size())
+            return false;
+
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].start != b[i].start || a[i].length != b[i].length)
+                return false;
+        }
+
+        return true;
+    }
+} // namespace
+
+TEST_CASE("selection.h", "[selection]")
+{
+    SelectionStorageOctree octree(vme::MapSize(2048, 2048, 16));
+    SelectionStorageIntervals intervals;
+
+    SECTION("A rectangle is stored as one span per row")
+    {
+        REQUIRE(intervals.addRegion(Position(10, 20, 7), Position(2009, 2019, 7)));
+
+        REQUIRE(intervals.size() == 2000 * 2000);
+        REQUIRE(intervals.contains(Position(10, 20, 7)));
+        REQUIRE(intervals.contains(Position(2009, 2019, 7)));
+        REQUIRE_FALSE(intervals.contains(Position(2010, 20, 7)));
+        REQUIRE_FALSE(intervals.contains(Position(10, 20, 6)));
+
+        auto spans = intervals.spans();
+        REQUIRE(spans.size() == 2000);
+        REQUIRE(spans.front().start == Position(10, 20, 7));
+        REQUIRE(spans.front().length == 2000);
+
+        REQUIRE(intervals.getCorner(0, 0, 0) == Position(10, 20, 7));
+        REQUIRE(intervals.getCorner(1, 1, 1) == Position(2009, 2019, 7));
+
+        // Splitting a row and merging it again
+        REQUIRE(intervals.remove(Position(500, 20, 7)));
+        REQUIRE(intervals.spans().size() == 2001);
+        REQUIRE(intervals.add(Position(500, 20, 7)));
+        REQUIRE(intervals.spans().size() == 2000);
+        REQUIRE_FALSE(intervals.add(Position(500, 20, 7)));
+    }
+
+    SECTION("Interval and octree storage agree")
+    {
+        std::mt19937 random(42);
+        std::uniform_int_distribution<int> coordinate(0, 200);
+        std::uniform_int_distribution<int> floor(5, 9);
+        std::uniform_int_distribution<int> extent(0, 80);
+        std::uniform_int_distribution<int> operation(0, 3);
+
+        for (int i = 0; i < 200; ++i)
+        {
+            Position from(coordinate(random), coordinate(random), floor(random));
+            Position to(from.x + extent(random), from.y + extent(random) / 8, from.z);
+
+            bool octreeChanged = false;
+            bool intervalsChanged = false;
+            switch (operation(random))
+            {
+                case 0:
+                    octreeChanged = octree.addRegion(from, to);
+                    intervalsChanged = intervals.addRegion(from, to);
+                    break;
+                case 1:
+                    octreeChanged = octree.removeRegion(from, to);
+                    intervalsChanged = intervals.removeRegion(from, to);
+                    break;
+                case 2:
+                    octreeChanged = octree.toggleRegion(from, to);
+                    intervalsChanged = intervals.toggleRegion(from, to);
+                    break;
+                case 3:
+                    octreeChanged = octree.add(from);
+                    intervalsChanged = intervals.add(from);
+                    break;
+            }
+
+            REQUIRE(octreeChanged == intervalsChanged);
+            REQUIRE(octree.size() == intervals.size());
+            REQUIRE(sameSpans(octree.spans(), intervals.spans()));
+            REQUIRE(octree.getCorner(0, 0, 0) == intervals.getCorner(0, 0, 0));
+            REQUIRE(octree.getCorner(1, 1, 1) == intervals.getCorner(1, 1, 1));
+        }
+
+        for (const auto &pos : intervals.allPositions())
+            REQUIRE(octree.contains(pos));
+    }
+}
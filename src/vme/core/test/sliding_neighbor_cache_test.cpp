@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include "core/brushes/sliding_neighbor_cache.h"
+#include "core/position.h"
+
+namespace
+{
+    int valueAt(const Position &position)
+    {
+        return position.x * 1000 + position.y;
+    }
+} // namespace
+
+TEST_CASE("sliding_neighbor_cache.h", "[core][brush]")
+{
+    SlidingNeighborCache<int> cache;
+    int map = 0;
+
+    std::vector<Position> loaded;
+    auto load = [&loaded](const Position &position) {
+        loaded.emplace_back(position);
+        return valueAt(position);
+    };
+
+    auto requireArea = [&cache](const Position &center) {
+        for (int dy = -2; dy <= 2; ++dy)
+        {
+            for (int dx = -2; dx <= 2; ++dx)
+            {
+                REQUIRE(cache.at(dx, dy) == valueAt(center + Position(dx, dy, 0)));
+            }
+        }
+    };
+
+    cache.validate(&map, 1);
+    cache.moveTo(Position(10, 10, 7), load);
+    REQUIRE(loaded.size() == 25);
+    requireArea(Position(10, 10, 7));
+
+    SECTION("Moving by one tile only loads the new edge")
+    {
+        loaded.clear();
+        cache.moveTo(Position(11, 10, 7), load);
+        REQUIRE(loaded.size() == 5);
+        for (const Position &position : loaded)
+        {
+            REQUIRE(position.x == 13);
+        }
+        requireArea(Position(11, 10, 7));
+
+        loaded.clear();
+        cache.moveTo(Position(12, 11, 7), load);
+        REQUIRE(loaded.size() == 9);
+        requireArea(Position(12, 11, 7));
+    }
+
+    SECTION("Invalidated tiles are loaded again")
+    {
+        loaded.clear();
+        cache.invalidate(Position(10, 10, 7), 1);
+        cache.moveTo(Position(10, 11, 7), load);
+
+        // The new row and the 3x3 area, which is still in the window
+        REQUIRE(loaded.size() == 5 + 9);
+        requireArea(Position(10, 11, 7));
+    }
+
+    SECTION("Another floor or a distant position loads everything")
+    {
+        loaded.clear();
+        cache.moveTo(Position(10, 10, 6), load);
+        REQUIRE(loaded.size() == 25);
+
+        loaded.clear();
+        cache.moveTo(Position(20, 10, 6), load);
+        REQUIRE(loaded.size() == 25);
+        requireArea(Position(20, 10, 6));
+    }
+
+    SECTION("A new revision or owner drops the cache")
+    {
+        cache.validate(&map, 1);
+        loaded.clear();
+        cache.moveTo(Position(10, 10, 7), load);
+        REQUIRE(loaded.empty());
+
+        cache.validate(&map, 2);
+        cache.moveTo(Position(10, 10, 7), load);
+        REQUIRE(loaded.size() == 25);
+
+        int otherMap = 0;
+        loaded.clear();
+        cache.setRevision(3);
+        cache.validate(&otherMap, 3);
+        cache.moveTo(Position(10, 10, 7), load);
+        REQUIRE(loaded.size() == 25);
+    }
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "allocation_counter.h"
+#include "core/small_vector.h"
+
+TEST_CASE("small_vector.h", "[core][small vector]")
+{
+    SECTION("Up to the inline capacity, nothing is allocated")
+    {
+        AllocationCounter allocations;
+
+        SmallVector<int, 4> values;
+        for (int i = 0; i < 4; ++i)
+        {
+            values.emplace_back(i);
+        }
+
+        SmallVector<int, 4> copy = values;
+        SmallVector<int, 4> moved = std::move(copy);
+
+        REQUIRE(allocations.count() == 0);
+        REQUIRE(values.isInline());
+        REQUIRE(moved == values);
+        REQUIRE(copy.empty());
+    }
+
+    SECTION("Growing past the inline capacity keeps the elements")
+    {
+        SmallVector<int, 2> values;
+        for (int i = 0; i < 100; ++i)
+        {
+            values.push_back(i);
+        }
+
+        REQUIRE(!values.isInline());
+        REQUIRE(values.size() == 100);
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(values[i] == i);
+        }
+
+        SmallVector<int, 2> moved = std::move(values);
+        REQUIRE(moved.size() == 100);
+        REQUIRE(moved.back() == 99);
+        REQUIRE(values.empty());
+        REQUIRE(values.isInline());
+
+        values = moved;
+        REQUIRE(values == moved);
+    }
+
+    SECTION("An element of the vector can be appended while it grows")
+    {
+        SmallVector<int, 2> values = {1, 2, 3, 4};
+        REQUIRE(values.size() == values.capacity());
+
+        values.push_back(values.back());
+        values.push_back(values[0]);
+        values.emplace_back(values[1]);
+
+        REQUIRE(values == SmallVector<int, 2>{1, 2, 3, 4, 4, 1, 2});
+
+        // From the inline storage to the heap
+        SmallVector<int, 2> inlineValues = {5, 6};
+        inlineValues.push_back(inlineValues.back());
+        REQUIRE(inlineValues == SmallVector<int, 2>{5, 6, 6});
+    }
+
+    SECTION("A cleared vector is refilled without allocating")
+    {
+        SmallVector<int, 2> values = {1, 2, 3, 4, 5};
+
+        values.clear();
+        AllocationCounter allocations;
+        for (int i = 0; i < 5; ++i)
+        {
+            values.push_back(i);
+        }
+
+        REQUIRE(allocations.count() == 0);
+    }
+
+    SECTION("erase and sort")
+    {
+        SmallVector<int, 8> values = {5, 3, 1, 4, 2};
+
+        values.erase(values.begin() + 1);
+        REQUIRE(values == SmallVector<int, 8>{5, 1, 4, 2});
+
+        std::sort(values.begin(), values.end());
+        REQUIRE(values == SmallVector<int, 8>{1, 2, 4, 5});
+    }
+}
@@ -0,0 +1,141 @@
+#include "test_items.h"
+
+#include <array>
+
+#include "core/graphics/appearances.h"
+#include "core/items.h"
+
+namespace
+{
+    // Far above the client IDs of the real appearances
+    constexpr uint32_t FirstClientId = 900000;
+
+    constexpr std::array Kinds{
+        TestItems::Kind::Ground,
+        TestItems::Kind::OtherGround,
+        TestItems::Kind::Border,
+        TestItems::Kind::OtherBorder,
+        TestItems::Kind::Bottom,
+        TestItems::Kind::Normal,
+        TestItems::Kind::OtherNormal,
+        TestItems::Kind::Top,
+        TestItems::Kind::Blocking};
+
+    constexpr uint32_t FirstGroundClientId = FirstClientId + 100;
+    constexpr uint32_t FirstBorderClientId = FirstClientId + 200;
+    constexpr uint32_t FirstDoodadClientId = FirstClientId + 300;
+    constexpr uint32_t FirstMountainWallClientId = FirstClientId + 400;
+
+    uint32_t clientId(TestItems::Kind kind)
+    {
+        return FirstClientId + static_cast<uint32_t>(kind);
+    }
+
+    proto::AppearanceFlags *addObject(proto::Appearances &appearances, uint32_t clientId)
+    {
+        proto::Appearance *object = appearances.add_object();
+        object->set_id(clientId);
+
+        // Without sprite IDs, no texture atlas is needed.
+        object->add_frame_group()->mutable_sprite_info();
+
+        return object->mutable_flags();
+    }
+
+    void registerItemTypes()
+    {
+        using Kind = TestItems::Kind;
+
+        proto::Appearances appearances;
+        for (Kind kind : Kinds)
+        {
+            proto::AppearanceFlags *flags = addObject(appearances, clientId(kind));
+            switch (kind)
+            {
+                case Kind::Ground:
+                case Kind::OtherGround:
+                    flags->mutable_bank();
+                    break;
+                case Kind::Border:
+                case Kind::OtherBorder:
+                    flags->set_clip(true);
+                    break;
+                case Kind::Bottom:
+                    flags->set_bottom(true);
+                    break;
+                case Kind::Top:
+                    flags->set_top(true);
+                    break;
+                case Kind::Blocking:
+                    flags->set_unpass(true);
+                    break;
+                case Kind::Normal:
+                case Kind::OtherNormal:
+                    break;
+            }
+        }
+
+        for (int i = 0; i < TestItems::GroundCount; ++i)
+        {
+            addObject(appearances, FirstGroundClientId + i)->mutable_bank();
+        }
+
+        for (int i = 0; i < TestItems::BorderCount; ++i)
+        {
+            addObject(appearances, FirstBorderClientId + i)->set_clip(true);
+        }
+
+        for (int i = 0; i < TestItems::DoodadCount; ++i)
+        {
+            addObject(appearances, FirstDoodadClientId + i)->set_unpass(true);
+        }
+
+        for (int i = 0; i < TestItems::MountainWallCount; ++i)
+        {
+            addObject(appearances, FirstMountainWallClientId + i)->set_unpass(true);
+        }
+
+        Appearances::loadAppearanceData(appearances);
+        Items::loadMissingItemTypes();
+    }
+
+    uint32_t serverId(uint32_t clientId)
+    {
+        static bool registered = false;
+        if (!registered)
+        {
+            registerItemTypes();
+            registered = true;
+        }
+
+        return Items::items.getItemTypeByClientId(clientId)->id;
+    }
+} // namespace
+
+namespace TestItems
+{
+    uint32_t id(Kind kind)
+    {
+        return serverId(clientId(kind));
+    }
+
+    uint32_t groundId(int index)
+    {
+        return serverId(FirstGroundClientId + index);
+    }
+
+    uint32_t borderId(int index)
+    {
+        return serverId(FirstBorderClientId + index);
+    }
+
+    uint32_t doodadId(int index)
+    {
+        return serverId(FirstDoodadClientId + index);
+    }
+
+    uint32_t mountainWallId(int index)
+    {
+        return serverId(FirstMountainWallClientId + index);
+    }
+} // namespace TestItems
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+    Item types for tests that need items but no client data. The item types have no sprites. They are registered
+    (see Appearances::loadAppearanceData and Items::loadMissingItemTypes) the first time that an ID is requested.
+*/
+namespace TestItems
+{
+    enum class Kind
+    {
+        Ground,
+        OtherGround,
+        Border,
+        OtherBorder,
+        Bottom,
+        Normal,
+        OtherNormal,
+        Top,
+        Blocking
+    };
+
+    // The server ID of the item type of 'kind'
+    uint32_t id(Kind kind);
+
+    // The number of item types of groundId, borderId, doodadId and mountainWallId
+    constexpr int GroundCount = 8;
+    constexpr int BorderCount = 48;
+    constexpr int DoodadCount = 8;
+    constexpr int MountainWallCount = 16;
+
+    /*
+        Ground, border, (blocking) doodad and (blocking) mountain wall item types for the brushes that tests create.
+        They are kept apart from the kinds above, since a brush is registered on the item types that it uses (see
+        Brushes).
+    */
+    uint32_t groundId(int index);
+    uint32_t borderId(int index);
+    uint32_t doodadId(int index);
+    uint32_t mountainWallId(int index);
+} // namespace TestItems
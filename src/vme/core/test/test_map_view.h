@@ -0,0 +1,94 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "core/editor_action.h"
+#include "core/map_view.h"
+
+/*
+    A MapView without a user interface, for tests of map changes and their history.
+*/
+class TestUIUtils : public UIUtils
+{
+  public:
+    double screenDevicePixelRatio() override
+    {
+        return 1.0;
+    }
+
+    double windowDevicePixelRatio() override
+    {
+        return 1.0;
+    }
+
+    ScreenPosition mouseScreenPosInView() override
+    {
+        return ScreenPosition(0, 0);
+    }
+
+    VME::ModifierKeys modifiers() const override
+    {
+        return VME::ModifierKeys::None;
+    }
+
+    void waitForDraw(std::function<void()> f) override
+    {
+        f();
+    }
+};
+
+inline std::unique_ptr<MapView> makeTestMapView()
+{
+    return std::make_unique<MapView>(std::make_unique<TestUIUtils>(), EditorAction::editorAction);
+}
+
+/*
+    The server IDs and selection state of the things on a tile, for comparing map states.
+*/
+struct TileContents
+{
+    std::optional<uint32_t> ground;
+    std::vector<uint32_t> items;
+    // Selected things, counted from the selected flags of the items
+    size_t selected = 0;
+
+    bool operator==(const TileContents &other) const = default;
+};
+
+// std::nullopt if there is no tile at 'position'
+inline std::optional<TileContents> tileContents(const MapView &mapView, const Position &position)
+{
+    const Tile *tile = mapView.getTile(position);
+    if (!tile)
+        return std::nullopt;
+
+    TileContents contents;
+    if (tile->ground())
+    {
+        contents.ground = tile->ground()->serverId();
+        contents.selected += tile->ground()->selected ? 1 : 0;
+    }
+
+    for (const auto &item : tile->items())
+    {
+        contents.items.emplace_back(item->serverId());
+        contents.selected += item->selected ? 1 : 0;
+    }
+
+    return contents;
+}
+
+inline std::vector<std::optional<TileContents>> tileContents(const MapView &mapView, const std::vector<Position> &positions)
+{
+    std::vector<std::optional<TileContents>> result;
+    result.reserve(positions.size());
+    for (const auto &position : positions)
+    {
+        result.emplace_back(tileContents(mapView, position));
+    }
+
+    return result;
+}
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "core/graphics/texture_atlas_index.h"
+#include "core/logger.h"
+#include "core/time_util.h"
+
+namespace
+{
+    // Creates atlases with the same layout as the client catalog: consecutive sprite ranges of 144, 72 or 36
+    // sprites with occasional gaps between them.
+    std::vector<std::unique_ptr<TextureAtlas>> createAtlases(size_t count)
+    {
+        const SpriteLayout layouts[] = {SpriteLayout::ONE_BY_ONE, SpriteLayout::ONE_BY_TWO, SpriteLayout::TWO_BY_TWO};
+        const uint32_t spriteCounts[] = {144, 72, 36};
+
+        std::vector<std::unique_ptr<TextureAtlas>> atlases;
+
+        uint32_t nextSpriteId = 1;
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t layout = i % 3;
+            uint32_t first = nextSpriteId;
+            uint32_t last = first + spriteCounts[layout] - 1;
+
+            atlases.emplace_back(std::make_unique<TextureAtlas>(LZMACompressedBuffer{}, TextureAtlasSize.width, TextureAtlasSize.height, first, last, layouts[layout], "atlas.bmp.lzma"));
+
+            nextSpriteId = last + 1 + (i % 7 == 0 ? 10 : 0);
+        }
+
+        return atlases;
+    }
+
+    std::vector<TextureAtlas *> pointers(const std::vector<std::unique_ptr<TextureAtlas>> &atlases)
+    {
+        std::vector<TextureAtlas *> result;
+        for (const auto &atlas : atlases)
+        {
+            result.emplace_back(atlas.get());
+        }
+
+        return result;
+    }
+} // namespace
+
+TEST_CASE("texture_atlas_index.h", "[graphics][atlas]")
+{
+    auto atlases = createAtlases(500);
+
+    TextureAtlasIndex index;
+    index.build(pointers(atlases));
+
+    SECTION("Every sprite ID maps to the atlas that contains it")
+    {
+        for (const auto &atlas : atlases)
+        {
+            REQUIRE(index.find(atlas->firstSpriteId) == atlas.get());
+            REQUIRE(index.find(atlas->lastSpriteId) == atlas.get());
+            REQUIRE(index.find((atlas->firstSpriteId + atlas->lastSpriteId) / 2) == atlas.get());
+        }
+    }
+
+    SECTION("Sprite IDs outside of all atlases map to nullptr")
+    {
+        REQUIRE(index.find(0) == nullptr);
+        REQUIRE(index.find(atlases.front()->lastSpriteId + 1) == nullptr);
+        REQUIRE(index.find(atlases.back()->lastSpriteId + 1) == nullptr);
+    }
+}
+
+TEST_CASE("TextureAtlasIndex lookup benchmark", "[.benchmark][graphics][atlas]")
+{
+    auto atlases = createAtlases(5000);
+    auto atlasPointers = pointers(atlases);
+
+    TextureAtlasIndex index;
+    index.build(atlasPointers);
+
+    // The previous approach: an upper bound search over the (sorted) last sprite IDs of the atlases.
+    std::vector<uint32_t> upperBounds;
+    for (const auto &atlas : atlases)
+    {
+        upperBounds.emplace_back(atlas->lastSpriteId);
+    }
+
+    const auto binarySearch = [&](uint32_t spriteId) -> TextureAtlas * {
+        auto it = std::lower_bound(upperBounds.begin(), upperBounds.end(), spriteId);
+        if (it == upperBounds.end())
+            return nullptr;
+
+        TextureAtlas *atlas = atlasPointers[it - upperBounds.begin()];
+        return atlas->firstSpriteId <= spriteId ? atlas : nullptr;
+    };
+
+    std::mt19937 rng(42);
+    std::vector<uint32_t> spriteIds;
+    for (int i = 0; i < 4'000'000; ++i)
+    {
+        const auto &atlas = atlases[rng() % atlases.size()];
+        spriteIds.emplace_back(atlas->firstSpriteId + rng() % (atlas->lastSpriteId - atlas->firstSpriteId + 1));
+    }
+
+    uintptr_t checksum = 0;
+
+    TimePoint searchStart;
+    for (uint32_t spriteId : spriteIds)
+    {
+        checksum += reinterpret_cast<uintptr_t>(binarySearch(spriteId));
+    }
+    auto searchMicros = searchStart.elapsedMicros();
+
+    TimePoint indexStart;
+    for (uint32_t spriteId : spriteIds)
+    {
+        checksum -= reinterpret_cast<uintptr_t>(index.find(spriteId));
+    }
+    auto indexMicros = indexStart.elapsedMicros();
+
+    VME_LOG("TextureAtlas lookup (" << spriteIds.size() << " sprites): binary search " << searchMicros << " us, direct index " << indexMicros << " us (" << index.sizeInBytes() / 1024 << " KB).");
+
+    REQUIRE(checksum == 0);
+}
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "core/logger.h"
+#include "core/tile_cover.h"
+#include "core/time_util.h"
+
+namespace
+{
+    using namespace TileCoverShortHands;
+
+    constexpr std::array<TileQuadrant, 4> Quadrants = {TileQuadrant::TopLeft, TileQuadrant::TopRight, TileQuadrant::BottomRight, TileQuadrant::BottomLeft};
+    constexpr std::array<TileCover, 5> PreferredDiagonals = {None, NorthWest, NorthEast, SouthWest, SouthEast};
+
+    // Covers of a synthetic map. Most tiles have no border, and the others have one to three border pieces.
+    std::vector<TileCover> createCovers(int width, int height)
+    {
+        constexpr std::array<TileCover, 13> pieces = {
+            Full, North, East, South, West, NorthWest, NorthEast, SouthWest, SouthEast, NorthWestCorner, NorthEastCorner, SouthWestCorner, SouthEastCorner};
+
+        std::mt19937 rng(42);
+        std::vector<TileCover> covers(static_cast<size_t>(width) * height, None);
+        for (auto &cover : covers)
+        {
+            if (rng() % 4 != 0)
+                continue;
+
+            int count = 1 + rng() % 3;
+            for (int i = 0; i < count; ++i)
+            {
+                cover |= pieces[rng() % pieces.size()];
+            }
+        }
+
+        return covers;
+    }
+} // namespace
+
+TEST_CASE("tile_cover.h", "[core][tile cover]")
+{
+    SECTION("The lookup tables match the computed covers")
+    {
+        for (size_t value = 0; value < TileCovers::CoverCount; ++value)
+        {
+            auto cover = static_cast<TileCover>(value);
+
+            REQUIRE(TileCovers::mirrorNorth(cover) == TileCovers::computeMirrorNorth(cover));
+            REQUIRE(TileCovers::mirrorNorth(cover, false) == TileCovers::computeMirrorNorth(cover, false));
+            REQUIRE(TileCovers::mirrorEast(cover) == TileCovers::computeMirrorEast(cover));
+            REQUIRE(TileCovers::mirrorSouth(cover) == TileCovers::computeMirrorSouth(cover));
+            REQUIRE(TileCovers::mirrorWest(cover) == TileCovers::computeMirrorWest(cover));
+
+            for (TileQuadrant quadrant : Quadrants)
+            {
+                for (TileCover preferredDiagonal : PreferredDiagonals)
+                {
+                    REQUIRE(TileCovers::unifyTileCover(cover, quadrant, preferredDiagonal) == TileCovers::computeUnifiedTileCover(cover, quadrant, preferredDiagonal));
+                }
+            }
+        }
+    }
+
+    SECTION("Preferred diagonals without a table are computed")
+    {
+        TileCover cover = North | East | NorthWest | NorthEast;
+        TileCover preferred = NorthWest | NorthEast;
+        REQUIRE(TileCovers::unifyTileCover(cover, TileQuadrant::TopLeft, preferred) == TileCovers::computeUnifiedTileCover(cover, TileQuadrant::TopLeft, preferred));
+    }
+}
+
+TEST_CASE("TileCover lookup benchmark", "[.benchmark][core][tile cover]")
+{
+    constexpr int Width = 1024;
+    constexpr int Height = 1024;
+
+    auto covers = createCovers(Width, Height);
+    auto at = [&covers](int x, int y) { return covers[static_cast<size_t>(y) * Width + x]; };
+
+    // Like the mirror step of borderizing: every tile takes the borders of its four neighbors and unifies them.
+    auto borderize = [&at](auto mirrorNorth, auto mirrorEast, auto mirrorSouth, auto mirrorWest, auto unify) {
+        uint64_t checksum = 0;
+        for (int y = 1; y < Height - 1; ++y)
+        {
+            for (int x = 1; x < Width - 1; ++x)
+            {
+                TileCover cover = at(x, y);
+                cover |= mirrorNorth(at(x, y + 1));
+                cover |= mirrorEast(at(x - 1, y));
+                cover |= mirrorSouth(at(x, y - 1));
+                cover |= mirrorWest(at(x + 1, y));
+
+                checksum = checksum * 31 + unify(cover, Quadrants[(x + y) % 4]);
+            }
+        }
+        return checksum;
+    };
+
+    TimePoint computeStart;
+    uint64_t computed = borderize(
+        [](TileCover cover) { return TileCovers::computeMirrorNorth(cover); },
+        [](TileCover cover) { return TileCovers::computeMirrorEast(cover); },
+        [](TileCover cover) { return TileCovers::computeMirrorSouth(cover); },
+        [](TileCover cover) { return TileCovers::computeMirrorWest(cover); },
+        [](TileCover cover, TileQuadrant quadrant) { return TileCovers::computeUnifiedTileCover(cover, quadrant); });
+    auto computeMicros = computeStart.elapsedMicros();
+
+    TileCovers::initializeLookupTables();
+
+    TimePoint lookupStart;
+    uint64_t lookedUp = borderize(
+        [](TileCover cover) { return TileCovers::mirrorNorth(cover); },
+        [](TileCover cover) { return TileCovers::mirrorEast(cover); },
+        [](TileCover cover) { return TileCovers::mirrorSouth(cover); },
+        [](TileCover cover) { return TileCovers::mirrorWest(cover); },
+        [](TileCover cover, TileQuadrant quadrant) { return TileCovers::unifyTileCover(cover, quadrant); });
+    auto lookupMicros = lookupStart.elapsedMicros();
+
+    VME_LOG("TileCover mirror + unify (" << (Width - 2) * (Height - 2) << " tiles): computed " << computeMicros << " us, lookup tables " << lookupMicros << " us.");
+
+    REQUIRE(computed == lookedUp);
+}
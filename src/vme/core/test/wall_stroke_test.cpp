@@ -0,0 +1,206 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "core/brushes/wall_stroke.h"
+#include "core/position.h"
+
+namespace
+{
+    constexpr int Size = 24;
+    constexpr int Z = 7;
+
+    // The wall types of a map. Tiles without a wall are empty.
+    struct WallMap
+    {
+        std::array<std::optional<WallType>, Size * Size> walls{};
+
+        bool contains(int x, int y) const
+        {
+            return 0 <= x && x < Size && 0 <= y && y < Size;
+        }
+
+        bool hasWall(int x, int y) const
+        {
+            return contains(x, y) && walls[y * Size + x].has_value();
+        }
+
+        void set(int x, int y, WallType type)
+        {
+            if (contains(x, y))
+            {
+                walls[y * Size + x] = type;
+            }
+        }
+
+        bool operator==(const WallMap &other) const = default;
+    };
+
+    // WallBrush::apply with auto border: reads the 5x5 area, then connects the walls in the 3x3 area (see WallStroke::connect).
+    void applyPerTile(WallMap &map, const Position &position)
+    {
+        std::array<bool, 25> neighbors{};
+        auto at = [&neighbors](int x, int y) -> bool & { return neighbors[(y + 2) * 5 + (x + 2)]; };
+
+        for (int dy = -2; dy <= 2; ++dy)
+        {
+            for (int dx = -2; dx <= 2; ++dx)
+            {
+                at(dx, dy) = map.hasWall(position.x + dx, position.y + dy);
+            }
+        }
+        at(0, 0) = true;
+
+        WallStroke::connect(
+            [&at](int x, int y) { return at(x, y); },
+            [&map, &position](int x, int y, WallType type) { map.set(position.x + x, position.y + y, type); });
+    }
+
+    void applyStroke(WallMap &map, const std::vector<Position> &positions)
+    {
+        WallStroke stroke;
+        for (const auto &position : positions)
+        {
+            stroke.place(position);
+        }
+
+        const WallMap before = map;
+        stroke.resolve(
+            [&before](const Position &position) { return before.hasWall(position.x, position.y); },
+            [&map](const Position &position, WallType type) { map.set(position.x, position.y, type); });
+    }
+
+    // Walls with random types, so that some of them do not match their neighbors
+    WallMap randomWalls(std::mt19937 &rng)
+    {
+        constexpr std::array<WallType, 4> types = {WallType::Horizontal, WallType::Vertical, WallType::Corner, WallType::Pole};
+
+        WallMap map;
+        for (auto &wall : map.walls)
+        {
+            if (rng() % 5 == 0)
+            {
+                wall = types[rng() % types.size()];
+            }
+        }
+
+        return map;
+    }
+
+    std::vector<Position> randomStroke(std::mt19937 &rng)
+    {
+        std::vector<Position> positions;
+
+        // Mouse samples, some of them outside the map
+        Position previous(static_cast<int>(rng() % Size), static_cast<int>(rng() % Size), Z);
+        int samples = 1 + rng() % 6;
+        for (int i = 0; i < samples; ++i)
+        {
+            Position next(static_cast<int>(rng() % (Size + 4)) - 2, static_cast<int>(rng() % (Size + 4)) - 2, Z);
+            for (const auto &position : Position::bresenHamsWithCorners(previous, next))
+            {
+                if (position.x >= 0 && position.y >= 0 && position.x < Size && position.y < Size)
+                {
+                    positions.emplace_back(position);
+                }
+            }
+            previous = next;
+        }
+
+        return positions;
+    }
+} // namespace
+
+TEST_CASE("wall_stroke.h", "[core][brush]")
+{
+    SECTION("The wall types follow the left and top neighbors")
+    {
+        REQUIRE(WallStroke::wallType(false, false) == WallType::Pole);
+        REQUIRE(WallStroke::wallType(true, false) == WallType::Horizontal);
+        REQUIRE(WallStroke::wallType(false, true) == WallType::Vertical);
+        REQUIRE(WallStroke::wallType(true, true) == WallType::Corner);
+    }
+
+    SECTION("A stroke gives the same walls as the per-tile rule of WallBrush::apply")
+    {
+        std::mt19937 rng(11);
+
+        for (int i = 0; i < 500; ++i)
+        {
+            WallMap perTile = randomWalls(rng);
+            WallMap stroked = perTile;
+
+            auto positions = randomStroke(rng);
+            for (const auto &position : positions)
+            {
+                applyPerTile(perTile, position);
+            }
+            applyStroke(stroked, positions);
+
+            REQUIRE(stroked == perTile);
+        }
+    }
+
+    SECTION("A rectangle gives the same walls as the per-tile rule of WallBrush::apply")
+    {
+        std::mt19937 rng(3);
+
+        for (int i = 0; i < 200; ++i)
+        {
+            WallMap perTile = randomWalls(rng);
+            WallMap stroked = perTile;
+
+            int fromX = rng() % Size;
+            int fromY = rng() % Size;
+            int toX = fromX + rng() % (Size - fromX);
+            int toY = fromY + rng() % (Size - fromY);
+
+            // Same order as WallBrush::applyInRectangleArea
+            std::vector<Position> positions;
+            for (int x = fromX; x <= toX; ++x)
+                positions.emplace_back(x, fromY, Z);
+            for (int y = fromY + 1; y < toY; ++y)
+                positions.emplace_back(toX, y, Z);
+            for (int x = fromX; x <= toX; ++x)
+                positions.emplace_back(x, toY, Z);
+            for (int y = fromY + 1; y < toY; ++y)
+                positions.emplace_back(fromX, y, Z);
+
+            for (const auto &position : positions)
+            {
+                applyPerTile(perTile, position);
+            }
+            applyStroke(stroked, positions);
+
+            REQUIRE(stroked == perTile);
+        }
+    }
+
+    SECTION("Every tile is read from the map at most once")
+    {
+        WallStroke stroke;
+        for (int x = 0; x < 10; ++x)
+        {
+            stroke.place(Position(x, 5, Z));
+            stroke.place(Position(x, 6, Z));
+        }
+
+        std::vector<Position> reads;
+        int walls = 0;
+        stroke.resolve(
+            [&reads](const Position &position) {
+                reads.emplace_back(position);
+                return false;
+            },
+            [&walls](const Position &, WallType) { ++walls; });
+
+        REQUIRE(walls == 20);
+
+        std::sort(reads.begin(), reads.end(), [](const Position &a, const Position &b) { return a.y < b.y || (a.y == b.y && a.x < b.x); });
+        REQUIRE(std::adjacent_find(reads.begin(), reads.end()) == reads.end());
+    }
+}